@@ -0,0 +1,263 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// CAN总线编码(canbus-protocol的CanProtocol::reorganize_*)每类消息打包成64位报文的耗时，
+// 以及mm_tool的calculate_projection(点到线段投影，三种投影类型混合)
+
+#include <bitset>
+#include <vector>
+
+#include "bench_util.h"
+#include "can_protocol.h"
+#include "mm_tool.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+using can::CanProtocol;
+
+const size_t MESSAGE_COUNT = 1024;
+
+// 逐条编码messages，每条报文从全0开始，返回值不为0或者编码后报文仍然全0都算错误
+template<typename Message>
+void bench_reorganize(BenchState& state, const std::vector<Message>& messages, can::EncodeType type,
+                      int (CanProtocol::*reorganize)(const Message&, std::bitset<64>&)) {
+    CanProtocol protocol;
+    protocol.set_encode_type(type);
+    for (size_t i = 0; i < messages.size(); i++) {
+        std::bitset<64> message;
+        if (0 != (protocol.*reorganize)(messages[i], message) || message.none()) {
+            state.set_error("reorganize failed");
+            return;
+        }
+    }
+
+    state.set_items_per_iteration(messages.size());
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < messages.size(); i++) {
+            std::bitset<64> message;
+            (protocol.*reorganize)(messages[i], message);
+            sum += message.to_ullong();
+        }
+        do_not_optimize(sum);
+    }
+}
+
+std::vector<can::PositionMessage> position_messages() {
+    std::vector<can::PositionMessage> messages(MESSAGE_COUNT);
+    for (size_t i = 0; i < messages.size(); i++) {
+        can::PositionMessage& m = messages[i];
+        m = {};
+        m.type = 1;
+        m.cyclic_counter = i % 4;
+        m.path_index = 8;
+        m.offset = (i * 37) % 8192;
+        m.position_index = i % 4;
+        m.position_age = (i * 7) % 511;
+        m.speed = 64 + i % 400;
+        m.relative_heading = i % 255;
+        m.position_probability = 30;
+        m.position_confidence = i % 8;
+        m.current_lane = i % 8;
+    }
+    return messages;
+}
+
+std::vector<can::StubMessage> stub_messages() {
+    std::vector<can::StubMessage> messages(MESSAGE_COUNT);
+    for (size_t i = 0; i < messages.size(); i++) {
+        can::StubMessage& m = messages[i];
+        m = {};
+        m.type = 3;
+        m.cyclic_counter = i % 4;
+        m.path_index = 8;
+        m.offset = (i * 37) % 8192;
+        m.sub_path_index = 9 + i % 50;
+        m.turn_angle = i % 255;
+        m.relative_probability = i % 32;
+        m.functional_road_class = i % 8;
+        m.form_of_way = i % 16;
+        m.number_of_lanes_in_driving_direction = i % 8;
+        m.number_of_lanes_in_opposite_direction = i % 4;
+        m.complex_intersection = i % 2;
+        m.right_of_way = i % 4;
+        m.part_of_calculated_route = i % 2;
+        m.last_stub_at_offset = i % 2;
+    }
+    return messages;
+}
+
+std::vector<can::SegmentMessage> segment_messages() {
+    std::vector<can::SegmentMessage> messages(MESSAGE_COUNT);
+    for (size_t i = 0; i < messages.size(); i++) {
+        can::SegmentMessage& m = messages[i];
+        m = {};
+        m.type = 2;
+        m.cyclic_counter = i % 4;
+        m.path_index = 8;
+        m.offset = (i * 37) % 8192;
+        m.functional_road_class = i % 8;
+        m.form_of_way = i % 16;
+        m.effective_speed_limit = i % 32;
+        m.effective_speed_limit_type = i % 8;
+        m.number_of_lanes_in_driving_direction = i % 8;
+        m.number_of_lanes_in_opposite_direction = i % 4;
+        m.tunnel = i % 4;
+        m.bridge = i % 4;
+        m.divided_road = i % 4;
+        m.built_up_area = i % 4;
+        m.complex_intersection = i % 4;
+        m.relative_probability = i % 32;
+        m.part_of_calculated_route = i % 4;
+    }
+    return messages;
+}
+
+std::vector<can::ProfileShortMessage> shortprofile_messages() {
+    std::vector<can::ProfileShortMessage> messages(MESSAGE_COUNT);
+    for (size_t i = 0; i < messages.size(); i++) {
+        can::ProfileShortMessage& m = messages[i];
+        m = {};
+        m.type = 4;
+        m.cyclic_counter = i % 4;
+        m.path_index = 8;
+        m.offset = (i * 37) % 8192;
+        m.profile_type = 1 + i % 2; // 曲率、坡度
+        m.control_point = i % 2;
+        m.value0 = (i * 13) % 1024;
+        m.distance1 = (i * 5) % 1024;
+        m.value1 = (i * 17) % 1024;
+        m.accuracy = i % 4;
+    }
+    return messages;
+}
+
+std::vector<can::ProfileLongMessage> longprofile_messages() {
+    std::vector<can::ProfileLongMessage> messages(MESSAGE_COUNT);
+    for (size_t i = 0; i < messages.size(); i++) {
+        can::ProfileLongMessage& m = messages[i];
+        m.type = 5;
+        m.cyclic_counter = i % 4;
+        m.retrans = 0;
+        m.path_index = 8;
+        m.offset = (i * 37) % 8192;
+        // 经纬度之外，货车限速、路况、交通事件各有单独的排列
+        const int profile_types[] = {1, 2, 9, 13, 14};
+        m.profile_type = profile_types[i % 5];
+        m.value = uint32_t((121.4 + 180.0 + 1e-4 * i) * 1e7);
+        m.truck_speed.speed = i % 256;
+        m.truck_speed.weight = (i * 3) % 256;
+        m.traffic_state.speed = i % 256;
+        m.traffic_state.state = i % 4;
+        m.traffic_incident.incident_id = (i * 101) % 65536;
+        m.traffic_incident.severity = i % 4;
+    }
+    return messages;
+}
+
+std::vector<can::MetaMessage> metadata_messages() {
+    std::vector<can::MetaMessage> messages(MESSAGE_COUNT);
+    for (size_t i = 0; i < messages.size(); i++) {
+        can::MetaMessage& m = messages[i];
+        m = {};
+        m.type = 6;
+        m.cyclic_counter = i % 4;
+        m.country_code = 156;
+        m.region_code = i % 1024;
+        m.driving_side = 1;
+        m.speed_units = 0;
+        m.major_protocol_version = 2;
+        m.minor_protocol_version = 1;
+        m.minor_protocol_sub_version = i % 8;
+        m.hardware_version = i % 512;
+        m.map_provider = 3;
+        m.map_version_y = 24;
+        m.map_version_q = 1 + i % 4;
+    }
+    return messages;
+}
+
+void bench_position(BenchState& state) {
+    bench_reorganize(state, position_messages(), can::MOTOROLA, &CanProtocol::reorganize_position);
+}
+
+void bench_position_intel(BenchState& state) {
+    bench_reorganize(state, position_messages(), can::INTEL, &CanProtocol::reorganize_position);
+}
+
+void bench_stub(BenchState& state) {
+    bench_reorganize(state, stub_messages(), can::MOTOROLA, &CanProtocol::reorganize_stub);
+}
+
+void bench_segment(BenchState& state) {
+    bench_reorganize(state, segment_messages(), can::MOTOROLA, &CanProtocol::reorganize_segment);
+}
+
+void bench_shortprofile(BenchState& state) {
+    bench_reorganize(state, shortprofile_messages(), can::MOTOROLA, &CanProtocol::reorganize_shortprofile);
+}
+
+void bench_longprofile(BenchState& state) {
+    bench_reorganize(state, longprofile_messages(), can::MOTOROLA, &CanProtocol::reorganize_longprofile);
+}
+
+void bench_metadata(BenchState& state) {
+    bench_reorganize(state, metadata_messages(), can::MOTOROLA, &CanProtocol::reorganize_metadata);
+}
+
+// 沿一条约100m的线段撒点，投影落在首点之前、线段上、末点之后大致各占1/3
+void bench_calculate_projection(BenchState& state) {
+    const double x1 = 121.4;
+    const double y1 = 31.2;
+    const double x2 = 121.401;
+    const double y2 = 31.2003;
+    std::vector<double> points(2 * MESSAGE_COUNT);
+    int types[3] = {0, 0, 0};
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        double t = -1.0 + 3.0 * i / MESSAGE_COUNT;
+        points[2 * i] = x1 + t * (x2 - x1) - 0.0002 * ((i % 5) - 2.0);
+        points[2 * i + 1] = y1 + t * (y2 - y1) + 0.0002 * ((i % 7) - 3.0);
+        double dist_to_line = 0.0;
+        double dist_to_snode = 0.0;
+        int project_type = -1;
+        calculate_projection(points[2 * i], points[2 * i + 1], x1, y1, x2, y2,
+                             dist_to_line, dist_to_snode, project_type);
+        if (project_type < 0 || project_type > 2) {
+            state.set_error("unexpected project_type");
+            return;
+        }
+        types[project_type]++;
+    }
+    if (0 == types[0] || 0 == types[1] || 0 == types[2]) {
+        state.set_error("sample does not cover all project types");
+        return;
+    }
+
+    state.set_items_per_iteration(MESSAGE_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+            double dist_to_line = 0.0;
+            double dist_to_snode = 0.0;
+            int project_type = 0;
+            calculate_projection(points[2 * i], points[2 * i + 1], x1, y1, x2, y2,
+                                 dist_to_line, dist_to_snode, project_type);
+            sum += dist_to_line + dist_to_snode + project_type;
+        }
+        do_not_optimize(sum);
+    }
+}
+
+ADAS_BENCH("can/reorganize_position", bench_position);
+ADAS_BENCH("can/reorganize_position_intel", bench_position_intel);
+ADAS_BENCH("can/reorganize_stub", bench_stub);
+ADAS_BENCH("can/reorganize_segment", bench_segment);
+ADAS_BENCH("can/reorganize_shortprofile", bench_shortprofile);
+ADAS_BENCH("can/reorganize_longprofile", bench_longprofile);
+ADAS_BENCH("can/reorganize_metadata", bench_metadata);
+ADAS_BENCH("mm_tool/calculate_projection", bench_calculate_projection);
+
+} // namespace
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,146 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// cJSON解析吞吐，样本为上海高速的ehp下发数据和上报case
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "cJSON.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+const char* const UPLINK_CASE = "../../../examples/baidu_map_client/shanghai_gaosu_navigation_case.jsonl";
+
+void bench_parse_payloads(BenchState& state, const std::vector<std::string>& payloads) {
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < payloads.size(); i++) {
+        bytes += payloads[i].size();
+    }
+    state.set_bytes_per_iteration(bytes);
+    state.set_items_per_iteration(payloads.size());
+
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < payloads.size(); i++) {
+            cJSON* root = cJSON_Parse(payloads[i].c_str());
+            if (nullptr == root) {
+                state.set_error("parse failed at payload " + std::to_string(i));
+                return;
+            }
+            do_not_optimize(root);
+            cJSON_Delete(root);
+        }
+    }
+}
+
+// 从样本中抠出所有的数字token
+std::vector<std::string> extract_numbers(const std::string& payload) {
+    std::vector<std::string> numbers;
+    size_t i = 0;
+    bool in_string = false;
+    while (i < payload.size()) {
+        char c = payload[i];
+        if (in_string) {
+            if ('\\' == c) {
+                i += 2;
+                continue;
+            }
+            if ('"' == c) {
+                in_string = false;
+            }
+            i++;
+            continue;
+        }
+        if ('"' == c) {
+            in_string = true;
+            i++;
+            continue;
+        }
+        if ('-' == c || (c >= '0' && c <= '9')) {
+            size_t start = i;
+            while (i < payload.size() && nullptr != strchr("0123456789+-.eE", payload[i])) {
+                i++;
+            }
+            numbers.push_back(payload.substr(start, i - start));
+            continue;
+        }
+        i++;
+    }
+    return numbers;
+}
+
+std::vector<std::string> sample_numbers() {
+    std::vector<std::string> numbers = extract_numbers(read_data_file("shanghai_gaosu_ehp.json"));
+    std::vector<std::string> route_numbers = extract_numbers(read_data_file("shanghai_gaosu_route.json"));
+    numbers.insert(numbers.end(), route_numbers.begin(), route_numbers.end());
+    return numbers;
+}
+
+void bench_numbers_strtod(BenchState& state) {
+    static const std::vector<std::string> numbers = sample_numbers();
+    state.set_items_per_iteration(numbers.size());
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < numbers.size(); i++) {
+            double value = strtod(numbers[i].c_str(), nullptr);
+            do_not_optimize(value);
+        }
+    }
+}
+
+// 所有数字放进一个数组由cJSON解析，同时逐个和strtod的结果比对，必须逐位一致
+void bench_numbers_cjson(BenchState& state) {
+    static const std::vector<std::string> numbers = sample_numbers();
+    std::string array = "[";
+    for (size_t i = 0; i < numbers.size(); i++) {
+        array += (0 == i ? "" : ",") + numbers[i];
+    }
+    array += "]";
+
+    cJSON* check = cJSON_Parse(array.c_str());
+    if (nullptr == check) {
+        state.set_error("parse number array failed");
+        return;
+    }
+    size_t index = 0;
+    for (cJSON* item = check->child; nullptr != item; item = item->next, index++) {
+        double expected = strtod(numbers[index].c_str(), nullptr);
+        if (0 != memcmp(&expected, &item->valuedouble, sizeof(double))) {
+            state.set_error("not bit exact: " + numbers[index]);
+            cJSON_Delete(check);
+            return;
+        }
+    }
+    cJSON_Delete(check);
+
+    state.set_items_per_iteration(numbers.size());
+    state.set_bytes_per_iteration(array.size());
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        cJSON* root = cJSON_Parse(array.c_str());
+        do_not_optimize(root);
+        cJSON_Delete(root);
+    }
+}
+
+ADAS_BENCH("cjson_parse/shanghai_ehp", [](BenchState& state) {
+    static const std::vector<std::string> payloads = {read_data_file("shanghai_gaosu_ehp.json")};
+    bench_parse_payloads(state, payloads);
+});
+
+ADAS_BENCH("cjson_parse/shanghai_route", [](BenchState& state) {
+    static const std::vector<std::string> payloads = {read_data_file("shanghai_gaosu_route.json")};
+    bench_parse_payloads(state, payloads);
+});
+
+ADAS_BENCH("cjson_parse/shanghai_uplink_case", [](BenchState& state) {
+    static const std::vector<std::string> payloads = read_data_lines(UPLINK_CASE);
+    bench_parse_payloads(state, payloads);
+});
+
+ADAS_BENCH("cjson_numbers/strtod", bench_numbers_strtod);
+ADAS_BENCH("cjson_numbers/cjson_array", bench_numbers_cjson);
+
+} // namespace
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,214 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// link形点紧凑存储: 用上海高速ehp里所有link的形点，检查解码结果和原始坐标逐位一致、
+// 压缩后小于Coord的1/3，对比压缩、顺序解码和直接读std::vector<Coord>的耗时；
+// 统计每条link形点相关的全部内存(形点、累计距离、LinkRef里的局部坐标)，以及紧凑存储时现算累计距离的耗时
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "bench_util.h"
+#include "cJSON.h"
+#include "adas_v2_type.h"
+#include "adas_v2_utility.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+using protocol_v2::Coord;
+using protocol_v2::CompactShape;
+using protocol_v2::LinkInfo;
+
+void collect_shapes(const cJSON* item, std::vector<std::vector<Coord> >& shapes) {
+    for (const cJSON* child = item->child; nullptr != child; child = child->next) {
+        if (nullptr != child->string && 0 == strcmp(child->string, "shape") && cJSON_IsArray(child)) {
+            std::vector<Coord> shape;
+            for (const cJSON* point = child->child; nullptr != point; point = point->next) {
+                if (cJSON_IsArray(point) && 2 == cJSON_GetArraySize(point)) {
+                    Coord coord;
+                    coord.x = cJSON_GetArrayItem(point, 0)->valuedouble;
+                    coord.y = cJSON_GetArrayItem(point, 1)->valuedouble;
+                    shape.push_back(coord);
+                }
+            }
+            shapes.push_back(shape);
+        } else {
+            collect_shapes(child, shapes);
+        }
+    }
+}
+
+const std::vector<std::vector<Coord> >& horizon_shapes() {
+    static std::vector<std::vector<Coord> > shapes;
+    if (shapes.empty()) {
+        cJSON* root = cJSON_Parse(read_data_file("shanghai_gaosu_ehp.json").c_str());
+        if (nullptr != root) {
+            collect_shapes(root, shapes);
+            cJSON_Delete(root);
+        }
+    }
+    return shapes;
+}
+
+size_t point_count(const std::vector<std::vector<Coord> >& shapes) {
+    size_t count = 0;
+    for (size_t i = 0; i < shapes.size(); i++) {
+        count += shapes[i].size();
+    }
+    return count;
+}
+
+void bench_encode(BenchState& state) {
+    const std::vector<std::vector<Coord> >& shapes = horizon_shapes();
+    if (shapes.empty()) {
+        state.set_error("no shape in shanghai_gaosu_ehp.json");
+        return;
+    }
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < shapes.size(); i++) {
+        CompactShape compact;
+        compact.assign(shapes[i].data(), shapes[i].size());
+        bytes += compact.byte_size();
+        std::vector<Coord> decoded;
+        compact.decode(decoded);
+        if (decoded.size() != shapes[i].size() ||
+                0 != memcmp(decoded.data(), shapes[i].data(), decoded.size() * sizeof(Coord))) {
+            state.set_error("decoded shape differs from input");
+            return;
+        }
+    }
+    // 每条link的首点存绝对坐标约10字节，这份数据平均每条link不到7个形点，整体约5字节/点
+    size_t count = point_count(shapes);
+    if (bytes * 3 > count * sizeof(Coord)) {
+        char message[128];
+        snprintf(message, sizeof(message), "%.2f bytes/point", double(bytes) / count);
+        state.set_error(message);
+        return;
+    }
+
+    state.set_items_per_iteration(count);
+    CompactShape compact;
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < shapes.size(); i++) {
+            compact.assign(shapes[i].data(), shapes[i].size());
+            do_not_optimize(compact);
+        }
+    }
+}
+
+void bench_iterate_compact(BenchState& state) {
+    const std::vector<std::vector<Coord> >& shapes = horizon_shapes();
+    std::vector<CompactShape> compact(shapes.size());
+    for (size_t i = 0; i < shapes.size(); i++) {
+        compact[i].assign(shapes[i].data(), shapes[i].size());
+    }
+
+    state.set_items_per_iteration(point_count(shapes));
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < compact.size(); i++) {
+            for (CompactShape::const_iterator it = compact[i].begin(); it != compact[i].end(); ++it) {
+                sum += it->x + it->y;
+            }
+        }
+        do_not_optimize(sum);
+    }
+}
+
+void bench_iterate_vector(BenchState& state) {
+    const std::vector<std::vector<Coord> >& shapes = horizon_shapes();
+    state.set_items_per_iteration(point_count(shapes));
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < shapes.size(); i++) {
+            for (size_t j = 0; j < shapes[i].size(); j++) {
+                sum += shapes[i][j].x + shapes[i][j].y;
+            }
+        }
+        do_not_optimize(sum);
+    }
+}
+
+// 一条link形点相关的堆内存，unit byte，不计vector多余的capacity:
+// LinkInfo的shapes、compact_shapes、shape_distances，以及AdasV2Protocol::LinkRef的local_east、local_north(每点8字节)
+size_t link_heap_bytes(const LinkInfo& link_info) {
+    return link_info.shapes.size() * sizeof(Coord) + link_info.compact_shapes.byte_size() +
+            link_info.shape_distances.size() * sizeof(double) +
+            2 * protocol_v2::link_shape_count(link_info) * sizeof(float);
+}
+
+// 上面这些容器本身的大小，两种存储相同
+const size_t LINK_CONTAINER_BYTES = sizeof(std::vector<Coord>) + sizeof(CompactShape) + sizeof(std::vector<double>) +
+        2 * sizeof(std::vector<float>);
+
+// 按AdasV2Protocol解析时的方式存两份: 普通存储保存Coord和累计距离，紧凑存储只保存压缩后的形点
+void build_links(std::vector<LinkInfo>& plain, std::vector<LinkInfo>& compact) {
+    const std::vector<std::vector<Coord> >& shapes = horizon_shapes();
+    plain.resize(shapes.size());
+    compact.resize(shapes.size());
+    for (size_t i = 0; i < shapes.size(); i++) {
+        plain[i].shapes = shapes[i];
+        protocol_v2::calculate_shape_distances(plain[i].shapes, plain[i].shape_distances);
+        compact[i].compact_shapes.assign(shapes[i].data(), shapes[i].size());
+    }
+}
+
+// 计时部分是紧凑存储时读一条link的形点和累计距离: 解码加现算距离
+void bench_link_footprint(BenchState& state) {
+    std::vector<LinkInfo> plain;
+    std::vector<LinkInfo> compact;
+    build_links(plain, compact);
+    if (plain.empty()) {
+        state.set_error("no shape in shanghai_gaosu_ehp.json");
+        return;
+    }
+
+    size_t plain_heap = 0;
+    size_t compact_heap = 0;
+    std::vector<Coord> shape_buffer;
+    std::vector<double> distance_buffer;
+    for (size_t i = 0; i < plain.size(); i++) {
+        plain_heap += link_heap_bytes(plain[i]);
+        compact_heap += link_heap_bytes(compact[i]);
+        const std::vector<Coord>& shapes = protocol_v2::link_shapes(compact[i], shape_buffer);
+        const std::vector<double>& distances = protocol_v2::link_shape_distances(compact[i], shapes, distance_buffer);
+        if (distances != plain[i].shape_distances) {
+            state.set_error("derived shape distances differ from parsed ones");
+            return;
+        }
+    }
+
+    // 每条link平均不到7个形点，容器本身的128字节占了紧凑存储的大头，所以同时给出每条link和每个形点的数字
+    size_t count = point_count(horizon_shapes());
+    size_t links = plain.size();
+    char label[192];
+    snprintf(label, sizeof(label), "plain %.1f B/link (heap %.1f B/pt), compact %.1f B/link (heap %.1f B/pt)",
+             double(plain_heap) / links + LINK_CONTAINER_BYTES, double(plain_heap) / count,
+             double(compact_heap) / links + LINK_CONTAINER_BYTES, double(compact_heap) / count);
+    state.set_label(label);
+    if (compact_heap * 2 > plain_heap) {
+        state.set_error(label);
+        return;
+    }
+
+    state.set_items_per_iteration(count);
+    state.reset_timer();
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < compact.size(); i++) {
+            const std::vector<Coord>& shapes = protocol_v2::link_shapes(compact[i], shape_buffer);
+            do_not_optimize(protocol_v2::link_shape_distances(compact[i], shapes, distance_buffer));
+        }
+    }
+}
+
+ADAS_BENCH("compact_shape/encode", bench_encode);
+ADAS_BENCH("compact_shape/iterate_compact", bench_iterate_compact);
+ADAS_BENCH("compact_shape/iterate_vector", bench_iterate_vector);
+ADAS_BENCH("compact_shape/link_footprint", bench_link_footprint);
+
+} // namespace
+} // namespace bench
+} // namespace adas
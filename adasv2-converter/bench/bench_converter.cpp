@@ -0,0 +1,261 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 转换器的基础函数: 单位换算、各类消息转json、发送队列的入队出队，
+// 以及上海高速样本(position + ehp)整体走一遍input_ehp_info
+
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "adas_v2_channel.h"
+#include "adas_v2_message_json.h"
+#include "adas_v2_replay.h"
+#include "adas_v2_utility.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+using namespace protocol_v2;
+
+const size_t SAMPLE_COUNT = 1024;
+
+void bench_calculate_distance(BenchState& state) {
+    std::vector<double> lons(SAMPLE_COUNT);
+    std::vector<double> lats(SAMPLE_COUNT);
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        lons[i] = 121.38 + 0.0001 * i;
+        lats[i] = 31.24 - 0.00007 * i;
+    }
+    state.set_items_per_iteration(SAMPLE_COUNT - 1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        double sum = 0.0;
+        for (size_t i = 1; i < SAMPLE_COUNT; i++) {
+            sum += calculate_distance(lons[i - 1], lats[i - 1], lons[i], lats[i]);
+        }
+        do_not_optimize(sum);
+    }
+}
+
+void bench_normalize_direction(BenchState& state) {
+    std::vector<double> deltas(SAMPLE_COUNT);
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        deltas[i] = -360.0 + 720.0 * i / SAMPLE_COUNT;
+    }
+    state.set_items_per_iteration(SAMPLE_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        int sum = 0;
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            sum += normalize_direction(deltas[i]);
+        }
+        do_not_optimize(sum);
+    }
+}
+
+void bench_normalize_speed(BenchState& state) {
+    state.set_items_per_iteration(SAMPLE_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        int sum = 0;
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            sum += normalize_speed(int(i % 160));
+        }
+        do_not_optimize(sum);
+    }
+}
+
+// 字段取值参照上海高速样本转出的消息
+SegmentMessage sample_segment() {
+    SegmentMessage message;
+    message.cyclic_counter = 1;
+    message.path_index = 8;
+    message.offset = 396;
+    message.functional_road_class = 2;
+    message.form_of_way = 2;
+    message.effective_speed_limit = 17;
+    message.effective_speed_limit_type = 1;
+    message.number_of_lanes_in_driving_direction = 4;
+    message.number_of_lanes_in_opposite_direction = 0;
+    message.complex_intersection = 0;
+    message.relative_probability = 30;
+    message.part_of_calculated_route = 1;
+    message.link_id = 16294306630;
+    return message;
+}
+
+PositionMessage sample_position() {
+    PositionMessage message;
+    message.cyclic_counter = 2;
+    message.path_index = 8;
+    message.offset = 160;
+    message.position_age = 10;
+    message.speed = 21;
+    message.relative_heading = 0;
+    message.position_probability = 30;
+    return message;
+}
+
+ProfileLongMessage sample_profilelong() {
+    ProfileLongMessage message;
+    message.cyclic_counter = 3;
+    message.path_index = 8;
+    message.offset = 1131;
+    message.profile_type = 8;
+    message.control_point = 0;
+    message.traffic_sign.sign_type = 254;
+    return message;
+}
+
+ProfileShortMessage sample_profileshort() {
+    ProfileShortMessage message;
+    message.cyclic_counter = 0;
+    message.path_index = 8;
+    message.offset = 420;
+    message.profile_type = 4;
+    message.value0 = 512;
+    message.distance1 = 20;
+    message.value1 = 516;
+    return message;
+}
+
+StubMessage sample_stub() {
+    StubMessage message;
+    message.path_index = 8;
+    message.offset = 814;
+    message.sub_path_index = 9;
+    message.turn_angle = 21;
+    message.relative_probability = 0;
+    message.functional_road_class = 3;
+    message.form_of_way = 10;
+    message.number_of_lanes_in_driving_direction = 1;
+    message.number_of_lanes_in_opposite_direction = 0;
+    message.complex_intersection = 0;
+    message.part_of_calculated_route = 0;
+    message.last_stub_at_offset = 0;
+    for (int i = 0; i < 6; i++) {
+        Coord coord;
+        coord.x = 121.3842 + 0.0001 * i;
+        coord.y = 31.2356 - 0.00008 * i;
+        message.coords.push_back(coord);
+    }
+    return message;
+}
+
+template<typename Message>
+void bench_to_json(BenchState& state, const Message& message, std::string (*to_json)(const Message&)) {
+    state.set_bytes_per_iteration(to_json(message).size());
+    state.set_items_per_iteration(1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        std::string json = to_json(message);
+        do_not_optimize(json.data());
+    }
+}
+
+// 一次更新的消息量: 先全部入队再全部取出
+const size_t CHANNEL_MESSAGES = 64;
+
+void bench_channel_push_pop(BenchState& state) {
+    std::string message = segment_message_to_json(sample_segment());
+    Adasv2Channel channel;
+    std::string out;
+    uint64_t enqueue_ns = 0;
+    state.set_items_per_iteration(CHANNEL_MESSAGES);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < CHANNEL_MESSAGES; i++) {
+            if (0 == i % 8) {
+                channel.push_list0(message);
+            } else {
+                channel.push_list1(message);
+            }
+        }
+        while (-1 != channel.pop(out, enqueue_ns)) {
+            do_not_optimize(out.data());
+        }
+    }
+}
+
+void bench_channel_batch(BenchState& state) {
+    std::string message = segment_message_to_json(sample_segment());
+    Adasv2Channel channel;
+    EhpV2Batch batch;
+    uint64_t enqueue_ns = 0;
+    state.set_items_per_iteration(CHANNEL_MESSAGES);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        EhpV2Batch pending;
+        pending.messages.assign(CHANNEL_MESSAGES, message);
+        channel.push_batch(std::move(pending));
+        if (0 != channel.pop_batch(batch, enqueue_ns)) {
+            state.set_error("pop batch failed");
+            return;
+        }
+        do_not_optimize(batch.messages.size());
+    }
+}
+
+// 样本的version固定，交替使用两个版本号，每次都是整个horizon重新下发
+void bench_input_ehp_info(BenchState& state) {
+    ReplayEvent route_event;
+    route_event.type = REPLAY_SET_NAVI_ROUTE;
+    route_event.payload = read_data_file("shanghai_gaosu_route.json");
+    std::string position = read_data_file("shanghai_gaosu_position.json");
+    std::string ehp = read_data_file("shanghai_gaosu_ehp.json");
+    const std::string version = "\"version\":200";
+    size_t pos = ehp.find(version);
+    if (route_event.payload.empty() || position.empty() || std::string::npos == pos) {
+        state.set_error("bad sample data");
+        return;
+    }
+
+    ReplayProtocol protocol;
+    protocol.set_log_level(LOG_LEVEL_OFF);
+    std::vector<std::string> messages;
+    protocol.replay(route_event, messages);
+    ReplayEvent events[2];
+    for (int i = 0; i < 2; i++) {
+        events[i].type = REPLAY_INPUT_EHP_INFO;
+        events[i].payload = ehp;
+        events[i].payload.replace(pos, version.size(), "\"version\":" + std::to_string(200 + i));
+    }
+    ReplayEvent position_event;
+    position_event.type = REPLAY_INPUT_EHP_INFO;
+    position_event.payload = position;
+
+    state.set_bytes_per_iteration(ehp.size());
+    state.reset_timer();
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        messages.clear();
+        protocol.replay(events[n % 2], messages);
+        protocol.replay(position_event, messages);
+        do_not_optimize(messages.size());
+    }
+    if (messages.empty()) {
+        state.set_error("no message emitted");
+        return;
+    }
+    state.set_items_per_iteration(messages.size());
+}
+
+ADAS_BENCH("utility/calculate_distance", bench_calculate_distance);
+ADAS_BENCH("utility/normalize_direction", bench_normalize_direction);
+ADAS_BENCH("utility/normalize_speed", bench_normalize_speed);
+ADAS_BENCH("message_json/segment", [](BenchState& state) {
+    bench_to_json(state, sample_segment(), segment_message_to_json);
+});
+ADAS_BENCH("message_json/position", [](BenchState& state) {
+    bench_to_json(state, sample_position(), position_message_to_json);
+});
+ADAS_BENCH("message_json/profilelong", [](BenchState& state) {
+    bench_to_json(state, sample_profilelong(), profilelong_message_to_json);
+});
+ADAS_BENCH("message_json/profileshort", [](BenchState& state) {
+    bench_to_json(state, sample_profileshort(), profileshort_message_to_json);
+});
+ADAS_BENCH("message_json/stub", [](BenchState& state) {
+    bench_to_json(state, sample_stub(), stub_message_to_json);
+});
+ADAS_BENCH("channel/push_pop", bench_channel_push_pop);
+ADAS_BENCH("channel/batch", bench_channel_batch);
+ADAS_BENCH("protocol/input_ehp_info_shanghai", bench_input_ehp_info);
+
+} // namespace
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,297 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "cJSON.h"
+#include "geo_kernel.h"
+#include "bench_ehp_generator.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+const double ORIGIN_LON = 121.4;
+const double ORIGIN_LAT = 31.2;
+const double METERS_PER_DEGREE = geo::EARTH_RADIUS * geo::PI / 180.0;
+const int MAIN_PATH_ID = 8;
+const int MAX_PATH_ID = 63;
+const int CONTINUE_STUB_ID = 6;
+const int CONTINUE_STUB_LINKS = 4; // 每隔几条link有一个continue stub(车道数变化)
+const int64_t LINK_ID_BASE = 16000000000LL;
+const double MAX_HEADING_RATE = 1.0 / 300.0; // rad/m，转弯半径不小于300m
+const int PROFILE_INVALID = 1023;
+
+// 在baidu_traffic_sign_2_std_protocol里的警示类型
+const int WARNING_TYPE_CODES[] = {32, 29, 30, 31, 13, 48, 1, 2};
+const size_t WARNING_TYPE_COUNT = sizeof(WARNING_TYPE_CODES) / sizeof(WARNING_TYPE_CODES[0]);
+
+class Random {
+public:
+    explicit Random(uint64_t seed) : _state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    double uniform(double low, double high) {
+        _state = _state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return low + (high - low) * double(_state >> 11) / double(1ULL << 53);
+    }
+
+private:
+    uint64_t _state;
+};
+
+// 沿path前进时的位置和航向，航向为和正北方向的夹角，顺时针，unit rad
+struct Cursor {
+    double east = 0.0;
+    double north = 0.0;
+    double heading = 0.0;
+    double heading_rate = 0.0;
+};
+
+struct PathLayout {
+    int id = 0;
+    double branch_offset = 0.0; // 在主路径上的分叉位置
+    Cursor start;
+    std::vector<double> heading_rates; // 每个形点间隔的航向变化率，用于曲率采样
+    std::vector<double> slopes; // 同上，坡度，unit ‰
+    double step = 0.0;
+};
+
+cJSON* lonlat_array(const Cursor& cursor) {
+    double lonlat[2] = {
+        ORIGIN_LON + cursor.east / (METERS_PER_DEGREE * cos(geo::rad(ORIGIN_LAT))),
+        ORIGIN_LAT + cursor.north / METERS_PER_DEGREE
+    };
+    return cJSON_CreateDoubleArray(lonlat, 2);
+}
+
+double heading_degree(double heading) {
+    double degree = fmod(heading * 180.0 / geo::PI, 360.0);
+    return degree < 0.0 ? degree + 360.0 : degree;
+}
+
+int64_t link_id(int path_id, int link_index) {
+    return LINK_ID_BASE + int64_t(path_id) * 1000000 + link_index;
+}
+
+// 按形点间隔推进，航向变化率缓慢随机游走
+void advance(Cursor& cursor, double step, Random& random) {
+    cursor.heading_rate = 0.9 * cursor.heading_rate + random.uniform(-0.2, 0.2) * MAX_HEADING_RATE;
+    cursor.heading_rate = std::max(-MAX_HEADING_RATE, std::min(MAX_HEADING_RATE, cursor.heading_rate));
+    cursor.heading += cursor.heading_rate * step;
+    cursor.east += step * sin(cursor.heading);
+    cursor.north += step * cos(cursor.heading);
+}
+
+void add_links(const SyntheticEhpConfig& config, PathLayout& layout, double position_offset, Random& random,
+               cJSON* links, SyntheticEhpStats& stats) {
+    int points_per_link = std::max(1, int(lround(config.link_length / config.shape_spacing)));
+    layout.step = config.link_length / points_per_link;
+    bool main_path = MAIN_PATH_ID == layout.id;
+    Cursor cursor = layout.start;
+    double slope = 0.0;
+    for (int i = 0; i < config.links_per_path; i++) {
+        double offset = i * config.link_length;
+        cJSON* link = cJSON_CreateObject();
+        cJSON_AddNumberToObject(link, "distance_to_pos", layout.branch_offset + offset - position_offset);
+        cJSON_AddNumberToObject(link, "form_of_way", main_path ? 2 : 10);
+        cJSON_AddBoolToObject(link, "is_complex_intersection", false);
+        cJSON_AddBoolToObject(link, "is_part_of_route", main_path);
+        int kinds[2] = {main_path ? 258 : 1029, main_path ? 268 : 1035};
+        cJSON_AddItemToObject(link, "kind", cJSON_CreateIntArray(kinds, 2));
+        cJSON_AddNumberToObject(link, "lanenum", main_path ? 3 + (i / CONTINUE_STUB_LINKS) % 3 : 1);
+        cJSON_AddNumberToObject(link, "lanenume2s", 0);
+        cJSON_AddNumberToObject(link, "length", config.link_length);
+        cJSON_AddNumberToObject(link, "link_id", double(link_id(layout.id, i)));
+        cJSON_AddNumberToObject(link, "link_index", i);
+        cJSON_AddNumberToObject(link, "offset", offset);
+        cJSON_AddNumberToObject(link, "ownership", 0);
+        cJSON_AddNumberToObject(link, "path_id", layout.id);
+        cJSON_AddNumberToObject(link, "pathclass", main_path ? 2 : 3);
+        cJSON_AddNumberToObject(link, "relative_probability", main_path ? 30.0 : 0.0);
+        cJSON_AddNumberToObject(link, "road_grade", main_path ? 1 : 4);
+
+        cJSON* shape = cJSON_AddArrayToObject(link, "shape");
+        cJSON_AddItemToArray(shape, lonlat_array(cursor));
+        for (int j = 0; j < points_per_link; j++) {
+            advance(cursor, layout.step, random);
+            slope = std::max(-60.0, std::min(60.0, slope + random.uniform(-3.0, 3.0)));
+            layout.heading_rates.push_back(cursor.heading_rate);
+            layout.slopes.push_back(slope);
+            cJSON_AddItemToArray(shape, lonlat_array(cursor));
+        }
+        stats.shape_points += points_per_link + 1;
+
+        cJSON_AddNumberToObject(link, "speed_limit", main_path ? 80 : 40);
+        cJSON_AddNumberToObject(link, "speed_limit_type", 1);
+        cJSON_AddNumberToObject(link, "uflag", 1);
+        cJSON_AddItemToArray(links, link);
+        stats.links++;
+    }
+}
+
+cJSON* create_path(int id, int pid, double offset, double turn_angle, bool main_path, int lanes) {
+    cJSON* path = cJSON_CreateObject();
+    cJSON_AddNumberToObject(path, "form_of_way", main_path ? 2 : 10);
+    cJSON_AddNumberToObject(path, "id", id);
+    cJSON_AddBoolToObject(path, "is_complex_intersection", false);
+    cJSON_AddBoolToObject(path, "is_last_stub_at_offset", false);
+    cJSON_AddBoolToObject(path, "is_part_of_route", main_path);
+    cJSON_AddNumberToObject(path, "lanenume2s", 0);
+    cJSON_AddNumberToObject(path, "lanenums2e", lanes);
+    cJSON_AddNumberToObject(path, "offset", offset);
+    cJSON_AddNumberToObject(path, "pathclass", main_path ? 2 : 3);
+    cJSON_AddNumberToObject(path, "pid", pid);
+    cJSON_AddNumberToObject(path, "relative_probability", main_path ? 30.0 : 0.0);
+    cJSON_AddNumberToObject(path, "right_of_way", main_path ? 0 : 1);
+    cJSON_AddNumberToObject(path, "turn_angle", turn_angle);
+    cJSON_AddNumberToObject(path, "type", CONTINUE_STUB_ID == id ? 2 : 0);
+    return path;
+}
+
+// 坡度、曲率: 每隔profile_spacing取一个采样点，最后一个点为1023表示之后没有数据
+void add_profiles(const SyntheticEhpConfig& config, const PathLayout& layout, cJSON* slopes, cJSON* curvatures,
+                  SyntheticEhpStats& stats) {
+    double length = config.links_per_path * config.link_length;
+    std::vector<int> offsets;
+    std::vector<int> slope_steps;
+    std::vector<int> curvature_steps;
+    for (double s = 0.0; s < length; s += config.profile_spacing) {
+        size_t index = std::min(layout.heading_rates.size() - 1, size_t(s / layout.step));
+        offsets.push_back(int(s));
+        slope_steps.push_back(int(lround(512 + layout.slopes[index] * 4)));
+        curvature_steps.push_back(int(lround(512 + layout.heading_rates[index] * 1e5)));
+    }
+    offsets.push_back(int(length));
+    slope_steps.push_back(PROFILE_INVALID);
+    curvature_steps.push_back(PROFILE_INVALID);
+    stats.profile_points += 2 * offsets.size();
+
+    cJSON* slope = cJSON_CreateObject();
+    cJSON_AddNumberToObject(slope, "path_id", layout.id);
+    cJSON_AddItemToObject(slope, "offset", cJSON_CreateIntArray(offsets.data(), offsets.size()));
+    cJSON_AddItemToObject(slope, "step", cJSON_CreateIntArray(slope_steps.data(), slope_steps.size()));
+    cJSON_AddItemToArray(slopes, slope);
+
+    cJSON* curvature = cJSON_CreateObject();
+    cJSON_AddNumberToObject(curvature, "path_id", layout.id);
+    cJSON_AddItemToObject(curvature, "offset", cJSON_CreateIntArray(offsets.data(), offsets.size()));
+    cJSON_AddItemToObject(curvature, "step", cJSON_CreateIntArray(curvature_steps.data(), curvature_steps.size()));
+    cJSON_AddItemToArray(curvatures, curvature);
+}
+
+void add_points_of_interest(const SyntheticEhpConfig& config, const PathLayout& layout, cJSON* traffic_lights,
+                            cJSON* warnings, SyntheticEhpStats& stats) {
+    double length = config.links_per_path * config.link_length;
+    if (config.traffic_light_spacing > 0.0) {
+        for (double s = config.traffic_light_spacing / 2; s < length; s += config.traffic_light_spacing) {
+            cJSON* light = cJSON_CreateObject();
+            cJSON_AddNumberToObject(light, "path_id", layout.id);
+            cJSON_AddNumberToObject(light, "offset", int(s));
+            cJSON_AddItemToArray(traffic_lights, light);
+            stats.traffic_lights++;
+        }
+    }
+    if (config.warning_spacing > 0.0) {
+        size_t type = layout.id;
+        for (double s = config.warning_spacing / 2; s < length; s += config.warning_spacing) {
+            cJSON* warning = cJSON_CreateObject();
+            cJSON_AddNumberToObject(warning, "path_id", layout.id);
+            cJSON_AddNumberToObject(warning, "type_code", WARNING_TYPE_CODES[type++ % WARNING_TYPE_COUNT]);
+            cJSON_AddNumberToObject(warning, "offset", int(s));
+            cJSON_AddItemToArray(warnings, warning);
+            stats.warnings++;
+        }
+    }
+}
+
+} // namespace
+
+std::string generate_ehp(const SyntheticEhpConfig& config, SyntheticEhpStats* stats) {
+    SyntheticEhpStats local_stats;
+    SyntheticEhpStats& counts = nullptr == stats ? local_stats : *stats;
+    counts = SyntheticEhpStats();
+    if (config.links_per_path <= 0 || config.link_length <= 0.0 || config.shape_spacing <= 0.0 ||
+            config.profile_spacing <= 0.0) {
+        return "";
+    }
+
+    Random random(config.seed);
+    int paths = std::max(1, std::min(config.paths, MAX_PATH_ID - MAIN_PATH_ID + 1));
+    double main_length = config.links_per_path * config.link_length;
+    double position_offset = std::min(100.0, config.link_length / 2);
+
+    cJSON* root = cJSON_CreateObject();
+    cJSON* links = cJSON_AddArrayToObject(root, "link");
+    cJSON_AddNumberToObject(root, "max_send_length", 2000);
+    cJSON* path_array = cJSON_AddArrayToObject(root, "path");
+    cJSON* slopes = cJSON_AddArrayToObject(root, "slope");
+    cJSON* curvatures = cJSON_AddArrayToObject(root, "curvature");
+    cJSON* traffic_lights = cJSON_AddArrayToObject(root, "traffic_light");
+    cJSON* warnings = cJSON_AddArrayToObject(root, "warning_info");
+
+    // 主路径先生成，侧路从主路径上分叉处的位置和航向出发
+    PathLayout main_layout;
+    main_layout.id = MAIN_PATH_ID;
+    main_layout.start.heading = random.uniform(0.0, 2 * geo::PI);
+    Cursor main_start = main_layout.start;
+    add_links(config, main_layout, position_offset, random, links, counts);
+    cJSON_AddItemToArray(path_array, create_path(MAIN_PATH_ID, 0, 0.0, 0.0, true, 3));
+    for (int i = 0; i < config.links_per_path; i += CONTINUE_STUB_LINKS) {
+        cJSON_AddItemToArray(path_array, create_path(CONTINUE_STUB_ID, MAIN_PATH_ID, i * config.link_length,
+            random.uniform(-5.0, 5.0), true, 3 + (i / CONTINUE_STUB_LINKS) % 3));
+    }
+    add_profiles(config, main_layout, slopes, curvatures, counts);
+    add_points_of_interest(config, main_layout, traffic_lights, warnings, counts);
+
+    for (int i = 1; i < paths; i++) {
+        PathLayout layout;
+        layout.id = MAIN_PATH_ID + i;
+        layout.branch_offset = main_length * i / paths;
+        // 按主路径的航向变化率积分出分叉处的位置，和add_links推进的结果一致
+        Cursor cursor = main_start;
+        size_t steps = std::min(main_layout.heading_rates.size(), size_t(layout.branch_offset / main_layout.step));
+        for (size_t j = 0; j < steps; j++) {
+            cursor.heading += main_layout.heading_rates[j] * main_layout.step;
+            cursor.east += main_layout.step * sin(cursor.heading);
+            cursor.north += main_layout.step * cos(cursor.heading);
+        }
+        double turn_angle = random.uniform(30.0, 60.0) * (random.uniform(0.0, 1.0) < 0.5 ? -1 : 1);
+        layout.start = cursor;
+        layout.start.heading += geo::rad(turn_angle);
+        layout.start.heading_rate = 0.0;
+        add_links(config, layout, position_offset, random, links, counts);
+        cJSON_AddItemToArray(path_array, create_path(layout.id, MAIN_PATH_ID, layout.branch_offset, turn_angle,
+            false, 1));
+        add_profiles(config, layout, slopes, curvatures, counts);
+        add_points_of_interest(config, layout, traffic_lights, warnings, counts);
+    }
+    counts.paths = paths;
+
+    if (0 != config.position_time_ms) {
+        cJSON* position = cJSON_CreateObject();
+        cJSON_AddNumberToObject(position, "dir", heading_degree(main_start.heading));
+        cJSON_AddNumberToObject(position, "elevated", 0);
+        cJSON_AddItemToObject(position, "gps_loc", lonlat_array(main_start));
+        cJSON_AddNumberToObject(position, "gps_loc_time", double(config.position_time_ms));
+        cJSON_AddNumberToObject(position, "link_dir", heading_degree(main_start.heading));
+        cJSON_AddNumberToObject(position, "link_id", double(link_id(MAIN_PATH_ID, 0)));
+        cJSON_AddNumberToObject(position, "link_offset", position_offset);
+        cJSON_AddNumberToObject(position, "offset", position_offset);
+        cJSON_AddNumberToObject(position, "path_id", MAIN_PATH_ID);
+        cJSON_AddNumberToObject(position, "probability", 30.0);
+        cJSON_AddNumberToObject(position, "speed", 20.0);
+        cJSON_AddItemToObject(root, "position", position);
+    }
+    cJSON_AddNumberToObject(root, "version", double(config.version));
+
+    char* text = cJSON_PrintUnformatted(root);
+    std::string ehp = nullptr == text ? "" : text;
+    free(text);
+    cJSON_Delete(root);
+    return ehp;
+}
+
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,40 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <string>
+
+namespace adas {
+namespace bench {
+
+// 合成的ehp服务端下发数据(input_ehp_info的参数)，字段和test/data/shanghai_gaosu_ehp.json一致。
+// 主路径为path 8，侧路为path 9开始、pid为8的子路径，在主路径上等间隔分叉。
+// 每条path的link首尾相接，形点按航向随机缓变的折线生成；坡度、曲率按固定间隔采样，
+// 红绿灯和警示信息按固定间隔分布在每条path上。同样的参数和seed生成同样的内容
+struct SyntheticEhpConfig {
+    int paths = 1; // 包括主路径，path index最大63，超出的截断
+    int links_per_path = 16;
+    double link_length = 200.0; // unit m
+    double shape_spacing = 10.0; // 相邻形点的距离，unit m
+    double profile_spacing = 20.0; // 坡度、曲率的采样间隔，unit m
+    double traffic_light_spacing = 500.0; // unit m，小于等于0时不生成
+    double warning_spacing = 300.0; // unit m，小于等于0时不生成
+    int64_t version = 1; // 和上一次input_ehp_info不同时protocol清空缓存，整个horizon重新下发
+    int64_t position_time_ms = 0; // position的gps_loc_time，0时不带position
+    uint32_t seed = 1;
+};
+
+// 生成的数据里各类元素的个数
+struct SyntheticEhpStats {
+    size_t paths = 0;
+    size_t links = 0;
+    size_t shape_points = 0;
+    size_t profile_points = 0; // 坡度和曲率的采样点
+    size_t traffic_lights = 0;
+    size_t warnings = 0;
+};
+
+std::string generate_ehp(const SyntheticEhpConfig& config, SyntheticEhpStats* stats = nullptr);
+
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,287 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 不同规模的合成horizon(path数 x 每条path的link数 x 形点密度)下input_ehp_info的耗时，
+// 按形点数计吞吐，规模变大时吞吐明显下降说明有超线性的环节:
+//   parse:        只做cJSON_Parse，作为基准
+//   full_update:  版本号每次变化，清空缓存后整个horizon重新解析、建索引、转成消息并取出
+//   same_version: 版本号不变，只解析和更新索引，已经发过的消息不再转换
+// full_update和same_version的差即消息转换和取出的开销
+//   can_frames:   full_update输出的每条消息按CAN网关的做法取出字段，经CanProtocol::reorganize_*
+//                 编码成64位报文，按报文数计吞吐
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "cJSON.h"
+#include "bench_util.h"
+#include "bench_ehp_generator.h"
+#include "adas_v2_replay.h"
+#include "can_protocol.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+using protocol_v2::ReplayEvent;
+using protocol_v2::ReplayProtocol;
+
+struct Scale {
+    const char* name;
+    int paths;
+    int links_per_path;
+    double shape_spacing;
+    double profile_spacing;
+};
+
+const Scale SCALES[] = {
+    {"p1_l16", 1, 16, 10.0, 20.0},
+    {"p1_l128", 1, 128, 10.0, 20.0},
+    {"p8_l16", 8, 16, 10.0, 20.0},
+    {"p8_l128", 8, 128, 10.0, 20.0},
+    {"p56_l16", 56, 16, 10.0, 20.0},
+    {"p56_l128", 56, 128, 10.0, 20.0},
+    {"p8_l64_dense", 8, 64, 2.0, 5.0},
+};
+
+// 同一规模两个版本号的数据，交替输入让每次都是整个horizon更新
+struct ScaleData {
+    std::string ehp[2];
+    SyntheticEhpStats stats;
+};
+
+const ScaleData& scale_data(const Scale& scale) {
+    static std::vector<std::pair<const Scale*, ScaleData> > cache;
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache[i].first == &scale) {
+            return cache[i].second;
+        }
+    }
+    SyntheticEhpConfig config;
+    config.paths = scale.paths;
+    config.links_per_path = scale.links_per_path;
+    config.shape_spacing = scale.shape_spacing;
+    config.profile_spacing = scale.profile_spacing;
+    ScaleData data;
+    for (int i = 0; i < 2; i++) {
+        config.version = i + 1;
+        data.ehp[i] = generate_ehp(config, &data.stats);
+    }
+    cache.push_back(std::make_pair(&scale, data));
+    return cache.back().second;
+}
+
+void bench_parse(BenchState& state, const Scale& scale) {
+    const ScaleData& data = scale_data(scale);
+    state.set_items_per_iteration(data.stats.shape_points);
+    state.set_bytes_per_iteration(data.ehp[0].size());
+    state.reset_timer();
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        cJSON* root = cJSON_Parse(data.ehp[0].c_str());
+        do_not_optimize(root);
+        cJSON_Delete(root);
+    }
+}
+
+void bench_update(BenchState& state, const Scale& scale, bool full_update) {
+    const ScaleData& data = scale_data(scale);
+    state.set_items_per_iteration(data.stats.shape_points);
+    state.set_bytes_per_iteration(data.ehp[0].size());
+
+    ReplayProtocol protocol;
+    protocol.set_log_level(protocol_v2::LOG_LEVEL_OFF);
+    ReplayEvent events[2];
+    for (int i = 0; i < 2; i++) {
+        events[i].type = protocol_v2::REPLAY_INPUT_EHP_INFO;
+        events[i].payload = data.ehp[i];
+    }
+    std::vector<std::string> messages;
+    protocol.replay(events[0], messages);
+    if (messages.size() < data.stats.links) {
+        state.set_error("too few messages: " + std::to_string(messages.size()));
+        return;
+    }
+
+    state.reset_timer();
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        messages.clear();
+        protocol.replay(events[full_update ? (n + 1) % 2 : 0], messages);
+        do_not_optimize(messages.size());
+    }
+}
+
+// json消息Data里的整数或者bool字段，不存在时为0
+int data_field(const cJSON* data, const char* name) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(data, name);
+    if (cJSON_IsBool(item)) {
+        return cJSON_IsTrue(item) ? 1 : 0;
+    }
+    return cJSON_IsNumber(item) ? item->valueint : 0;
+}
+
+// 把一条转换器输出的json消息编码成CAN报文
+// @return reorganize_*的返回值，json解析失败或者不认识的MessageType返回-1
+int encode_can_frame(can::CanProtocol& protocol, const std::string& json, std::bitset<64>& frame) {
+    cJSON* root = cJSON_Parse(json.c_str());
+    const cJSON* data = cJSON_GetObjectItemCaseSensitive(root, "Data");
+    int ret = -1;
+    switch (data_field(data, "MessageType")) {
+        case 1: {
+            can::PositionMessage m = {};
+            m.type = 1;
+            m.cyclic_counter = data_field(data, "CyclicCounter");
+            m.path_index = data_field(data, "PathIndex");
+            m.offset = data_field(data, "Offset");
+            m.position_index = data_field(data, "PositionIndex");
+            m.position_age = data_field(data, "PositionAge");
+            m.speed = data_field(data, "Speed");
+            m.relative_heading = data_field(data, "RelativeHeading");
+            m.position_probability = data_field(data, "PositionProbability");
+            m.position_confidence = data_field(data, "PositionConfidence");
+            m.current_lane = data_field(data, "CurrentLane");
+            ret = protocol.reorganize_position(m, frame);
+            break;
+        }
+        case 2: {
+            can::SegmentMessage m = {};
+            m.type = 2;
+            m.cyclic_counter = data_field(data, "CyclicCounter");
+            m.retrans = data_field(data, "Retransmission");
+            m.path_index = data_field(data, "PathIndex");
+            m.offset = data_field(data, "Offset");
+            m.update = data_field(data, "Update");
+            m.functional_road_class = data_field(data, "FunctionalRoadClass");
+            m.form_of_way = data_field(data, "FormOfWay");
+            m.effective_speed_limit = data_field(data, "EffectiveSpeedLimit");
+            m.effective_speed_limit_type = data_field(data, "EffectiveSpeedLimitType");
+            m.number_of_lanes_in_driving_direction = data_field(data, "NumberOfLane");
+            m.number_of_lanes_in_opposite_direction = data_field(data, "NumberOfLaneOpposite");
+            m.tunnel = data_field(data, "Tunnel");
+            m.bridge = data_field(data, "Bridge");
+            m.divided_road = data_field(data, "DividedRoad");
+            m.built_up_area = data_field(data, "BuiltupArea");
+            m.complex_intersection = data_field(data, "ComplexIntersection");
+            m.relative_probability = data_field(data, "RelativeProbability");
+            m.part_of_calculated_route = data_field(data, "PartOfCalculatedRoute");
+            ret = protocol.reorganize_segment(m, frame);
+            break;
+        }
+        case 3: {
+            can::StubMessage m = {};
+            m.type = 3;
+            m.cyclic_counter = data_field(data, "CyclicCounter");
+            m.retrans = data_field(data, "Retransmission");
+            m.path_index = data_field(data, "PathIndex");
+            m.offset = data_field(data, "Offset");
+            m.update = data_field(data, "Update");
+            m.sub_path_index = data_field(data, "SubPathIndex");
+            m.turn_angle = data_field(data, "TurnAngle");
+            m.relative_probability = data_field(data, "RelativeProbability");
+            m.functional_road_class = data_field(data, "FunctionalRoadClass");
+            m.form_of_way = data_field(data, "FormOfWay");
+            m.number_of_lanes_in_driving_direction = data_field(data, "NumberOfLane");
+            m.number_of_lanes_in_opposite_direction = data_field(data, "NumberOfLaneOpposite");
+            m.complex_intersection = data_field(data, "ComplexIntersection");
+            m.right_of_way = data_field(data, "RightOfWay");
+            m.part_of_calculated_route = data_field(data, "PartOfCalculatedRoute");
+            m.last_stub_at_offset = data_field(data, "LastStubAtOffset");
+            ret = protocol.reorganize_stub(m, frame);
+            break;
+        }
+        case 4: {
+            can::ProfileShortMessage m = {};
+            m.type = 4;
+            m.cyclic_counter = data_field(data, "CyclicCounter");
+            m.retrans = data_field(data, "Retransmission");
+            m.path_index = data_field(data, "PathIndex");
+            m.offset = data_field(data, "Offset");
+            m.update = data_field(data, "Update");
+            m.profile_type = data_field(data, "ProfileType");
+            m.control_point = data_field(data, "ControlPoint");
+            m.value0 = data_field(data, "Value0");
+            m.distance1 = data_field(data, "Distance1");
+            m.value1 = data_field(data, "Value1");
+            m.accuracy = data_field(data, "Accuracy");
+            ret = protocol.reorganize_shortprofile(m, frame);
+            break;
+        }
+        case 5: {
+            can::ProfileLongMessage m;
+            m.type = 5;
+            m.cyclic_counter = data_field(data, "CyclicCounter");
+            m.retrans = data_field(data, "Retransmission");
+            m.path_index = data_field(data, "PathIndex");
+            m.offset = data_field(data, "Offset");
+            m.update = data_field(data, "Update");
+            m.profile_type = data_field(data, "ProfileType");
+            m.control_point = data_field(data, "ControlPoint");
+            // 经纬度的Value超过int范围
+            const cJSON* value = cJSON_GetObjectItemCaseSensitive(data, "Value");
+            m.value = cJSON_IsNumber(value) ? uint32_t(value->valuedouble) : 0;
+            ret = protocol.reorganize_longprofile(m, frame);
+            break;
+        }
+        default:
+            break;
+    }
+    cJSON_Delete(root);
+    return ret;
+}
+
+void bench_can_frames(BenchState& state, const Scale& scale) {
+    const ScaleData& data = scale_data(scale);
+    ReplayProtocol protocol;
+    protocol.set_log_level(protocol_v2::LOG_LEVEL_OFF);
+    ReplayEvent event;
+    event.type = protocol_v2::REPLAY_INPUT_EHP_INFO;
+    event.payload = data.ehp[0];
+    std::vector<std::string> messages;
+    protocol.replay(event, messages);
+
+    can::CanProtocol can_protocol;
+    for (size_t i = 0; i < messages.size(); i++) {
+        std::bitset<64> frame;
+        if (0 != encode_can_frame(can_protocol, messages[i], frame)) {
+            state.set_error("encode failed: " + messages[i].substr(0, 64));
+            return;
+        }
+    }
+
+    state.set_items_per_iteration(messages.size());
+    state.reset_timer();
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < messages.size(); i++) {
+            std::bitset<64> frame;
+            encode_can_frame(can_protocol, messages[i], frame);
+            sum += frame.to_ullong();
+        }
+        do_not_optimize(sum);
+    }
+}
+
+bool register_scale_cases() {
+    for (size_t i = 0; i < sizeof(SCALES) / sizeof(SCALES[0]); i++) {
+        const Scale& scale = SCALES[i];
+        std::string suffix = std::string("/") + scale.name;
+        BenchRegistrar("ehp_scale/parse" + suffix, [&scale](BenchState& state) {
+            bench_parse(state, scale);
+        });
+        BenchRegistrar("ehp_scale/full_update" + suffix, [&scale](BenchState& state) {
+            bench_update(state, scale, true);
+        });
+        BenchRegistrar("ehp_scale/same_version" + suffix, [&scale](BenchState& state) {
+            bench_update(state, scale, false);
+        });
+        BenchRegistrar("ehp_scale/can_frames" + suffix, [&scale](BenchState& state) {
+            bench_can_frames(state, scale);
+        });
+    }
+    return true;
+}
+
+const bool SCALE_CASES_REGISTERED = register_scale_cases();
+
+} // namespace
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,253 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 距离内核: 精确haversine、多项式批量haversine、标量等距圆柱近似、SIMD批量等距圆柱近似的吞吐对比，
+// 以及多项式haversine和快速模式相对精确haversine的误差检查；折线抽稀的误差上界检查和耗时
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include "bench_util.h"
+#include "geo_kernel.h"
+#include "geo_simplify.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+const size_t SEGMENT_COUNT = 4096;
+
+struct Segments {
+    std::vector<double> lon1;
+    std::vector<double> lat1;
+    std::vector<double> lon2;
+    std::vector<double> lat2;
+};
+
+// 以(center_lon, center_lat)为中心，随机生成长度不超过max_length米的线段，用固定种子保证每次一致
+Segments make_segments(size_t count, double center_lon, double center_lat, double lat_span, double max_length) {
+    Segments segments;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&seed]() {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return double(seed >> 11) / double(1ULL << 53);
+    };
+    for (size_t i = 0; i < count; i++) {
+        double lon = center_lon + (next() - 0.5) * 2.0;
+        double lat = center_lat + (next() - 0.5) * lat_span;
+        double length = next() * max_length;
+        double heading = next() * 2 * geo::PI;
+        double dlat = length * cos(heading) / geo::EARTH_RADIUS * 180.0 / geo::PI;
+        double dlon = length * sin(heading) / (geo::EARTH_RADIUS * cos(geo::rad(lat))) * 180.0 / geo::PI;
+        segments.lon1.push_back(lon);
+        segments.lat1.push_back(lat);
+        segments.lon2.push_back(lon + dlon);
+        segments.lat2.push_back(lat + dlat);
+    }
+    return segments;
+}
+
+const Segments& shanghai_segments() {
+    static const Segments segments = make_segments(SEGMENT_COUNT, 121.4, 31.2, 1.0, 1000.0);
+    return segments;
+}
+
+void bench_haversine_scalar(BenchState& state) {
+    const Segments& s = shanghai_segments();
+    state.set_items_per_iteration(SEGMENT_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < SEGMENT_COUNT; i++) {
+            double d = geo::haversine_distance(s.lon1[i], s.lat1[i], s.lon2[i], s.lat2[i]);
+            do_not_optimize(d);
+        }
+    }
+}
+
+void bench_equirectangular_scalar(BenchState& state) {
+    const Segments& s = shanghai_segments();
+    state.set_items_per_iteration(SEGMENT_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < SEGMENT_COUNT; i++) {
+            double d = geo::equirectangular_distance(s.lon1[i], s.lat1[i], s.lon2[i], s.lat2[i]);
+            do_not_optimize(d);
+        }
+    }
+}
+
+void bench_batch(BenchState& state, geo::DistanceMode mode) {
+    const Segments& s = shanghai_segments();
+    std::vector<double> distances(SEGMENT_COUNT);
+    state.set_items_per_iteration(SEGMENT_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        geo::distance_batch(s.lon1.data(), s.lat1.data(), s.lon2.data(), s.lat2.data(),
+                            distances.data(), SEGMENT_COUNT, mode);
+        do_not_optimize(distances.data());
+    }
+}
+
+// 1km以内的线段在不同纬度带上的最大相对误差，不满足geo_kernel.h里写明的误差上限时报错。
+// 同时要求批量内核和标量实现的结果一致
+double max_relative_error(BenchState& state, double center_lat, double lat_span) {
+    Segments s = make_segments(SEGMENT_COUNT, 121.4, center_lat, lat_span, 1000.0);
+    std::vector<double> fast(SEGMENT_COUNT);
+    geo::distance_batch(s.lon1.data(), s.lat1.data(), s.lon2.data(), s.lat2.data(),
+                        fast.data(), SEGMENT_COUNT, geo::DISTANCE_EQUIRECTANGULAR);
+    double max_error = 0.0;
+    for (size_t i = 0; i < SEGMENT_COUNT; i++) {
+        double scalar = geo::equirectangular_distance(s.lon1[i], s.lat1[i], s.lon2[i], s.lat2[i]);
+        if (0 != memcmp(&scalar, &fast[i], sizeof(double))) {
+            state.set_error(std::string("batch kernel differs from scalar: ") + geo::simd_kernel_name());
+        }
+        double exact = geo::haversine_distance(s.lon1[i], s.lat1[i], s.lon2[i], s.lat2[i]);
+        if (exact > 1.0) {
+            max_error = std::max(max_error, fabs(fast[i] - exact) / exact);
+        }
+    }
+    return max_error;
+}
+
+void bench_equirectangular_error(BenchState& state) {
+    double error_70 = 0.0;
+    double error_85 = 0.0;
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        error_70 = std::max(max_relative_error(state, 0.0, 140.0), error_70);
+        error_85 = std::max(max_relative_error(state, 0.0, 170.0), error_85);
+    }
+    if (error_70 >= 1e-7 || error_85 >= 1e-6) {
+        state.set_error("relative error out of bound. lat70:" + std::to_string(error_70) +
+                        " lat85:" + std::to_string(error_85));
+    }
+    do_not_optimize(error_70);
+}
+
+// long double算的haversine，作为多项式haversine的参考值
+double reference_haversine(double lon1, double lat1, double lon2, double lat2) {
+    const long double deg = acosl(-1.0L) / 180.0L;
+    long double a = ((long double)lat1 - lat2) * deg;
+    long double b = ((long double)lon1 - lon2) * deg;
+    long double sin_a = sinl(a / 2);
+    long double sin_b = sinl(b / 2);
+    long double h = sin_a * sin_a + cosl(lat1 * deg) * cosl(lat2 * deg) * sin_b * sin_b;
+    return 2 * asinl(sqrtl(h)) * geo::EARTH_RADIUS;
+}
+
+// 多项式haversine不限线段长度: 1km以内的短线段，以及全球范围的任意两点(离对跖点130km以内的不计，见geo_kernel.h)。
+// 批量结果和线段在数组中的位置无关，按奇数长度的子数组再算一遍比较
+void bench_haversine_poly_error(BenchState& state) {
+    Segments short_segments = make_segments(SEGMENT_COUNT, 121.4, 0.0, 170.0, 1000.0);
+    Segments long_segments = make_segments(SEGMENT_COUNT, 0.0, 0.0, 178.0, 0.0);
+    for (size_t i = 0; i < SEGMENT_COUNT; i++) {
+        long_segments.lon1[i] = (long_segments.lon1[i] - 0.0) * 179.0;
+        long_segments.lon2[i] = -long_segments.lon1[i] * 0.5 + (i % 7) * 25.0;
+        long_segments.lat2[i] = -long_segments.lat1[i] + (i % 5) * 0.001;
+    }
+    const Segments* cases[] = {&short_segments, &long_segments};
+    double max_error = 0.0;
+    std::vector<double> poly(SEGMENT_COUNT);
+    std::vector<double> shifted(SEGMENT_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (const Segments* s : cases) {
+            geo::distance_batch(s->lon1.data(), s->lat1.data(), s->lon2.data(), s->lat2.data(),
+                                poly.data(), SEGMENT_COUNT, geo::DISTANCE_HAVERSINE_POLY);
+            geo::distance_batch(s->lon1.data() + 1, s->lat1.data() + 1, s->lon2.data() + 1, s->lat2.data() + 1,
+                                shifted.data(), SEGMENT_COUNT - 2, geo::DISTANCE_HAVERSINE_POLY);
+            for (size_t i = 0; i < SEGMENT_COUNT; i++) {
+                if (i >= 1 && i + 1 < SEGMENT_COUNT && 0 != memcmp(&poly[i], &shifted[i - 1], sizeof(double))) {
+                    state.set_error("batch result depends on position at " + std::to_string(i));
+                }
+                double reference = reference_haversine(s->lon1[i], s->lat1[i], s->lon2[i], s->lat2[i]);
+                if (reference > 1.0 && reference < geo::EARTH_RADIUS * (geo::PI - 0.02)) {
+                    max_error = std::max(max_error, fabs(poly[i] - reference) / reference);
+                }
+            }
+        }
+    }
+    if (max_error >= 1e-13) {
+        state.set_error("relative error out of bound: " + std::to_string(max_error * 1e13) + "e-13");
+    }
+    do_not_optimize(max_error);
+}
+
+// 一条约2km、2000个形点的折线，查询点在折线附近随机分布
+void bench_nearest_segment(BenchState& state) {
+    static const Segments s = make_segments(SEGMENT_COUNT, 121.4, 31.2, 0.02, 1.0);
+    const size_t point_count = 2000;
+    std::vector<double> lonlat;
+    for (size_t i = 0; i < point_count; i++) {
+        lonlat.push_back(121.4 + i * 0.00001);
+        lonlat.push_back(31.2 + (s.lat2[i] - s.lat1[i]) * 100);
+    }
+    state.set_items_per_iteration(SEGMENT_COUNT * (point_count - 1));
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < SEGMENT_COUNT; i++) {
+            double lon = 121.4 + (s.lon1[i] - 120.4) * 0.01;
+            int index = geo::nearest_segment(lon, s.lat1[i], lonlat.data(), point_count);
+            do_not_optimize(index);
+        }
+    }
+}
+
+// 约2km的弯道，形点间隔1m，横向有0.2m以内的抖动，容差1m。
+// 每个抽掉的形点到包含它的保留线段的距离不超过容差，耗时包含每次拷贝输入
+void bench_simplify(BenchState& state) {
+    const size_t point_count = 2000;
+    const double tolerance = 1.0;
+    const double meters_per_degree = geo::EARTH_RADIUS * geo::PI / 180.0;
+    static const Segments s = make_segments(point_count, 121.4, 31.2, 0.02, 0.2);
+    std::vector<double> input;
+    for (size_t i = 0; i < point_count; i++) {
+        double east = 1000.0 * sin(i / 1000.0) + (s.lon2[i] - s.lon1[i]) * meters_per_degree;
+        double north = 1000.0 * (1.0 - cos(i / 1000.0)) + (s.lat2[i] - s.lat1[i]) * meters_per_degree;
+        input.push_back(121.4 + east / (meters_per_degree * cos(geo::rad(31.2))));
+        input.push_back(31.2 + north / meters_per_degree);
+    }
+
+    std::vector<double> lonlat = input;
+    std::vector<uint8_t> keep(point_count);
+    size_t count = geo::simplify_polyline(lonlat.data(), point_count, tolerance, keep.data());
+    if (count * 4 > point_count) {
+        state.set_error("kept " + std::to_string(count) + " of " + std::to_string(point_count) + " points");
+        return;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < point_count; i++) {
+        if (keep[i]) {
+            kept++;
+            continue;
+        }
+        const double* p = &input[2 * i];
+        const double* a = &lonlat[2 * (kept - 1)];
+        double d = geo::local_segment_distance(p[0], p[1], cos(geo::rad(p[1])), a[0], a[1], a[2], a[3]);
+        if (d > tolerance * 1.001) {
+            state.set_error("point " + std::to_string(i) + " off by " + std::to_string(d) + "m");
+            return;
+        }
+    }
+
+    state.set_items_per_iteration(point_count);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        lonlat = input;
+        count = geo::simplify_polyline(lonlat.data(), point_count, tolerance, keep.data());
+        do_not_optimize(count);
+    }
+}
+
+ADAS_BENCH("geo_distance/haversine_scalar", bench_haversine_scalar);
+ADAS_BENCH("geo_distance/haversine_batch", [](BenchState& state) {
+    bench_batch(state, geo::DISTANCE_HAVERSINE);
+});
+ADAS_BENCH("geo_distance/haversine_poly_batch", [](BenchState& state) {
+    bench_batch(state, geo::DISTANCE_HAVERSINE_POLY);
+});
+ADAS_BENCH("geo_distance/haversine_poly_error", bench_haversine_poly_error);
+ADAS_BENCH("geo_distance/equirectangular_scalar", bench_equirectangular_scalar);
+ADAS_BENCH("geo_distance/equirectangular_batch", [](BenchState& state) {
+    bench_batch(state, geo::DISTANCE_EQUIRECTANGULAR);
+});
+ADAS_BENCH("geo_distance/equirectangular_error", bench_equirectangular_error);
+ADAS_BENCH("geo_nearest_segment/polyline_2000", bench_nearest_segment);
+ADAS_BENCH("geo_simplify/polyline_2000", bench_simplify);
+
+} // namespace
+} // namespace bench
+} // namespace adas
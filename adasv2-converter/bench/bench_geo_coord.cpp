@@ -0,0 +1,122 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 坐标转换: 单点函数和批量函数的吞吐对比。精度(公开参考点、求逆、批量和单点的差别)
+// 由test/unit/test_geo_coord.cpp检查
+
+#include <vector>
+
+#include "bench_util.h"
+#include "geo_coord.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+const size_t POINT_COUNT = 4096;
+
+struct ReferencePoint {
+    geo::CoordType from;
+    geo::CoordType to;
+    double lon;
+    double lat;
+};
+
+// 北京的点和境外的点
+const ReferencePoint REFERENCE_POINTS[] = {
+    {geo::COORD_WGS84, geo::COORD_GCJ02, 116.404, 39.915},
+    {geo::COORD_GCJ02, geo::COORD_BD09, 116.404, 39.915},
+    {geo::COORD_BD09, geo::COORD_GCJ02, 116.404, 39.915},
+    {geo::COORD_WGS84, geo::COORD_GCJ02, 139.6917, 35.6895},
+    {geo::COORD_GCJ02, geo::COORD_WGS84, -122.4194, 37.7749},
+};
+
+void convert_one(geo::CoordType from, geo::CoordType to, double lon, double lat, double& out_lon, double& out_lat) {
+    if (geo::COORD_WGS84 == from) {
+        geo::wgs84_to_gcj02(lon, lat, lon, lat);
+    } else if (geo::COORD_BD09 == from) {
+        geo::bd09_to_gcj02(lon, lat, lon, lat);
+    }
+    if (geo::COORD_WGS84 == to) {
+        geo::gcj02_to_wgs84(lon, lat, lon, lat);
+    } else if (geo::COORD_BD09 == to) {
+        geo::gcj02_to_bd09(lon, lat, lon, lat);
+    }
+    out_lon = lon;
+    out_lat = lat;
+}
+
+// 中国境内的随机点，用固定种子保证每次一致
+const std::vector<double>& china_points() {
+    static std::vector<double> points;
+    if (points.empty()) {
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        auto next = [&seed]() {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            return double(seed >> 11) / double(1ULL << 53);
+        };
+        for (size_t i = 0; i < POINT_COUNT; i++) {
+            points.push_back(75.0 + next() * 60.0);
+            points.push_back(18.0 + next() * 35.0);
+        }
+    }
+    return points;
+}
+
+void bench_reference_points(BenchState& state) {
+    const size_t count = sizeof(REFERENCE_POINTS) / sizeof(REFERENCE_POINTS[0]);
+    state.set_items_per_iteration(count);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < count; i++) {
+            const ReferencePoint& p = REFERENCE_POINTS[i];
+            double out[2];
+            convert_one(p.from, p.to, p.lon, p.lat, out[0], out[1]);
+            do_not_optimize(out);
+        }
+    }
+}
+
+void bench_scalar(BenchState& state, geo::CoordType from, geo::CoordType to) {
+    const std::vector<double>& points = china_points();
+    state.set_items_per_iteration(POINT_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < POINT_COUNT; i++) {
+            double out[2];
+            convert_one(from, to, points[2 * i], points[2 * i + 1], out[0], out[1]);
+            do_not_optimize(out);
+        }
+    }
+}
+
+void bench_batch(BenchState& state, geo::CoordType from, geo::CoordType to) {
+    const std::vector<double>& points = china_points();
+    std::vector<double> out(points.size());
+    state.set_items_per_iteration(POINT_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        geo::convert_coords(points.data(), out.data(), POINT_COUNT, from, to);
+        do_not_optimize(out.data());
+    }
+}
+
+ADAS_BENCH("geo_coord/reference_points", bench_reference_points);
+ADAS_BENCH("geo_coord/wgs84_to_gcj02_scalar", [](BenchState& state) {
+    bench_scalar(state, geo::COORD_WGS84, geo::COORD_GCJ02);
+});
+ADAS_BENCH("geo_coord/wgs84_to_gcj02_batch", [](BenchState& state) {
+    bench_batch(state, geo::COORD_WGS84, geo::COORD_GCJ02);
+});
+ADAS_BENCH("geo_coord/gcj02_to_wgs84_scalar", [](BenchState& state) {
+    bench_scalar(state, geo::COORD_GCJ02, geo::COORD_WGS84);
+});
+ADAS_BENCH("geo_coord/gcj02_to_wgs84_batch", [](BenchState& state) {
+    bench_batch(state, geo::COORD_GCJ02, geo::COORD_WGS84);
+});
+ADAS_BENCH("geo_coord/wgs84_to_bd09_scalar", [](BenchState& state) {
+    bench_scalar(state, geo::COORD_WGS84, geo::COORD_BD09);
+});
+ADAS_BENCH("geo_coord/wgs84_to_bd09_batch", [](BenchState& state) {
+    bench_batch(state, geo::COORD_WGS84, geo::COORD_BD09);
+});
+
+} // namespace
+} // namespace bench
+} // namespace adas
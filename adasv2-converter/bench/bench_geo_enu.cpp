@@ -0,0 +1,164 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 局部切平面坐标系: 换算往返和距离的精度检查，
+// 40个形点的折线上经纬度最近线段和局部坐标投影的耗时对比
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "bench_util.h"
+#include "geo_enu.h"
+#include "geo_kernel.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+const double ORIGIN_LON = 121.4;
+const double ORIGIN_LAT = 31.2;
+const double METERS_PER_DEGREE = geo::EARTH_RADIUS * geo::PI / 180.0;
+const size_t SHAPE_POINT_COUNT = 40;
+const size_t QUERY_COUNT = 1024;
+
+struct Sample {
+    geo::LocalFrame frame;
+    std::vector<double> shape;   // 交错存放的lon, lat
+    std::vector<float> shape_east;
+    std::vector<float> shape_north;
+    std::vector<double> queries; // 交错存放的lon, lat
+};
+
+// 原点附近10km处一条弯曲的折线，形点间隔约25m，查询点在折线两侧30m以内
+const Sample& sample() {
+    static Sample sample;
+    if (!sample.shape.empty()) {
+        return sample;
+    }
+    sample.frame.reset(ORIGIN_LON, ORIGIN_LAT);
+    double lon_scale = METERS_PER_DEGREE * cos(geo::rad(ORIGIN_LAT));
+    for (size_t i = 0; i < SHAPE_POINT_COUNT; i++) {
+        double east = 10000.0 + 25.0 * i;
+        double north = 6000.0 + 80.0 * sin(i / 6.0);
+        sample.shape.push_back(ORIGIN_LON + east / lon_scale);
+        sample.shape.push_back(ORIGIN_LAT + north / METERS_PER_DEGREE);
+    }
+    sample.shape_east.resize(SHAPE_POINT_COUNT);
+    sample.shape_north.resize(SHAPE_POINT_COUNT);
+    sample.frame.to_local(sample.shape.data(), SHAPE_POINT_COUNT,
+            sample.shape_east.data(), sample.shape_north.data());
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&seed]() {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return double(seed >> 11) / double(1ULL << 53);
+    };
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        double east = 10000.0 + next() * 25.0 * (SHAPE_POINT_COUNT - 1);
+        double north = 6000.0 + 80.0 * sin((east - 10000.0) / 150.0) + (next() - 0.5) * 60.0;
+        sample.queries.push_back(ORIGIN_LON + east / lon_scale);
+        sample.queries.push_back(ORIGIN_LAT + north / METERS_PER_DEGREE);
+    }
+    return sample;
+}
+
+// 往返误差小于1e-9度，20km以内两点的平面距离和大圆距离相对误差小于1e-5
+void bench_to_local(BenchState& state) {
+    geo::LocalFrame frame(ORIGIN_LON, ORIGIN_LAT);
+    const double offsets[][2] = {{0.0, 0.0}, {0.05, 0.0}, {0.0, -0.15}, {0.15, 0.12}, {-0.2, 0.1}};
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        double lon = ORIGIN_LON + offsets[i][0];
+        double lat = ORIGIN_LAT + offsets[i][1];
+        double east = 0.0;
+        double north = 0.0;
+        double back_lon = 0.0;
+        double back_lat = 0.0;
+        frame.to_local(lon, lat, east, north);
+        frame.to_lonlat(east, north, back_lon, back_lat);
+        if (fabs(back_lon - lon) > 1e-9 || fabs(back_lat - lat) > 1e-9) {
+            state.set_error("to_local -> to_lonlat round trip mismatch");
+            return;
+        }
+        double distance = geo::haversine_distance(ORIGIN_LON, ORIGIN_LAT, lon, lat);
+        if (distance < 20000.0 && fabs(sqrt(east * east + north * north) - distance) > 1e-5 * distance) {
+            char message[128];
+            snprintf(message, sizeof(message), "local distance error at %.0fm", distance);
+            state.set_error(message);
+            return;
+        }
+    }
+
+    const Sample& s = sample();
+    std::vector<float> east(QUERY_COUNT);
+    std::vector<float> north(QUERY_COUNT);
+    state.set_items_per_iteration(QUERY_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        s.frame.to_local(s.queries.data(), QUERY_COUNT, east.data(), north.data());
+        do_not_optimize(east.data());
+        do_not_optimize(north.data());
+    }
+}
+
+void bench_nearest_lonlat(BenchState& state) {
+    const Sample& s = sample();
+    state.set_items_per_iteration(QUERY_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < QUERY_COUNT; i++) {
+            double ratio = 0.0;
+            int index = geo::nearest_segment(s.queries[2 * i], s.queries[2 * i + 1], s.shape.data(),
+                    SHAPE_POINT_COUNT, &ratio);
+            do_not_optimize(index);
+            do_not_optimize(ratio);
+        }
+    }
+}
+
+// 查询点的换算算在耗时里，投影距离和经纬度下的结果相差不超过1cm
+void bench_project_local(BenchState& state) {
+    const Sample& s = sample();
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        double east = 0.0;
+        double north = 0.0;
+        s.frame.to_local(s.queries[2 * i], s.queries[2 * i + 1], east, north);
+        geo::LocalProjection projection;
+        geo::project_local(east, north, s.shape_east.data(), s.shape_north.data(), SHAPE_POINT_COUNT, projection);
+
+        double ratio = 0.0;
+        int index = geo::nearest_segment(s.queries[2 * i], s.queries[2 * i + 1], s.shape.data(),
+                SHAPE_POINT_COUNT, &ratio);
+        ratio = std::min(std::max(ratio, 0.0), 1.0); // nearest_segment的ratio没有截断，首末线段可能超出[0, 1]
+        const double* a = &s.shape[2 * index];
+        double lon = a[0] + ratio * (a[2] - a[0]);
+        double lat = a[1] + ratio * (a[3] - a[1]);
+        double expected = geo::haversine_distance(s.queries[2 * i], s.queries[2 * i + 1], lon, lat);
+        if (fabs(projection.distance - expected) > 0.01) {
+            char message[128];
+            snprintf(message, sizeof(message), "query %zu distance %.3f expected %.3f",
+                    i, projection.distance, expected);
+            state.set_error(message);
+            return;
+        }
+    }
+
+    state.set_items_per_iteration(QUERY_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < QUERY_COUNT; i++) {
+            double east = 0.0;
+            double north = 0.0;
+            s.frame.to_local(s.queries[2 * i], s.queries[2 * i + 1], east, north);
+            geo::LocalProjection projection;
+            geo::project_local(east, north, s.shape_east.data(), s.shape_north.data(),
+                    SHAPE_POINT_COUNT, projection);
+            do_not_optimize(projection);
+        }
+    }
+}
+
+ADAS_BENCH("geo_enu/to_local", bench_to_local);
+ADAS_BENCH("geo_enu/nearest_segment_lonlat", bench_nearest_lonlat);
+ADAS_BENCH("geo_enu/project_local", bench_project_local);
+
+} // namespace
+} // namespace bench
+} // namespace adas
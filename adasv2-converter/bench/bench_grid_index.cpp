@@ -0,0 +1,141 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// link线段网格索引: 10km主路径，每200m一条500m的侧路，形点间隔10m，
+// 半径查询、批量建索引和单条link增量更新的耗时
+
+#include <math.h>
+#include <vector>
+
+#include "bench_util.h"
+#include "geo_grid_index.h"
+#include "geo_kernel.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+const double ORIGIN_LON = 121.4;
+const double ORIGIN_LAT = 31.2;
+const double METERS_PER_DEGREE = geo::EARTH_RADIUS * geo::PI / 180.0;
+
+struct Horizon {
+    std::vector<std::vector<double> > links;
+};
+
+void append_point(std::vector<double>& link, double east, double north) {
+    link.push_back(ORIGIN_LON + east / (METERS_PER_DEGREE * cos(geo::rad(ORIGIN_LAT))));
+    link.push_back(ORIGIN_LAT + north / METERS_PER_DEGREE);
+}
+
+// 主路径按100m一条link切开，主路径略有弯曲
+const Horizon& sample_horizon() {
+    static Horizon horizon;
+    if (!horizon.links.empty()) {
+        return horizon;
+    }
+    for (int start = 0; start < 10000; start += 100) {
+        std::vector<double> link;
+        for (int s = start; s <= start + 100; s += 10) {
+            append_point(link, s, 200.0 * sin(s / 1500.0));
+        }
+        horizon.links.push_back(link);
+    }
+    for (int start = 200; start < 10000; start += 200) {
+        std::vector<double> link;
+        double north = 200.0 * sin(start / 1500.0);
+        for (int s = 0; s <= 500; s += 10) {
+            append_point(link, start + s * 0.6, north + s * 0.8);
+        }
+        horizon.links.push_back(link);
+    }
+    return horizon;
+}
+
+void build_index(geo::SegmentGridIndex& index) {
+    const Horizon& horizon = sample_horizon();
+    for (size_t i = 0; i < horizon.links.size(); i++) {
+        index.insert(i, horizon.links[i].data(), horizon.links[i].size() / 2);
+    }
+}
+
+void bench_build(BenchState& state) {
+    const Horizon& horizon = sample_horizon();
+    state.set_items_per_iteration(horizon.links.size());
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        geo::SegmentGridIndex index;
+        build_index(index);
+        do_not_optimize(index.segment_count());
+    }
+}
+
+// 暴力遍历所有线段，统计半径内的线段数，用于核对query的结果
+size_t brute_force_count(double lon, double lat, double radius) {
+    const Horizon& horizon = sample_horizon();
+    double cos_lat = cos(geo::rad(lat));
+    size_t count = 0;
+    for (size_t i = 0; i < horizon.links.size(); i++) {
+        const std::vector<double>& link = horizon.links[i];
+        for (size_t k = 0; k + 3 < link.size(); k += 2) {
+            if (geo::local_segment_distance(lon, lat, cos_lat, link[k], link[k + 1], link[k + 2], link[k + 3])
+                    <= radius) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void bench_query(BenchState& state) {
+    geo::SegmentGridIndex index;
+    build_index(index);
+
+    std::vector<double> queries;
+    for (int s = 0; s < 10000; s += 7) {
+        append_point(queries, s, 200.0 * sin(s / 1500.0) + (s % 50) - 25);
+    }
+    size_t query_count = queries.size() / 2;
+
+    std::vector<geo::SegmentHit> hits;
+    for (size_t i = 0; i < query_count; i += 97) {
+        index.query(queries[2 * i], queries[2 * i + 1], 50.0, hits);
+        if (hits.size() != brute_force_count(queries[2 * i], queries[2 * i + 1], 50.0)) {
+            state.set_error("mismatch with brute force");
+            return;
+        }
+    }
+
+    uint64_t total_hits = 0;
+    state.set_items_per_iteration(query_count);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < query_count; i++) {
+            index.query(queries[2 * i], queries[2 * i + 1], 50.0, hits);
+            total_hits += hits.size();
+        }
+    }
+    if (0 == total_hits) {
+        state.set_error("no hits");
+    }
+    do_not_optimize(total_hits);
+}
+
+// 新的horizon下发时，只有前方新出现的link需要插入，后方走过的link需要删除
+void bench_incremental_update(BenchState& state) {
+    geo::SegmentGridIndex index;
+    build_index(index);
+    const Horizon& horizon = sample_horizon();
+    state.set_items_per_iteration(1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        uint64_t id = n % horizon.links.size();
+        index.remove(id);
+        index.insert(id, horizon.links[id].data(), horizon.links[id].size() / 2);
+    }
+    do_not_optimize(index.size());
+}
+
+ADAS_BENCH("geo_grid_index/build_10km_horizon", bench_build);
+ADAS_BENCH("geo_grid_index/query_50m", bench_query);
+ADAS_BENCH("geo_grid_index/remove_insert_link", bench_incremental_update);
+
+} // namespace
+} // namespace bench
+} // namespace adas
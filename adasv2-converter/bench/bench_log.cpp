@@ -0,0 +1,200 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 二进制日志: 写日志线程上的耗时，和关掉的级别、原来拼接字符串的方式对比。
+// 日志写到临时目录，后台线程的写文件开销不算在调用方。
+// 按文件切分的mmap写入: 后台线程追加一块数据的耗时。
+// 时间前缀: 按秒缓存的format_log_time和原来localtime_r + stringstream的实现对比
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "bench_util.h"
+#include "adas_v2_log.h"
+#include "adas_v2_utility.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+using protocol_v2::BinaryLogger;
+using protocol_v2::LogRotation;
+using protocol_v2::LogSegmentWriter;
+
+const int64_t LINK_ID = 16294306630;
+const double LINK_OFFSET = 64.990585;
+const double DISTANCE = 0.212996;
+
+// 每个case一个临时目录，只保留一个不压缩的文件，结束时删掉
+class TempLogDir {
+public:
+    TempLogDir() {
+        char path[] = "/tmp/adasv2_bench_log_XXXXXX";
+        if (nullptr != mkdtemp(path)) {
+            _dir = path;
+        }
+    }
+    ~TempLogDir() {
+        if (!_dir.empty()) {
+            unlink(file().c_str());
+            rmdir(_dir.c_str());
+        }
+    }
+
+    bool valid() const {
+        return !_dir.empty();
+    }
+
+    std::string file() const {
+        return _dir + "/bench.log";
+    }
+
+    static LogRotation rotation() {
+        LogRotation rotation;
+        rotation.segment_size = 4 * 1024 * 1024;
+        rotation.max_segments = 1;
+        rotation.compress = false;
+        return rotation;
+    }
+
+private:
+    std::string _dir;
+};
+
+void bench_binary(BenchState& state) {
+    TempLogDir dir;
+    BinaryLogger logger;
+    if (!dir.valid() || 0 != logger.open(dir.file(), TempLogDir::rotation())) {
+        state.set_error("open log file failed");
+        return;
+    }
+    state.set_items_per_iteration(1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        ADASV2_LOG(logger, protocol_v2::LOG_LEVEL_DEBUG,
+                   "input loc matched on main path. linkid:%ld linkindex:%ld linkoffset:%f distance:%f",
+                   LINK_ID, int64_t(n & 63), LINK_OFFSET, DISTANCE);
+    }
+    logger.close();
+}
+
+// 一块256字节，4MB的文件写满后切换
+void bench_segment_append(BenchState& state) {
+    TempLogDir dir;
+    LogSegmentWriter writer;
+    if (!dir.valid() || 0 != writer.open(dir.file(), TempLogDir::rotation(), "ADV2BLOG")) {
+        state.set_error("open log file failed");
+        return;
+    }
+    uint8_t block[256] = {};
+    state.set_bytes_per_iteration(sizeof(block));
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        if (writer.available() < sizeof(block)) {
+            writer.rotate();
+        }
+        block[0] = n;
+        writer.append(block, sizeof(block));
+    }
+    writer.close();
+}
+
+int64_t evaluated_count = 0;
+
+int64_t count_evaluation(int64_t value) {
+    evaluated_count++;
+    return value;
+}
+
+// 运行时关掉的级别: 只剩一次原子读，参数不求值
+void bench_disabled(BenchState& state) {
+    BinaryLogger logger;
+    logger.set_level(protocol_v2::LOG_LEVEL_INFO);
+    evaluated_count = 0;
+    state.set_items_per_iteration(1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        ADASV2_LOG(logger, protocol_v2::LOG_LEVEL_DEBUG, "input loc linkindex:%ld", count_evaluation(n & 63));
+    }
+    if (0 != evaluated_count) {
+        state.set_error("arguments of disabled log evaluated");
+    }
+}
+
+// 原来的LOG: 时间、文件行号和参数都在调用线程上转成字符串
+void bench_string_concat(BenchState& state) {
+    state.set_items_per_iteration(1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        std::string line = protocol_v2::log_time() + "[" + std::string(__FILE__) + ":" +
+                std::to_string(__LINE__) + "]" + "input loc matched on main path. linkid:" +
+                std::to_string(LINK_ID) + " linkindex:" + std::to_string(int64_t(n & 63)) +
+                " linkoffset:" + std::to_string(LINK_OFFSET) + " distance:" + std::to_string(DISTANCE);
+        do_not_optimize(line.data());
+    }
+}
+
+// 原来的log_time
+std::string stream_log_time(uint64_t time_ms) {
+    time_t seconds = time_ms / 1000;
+    struct tm buf;
+    localtime_r(&seconds, &buf);
+    std::stringstream ss;
+    ss << std::put_time(&buf, "%Y-%m-%d %H:%M:%S");
+    ss << '.' << std::setfill('0') << std::setw(3) << time_ms % 1000;
+    return ss.str();
+}
+
+// 1ms一条，每1000条跨一秒
+const uint64_t TIME_BASE_MS = 1714536000000ULL;
+const uint64_t TIME_COUNT = 4096;
+
+void bench_time_stream(BenchState& state) {
+    state.set_items_per_iteration(TIME_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (uint64_t i = 0; i < TIME_COUNT; i++) {
+            std::string text = stream_log_time(TIME_BASE_MS + i);
+            do_not_optimize(text.data());
+        }
+    }
+}
+
+void bench_time_cached(BenchState& state) {
+    char text[protocol_v2::LOG_TIME_LENGTH + 1];
+    for (uint64_t i = 0; i < TIME_COUNT; i += 7) {
+        protocol_v2::format_log_time(TIME_BASE_MS + i * 997, text);
+        if (stream_log_time(TIME_BASE_MS + i * 997) != text) {
+            state.set_error(std::string("format_log_time differs: ") + text);
+            return;
+        }
+    }
+
+    state.set_items_per_iteration(TIME_COUNT);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (uint64_t i = 0; i < TIME_COUNT; i++) {
+            protocol_v2::format_log_time(TIME_BASE_MS + i, text);
+            do_not_optimize(text);
+        }
+    }
+}
+
+// 取时间加格式化，即现在的log_time()
+void bench_log_time(BenchState& state) {
+    state.set_items_per_iteration(1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        std::string text = protocol_v2::log_time();
+        do_not_optimize(text.data());
+    }
+}
+
+ADAS_BENCH("log/binary", bench_binary);
+ADAS_BENCH("log/disabled", bench_disabled);
+ADAS_BENCH("log/segment_append", bench_segment_append);
+ADAS_BENCH("log/string_concat", bench_string_concat);
+ADAS_BENCH("log/time_stream", bench_time_stream);
+ADAS_BENCH("log/time_cached", bench_time_cached);
+ADAS_BENCH("log/log_time", bench_log_time);
+
+} // namespace
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,237 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 用法: bench_bin [--min_time=秒] [--json=文件] [过滤子串...]
+// 不带过滤参数时运行所有注册的case。--json把结果按Google Benchmark的JSON格式写到文件，
+// 不同提交的结果可以直接用它的tools/compare.py对比:
+//   compare.py benchmarks base.json new.json
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "cJSON.h"
+#include "bench_util.h"
+
+namespace adas {
+namespace bench {
+
+std::vector<BenchCase>& bench_registry() {
+    static std::vector<BenchCase> registry;
+    return registry;
+}
+
+std::string read_data_file(const std::string& name) {
+    std::string path = name;
+    if (name.empty() || '/' != name[0]) {
+        path = std::string(ADASV2_DATA_DIR) + "/" + name;
+    }
+
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        fprintf(stderr, "open data file failed. %s\n", path.c_str());
+        return "";
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+std::vector<std::string> read_data_lines(const std::string& name) {
+    std::vector<std::string> lines;
+    std::stringstream ss(read_data_file(name));
+    std::string line;
+    while (std::getline(ss, line)) {
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+} // namespace bench
+} // namespace adas
+
+using adas::bench::BenchCase;
+using adas::bench::BenchState;
+
+static bool match_filters(const std::string& name, const std::vector<std::string>& filters) {
+    if (filters.empty()) {
+        return true;
+    }
+    for (size_t i = 0; i < filters.size(); i++) {
+        if (std::string::npos != name.find(filters[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations = 0;
+    double real_ns = 0.0; // 每次迭代
+    double cpu_ns = 0.0;
+    double bytes_per_second = 0.0;
+    double items_per_second = 0.0;
+    std::string label;
+    std::string error;
+};
+
+static double thread_cpu_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 迭代次数从1开始翻倍，直到一次运行超过min_time。
+// cpu时间按整个调用统计，包括reset_timer之前的准备，最多取到real_time
+static BenchResult run_case(const BenchCase& bench_case, double min_time) {
+    uint64_t iterations = 1;
+    double elapsed = 0.0;
+    double cpu = 0.0;
+    BenchState state(iterations);
+    while (true) {
+        state = BenchState(iterations);
+        double cpu_start = thread_cpu_seconds();
+        auto start = std::chrono::steady_clock::now();
+        bench_case.func(state);
+        auto end = std::chrono::steady_clock::now();
+        cpu = thread_cpu_seconds() - cpu_start;
+        if (state.timer_reset()) {
+            start = state.start();
+        }
+        elapsed = std::chrono::duration<double>(end - start).count();
+        if (!state.error().empty() || elapsed >= min_time || iterations >= (1ULL << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    BenchResult result;
+    result.name = bench_case.name;
+    result.iterations = iterations;
+    if (!state.error().empty()) {
+        result.error = state.error();
+        printf("%-48s FAILED: %s\n", bench_case.name.c_str(), state.error().c_str());
+        return result;
+    }
+
+    result.real_ns = elapsed * 1e9 / iterations;
+    result.cpu_ns = std::min(cpu, elapsed) * 1e9 / iterations;
+    printf("%-48s %12llu iters %14.1f ns/iter", bench_case.name.c_str(),
+           (unsigned long long)iterations, result.real_ns);
+    if (0 != state.bytes_per_iteration()) {
+        result.bytes_per_second = state.bytes_per_iteration() * iterations / elapsed;
+        printf(" %10.1f MB/s", result.bytes_per_second / 1e6);
+    }
+    if (0 != state.items_per_iteration()) {
+        result.items_per_second = state.items_per_iteration() * iterations / elapsed;
+        printf(" %10.2f M items/s", result.items_per_second / 1e6);
+    }
+    result.label = state.label();
+    if (!result.label.empty()) {
+        printf(" %s", result.label.c_str());
+    }
+    printf("\n");
+    return result;
+}
+
+static int write_json(const std::string& file, const char* executable, const std::vector<BenchResult>& results) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON* context = cJSON_AddObjectToObject(root, "context");
+    char text[256];
+    time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S%z", &local);
+    cJSON_AddStringToObject(context, "date", text);
+    if (0 == gethostname(text, sizeof(text))) {
+        text[sizeof(text) - 1] = '\0';
+        cJSON_AddStringToObject(context, "host_name", text);
+    }
+    cJSON_AddStringToObject(context, "executable", executable);
+    cJSON_AddNumberToObject(context, "num_cpus", sysconf(_SC_NPROCESSORS_ONLN));
+    cJSON_AddStringToObject(context, "library_build_type", "release");
+
+    cJSON* benchmarks = cJSON_AddArrayToObject(root, "benchmarks");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", result.name.c_str());
+        cJSON_AddStringToObject(item, "run_name", result.name.c_str());
+        cJSON_AddStringToObject(item, "run_type", "iteration");
+        cJSON_AddNumberToObject(item, "repetitions", 1);
+        cJSON_AddNumberToObject(item, "repetition_index", 0);
+        cJSON_AddNumberToObject(item, "threads", 1);
+        cJSON_AddNumberToObject(item, "iterations", double(result.iterations));
+        cJSON_AddNumberToObject(item, "real_time", result.real_ns);
+        cJSON_AddNumberToObject(item, "cpu_time", result.cpu_ns);
+        cJSON_AddStringToObject(item, "time_unit", "ns");
+        if (0.0 != result.bytes_per_second) {
+            cJSON_AddNumberToObject(item, "bytes_per_second", result.bytes_per_second);
+        }
+        if (0.0 != result.items_per_second) {
+            cJSON_AddNumberToObject(item, "items_per_second", result.items_per_second);
+        }
+        if (!result.label.empty()) {
+            cJSON_AddStringToObject(item, "label", result.label.c_str());
+        }
+        if (!result.error.empty()) {
+            cJSON_AddTrueToObject(item, "error_occurred");
+            cJSON_AddStringToObject(item, "error_message", result.error.c_str());
+        }
+        cJSON_AddItemToArray(benchmarks, item);
+    }
+
+    char* json = cJSON_Print(root);
+    cJSON_Delete(root);
+    FILE* out = fopen(file.c_str(), "w");
+    int ret = -1;
+    if (nullptr != out && nullptr != json) {
+        ret = fputs(json, out) >= 0 && fputc('\n', out) != EOF ? 0 : -1;
+    }
+    if (nullptr != out) {
+        ret = 0 == fclose(out) ? ret : -1;
+    }
+    free(json);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    double min_time = 0.2;
+    std::string json_file;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; i++) {
+        if (0 == strncmp(argv[i], "--min_time=", strlen("--min_time="))) {
+            min_time = atof(argv[i] + strlen("--min_time="));
+        } else if (0 == strncmp(argv[i], "--json=", strlen("--json="))) {
+            json_file = argv[i] + strlen("--json=");
+        } else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    int ret = 0;
+    std::vector<BenchResult> results;
+    const std::vector<BenchCase>& registry = adas::bench::bench_registry();
+    for (size_t i = 0; i < registry.size(); i++) {
+        if (!match_filters(registry[i].name, filters)) {
+            continue;
+        }
+        results.push_back(run_case(registry[i], min_time));
+        if (!results.back().error.empty()) {
+            ret = 1;
+        }
+    }
+    if (!json_file.empty() && 0 != write_json(json_file, argv[0], results)) {
+        fprintf(stderr, "write %s failed\n", json_file.c_str());
+        ret = 1;
+    }
+    return ret;
+}
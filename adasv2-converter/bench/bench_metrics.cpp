@@ -0,0 +1,83 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 耗时直方图: 记录一次的开销，分位数和排序后精确值的相对误差不超过1/SUB_BUCKET_COUNT
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "bench_util.h"
+#include "adas_v2_metrics.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+using protocol_v2::LatencyHistogram;
+
+const size_t SAMPLE_COUNT = 4096;
+
+// 对数均匀分布在100ns到100ms之间
+const std::vector<uint64_t>& samples() {
+    static std::vector<uint64_t> values;
+    if (values.empty()) {
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            double exponent = 2.0 + 6.0 * double(seed >> 11) / double(1ULL << 53);
+            values.push_back(uint64_t(pow(10.0, exponent)));
+        }
+    }
+    return values;
+}
+
+void bench_record(BenchState& state) {
+    const std::vector<uint64_t>& values = samples();
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < values.size(); i++) {
+        histogram.record(values[i]);
+    }
+    std::vector<uint64_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    const double percentiles[] = {50.0, 90.0, 99.0, 99.9, 100.0};
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        size_t rank = std::max<size_t>(1, ceil(percentiles[i] / 100.0 * sorted.size()));
+        uint64_t expected = sorted[rank - 1];
+        uint64_t value = histogram.percentile(percentiles[i]);
+        if (value < expected || value - expected > expected / LatencyHistogram::SUB_BUCKET_COUNT) {
+            char message[128];
+            snprintf(message, sizeof(message), "p%.1f %lu expected %lu", percentiles[i], value, expected);
+            state.set_error(message);
+            return;
+        }
+    }
+
+    state.set_items_per_iteration(values.size());
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (size_t i = 0; i < values.size(); i++) {
+            histogram.record(values[i]);
+        }
+    }
+    do_not_optimize(histogram.count());
+}
+
+void bench_percentile(BenchState& state) {
+    const std::vector<uint64_t>& values = samples();
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < values.size(); i++) {
+        histogram.record(values[i]);
+    }
+    state.set_items_per_iteration(1);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        uint64_t value = histogram.percentile(99.9);
+        do_not_optimize(value);
+    }
+}
+
+ADAS_BENCH("metrics/record", bench_record);
+ADAS_BENCH("metrics/percentile", bench_percentile);
+
+} // namespace
+} // namespace bench
+} // namespace adas
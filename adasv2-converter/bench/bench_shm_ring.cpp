@@ -0,0 +1,101 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 共享内存环形队列的发布和零拷贝读取，样本为上海高速的ehp下发数据拆出的消息大小
+
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+#include "bench_util.h"
+#include "adas_v2_shm_ring.h"
+
+namespace adas {
+namespace bench {
+namespace {
+
+using adas::protocol_v2::Adasv2ShmMessage;
+using adas::protocol_v2::Adasv2ShmPublisher;
+using adas::protocol_v2::Adasv2ShmReader;
+
+const uint32_t SLOT_COUNT = 1024;
+const uint32_t SLOT_SIZE = 2048;
+const size_t MESSAGE_SIZE = 512;
+
+std::string ring_name() {
+    return "/adasv2_bench_ring_" + std::to_string(getpid());
+}
+
+void bench_publish(BenchState& state) {
+    Adasv2ShmPublisher publisher;
+    if (0 != publisher.open(ring_name(), SLOT_COUNT, SLOT_SIZE)) {
+        state.set_error("open shm ring failed");
+        return;
+    }
+    std::string message(MESSAGE_SIZE, 'x');
+    state.set_items_per_iteration(1);
+    state.set_bytes_per_iteration(message.size());
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        publisher.publish(message.data(), message.size());
+    }
+    publisher.close(true);
+}
+
+// 同一进程内一写一读交替，读端消费完做一次validate
+void bench_publish_read(BenchState& state) {
+    Adasv2ShmPublisher publisher;
+    Adasv2ShmReader reader;
+    if (0 != publisher.open(ring_name(), SLOT_COUNT, SLOT_SIZE) || 0 != reader.open(ring_name())) {
+        state.set_error("open shm ring failed");
+        return;
+    }
+    std::string message(MESSAGE_SIZE, 'x');
+    state.set_items_per_iteration(1);
+    state.set_bytes_per_iteration(message.size());
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        memcpy(&message[0], &n, sizeof(n));
+        publisher.publish(message.data(), message.size());
+        Adasv2ShmMessage view;
+        if (0 != reader.read(view) || view.sequence != n || 0 != memcmp(view.data, &n, sizeof(n)) ||
+                !reader.validate(view)) {
+            state.set_error("read mismatch at " + std::to_string(n));
+            break;
+        }
+    }
+    reader.close();
+    publisher.close(true);
+}
+
+// 读端不读，写端写满两圈之后读端应当检测到被套圈
+void bench_lapped_reader(BenchState& state) {
+    Adasv2ShmPublisher publisher;
+    Adasv2ShmReader reader;
+    if (0 != publisher.open(ring_name(), SLOT_COUNT, SLOT_SIZE) || 0 != reader.open(ring_name())) {
+        state.set_error("open shm ring failed");
+        return;
+    }
+    std::string message(MESSAGE_SIZE, 'x');
+    state.set_items_per_iteration(SLOT_COUNT * 2);
+    for (uint64_t n = 0; n < state.iterations(); n++) {
+        for (uint32_t i = 0; i < SLOT_COUNT * 2; i++) {
+            publisher.publish(message.data(), message.size());
+        }
+        Adasv2ShmMessage view;
+        if (-2 != reader.read(view) || 0 != reader.read(view) ||
+                view.sequence != publisher.published() - SLOT_COUNT + 1) {
+            state.set_error("lapped reader not detected");
+            break;
+        }
+        while (0 == reader.read(view)) {
+        }
+    }
+    reader.close();
+    publisher.close(true);
+}
+
+ADAS_BENCH("shm_ring/publish", bench_publish);
+ADAS_BENCH("shm_ring/publish_read", bench_publish_read);
+ADAS_BENCH("shm_ring/lapped_reader", bench_lapped_reader);
+
+} // namespace
+} // namespace bench
+} // namespace adas
@@ -0,0 +1,108 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace adas {
+namespace bench {
+
+// 每个case由runner反复调用，每次调用执行iterations()次被测代码
+class BenchState {
+public:
+    explicit BenchState(uint64_t iterations) : _iterations(iterations) {}
+
+    uint64_t iterations() const {
+        return _iterations;
+    }
+
+    // 单次迭代处理的字节数/条目数，用于计算吞吐
+    void set_bytes_per_iteration(uint64_t bytes) {
+        _bytes_per_iteration = bytes;
+    }
+    void set_items_per_iteration(uint64_t items) {
+        _items_per_iteration = items;
+    }
+
+    uint64_t bytes_per_iteration() const {
+        return _bytes_per_iteration;
+    }
+    uint64_t items_per_iteration() const {
+        return _items_per_iteration;
+    }
+
+    // case自身的失败信息，比如结果和参考值对不上
+    void set_error(const std::string& error) {
+        _error = error;
+    }
+    const std::string& error() const {
+        return _error;
+    }
+
+    // 附在结果后面的说明，比如内存占用这类不随迭代变化的数值
+    void set_label(const std::string& label) {
+        _label = label;
+    }
+    const std::string& label() const {
+        return _label;
+    }
+
+    // 准备数据比较耗时的case在进入循环前调用，计时从这里开始
+    void reset_timer() {
+        _start = std::chrono::steady_clock::now();
+        _timer_reset = true;
+    }
+    bool timer_reset() const {
+        return _timer_reset;
+    }
+    std::chrono::steady_clock::time_point start() const {
+        return _start;
+    }
+
+private:
+    uint64_t _iterations = 0;
+    uint64_t _bytes_per_iteration = 0;
+    uint64_t _items_per_iteration = 0;
+    std::string _error;
+    std::string _label;
+    bool _timer_reset = false;
+    std::chrono::steady_clock::time_point _start;
+};
+
+typedef std::function<void(BenchState&)> BenchFunc;
+
+struct BenchCase {
+    std::string name;
+    BenchFunc func;
+};
+
+std::vector<BenchCase>& bench_registry();
+
+struct BenchRegistrar {
+    BenchRegistrar(const std::string& name, const BenchFunc& func) {
+        bench_registry().push_back(BenchCase{name, func});
+    }
+};
+
+// 阻止编译器把被测结果优化掉
+template<typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// 读取测试数据，ADASV2_DATA_DIR下的相对路径或者绝对路径
+std::string read_data_file(const std::string& name);
+std::vector<std::string> read_data_lines(const std::string& name);
+
+} // namespace bench
+} // namespace adas
+
+#define ADAS_BENCH_CONCAT_IMPL(a, b) a##b
+#define ADAS_BENCH_CONCAT(a, b) ADAS_BENCH_CONCAT_IMPL(a, b)
+
+// 注册一个case，name为字符串，func为void(BenchState&)
+#define ADAS_BENCH(name, func) \
+    static ::adas::bench::BenchRegistrar ADAS_BENCH_CONCAT(_bench_registrar_, __LINE__)(name, func)
@@ -43,6 +43,8 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <ctype.h>
+#include <float.h>
+#include <stdint.h>
 
 #ifdef ENABLE_LOCALES
 #include <locale.h>
@@ -272,6 +274,412 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
+/* Fast path for parse_number.
+ * Numbers of the form -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)? with at most 19 significant digits
+ * are converted without strtod: exact integers and Clinger's fast path first, then the Eisel-Lemire
+ * algorithm. Anything that can't be decided exactly here goes back to strtod, so results are bit-exact. */
+
+#define POW10_TABLE_MIN_EXP10 (-64)
+#define POW10_TABLE_MAX_EXP10 (64)
+
+/* 128-bit mantissas of the powers of ten, rounded down, most significant half first */
+static const uint64_t pow10_table[POW10_TABLE_MAX_EXP10 - POW10_TABLE_MIN_EXP10 + 1][2] = {
+    {0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL}, /* 1e-64 */
+    {0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL}, /* 1e-63 */
+    {0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL}, /* 1e-62 */
+    {0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL}, /* 1e-61 */
+    {0xCDB02555653131B6ULL, 0x3792F412CB06794DULL}, /* 1e-60 */
+    {0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL}, /* 1e-59 */
+    {0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL}, /* 1e-58 */
+    {0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL}, /* 1e-57 */
+    {0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL}, /* 1e-56 */
+    {0x9CED737BB6C4183DULL, 0x55464DD69685606BULL}, /* 1e-55 */
+    {0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL}, /* 1e-54 */
+    {0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL}, /* 1e-53 */
+    {0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL}, /* 1e-52 */
+    {0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL}, /* 1e-51 */
+    {0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL}, /* 1e-50 */
+    {0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL}, /* 1e-49 */
+    {0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL}, /* 1e-48 */
+    {0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL}, /* 1e-47 */
+    {0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL}, /* 1e-46 */
+    {0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL}, /* 1e-45 */
+    {0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL}, /* 1e-44 */
+    {0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL}, /* 1e-43 */
+    {0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL}, /* 1e-42 */
+    {0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL}, /* 1e-41 */
+    {0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL}, /* 1e-40 */
+    {0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL}, /* 1e-39 */
+    {0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL}, /* 1e-38 */
+    {0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL}, /* 1e-37 */
+    {0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL}, /* 1e-36 */
+    {0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL}, /* 1e-35 */
+    {0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL}, /* 1e-34 */
+    {0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL}, /* 1e-33 */
+    {0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL}, /* 1e-32 */
+    {0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL}, /* 1e-31 */
+    {0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL}, /* 1e-30 */
+    {0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL}, /* 1e-29 */
+    {0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL}, /* 1e-28 */
+    {0x9E74D1B791E07E48ULL, 0x775EA264CF55347DULL}, /* 1e-27 */
+    {0xC612062576589DDAULL, 0x95364AFE032A819DULL}, /* 1e-26 */
+    {0xF79687AED3EEC551ULL, 0x3A83DDBD83F52204ULL}, /* 1e-25 */
+    {0x9ABE14CD44753B52ULL, 0xC4926A9672793542ULL}, /* 1e-24 */
+    {0xC16D9A0095928A27ULL, 0x75B7053C0F178293ULL}, /* 1e-23 */
+    {0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6338ULL}, /* 1e-22 */
+    {0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E03ULL}, /* 1e-21 */
+    {0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF584ULL}, /* 1e-20 */
+    {0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E5ULL}, /* 1e-19 */
+    {0x9392EE8E921D5D07ULL, 0x3AFF322E62439FCFULL}, /* 1e-18 */
+    {0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C2ULL}, /* 1e-17 */
+    {0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B3ULL}, /* 1e-16 */
+    {0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A10ULL}, /* 1e-15 */
+    {0xB424DC35095CD80FULL, 0x538484C19EF38C94ULL}, /* 1e-14 */
+    {0xE12E13424BB40E13ULL, 0x2865A5F206B06FB9ULL}, /* 1e-13 */
+    {0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D3ULL}, /* 1e-12 */
+    {0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D748ULL}, /* 1e-11 */
+    {0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1BULL}, /* 1e-10 */
+    {0x89705F4136B4A597ULL, 0x31680A88F8953030ULL}, /* 1e-9 */
+    {0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3DULL}, /* 1e-8 */
+    {0xD6BF94D5E57A42BCULL, 0x3D32907604691B4CULL}, /* 1e-7 */
+    {0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B10FULL}, /* 1e-6 */
+    {0xA7C5AC471B478423ULL, 0x0FCF80DC33721D53ULL}, /* 1e-5 */
+    {0xD1B71758E219652BULL, 0xD3C36113404EA4A8ULL}, /* 1e-4 */
+    {0x83126E978D4FDF3BULL, 0x645A1CAC083126E9ULL}, /* 1e-3 */
+    {0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A3ULL}, /* 1e-2 */
+    {0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCCULL}, /* 1e-1 */
+    {0x8000000000000000ULL, 0x0000000000000000ULL}, /* 1e0 */
+    {0xA000000000000000ULL, 0x0000000000000000ULL}, /* 1e1 */
+    {0xC800000000000000ULL, 0x0000000000000000ULL}, /* 1e2 */
+    {0xFA00000000000000ULL, 0x0000000000000000ULL}, /* 1e3 */
+    {0x9C40000000000000ULL, 0x0000000000000000ULL}, /* 1e4 */
+    {0xC350000000000000ULL, 0x0000000000000000ULL}, /* 1e5 */
+    {0xF424000000000000ULL, 0x0000000000000000ULL}, /* 1e6 */
+    {0x9896800000000000ULL, 0x0000000000000000ULL}, /* 1e7 */
+    {0xBEBC200000000000ULL, 0x0000000000000000ULL}, /* 1e8 */
+    {0xEE6B280000000000ULL, 0x0000000000000000ULL}, /* 1e9 */
+    {0x9502F90000000000ULL, 0x0000000000000000ULL}, /* 1e10 */
+    {0xBA43B74000000000ULL, 0x0000000000000000ULL}, /* 1e11 */
+    {0xE8D4A51000000000ULL, 0x0000000000000000ULL}, /* 1e12 */
+    {0x9184E72A00000000ULL, 0x0000000000000000ULL}, /* 1e13 */
+    {0xB5E620F480000000ULL, 0x0000000000000000ULL}, /* 1e14 */
+    {0xE35FA931A0000000ULL, 0x0000000000000000ULL}, /* 1e15 */
+    {0x8E1BC9BF04000000ULL, 0x0000000000000000ULL}, /* 1e16 */
+    {0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL}, /* 1e17 */
+    {0xDE0B6B3A76400000ULL, 0x0000000000000000ULL}, /* 1e18 */
+    {0x8AC7230489E80000ULL, 0x0000000000000000ULL}, /* 1e19 */
+    {0xAD78EBC5AC620000ULL, 0x0000000000000000ULL}, /* 1e20 */
+    {0xD8D726B7177A8000ULL, 0x0000000000000000ULL}, /* 1e21 */
+    {0x878678326EAC9000ULL, 0x0000000000000000ULL}, /* 1e22 */
+    {0xA968163F0A57B400ULL, 0x0000000000000000ULL}, /* 1e23 */
+    {0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL}, /* 1e24 */
+    {0x84595161401484A0ULL, 0x0000000000000000ULL}, /* 1e25 */
+    {0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL}, /* 1e26 */
+    {0xCECB8F27F4200F3AULL, 0x0000000000000000ULL}, /* 1e27 */
+    {0x813F3978F8940984ULL, 0x4000000000000000ULL}, /* 1e28 */
+    {0xA18F07D736B90BE5ULL, 0x5000000000000000ULL}, /* 1e29 */
+    {0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL}, /* 1e30 */
+    {0xFC6F7C4045812296ULL, 0x4D00000000000000ULL}, /* 1e31 */
+    {0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL}, /* 1e32 */
+    {0xC5371912364CE305ULL, 0x6C28000000000000ULL}, /* 1e33 */
+    {0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL}, /* 1e34 */
+    {0x9A130B963A6C115CULL, 0x3C7F400000000000ULL}, /* 1e35 */
+    {0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL}, /* 1e36 */
+    {0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL}, /* 1e37 */
+    {0x96769950B50D88F4ULL, 0x1314448000000000ULL}, /* 1e38 */
+    {0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL}, /* 1e39 */
+    {0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL}, /* 1e40 */
+    {0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL}, /* 1e41 */
+    {0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL}, /* 1e42 */
+    {0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL}, /* 1e43 */
+    {0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL}, /* 1e44 */
+    {0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL}, /* 1e45 */
+    {0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL}, /* 1e46 */
+    {0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL}, /* 1e47 */
+    {0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL}, /* 1e48 */
+    {0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL}, /* 1e49 */
+    {0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL}, /* 1e50 */
+    {0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL}, /* 1e51 */
+    {0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL}, /* 1e52 */
+    {0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL}, /* 1e53 */
+    {0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL}, /* 1e54 */
+    {0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL}, /* 1e55 */
+    {0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL}, /* 1e56 */
+    {0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL}, /* 1e57 */
+    {0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL}, /* 1e58 */
+    {0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL}, /* 1e59 */
+    {0x9F4F2726179A2245ULL, 0x01D762422C946590ULL}, /* 1e60 */
+    {0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL}, /* 1e61 */
+    {0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL}, /* 1e62 */
+    {0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL}, /* 1e63 */
+    {0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL}, /* 1e64 */
+};
+
+/* powers of ten that are exact in a double */
+static const double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static void mul_64x64(uint64_t a, uint64_t b, uint64_t *high, uint64_t *low)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *high = (uint64_t)(product >> 64);
+    *low = (uint64_t)product;
+#else
+    uint64_t a_lo = a & 0xFFFFFFFFULL;
+    uint64_t a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFFULL;
+    uint64_t b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + lo_hi;
+    *high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+    *low = (cross << 32) | (lo_lo & 0xFFFFFFFFULL);
+#endif
+}
+
+static int leading_zeros_64(uint64_t value)
+{
+#if defined(__GNUC__)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
+    while ((value & 0x8000000000000000ULL) == 0)
+    {
+        value <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/* Eisel-Lemire: mantissa * 10^exp10 correctly rounded, mantissa != 0.
+ * Returns false when the result can't be decided (or is subnormal/infinite), the caller falls back to strtod. */
+static cJSON_bool eisel_lemire(uint64_t mantissa, int exp10, cJSON_bool negative, double *result)
+{
+    const uint64_t *power = NULL;
+    uint64_t x_high = 0;
+    uint64_t x_low = 0;
+    uint64_t y_high = 0;
+    uint64_t y_low = 0;
+    uint64_t merged_high = 0;
+    uint64_t merged_low = 0;
+    uint64_t msb = 0;
+    uint64_t result_mantissa = 0;
+    uint64_t result_exp2 = 0;
+    uint64_t bits = 0;
+    int clz = 0;
+
+    if ((exp10 < POW10_TABLE_MIN_EXP10) || (exp10 > POW10_TABLE_MAX_EXP10))
+    {
+        return false;
+    }
+    power = pow10_table[exp10 - POW10_TABLE_MIN_EXP10];
+
+    /* normalization */
+    clz = leading_zeros_64(mantissa);
+    mantissa <<= clz;
+    /* floor(exp10 * log2(10)) + 64 + bias - clz */
+    result_exp2 = (uint64_t)(((217706 * (int64_t)exp10) >> 16) + 64 + 1023) - (uint64_t)clz;
+
+    /* multiplication, widened with the low half of the power when the high half is not enough */
+    mul_64x64(mantissa, power[0], &x_high, &x_low);
+    if (((x_high & 0x1FF) == 0x1FF) && ((x_low + mantissa) < mantissa))
+    {
+        mul_64x64(mantissa, power[1], &y_high, &y_low);
+        merged_high = x_high;
+        merged_low = x_low + y_high;
+        if (merged_low < x_low)
+        {
+            merged_high++;
+        }
+        if (((merged_high & 0x1FF) == 0x1FF) && ((merged_low + 1) == 0) && ((y_low + mantissa) < mantissa))
+        {
+            return false;
+        }
+        x_high = merged_high;
+        x_low = merged_low;
+    }
+
+    /* shift to 54 bits */
+    msb = x_high >> 63;
+    result_mantissa = x_high >> (msb + 9);
+    result_exp2 -= 1 ^ msb;
+
+    /* halfway ambiguity */
+    if ((x_low == 0) && ((x_high & 0x1FF) == 0) && ((result_mantissa & 3) == 1))
+    {
+        return false;
+    }
+
+    /* round to 53 bits */
+    result_mantissa += result_mantissa & 1;
+    result_mantissa >>= 1;
+    if ((result_mantissa >> 53) > 0)
+    {
+        result_mantissa >>= 1;
+        result_exp2 += 1;
+    }
+
+    /* subnormal or infinite */
+    if ((result_exp2 - 1) >= (0x7FF - 1))
+    {
+        return false;
+    }
+
+    bits = (result_exp2 << 52) | (result_mantissa & 0x000FFFFFFFFFFFFFULL);
+    if (negative)
+    {
+        bits |= 0x8000000000000000ULL;
+    }
+    memcpy(result, &bits, sizeof(bits));
+    return true;
+}
+
+/* Returns the number of characters consumed, or 0 if the number has to be parsed by strtod. */
+static size_t parse_number_fast(const unsigned char *number, size_t length, double *result)
+{
+    const unsigned char *current = number;
+    const unsigned char *end = number + length;
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exp10 = 0;
+    int explicit_exp10 = 0;
+    cJSON_bool negative = false;
+    cJSON_bool negative_exponent = false;
+    double value = 0;
+
+    if ((current < end) && (*current == '-'))
+    {
+        negative = true;
+        current++;
+    }
+
+    if ((current >= end) || (*current < '0') || (*current > '9'))
+    {
+        return 0;
+    }
+
+    /* integer part, no leading zeros */
+    if (*current == '0')
+    {
+        current++;
+        if ((current < end) && (*current >= '0') && (*current <= '9'))
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        for (; (current < end) && (*current >= '0') && (*current <= '9'); current++)
+        {
+            if (significant_digits == 19)
+            {
+                return 0;
+            }
+            mantissa = mantissa * 10 + (uint64_t)(*current - '0');
+            significant_digits++;
+        }
+    }
+
+    /* fraction */
+    if ((current < end) && (*current == '.'))
+    {
+        current++;
+        if ((current >= end) || (*current < '0') || (*current > '9'))
+        {
+            return 0;
+        }
+        for (; (current < end) && (*current >= '0') && (*current <= '9'); current++)
+        {
+            if ((mantissa == 0) && (*current == '0'))
+            {
+                /* leading zeros only move the decimal point */
+                exp10--;
+                continue;
+            }
+            if (significant_digits == 19)
+            {
+                return 0;
+            }
+            mantissa = mantissa * 10 + (uint64_t)(*current - '0');
+            significant_digits++;
+            exp10--;
+        }
+    }
+
+    /* exponent */
+    if ((current < end) && ((*current == 'e') || (*current == 'E')))
+    {
+        current++;
+        if ((current < end) && ((*current == '+') || (*current == '-')))
+        {
+            negative_exponent = (*current == '-');
+            current++;
+        }
+        if ((current >= end) || (*current < '0') || (*current > '9'))
+        {
+            return 0;
+        }
+        for (; (current < end) && (*current >= '0') && (*current <= '9'); current++)
+        {
+            if (explicit_exp10 < 100000)
+            {
+                explicit_exp10 = explicit_exp10 * 10 + (*current - '0');
+            }
+        }
+        exp10 += negative_exponent ? -explicit_exp10 : explicit_exp10;
+    }
+
+    /* strtod would read further than the JSON grammar, let it decide */
+    if ((current < end) && ((*current == '.') || (*current == 'e') || (*current == 'E') || (*current == '+') || (*current == '-')))
+    {
+        return 0;
+    }
+
+    if (mantissa == 0)
+    {
+        *result = negative ? -0.0 : 0.0;
+        return (size_t)(current - number);
+    }
+
+    if (mantissa <= 9007199254740992ULL)
+    {
+        value = (double)mantissa;
+        if (exp10 == 0)
+        {
+            *result = negative ? -value : value;
+            return (size_t)(current - number);
+        }
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0)
+        /* Clinger: both operands are exact, so one correctly rounded operation gives the exact result */
+        if ((exp10 > 0) && (exp10 <= 22))
+        {
+            value *= exact_pow10[exp10];
+            *result = negative ? -value : value;
+            return (size_t)(current - number);
+        }
+        if ((exp10 < 0) && (exp10 >= -22))
+        {
+            value /= exact_pow10[-exp10];
+            *result = negative ? -value : value;
+            return (size_t)(current - number);
+        }
+#endif
+    }
+
+    if (!eisel_lemire(mantissa, exp10, negative, result))
+    {
+        return 0;
+    }
+
+    return (size_t)(current - number);
+}
+
 /* Parse the input text to generate a number, and populate the result into item. */
 static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -286,6 +694,13 @@ static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_bu
         return false;
     }
 
+    i = parse_number_fast(buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &number);
+    if (i > 0)
+    {
+        input_buffer->offset += i;
+        goto set_value;
+    }
+
     /* copy the number into a temporary buffer and replace '.' with the decimal point
      * of the current locale (for strtod)
      * This also takes care of '\0' not necessarily being available for marking the end of the input */
@@ -327,6 +742,9 @@ loop_end:
         return false; /* parse_error */
     }
 
+    input_buffer->offset += (size_t)(after_end - number_c_string);
+
+set_value:
     item->valuedouble = number;
 
     /* use saturation in case of overflow */
@@ -345,7 +763,6 @@ loop_end:
 
     item->type = cJSON_Number;
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
     return true;
 }
 
@@ -1827,6 +2244,85 @@ CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const objec
     return get_object_item(object, string, true);
 }
 
+/* FNV-1a, only used to filter candidates before the strcmp */
+static unsigned int hash_key(const char *key)
+{
+    unsigned int hash = 2166136261U;
+    for (; *key != '\0'; key++)
+    {
+        hash ^= (unsigned char)*key;
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+#define MAX_KEYS_PER_PASS 64
+
+CJSON_PUBLIC(int) cJSON_GetObjectItemsCaseSensitive(const cJSON * const object, const char * const * names, cJSON **items, int count)
+{
+    unsigned int hashes[MAX_KEYS_PER_PASS];
+    cJSON *current_element = NULL;
+    int found = 0;
+    int i = 0;
+
+    if ((names == NULL) || (items == NULL) || (count <= 0))
+    {
+        return 0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        items[i] = NULL;
+    }
+
+    if (object == NULL)
+    {
+        return 0;
+    }
+
+    if (count > MAX_KEYS_PER_PASS)
+    {
+        /* too many keys for the hash table on the stack, fall back to one walk per key */
+        for (i = 0; i < count; i++)
+        {
+            items[i] = get_object_item(object, names[i], true);
+            if (items[i] != NULL)
+            {
+                found++;
+            }
+        }
+        return found;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        hashes[i] = (names[i] != NULL) ? hash_key(names[i]) : 0;
+    }
+
+    for (current_element = object->child; (current_element != NULL) && (found < count); current_element = current_element->next)
+    {
+        unsigned int hash = 0;
+
+        if (current_element->string == NULL)
+        {
+            continue;
+        }
+
+        hash = hash_key(current_element->string);
+        for (i = 0; i < count; i++)
+        {
+            if ((items[i] == NULL) && (hashes[i] == hash) && (names[i] != NULL) && (strcmp(names[i], current_element->string) == 0))
+            {
+                items[i] = current_element;
+                found++;
+            }
+        }
+    }
+
+    return found;
+}
+
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string)
 {
     return cJSON_GetObjectItem(object, string) ? 1 : 0;
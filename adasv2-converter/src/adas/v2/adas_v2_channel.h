@@ -5,6 +5,10 @@
 #include <list>
 #include <mutex>
 
+#include "adas_v2_metrics.h"
+#include "adas_v2_trace.h"
+#include "adas_v2_type.h"
+
 namespace adas {
 namespace protocol_v2 {
 
@@ -17,31 +21,39 @@ public:
         _buffer_mutex.lock();
         list0.clear();
         list1.clear();
+        batches.clear();
         _buffer_mutex.unlock();
     }
 
     void push_list0(const std::string& ehp_json) {
         _buffer_mutex.lock();
-        list0.push_back(ehp_json);
+        list0.push_back(Entry<std::string>{ehp_json, monotonic_ns(), ++_sequence});
+        ADASV2_TRACE(message_enqueue, 0, ehp_json.size(), _sequence, list0.size());
         _buffer_mutex.unlock();
     }
 
     void push_list1(const std::string& ehp_json) {
         _buffer_mutex.lock();
-        list1.push_back(ehp_json);
+        list1.push_back(Entry<std::string>{ehp_json, monotonic_ns(), ++_sequence});
+        ADASV2_TRACE(message_enqueue, 1, ehp_json.size(), _sequence, list1.size());
         _buffer_mutex.unlock();
     }
 
-    int pop(std::string& ehp_json) {
+    // enqueue_ns为入队时的monotonic_ns()，用于统计排队时间
+    int pop(std::string& ehp_json, uint64_t& enqueue_ns) {
         std::lock_guard<std::mutex> lock(_buffer_mutex);
         if (0 != list0.size()) {
-            ehp_json = list0.front();
+            ehp_json.swap(list0.front().value);
+            enqueue_ns = list0.front().enqueue_ns;
+            ADASV2_TRACE(message_dequeue, 0, ehp_json.size(), list0.front().sequence, enqueue_ns);
             list0.pop_front();
             return 0;
         }
 
         if (0 != list1.size()) {
-            ehp_json = list1.front();
+            ehp_json.swap(list1.front().value);
+            enqueue_ns = list1.front().enqueue_ns;
+            ADASV2_TRACE(message_dequeue, 1, ehp_json.size(), list1.front().sequence, enqueue_ns);
             list1.pop_front();
             return 1;
         }
@@ -49,13 +61,44 @@ public:
         return -1;
     }
 
+    void push_batch(EhpV2Batch&& batch) {
+        _buffer_mutex.lock();
+        batches.push_back(Entry<EhpV2Batch>{std::move(batch), monotonic_ns(), ++_sequence});
+        ADASV2_TRACE(message_enqueue, 2, batches.back().value.messages.size(), _sequence, batches.size());
+        _buffer_mutex.unlock();
+    }
+
+    int pop_batch(EhpV2Batch& batch, uint64_t& enqueue_ns) {
+        std::lock_guard<std::mutex> lock(_buffer_mutex);
+        if (0 != batches.size()) {
+            batch = std::move(batches.front().value);
+            enqueue_ns = batches.front().enqueue_ns;
+            ADASV2_TRACE(message_dequeue, 2, batch.messages.size(), batches.front().sequence, enqueue_ns);
+            batches.pop_front();
+            return 0;
+        }
+
+        return -1;
+    }
+
 private:
+    template<typename T>
+    struct Entry {
+        T value;
+        uint64_t enqueue_ns;
+        uint64_t sequence; // 入队序号，只用于跟踪
+    };
+
     std::mutex _buffer_mutex;
+    uint64_t _sequence = 0;
     // stub
-    std::list<std::string> list0;
+    std::list<Entry<std::string> > list0;
 
     // segment, profileshort, profilelong
-    std::list<std::string> list1;
+    std::list<Entry<std::string> > list1;
+
+    // 批量模式下一次ehp更新的全部消息
+    std::list<Entry<EhpV2Batch> > batches;
 }; // class Adasv2Channel
 
 } // namespace protocol_v2
@@ -0,0 +1,71 @@
+#include <sys/time.h>
+#include <time.h>
+#include <chrono>
+#include <thread>
+
+#include "adas_v2_clock.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+namespace {
+
+int64_t monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+} // namespace
+
+SteadyClock::SteadyClock(Clock* realtime, Clock* monotonic) : _realtime(realtime), _monotonic(monotonic) {
+    int64_t now = _monotonic_ms();
+    _offset_ms = _realtime_ms() - now;
+    _next_check_ms = now + CHECK_INTERVAL_MS;
+}
+
+int64_t SteadyClock::now_ms() {
+    int64_t now = _monotonic_ms();
+    if (now >= _next_check_ms.load(std::memory_order_relaxed)) {
+        _check_anchor(now);
+    }
+    return now + _offset_ms.load(std::memory_order_relaxed);
+}
+
+int64_t SteadyClock::_realtime_ms() {
+    if (nullptr != _realtime) {
+        return _realtime->now_ms();
+    }
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return int64_t(tv.tv_sec) * 1000 + tv.tv_usec / 1000;
+}
+
+int64_t SteadyClock::_monotonic_ms() {
+    return nullptr != _monotonic ? _monotonic->now_ms() : monotonic_ms();
+}
+
+void SteadyClock::_check_anchor(int64_t monotonic_ms) {
+    int64_t next_check = _next_check_ms.load(std::memory_order_relaxed);
+    if (monotonic_ms < next_check ||
+            !_next_check_ms.compare_exchange_strong(next_check, monotonic_ms + CHECK_INTERVAL_MS)) {
+        return;
+    }
+    int64_t offset = _realtime_ms() - monotonic_ms;
+    int64_t drift = offset - _offset_ms.load(std::memory_order_relaxed);
+    if (drift > STEP_THRESHOLD_MS || drift < -STEP_THRESHOLD_MS) {
+        _offset_ms.store(offset, std::memory_order_relaxed);
+    }
+}
+
+void SteadyClock::sleep_ms(int64_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+SteadyClock& SteadyClock::instance() {
+    static SteadyClock clock(nullptr, nullptr);
+    return clock;
+}
+
+} // namespace protocol_v2
+} // namespace adas
@@ -0,0 +1,80 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <atomic>
+
+namespace adas {
+namespace protocol_v2 {
+
+// 转换器用到的时间: PositionAge按now_ms() - gps_loc_time计算，消息发送的节流用sleep_ms。
+// 通过AdasV2Protocol::set_clock替换，测试和回放时用ManualClock控制时间
+class Clock {
+public:
+    virtual ~Clock() {}
+
+    // epoch毫秒时间戳，和定位时间gps_loc_time可比
+    virtual int64_t now_ms() = 0;
+
+    virtual void sleep_ms(int64_t ms) = 0;
+}; // class Clock
+
+// 生产用: 按CLOCK_MONOTONIC推进，加上系统时间和monotonic之差(锚点)换算成epoch时间，
+// NTP微调系统时间不会让PositionAge跳到510/511。now_ms()最多每秒对比一次当前的差值，
+// 和锚点相差超过STEP_THRESHOLD_MS时(手动改时间、GNSS授时、NTP大步校正)重新取锚点
+class SteadyClock : public Clock {
+public:
+    static constexpr int64_t STEP_THRESHOLD_MS = 200;
+    static constexpr int64_t CHECK_INTERVAL_MS = 1000;
+
+    /**
+     * @brief 用realtime和monotonic作为系统时间和单调时间，nullptr为真实的系统时钟。
+     *        测试用ManualClock模拟系统时间跳变，两个clock的生命周期需要长于SteadyClock
+    */
+    SteadyClock(Clock* realtime, Clock* monotonic);
+
+    int64_t now_ms() override;
+
+    void sleep_ms(int64_t ms) override;
+
+    // 进程内共用一个，AdasV2Protocol默认使用
+    static SteadyClock& instance();
+
+private:
+    int64_t _realtime_ms();
+    int64_t _monotonic_ms();
+    // 到了检查时间的线程里只有一个真正去对比，其余直接用当前锚点
+    void _check_anchor(int64_t monotonic_ms);
+
+    Clock* _realtime;
+    Clock* _monotonic;
+    std::atomic<int64_t> _offset_ms; // 锚点: 系统时间 - 单调时间
+    std::atomic<int64_t> _next_check_ms; // 单调时间，到了之后再对比一次
+}; // class SteadyClock
+
+// 测试和回放用: 时间只由set_ms/advance_ms改变，sleep_ms不等待也不推进时间，
+// 回放可以快于实时，并且输出只取决于输入和设置的时间
+class ManualClock : public Clock {
+public:
+    explicit ManualClock(int64_t now_ms = 0) : _now_ms(now_ms) {}
+
+    int64_t now_ms() override {
+        return _now_ms.load(std::memory_order_acquire);
+    }
+
+    void sleep_ms(int64_t) override {}
+
+    void set_ms(int64_t now_ms) {
+        _now_ms.store(now_ms, std::memory_order_release);
+    }
+
+    void advance_ms(int64_t ms) {
+        _now_ms.fetch_add(ms, std::memory_order_acq_rel);
+    }
+
+private:
+    std::atomic<int64_t> _now_ms;
+}; // class ManualClock
+
+} // namespace protocol_v2
+} // namespace adas
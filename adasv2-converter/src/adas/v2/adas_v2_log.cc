@@ -0,0 +1,662 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef ADASV2_LOG_ZLIB
+#include <zlib.h>
+#endif
+
+#include "adas_v2_log.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+namespace {
+
+const char LOG_FILE_MAGIC[8] = {'A', 'D', 'V', '2', 'B', 'L', 'O', 'G'};
+const size_t LOG_RING_SIZE = 256 * 1024; // 每个线程的缓冲，2的幂
+const size_t LOG_BLOCK_SIZE = 1024 * 1024; // 攒够这么多再写文件
+const int LOG_DRAIN_INTERVAL_US = 5000; // 缓冲都空的时候后台线程的轮询间隔
+
+// 记录头之后的site_id为这几个值时是特殊记录
+const uint32_t LOG_PAD_ID = 0xFFFFFFFF; // 环形缓冲尾部放不下一条记录时的填充，不写文件
+const uint32_t LOG_DROPPED_ID = 0xFFFFFFFE; // 参数为一个UINT，到目前为止丢弃的条数
+const uint32_t LOG_SITE_ID = 0xFFFFFFFD; // 调用点定义: u32 id, i32 line, u32 + 文件名, u32 + 格式串
+
+// 缓冲和文件里的记录都以RecordHeader开头，size包括记录头，是8的倍数
+struct RecordHeader {
+    uint32_t size;
+    uint32_t site_id;
+    uint64_t time_ns;
+};
+
+static_assert(sizeof(RecordHeader) + LOG_MAX_ARGS_SIZE == LOG_RING_SIZE / 2, "LOG_MAX_ARGS_SIZE must fill half a ring");
+
+size_t align8(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+// 调用点定义记录的大小
+size_t site_record_size(const LogSite& site) {
+    return align8(sizeof(RecordHeader) + 16 + strlen(site.file()) + strlen(site.format()));
+}
+
+std::mutex& site_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<const LogSite*>& site_registry() {
+    static std::vector<const LogSite*> sites;
+    return sites;
+}
+
+std::atomic<uint64_t> next_logger_id(1);
+
+// 读取整个文件，.gz结尾的按gzip解压
+int read_log_file(const std::string& file, std::vector<uint8_t>& data) {
+    data.clear();
+    if (file.size() > 3 && 0 == file.compare(file.size() - 3, 3, ".gz")) {
+#ifdef ADASV2_LOG_ZLIB
+        gzFile in = gzopen(file.c_str(), "rb");
+        if (nullptr == in) {
+            return -1;
+        }
+        uint8_t buffer[64 * 1024];
+        int n = 0;
+        while ((n = gzread(in, buffer, sizeof(buffer))) > 0) {
+            data.insert(data.end(), buffer, buffer + n);
+        }
+        gzclose(in);
+        return n < 0 ? -1 : 0;
+#else
+        return -1;
+#endif
+    }
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open()) {
+        return -1;
+    }
+    data.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return 0;
+}
+
+} // namespace
+
+namespace log_detail {
+
+// 单写单读的环形缓冲，写端为owner线程，读端为后台线程。head、tail为累计字节数
+struct LogRing {
+    explicit LogRing(std::thread::id owner_thread) : owner(owner_thread), data(LOG_RING_SIZE) {}
+
+    const std::thread::id owner;
+    std::vector<uint8_t> data;
+    alignas(64) std::atomic<uint64_t> head{0};
+    uint64_t pending = 0; // 写端预留到的位置，commit时发布到head
+    alignas(64) std::atomic<uint64_t> tail{0};
+    uint64_t read = 0; // 读端本轮读到的位置
+    uint64_t limit = 0; // 读端本轮开始时的head
+};
+
+} // namespace log_detail
+
+using log_detail::LogRing;
+
+LogSite::LogSite(const char* file, int line, const char* format) : _file(file), _line(line), _format(format) {
+    std::lock_guard<std::mutex> guard(site_mutex());
+    _id = site_registry().size();
+    site_registry().push_back(this);
+}
+
+size_t format_log_time(uint64_t time_ms, char* out) {
+    // "2024-05-01 12:00:00"，second为-1时还没有缓存
+    struct SecondPrefix {
+        int64_t second = -1;
+        char text[LOG_TIME_LENGTH - 3];
+    };
+    static thread_local SecondPrefix prefix;
+
+    int64_t second = time_ms / 1000;
+    if (second != prefix.second) {
+        time_t seconds = second;
+        struct tm buf;
+        localtime_r(&seconds, &buf);
+        if (LOG_TIME_LENGTH - 4 != strftime(prefix.text, sizeof(prefix.text), "%Y-%m-%d %H:%M:%S", &buf)) {
+            memset(prefix.text, '0', LOG_TIME_LENGTH - 4); // 年份超出4位，不会出现
+        }
+        prefix.second = second;
+    }
+    memcpy(out, prefix.text, LOG_TIME_LENGTH - 4);
+    int millisecond = time_ms % 1000;
+    out[LOG_TIME_LENGTH - 4] = '.';
+    out[LOG_TIME_LENGTH - 3] = '0' + millisecond / 100;
+    out[LOG_TIME_LENGTH - 2] = '0' + millisecond / 10 % 10;
+    out[LOG_TIME_LENGTH - 1] = '0' + millisecond % 10;
+    out[LOG_TIME_LENGTH] = '\0';
+    return LOG_TIME_LENGTH;
+}
+
+const LogSite* LogSite::find(uint32_t id) {
+    std::lock_guard<std::mutex> guard(site_mutex());
+    return id < site_registry().size() ? site_registry()[id] : nullptr;
+}
+
+namespace log_detail {
+
+size_t string_limit(const size_t* lengths, size_t count, size_t fixed_size) {
+    // 截断的字符串多存一个uint32_t原长度，按每个参数都可能截断预留
+    size_t reserved = fixed_size + count * sizeof(uint32_t);
+    if (0 == count || reserved >= LOG_MAX_ARGS_SIZE) {
+        return 0;
+    }
+    size_t budget = LOG_MAX_ARGS_SIZE - reserved;
+    size_t share = budget / count;
+    size_t short_bytes = 0;
+    size_t long_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] <= share) {
+            short_bytes += lengths[i];
+        } else {
+            long_count++;
+        }
+    }
+    return 0 == long_count ? share : (budget - short_bytes) / long_count;
+}
+
+} // namespace log_detail
+
+namespace {
+
+void append_time(uint64_t time_ns, std::string& out) {
+    char text[LOG_TIME_LENGTH + 1];
+    out.append(text, format_log_time(time_ns / 1000000, text));
+}
+
+// 按spec格式化一个值，spec以'%'开头
+template<typename T>
+void append_formatted(std::string& out, const std::string& spec, T value) {
+    char text[128];
+    int length = snprintf(text, sizeof(text), spec.c_str(), value);
+    if (length < 0) {
+        return;
+    }
+    if (size_t(length) < sizeof(text)) {
+        out.append(text, length);
+        return;
+    }
+    std::vector<char> buffer(length + 1);
+    snprintf(buffer.data(), buffer.size(), spec.c_str(), value);
+    out.append(buffer.data(), length);
+}
+
+// 取出下一个参数，越界时返回false
+bool next_arg(const uint8_t*& args, const uint8_t* end, uint8_t& type, uint64_t& bits, std::string& text) {
+    if (args >= end) {
+        return false;
+    }
+    type = *args++;
+    if (LOG_ARG_STRING == type || LOG_ARG_STRING_TRUNCATED == type) {
+        uint32_t size = 0;
+        if (end - args < ptrdiff_t(sizeof(size))) {
+            return false;
+        }
+        memcpy(&size, args, sizeof(size));
+        args += sizeof(size);
+        if (end - args < ptrdiff_t(size)) {
+            return false;
+        }
+        text.assign(reinterpret_cast<const char*>(args), size);
+        args += size;
+        if (LOG_ARG_STRING_TRUNCATED == type) {
+            uint32_t original = 0;
+            if (end - args < ptrdiff_t(sizeof(original))) {
+                return false;
+            }
+            memcpy(&original, args, sizeof(original));
+            args += sizeof(original);
+            text += "...(truncated " + std::to_string(original) + " bytes)";
+            type = LOG_ARG_STRING;
+        }
+        return true;
+    }
+    if (end - args < 8) {
+        return false;
+    }
+    memcpy(&bits, args, 8);
+    args += 8;
+    return true;
+}
+
+// 格式串里的长度修饰(l、ll、z等)按记录的参数类型重写，转换字符保留
+void append_arg(std::string& out, std::string spec, char conversion, uint8_t type, uint64_t bits,
+                const std::string& text) {
+    bool is_float = nullptr != strchr("feEgGaA", conversion);
+    bool is_int = nullptr != strchr("diuxXo", conversion);
+    if (LOG_ARG_STRING == type) {
+        if ('s' == conversion) {
+            append_formatted(out, spec + "s", text.c_str());
+        } else {
+            out += text;
+        }
+    } else if (LOG_ARG_DOUBLE == type) {
+        double value = 0.0;
+        memcpy(&value, &bits, sizeof(value));
+        if (is_int) {
+            append_formatted(out, spec + "ll" + conversion, (long long)value);
+        } else {
+            append_formatted(out, spec + (is_float ? conversion : 'f'), value);
+        }
+    } else {
+        long long value = (long long)bits;
+        if (is_float) {
+            append_formatted(out, spec + conversion, LOG_ARG_INT == type ? double(value) : double(bits));
+        } else if (is_int) {
+            append_formatted(out, spec + "ll" + conversion, value);
+        } else {
+            append_formatted(out, spec + (LOG_ARG_INT == type ? "lld" : "llu"), value);
+        }
+    }
+}
+
+} // namespace
+
+std::string format_log_record(uint64_t time_ns, const char* file, int line, const char* format,
+                              const uint8_t* args, size_t args_size) {
+    std::string out;
+    out.reserve(128);
+    append_time(time_ns, out);
+    out += '[';
+    out += file;
+    out += ':';
+    out += std::to_string(line);
+    out += ']';
+
+    const uint8_t* end = args + args_size;
+    std::string text;
+    for (const char* p = format; '\0' != *p; p++) {
+        if ('%' != *p) {
+            out += *p;
+            continue;
+        }
+        if ('%' == p[1]) {
+            out += '%';
+            p++;
+            continue;
+        }
+        // %[flags][width][.precision][length]conversion
+        const char* q = p + 1;
+        while ('\0' != *q && nullptr != strchr("-+ #0", *q)) {
+            q++;
+        }
+        while (*q >= '0' && *q <= '9') {
+            q++;
+        }
+        if ('.' == *q) {
+            q++;
+            while (*q >= '0' && *q <= '9') {
+                q++;
+            }
+        }
+        std::string spec(p, q);
+        while ('\0' != *q && nullptr != strchr("hlzjtLq", *q)) {
+            q++;
+        }
+        if ('\0' == *q) {
+            out.append(p);
+            break;
+        }
+        uint8_t type = 0;
+        uint64_t bits = 0;
+        if (!next_arg(args, end, type, bits, text)) {
+            out.append(p, q + 1);
+        } else {
+            append_arg(out, spec, *q, type, bits, text);
+        }
+        p = q;
+    }
+    return out;
+}
+
+int decode_log_file(const std::string& file, std::ostream& out) {
+    std::vector<uint8_t> data;
+    if (0 != read_log_file(file, data)) {
+        return -1;
+    }
+    if (data.size() < sizeof(LOG_FILE_MAGIC) || 0 != memcmp(data.data(), LOG_FILE_MAGIC, sizeof(LOG_FILE_MAGIC))) {
+        return -1;
+    }
+
+    struct Site {
+        int line = 0;
+        std::string file;
+        std::string format;
+    };
+    std::vector<Site> sites;
+    size_t pos = sizeof(LOG_FILE_MAGIC);
+    while (pos + sizeof(RecordHeader) <= data.size()) {
+        RecordHeader header;
+        memcpy(&header, &data[pos], sizeof(header));
+        if (0 == header.size) {
+            // 异常退出时正在写的文件没有截断，预分配的尾部都是0
+            return 0;
+        }
+        if (header.size < sizeof(header) || header.size > data.size() - pos) {
+            return -1;
+        }
+        const uint8_t* body = &data[pos + sizeof(header)];
+        size_t body_size = header.size - sizeof(header);
+        pos += header.size;
+
+        if (LOG_SITE_ID == header.site_id) {
+            // u32 id, i32 line, u32 + 文件名, u32 + 格式串
+            uint32_t id = 0;
+            int32_t line = 0;
+            uint32_t file_size = 0;
+            uint32_t format_size = 0;
+            if (body_size < 16) {
+                return -1;
+            }
+            memcpy(&id, body, 4);
+            memcpy(&line, body + 4, 4);
+            memcpy(&file_size, body + 8, 4);
+            if (body_size < 16 + size_t(file_size)) {
+                return -1;
+            }
+            memcpy(&format_size, body + 12 + file_size, 4);
+            if (body_size < 16 + size_t(file_size) + format_size) {
+                return -1;
+            }
+            if (sites.size() <= id) {
+                sites.resize(id + 1);
+            }
+            sites[id].line = line;
+            sites[id].file.assign(reinterpret_cast<const char*>(body + 12), file_size);
+            sites[id].format.assign(reinterpret_cast<const char*>(body + 16 + file_size), format_size);
+        } else if (LOG_DROPPED_ID == header.site_id) {
+            out << format_log_record(header.time_ns, "log", 0, "dropped %lu records", body, body_size) << "\n";
+        } else {
+            if (header.site_id >= sites.size()) {
+                return -1;
+            }
+            const Site& site = sites[header.site_id];
+            out << format_log_record(header.time_ns, site.file.c_str(), site.line, site.format.c_str(),
+                                     body, body_size) << "\n";
+        }
+    }
+    return pos == data.size() ? 0 : -1;
+}
+
+BinaryLogger::BinaryLogger() : _logger_id(next_logger_id++), _running(false), _stop(false), _dropped(0), _truncated(0),
+        _level(LOG_LEVEL_DEBUG) {}
+
+BinaryLogger::~BinaryLogger() {
+    close();
+}
+
+int BinaryLogger::open(const std::string& file, const LogRotation& rotation) {
+    if (_running) {
+        return -1;
+    }
+    if (0 != _writer.open(file, rotation, std::string(LOG_FILE_MAGIC, sizeof(LOG_FILE_MAGIC)))) {
+        return -1;
+    }
+
+    _block.clear();
+    _block_records = 0;
+    _block.reserve(LOG_BLOCK_SIZE + LOG_RING_SIZE);
+    _written_sites.clear();
+    _reported_dropped = _dropped;
+    _stop = false;
+    _running.store(true, std::memory_order_release);
+    _drainer = std::thread(&BinaryLogger::_drain_loop, this);
+    pthread_setname_np(_drainer.native_handle(), "_async_tid");
+    return 0;
+}
+
+void BinaryLogger::close() {
+    if (!_running) {
+        return;
+    }
+    // 先让新的日志走std::cout，再让后台线程写完缓冲里剩下的
+    _running.store(false, std::memory_order_release);
+    _stop = true;
+    _drainer.join();
+    _writer.close();
+}
+
+LogRing* BinaryLogger::_thread_ring() {
+    // 每个线程缓存最近用过的几个logger的缓冲，logger_id全局唯一，析构的logger不会被误用
+    struct CacheEntry {
+        uint64_t logger_id;
+        LogRing* ring;
+    };
+    static const int CACHE_SIZE = 4;
+    thread_local CacheEntry cache[CACHE_SIZE] = {};
+    thread_local int cache_next = 0;
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (_logger_id == cache[i].logger_id) {
+            return cache[i].ring;
+        }
+    }
+
+    LogRing* ring = nullptr;
+    std::thread::id self = std::this_thread::get_id();
+    {
+        std::lock_guard<std::mutex> guard(_rings_mutex);
+        for (size_t i = 0; i < _rings.size() && nullptr == ring; i++) {
+            if (self == _rings[i]->owner) {
+                ring = _rings[i].get();
+            }
+        }
+        if (nullptr == ring) {
+            _rings.emplace_back(new LogRing(self));
+            ring = _rings.back().get();
+        }
+    }
+    cache[cache_next].logger_id = _logger_id;
+    cache[cache_next].ring = ring;
+    cache_next = (cache_next + 1) % CACHE_SIZE;
+    return ring;
+}
+
+uint8_t* BinaryLogger::_reserve(LogRing* ring, const LogSite& site, uint64_t time_ns, size_t args_size) {
+    size_t size = align8(sizeof(RecordHeader) + args_size);
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    size_t pos = head & (LOG_RING_SIZE - 1);
+    size_t contiguous = LOG_RING_SIZE - pos;
+    size_t padding = contiguous < size ? contiguous : 0;
+    if (size > LOG_RING_SIZE / 2 || head + padding + size - tail > LOG_RING_SIZE) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    RecordHeader header;
+    if (0 != padding) {
+        header.size = padding;
+        header.site_id = LOG_PAD_ID;
+        header.time_ns = 0;
+        memcpy(&ring->data[pos], &header, sizeof(uint32_t) * 2);
+        pos = 0;
+    }
+    header.size = size;
+    header.site_id = site.id();
+    header.time_ns = time_ns;
+    memcpy(&ring->data[pos], &header, sizeof(header));
+    ring->pending = head + padding + size;
+    return &ring->data[pos + sizeof(header)];
+}
+
+void BinaryLogger::_commit(LogRing* ring) {
+    ring->head.store(ring->pending, std::memory_order_release);
+}
+
+void BinaryLogger::_print(const LogSite& site, uint64_t time_ns, const uint8_t* args, size_t args_size) {
+    std::cout << format_log_record(time_ns, site.file(), site.line(), site.format(), args, args_size) << std::endl;
+}
+
+void BinaryLogger::_append_site(const LogSite& site) {
+    uint32_t id = site.id();
+    int32_t line = site.line();
+    uint32_t file_size = strlen(site.file());
+    uint32_t format_size = strlen(site.format());
+    RecordHeader header;
+    header.size = site_record_size(site);
+    header.site_id = LOG_SITE_ID;
+    header.time_ns = 0;
+
+    size_t start = _block.size();
+    _block.resize(start + header.size, 0);
+    uint8_t* out = &_block[start];
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, &id, 4);
+    memcpy(out + 4, &line, 4);
+    memcpy(out + 8, &file_size, 4);
+    memcpy(out + 12, site.file(), file_size);
+    memcpy(out + 12 + file_size, &format_size, 4);
+    memcpy(out + 16 + file_size, site.format(), format_size);
+}
+
+size_t BinaryLogger::_collect() {
+    std::vector<LogRing*> rings;
+    {
+        std::lock_guard<std::mutex> guard(_rings_mutex);
+        for (size_t i = 0; i < _rings.size(); i++) {
+            rings.push_back(_rings[i].get());
+        }
+    }
+    for (size_t i = 0; i < rings.size(); i++) {
+        rings[i]->read = rings[i]->tail.load(std::memory_order_relaxed);
+        rings[i]->limit = rings[i]->head.load(std::memory_order_acquire);
+    }
+
+    // 每个线程的记录按时间有序，每次取各线程下一条记录里最早的一条
+    size_t count = 0;
+    while (true) {
+        LogRing* next = nullptr;
+        RecordHeader next_header;
+        for (size_t i = 0; i < rings.size(); i++) {
+            LogRing* ring = rings[i];
+            RecordHeader header;
+            while (ring->read < ring->limit) {
+                // 填充记录可能只有size和site_id两个字段，先读这两个
+                const uint8_t* record = &ring->data[ring->read & (LOG_RING_SIZE - 1)];
+                memcpy(&header, record, sizeof(uint32_t) * 2);
+                if (LOG_PAD_ID != header.site_id) {
+                    memcpy(&header, record, sizeof(header));
+                    break;
+                }
+                ring->read += header.size;
+            }
+            if (ring->read < ring->limit && (nullptr == next || header.time_ns < next_header.time_ns)) {
+                next = ring;
+                next_header = header;
+            }
+        }
+        if (nullptr == next) {
+            break;
+        }
+
+        const LogSite* site = LogSite::find(next_header.site_id);
+        _ensure_space(next_header.size + (nullptr == site ? 0 : site_record_size(*site)));
+        if (_written_sites.size() <= next_header.site_id) {
+            _written_sites.resize(next_header.site_id + 1, false);
+        }
+        if (!_written_sites[next_header.site_id]) {
+            if (nullptr != site) {
+                _append_site(*site);
+            }
+            _written_sites[next_header.site_id] = true;
+        }
+        const uint8_t* record = &next->data[next->read & (LOG_RING_SIZE - 1)];
+        _block.insert(_block.end(), record, record + next_header.size);
+        _block_records++;
+        next->read += next_header.size;
+        count++;
+    }
+
+    for (size_t i = 0; i < rings.size(); i++) {
+        rings[i]->tail.store(rings[i]->read, std::memory_order_release);
+    }
+
+    // 没有打开的文件时丢弃统计写不出去，等重新打开之后再写
+    uint64_t dropped = _dropped.load(std::memory_order_relaxed);
+    if (dropped != _reported_dropped && _writer.is_open()) {
+        RecordHeader header;
+        header.size = sizeof(header) + 16;
+        _ensure_space(header.size);
+        header.site_id = LOG_DROPPED_ID;
+        header.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        uint8_t body[16] = {LOG_ARG_UINT};
+        memcpy(body + 1, &dropped, sizeof(dropped));
+        _block.insert(_block.end(), reinterpret_cast<const uint8_t*>(&header),
+                      reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+        _block.insert(_block.end(), body, body + sizeof(body));
+        _reported_dropped = dropped;
+    }
+    return count;
+}
+
+void BinaryLogger::_ensure_space(size_t size) {
+    if (_block.size() + size > _writer.available()) {
+        _rotate();
+    }
+}
+
+void BinaryLogger::_rotate() {
+    if (_writer.is_open()) {
+        _flush_block();
+        _written_sites.assign(_written_sites.size(), false);
+    }
+    // 重新打开成功时_block(包括其中的调用点定义)写进新文件，否则丢弃
+    if (0 != _writer.rotate()) {
+        _discard_block();
+    }
+}
+
+void BinaryLogger::_flush_block() {
+    if (0 != _writer.append(_block.data(), _block.size())) {
+        _discard_block();
+        return;
+    }
+    _writer.sync();
+    _block.clear();
+    _block_records = 0;
+}
+
+void BinaryLogger::_discard_block() {
+    _dropped.fetch_add(_block_records, std::memory_order_relaxed);
+    _block.clear();
+    _block_records = 0;
+    // 调用点定义跟着_block一起丢了，之后的日志重新带上定义
+    _written_sites.assign(_written_sites.size(), false);
+}
+
+void BinaryLogger::_drain_loop() {
+    while (!_stop) {
+        size_t count = _collect();
+        if (_block.size() >= LOG_BLOCK_SIZE || (0 == count && !_block.empty())) {
+            _flush_block();
+        }
+        // 切文件失败之后每一轮都尝试重新打开，没到重试时间时rotate直接返回
+        if (_writer.expired() || !_writer.is_open()) {
+            _rotate();
+        }
+        if (0 == count) {
+            usleep(LOG_DRAIN_INTERVAL_US);
+        }
+    }
+    while (0 != _collect()) {
+    }
+    _flush_block();
+}
+
+} // namespace protocol_v2
+} // namespace adas
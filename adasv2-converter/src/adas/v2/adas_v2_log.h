@@ -0,0 +1,339 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "adas_v2_log_file.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+// 二进制日志。写日志的线程只把时间戳、调用点id和原始参数拷进本线程的环形缓冲，
+// 不格式化、不加锁、不分配内存；后台线程把各线程的记录按时间归并，攒成大块写文件；
+// 文本由离线解码器(tools/adasv2_log_decode)按调用点的格式串生成，格式为
+//   2024-05-01 12:00:00.123[src/adas/v2/adas_v2_protocol.cc:85]input loc
+// 格式串为printf风格，编译期检查格式串和参数是否匹配，参数按类型记录:
+// 整数(%d %ld %lu %zu等)、浮点(%f %.3f等)、字符串(%s，传const char*)。
+// 一条记录的参数超过LOG_MAX_ARGS_SIZE时截断其中的长字符串，解码出的文本在截断处标出原长度。
+//
+//   ADASV2_LOG(logger, LOG_LEVEL_INFO, "send segment size:%zu", segment_messages.size());
+//
+// 没有打开日志文件时直接格式化输出到std::cout。
+// 低于编译期最低级别ADASV2_LOG_MIN_LEVEL或者运行时级别(BinaryLogger::set_level)的日志，
+// 参数表达式不会被求值；低于编译期级别的调用点整个被编译器去掉。
+
+// 编译期最低日志级别，比如-DADASV2_LOG_MIN_LEVEL=1去掉所有LOG_LEVEL_DEBUG的日志
+#ifndef ADASV2_LOG_MIN_LEVEL
+#define ADASV2_LOG_MIN_LEVEL 0
+#endif
+
+enum LogLevel {
+    LOG_LEVEL_DEBUG = 0, // 每个定位点、每条link、耗时统计这类高频日志
+    LOG_LEVEL_INFO = 1,
+    LOG_LEVEL_WARN = 2,
+    LOG_LEVEL_ERROR = 3,
+    LOG_LEVEL_OFF = 4,   // 只用于set_level，关闭所有日志
+};
+
+// 一个调用点，第一次执行到时注册，id在进程内唯一
+class LogSite {
+public:
+    LogSite(const char* file, int line, const char* format);
+
+    uint32_t id() const {
+        return _id;
+    }
+
+    const char* file() const {
+        return _file;
+    }
+
+    int line() const {
+        return _line;
+    }
+
+    const char* format() const {
+        return _format;
+    }
+
+    // 按id查找，id不存在时返回nullptr
+    static const LogSite* find(uint32_t id);
+
+private:
+    const char* _file;
+    int _line;
+    const char* _format;
+    uint32_t _id;
+};
+
+enum LogArgType {
+    LOG_ARG_INT = 1,    // int64_t
+    LOG_ARG_UINT = 2,   // uint64_t
+    LOG_ARG_DOUBLE = 3, // double
+    LOG_ARG_STRING = 4, // uint32_t长度 + 字节
+    LOG_ARG_STRING_TRUNCATED = 5, // uint32_t保留的长度 + 字节 + uint32_t原长度
+};
+
+// 一条记录的参数最多这么多字节(线程缓冲的一半减去记录头)，超过时截断字符串参数
+const size_t LOG_MAX_ARGS_SIZE = 128 * 1024 - 16;
+
+// format_log_time输出的长度，不含结尾的'\0'
+const size_t LOG_TIME_LENGTH = 23;
+
+/**
+ * @brief 把毫秒时间戳格式化成本地时间"2024-05-01 12:00:00.123"，写入out(至少LOG_TIME_LENGTH + 1字节)。
+ *        精确到秒的前缀按线程缓存，同一秒内只改写毫秒，不调用localtime_r和strftime
+ * @return 写入的长度(不含'\0')
+*/
+size_t format_log_time(uint64_t time_ms, char* out);
+
+/**
+ * @brief 按调用点的格式串和编码后的参数生成一行文本(不带换行)，时间、文件、行号在前。
+ *        args为依次存放的1字节LogArgType + 值
+*/
+std::string format_log_record(uint64_t time_ns, const char* file, int line, const char* format,
+                              const uint8_t* args, size_t args_size);
+
+/**
+ * @brief 把BinaryLogger写出的文件解码成文本，每条日志一行。.gz结尾的文件先解压(编译时有zlib)
+ * @return 0 for ok, -1 for 文件打不开或者格式不对(已经解出的部分会输出)
+*/
+int decode_log_file(const std::string& file, std::ostream& out);
+
+namespace log_detail {
+
+// 参数编码: 先算总长度，再写入预留好的空间。limit为字符串参数最多保留的字节数，只在记录超长时小于原长度
+const size_t NO_STRING_LIMIT = size_t(-1);
+
+inline size_t string_length(const char* value) {
+    return nullptr == value ? 0 : strlen(value);
+}
+
+template<typename T>
+inline size_t string_length(const T&) {
+    return 0;
+}
+
+inline size_t arg_size(const char* value, size_t limit) {
+    size_t size = string_length(value);
+    return size > limit ? 1 + 2 * sizeof(uint32_t) + limit : 1 + sizeof(uint32_t) + size;
+}
+
+template<typename T>
+inline size_t arg_size(const T&, size_t) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "unsupported log argument type");
+    return 1 + 8;
+}
+
+inline size_t args_size(size_t) {
+    return 0;
+}
+
+template<typename T, typename... Args>
+inline size_t args_size(size_t limit, const T& value, const Args&... args) {
+    return arg_size(value, limit) + args_size(limit, args...);
+}
+
+/**
+ * @brief 参数总长超过LOG_MAX_ARGS_SIZE时字符串参数的截断长度: 先按参数个数平分预算，
+ *        不超过平分值的字符串原样保留，省下的再平分给其余字符串。lengths为各参数的字符串长度，非字符串为0
+*/
+size_t string_limit(const size_t* lengths, size_t count, size_t fixed_size);
+
+inline uint8_t* put_string(uint8_t* out, const char* data, uint32_t size) {
+    *out++ = LOG_ARG_STRING;
+    memcpy(out, &size, sizeof(size));
+    memcpy(out + sizeof(size), data, size);
+    return out + sizeof(size) + size;
+}
+
+inline uint8_t* put_arg(uint8_t* out, const char* value, size_t limit) {
+    size_t size = string_length(value);
+    if (size <= limit) {
+        return put_string(out, value, size);
+    }
+    // 截断时类型改为LOG_ARG_STRING_TRUNCATED，最后补上原长度
+    uint8_t* end = put_string(out, value, limit);
+    *out = LOG_ARG_STRING_TRUNCATED;
+    uint32_t original = size;
+    memcpy(end, &original, sizeof(original));
+    return end + sizeof(original);
+}
+
+template<typename T>
+inline uint8_t* put_arg(uint8_t* out, const T& value, size_t) {
+    if (std::is_floating_point<T>::value) {
+        double v = value;
+        *out = LOG_ARG_DOUBLE;
+        memcpy(out + 1, &v, 8);
+    } else if (std::is_signed<T>::value || std::is_enum<T>::value) {
+        int64_t v = int64_t(value);
+        *out = LOG_ARG_INT;
+        memcpy(out + 1, &v, 8);
+    } else {
+        uint64_t v = uint64_t(value);
+        *out = LOG_ARG_UINT;
+        memcpy(out + 1, &v, 8);
+    }
+    return out + 9;
+}
+
+inline uint8_t* put_args(uint8_t* out, size_t) {
+    return out;
+}
+
+template<typename T, typename... Args>
+inline uint8_t* put_args(uint8_t* out, size_t limit, const T& value, const Args&... args) {
+    return put_args(put_arg(out, value, limit), limit, args...);
+}
+
+// 只用于编译期检查格式串和参数是否匹配，不会被调用
+inline void check_format(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void check_format(const char*, ...) {}
+
+struct LogRing;
+
+} // namespace log_detail
+
+class BinaryLogger {
+public:
+    BinaryLogger();
+    ~BinaryLogger();
+
+    BinaryLogger(const BinaryLogger&) = delete;
+    BinaryLogger& operator=(const BinaryLogger&) = delete;
+
+    /**
+     * @brief 打开日志文件并启动后台写文件线程，按rotation切分文件，见LogRotation
+     * @return 0 for ok, -1 for 已经打开或者文件打不开
+    */
+    int open(const std::string& file, const LogRotation& rotation = LogRotation());
+
+    /**
+     * @brief 写完所有线程缓冲里的日志后关闭文件，之后的日志输出到std::cout
+    */
+    void close();
+
+    bool is_open() const {
+        return _running.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 设置运行时最低日志级别，默认LOG_LEVEL_DEBUG，低于编译期级别的日志不受影响仍然不输出
+    */
+    void set_level(LogLevel level) {
+        _level.store(level, std::memory_order_relaxed);
+    }
+
+    bool enabled(LogLevel level) const {
+        return level >= _level.load(std::memory_order_relaxed);
+    }
+
+    // 缓冲满，或者切文件失败、没有可写的日志文件而被丢弃的日志条数
+    uint64_t dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    // 参数超长、字符串被截断的日志条数
+    uint64_t truncated() const {
+        return _truncated.load(std::memory_order_relaxed);
+    }
+
+    template<typename... Args>
+    void write(const LogSite& site, const Args&... args) {
+        uint64_t time_ns = _now_ns();
+        size_t limit = log_detail::NO_STRING_LIMIT;
+        size_t size = log_detail::args_size(limit, args...);
+        if (!is_open()) {
+            std::vector<uint8_t> buffer(size);
+            log_detail::put_args(buffer.data(), limit, args...);
+            _print(site, time_ns, buffer.data(), size);
+            return;
+        }
+        if (size > LOG_MAX_ARGS_SIZE) {
+            const size_t lengths[] = {log_detail::string_length(args)..., 0};
+            size_t strings = 0;
+            for (size_t i = 0; i < sizeof...(Args); i++) {
+                strings += lengths[i];
+            }
+            limit = log_detail::string_limit(lengths, sizeof...(Args), size - strings);
+            size = log_detail::args_size(limit, args...);
+            _truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+        log_detail::LogRing* ring = _thread_ring();
+        uint8_t* out = _reserve(ring, site, time_ns, size);
+        if (nullptr != out) {
+            log_detail::put_args(out, limit, args...);
+            _commit(ring);
+        }
+    }
+
+private:
+    static uint64_t _now_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // 在本线程的环形缓冲里写好记录头，返回参数的写入位置，缓冲满时返回nullptr
+    uint8_t* _reserve(log_detail::LogRing* ring, const LogSite& site, uint64_t time_ns, size_t args_size);
+    void _commit(log_detail::LogRing* ring);
+    void _print(const LogSite& site, uint64_t time_ns, const uint8_t* args, size_t args_size);
+    log_detail::LogRing* _thread_ring();
+
+    void _drain_loop();
+    // 把各线程缓冲里已有的记录按时间归并到_block，返回取出的记录数
+    size_t _collect();
+    void _append_site(const LogSite& site);
+    // 当前文件放不下_block再加size字节时，先写出_block并切到新文件
+    void _ensure_space(size_t size);
+    // 切到新文件；没有打开的文件时按退避间隔重新打开，打不开则丢弃_block
+    void _rotate();
+    // 写出_block，写不进去时丢弃
+    void _flush_block();
+    // 丢弃_block，其中的日志计入_dropped
+    void _discard_block();
+
+    const uint64_t _logger_id;
+    std::atomic<bool> _running;
+    std::atomic<bool> _stop;
+    std::atomic<uint64_t> _dropped;
+    std::atomic<uint64_t> _truncated;
+    std::atomic<int> _level;
+    std::thread _drainer;
+
+    std::mutex _rings_mutex;
+    std::vector<std::unique_ptr<log_detail::LogRing> > _rings;
+
+    // 以下只由后台线程访问
+    LogSegmentWriter _writer;
+    std::vector<uint8_t> _block; // 待写文件的数据，攒够一块或者空闲时写一次
+    size_t _block_records = 0; // _block里的日志条数，不含调用点定义和丢弃统计
+    std::vector<bool> _written_sites; // 调用点的定义是否已经写进当前文件，每个文件单独可解码
+    uint64_t _reported_dropped = 0;
+}; // class BinaryLogger
+
+} // namespace protocol_v2
+} // namespace adas
+
+// level须为常量，编译期的比较会被折叠掉；参数只在日志会输出时求值
+#define ADASV2_LOG(logger, level, format, ...) do { \
+    if ((level) >= ADASV2_LOG_MIN_LEVEL && (logger).enabled(level)) { \
+        static const ::adas::protocol_v2::LogSite _adasv2_log_site(__FILE__, __LINE__, format); \
+        if (false) { \
+            ::adas::protocol_v2::log_detail::check_format(format, ##__VA_ARGS__); \
+        } \
+        (logger).write(_adasv2_log_site, ##__VA_ARGS__); \
+    } \
+} while (0)
@@ -0,0 +1,276 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifdef ADASV2_LOG_ZLIB
+#include <zlib.h>
+#endif
+
+#include "adas_v2_log_file.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+namespace {
+
+const size_t MIN_SEGMENT_SIZE = 1024 * 1024;
+const size_t COMPRESS_BUFFER_SIZE = 64 * 1024;
+// 新文件打开失败后的重试间隔，从最小值开始每次加倍
+const uint64_t RETRY_MIN_MS = 100;
+const uint64_t RETRY_MAX_MS = 10000;
+
+uint64_t monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return uint64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// name为prefix + 数字 + suffix时取出数字，否则返回0
+uint64_t segment_index(const std::string& name, const std::string& prefix, const std::string& suffix) {
+    if (name.size() <= prefix.size() + suffix.size() || 0 != name.compare(0, prefix.size(), prefix) ||
+            0 != name.compare(name.size() - suffix.size(), suffix.size(), suffix)) {
+        return 0;
+    }
+    uint64_t index = 0;
+    for (size_t i = prefix.size(); i < name.size() - suffix.size(); i++) {
+        if (name[i] < '0' || name[i] > '9') {
+            return 0;
+        }
+        index = index * 10 + (name[i] - '0');
+    }
+    return index;
+}
+
+} // namespace
+
+LogSegmentWriter::~LogSegmentWriter() {
+    close();
+}
+
+int LogSegmentWriter::open(const std::string& file, const LogRotation& rotation, const std::string& header) {
+    if (is_open() || _archiver.joinable()) {
+        return -1;
+    }
+    _file = file;
+    _rotation = rotation;
+    _rotation.max_segments = std::max(rotation.max_segments, 1);
+    long page = sysconf(_SC_PAGESIZE);
+    _capacity = std::max(rotation.segment_size, std::max(MIN_SEGMENT_SIZE, header.size()));
+    _capacity = (_capacity + page - 1) / page * page;
+    _header = header;
+
+    // 找出上次运行留下的file.N、file.N.gz，没压缩完的临时文件直接删掉
+    size_t slash = file.rfind('/');
+    std::string dir = std::string::npos == slash ? "." : file.substr(0, slash + 1);
+    std::string prefix = (std::string::npos == slash ? file : file.substr(slash + 1)) + ".";
+    std::vector<std::pair<uint64_t, std::string> > found;
+    DIR* handle = opendir(dir.c_str());
+    if (nullptr != handle) {
+        std::string path_prefix = std::string::npos == slash ? "" : dir;
+        for (struct dirent* entry = readdir(handle); nullptr != entry; entry = readdir(handle)) {
+            std::string name = entry->d_name;
+            uint64_t index = segment_index(name, prefix, "");
+            if (0 == index) {
+                index = segment_index(name, prefix, ".gz");
+            }
+            if (0 != index) {
+                found.push_back(std::make_pair(index, path_prefix + name));
+            } else if (0 != segment_index(name, prefix, ".gz.tmp")) {
+                unlink((path_prefix + name).c_str());
+            }
+        }
+        closedir(handle);
+    }
+    std::sort(found.begin(), found.end());
+
+    _stop = false;
+    _retry_ms = 0;
+    _retry_interval_ms = 0;
+    _pending.clear();
+    _archives.clear();
+    _next_index = found.empty() ? 1 : found.back().first + 1;
+    for (size_t i = 0; i < found.size(); i++) {
+        _archives.push_back(found[i].second);
+    }
+    struct stat st;
+    if (0 == stat(file.c_str(), &st) && st.st_size > 0) {
+        _archive_active();
+    }
+    _archiver = std::thread(&LogSegmentWriter::_archive_loop, this);
+    pthread_setname_np(_archiver.native_handle(), "_log_archive");
+
+    if (0 != _open_segment()) {
+        close();
+        return -1;
+    }
+    return 0;
+}
+
+void LogSegmentWriter::close() {
+    _close_segment();
+    if (_archiver.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(_archive_mutex);
+            _stop = true;
+        }
+        _archive_cond.notify_all();
+        _archiver.join();
+    }
+}
+
+bool LogSegmentWriter::expired() const {
+    return is_open() && _rotation.segment_seconds > 0 && _size > _header.size() &&
+            monotonic_ms() - _opened_ms >= uint64_t(_rotation.segment_seconds) * 1000;
+}
+
+int LogSegmentWriter::append(const uint8_t* data, size_t size) {
+    if (!is_open() || size > available()) {
+        return -1;
+    }
+    memcpy(_data + _size, data, size);
+    _size += size;
+    return 0;
+}
+
+void LogSegmentWriter::sync() {
+    if (!is_open() || _size == _synced) {
+        return;
+    }
+    size_t start = _synced & ~size_t(sysconf(_SC_PAGESIZE) - 1);
+    msync(_data + start, _size - start, MS_ASYNC);
+    _synced = _size;
+}
+
+int LogSegmentWriter::rotate() {
+    if (!_archiver.joinable()) {
+        return -1;
+    }
+    if (is_open()) {
+        _close_segment();
+        _archive_active();
+    } else if (monotonic_ms() < _retry_ms) {
+        return -1;
+    }
+    if (0 != _open_segment()) {
+        _retry_interval_ms = 0 == _retry_interval_ms ? RETRY_MIN_MS :
+                std::min(2 * _retry_interval_ms, RETRY_MAX_MS);
+        _retry_ms = monotonic_ms() + _retry_interval_ms;
+        return -1;
+    }
+    _retry_interval_ms = 0;
+    return 0;
+}
+
+int LogSegmentWriter::_open_segment() {
+    _fd = ::open(_file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        return -1;
+    }
+    // 先把磁盘空间分配好，磁盘满时在这里失败，而不是写映射内存时收到SIGBUS
+    void* data = MAP_FAILED;
+    if (0 == posix_fallocate(_fd, 0, _capacity)) {
+        data = mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    }
+    if (MAP_FAILED == data) {
+        ::close(_fd);
+        _fd = -1;
+        return -1;
+    }
+    _data = static_cast<uint8_t*>(data);
+    memcpy(_data, _header.data(), _header.size());
+    _size = _header.size();
+    _synced = 0;
+    _opened_ms = monotonic_ms();
+    return 0;
+}
+
+void LogSegmentWriter::_close_segment() {
+    if (!is_open()) {
+        return;
+    }
+    munmap(_data, _capacity);
+    _data = nullptr;
+    if (0 != ftruncate(_fd, _size)) {
+        perror("truncate log segment");
+    }
+    ::close(_fd);
+    _fd = -1;
+}
+
+void LogSegmentWriter::_archive_active() {
+    std::string path = _file + "." + std::to_string(_next_index++);
+    if (0 != rename(_file.c_str(), path.c_str())) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_archive_mutex);
+        _pending.push_back(path);
+    }
+    _archive_cond.notify_one();
+}
+
+void LogSegmentWriter::_archive_loop() {
+    std::unique_lock<std::mutex> lock(_archive_mutex);
+    while (true) {
+        // 正在写的文件占一个，超出的从最旧的开始删
+        while (!_archives.empty() && _archives.size() + _pending.size() + 1 > size_t(_rotation.max_segments)) {
+            unlink(_archives.front().c_str());
+            _archives.pop_front();
+        }
+        _archive_cond.wait(lock, [this]() {
+            return _stop || !_pending.empty();
+        });
+        if (_pending.empty()) {
+            break;
+        }
+        std::string path = _pending.front();
+        lock.unlock();
+        std::string archived = _rotation.compress ? _compress(path) : path;
+        lock.lock();
+        _pending.pop_front();
+        _archives.push_back(archived);
+    }
+}
+
+std::string LogSegmentWriter::_compress(const std::string& path) {
+#ifdef ADASV2_LOG_ZLIB
+    std::string gz_path = path + ".gz";
+    std::string tmp_path = gz_path + ".tmp";
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return path;
+    }
+    gzFile out = gzopen(tmp_path.c_str(), "wb6");
+    if (nullptr == out) {
+        ::close(fd);
+        return path;
+    }
+    std::vector<char> buffer(COMPRESS_BUFFER_SIZE);
+    bool ok = true;
+    ssize_t n = 0;
+    while (ok && (n = read(fd, buffer.data(), buffer.size())) > 0) {
+        ok = gzwrite(out, buffer.data(), n) == n;
+    }
+    ok = gzclose(out) == Z_OK && ok && 0 == n;
+    ::close(fd);
+    if (ok && 0 == rename(tmp_path.c_str(), gz_path.c_str())) {
+        unlink(path.c_str());
+        return gz_path;
+    }
+    unlink(tmp_path.c_str());
+#endif
+    return path;
+}
+
+} // namespace protocol_v2
+} // namespace adas
@@ -0,0 +1,110 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace adas {
+namespace protocol_v2 {
+
+// 日志文件按大小和时间切分，总数固定。正在写的文件为file，切出去的文件改名为file.N(N递增)，
+// 由后台线程压缩成file.N.gz(编译时有zlib)，并删除超出数量的最旧文件。
+// 重启时把上次留下的file也切出去，已有的file.N和file.N.gz一起计数。
+struct LogRotation {
+    size_t segment_size = 32 * 1024 * 1024; // 单个文件的大小上限，byte
+    int segment_seconds = 0; // 单个文件最长写多久，0为不按时间切
+    int max_segments = 8; // 包括正在写的文件
+    bool compress = true; // 切出去的文件是否压缩
+};
+
+// 正在写的文件预先分配到segment_size并整个mmap，追加时只拷贝内存，不走write系统调用；
+// 进程崩溃时已经拷进去的数据由内核写回，文件尾部是没写到的0。
+// 除构造析构外都只由一个线程调用(BinaryLogger的后台线程)。
+class LogSegmentWriter {
+public:
+    LogSegmentWriter() = default;
+    ~LogSegmentWriter();
+
+    LogSegmentWriter(const LogSegmentWriter&) = delete;
+    LogSegmentWriter& operator=(const LogSegmentWriter&) = delete;
+
+    /**
+     * @brief 打开file作为第一个文件，header为每个文件开头的内容(文件magic)
+     * @return 0 for ok, -1 for 已经打开或者文件创建、映射失败
+    */
+    int open(const std::string& file, const LogRotation& rotation, const std::string& header);
+
+    /**
+     * @brief 把正在写的文件截断到实际长度后关闭，等后台线程处理完切出去的文件
+    */
+    void close();
+
+    bool is_open() const {
+        return nullptr != _data;
+    }
+
+    // 当前文件还能追加的字节数
+    size_t available() const {
+        return nullptr == _data ? 0 : _capacity - _size;
+    }
+
+    // 当前文件写的时间超过segment_seconds，并且写过日志
+    bool expired() const;
+
+    /**
+     * @brief 追加到当前文件，放不下或者没有打开的文件时返回-1，不自动切文件
+    */
+    int append(const uint8_t* data, size_t size);
+
+    /**
+     * @brief 发起上次sync之后追加部分的异步写回(MS_ASYNC)，不等待
+    */
+    void sync();
+
+    /**
+     * @brief 关闭当前文件，交给后台线程压缩，打开新的file。
+     *        新文件打开失败(磁盘满等)之后没有打开的文件，再调用时按退避间隔重新打开file，
+     *        没到重试时间直接返回-1
+     * @return 0 for ok, -1 for 新文件打开失败或者还没到重试时间(之后append都失败，直到重新打开成功)
+    */
+    int rotate();
+
+private:
+    int _open_segment();
+    void _close_segment();
+    // 把file改名为下一个file.N，交给后台线程
+    void _archive_active();
+    void _archive_loop();
+    // 压缩file.N为file.N.gz，成功返回压缩后的路径，失败或者没有zlib时返回原路径
+    std::string _compress(const std::string& path);
+
+    std::string _file;
+    LogRotation _rotation;
+    std::string _header;
+
+    int _fd = -1;
+    uint8_t* _data = nullptr;
+    size_t _capacity = 0;
+    size_t _size = 0;
+    size_t _synced = 0;
+    uint64_t _opened_ms = 0;
+    uint64_t _retry_ms = 0; // 打开失败后下一次重试的时间
+    uint64_t _retry_interval_ms = 0; // 连续失败时加倍
+
+    // 切出去的文件，按N从小到大，由后台线程压缩和删除
+    std::mutex _archive_mutex;
+    std::condition_variable _archive_cond;
+    std::deque<std::string> _pending; // 等待压缩
+    std::deque<std::string> _archives; // 已经处理完的
+    uint64_t _next_index = 1;
+    bool _stop = false;
+    std::thread _archiver;
+}; // class LogSegmentWriter
+
+} // namespace protocol_v2
+} // namespace adas
@@ -0,0 +1,198 @@
+#include <stdlib.h>
+
+#include "cJSON.h"
+#include "adas_v2_message_json.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+std::string segment_message_to_json(const SegmentMessage& segment_message) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2Segment"));
+
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(segment_message.type));
+    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(segment_message.cyclic_counter));
+    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(segment_message.retrans));
+    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(segment_message.path_index));
+    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(segment_message.offset));
+    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(segment_message.update));
+    cJSON_AddItemToObject(data, "FunctionalRoadClass", cJSON_CreateNumber(segment_message.functional_road_class));
+    cJSON_AddItemToObject(data, "FormOfWay", cJSON_CreateNumber(segment_message.form_of_way));
+    cJSON_AddItemToObject(data, "EffectiveSpeedLimit", cJSON_CreateNumber(segment_message.effective_speed_limit));
+    cJSON_AddItemToObject(data, "EffectiveSpeedLimitType", 
+                        cJSON_CreateNumber(segment_message.effective_speed_limit_type));
+    cJSON_AddItemToObject(data, "NumberOfLane", 
+                        cJSON_CreateNumber(segment_message.number_of_lanes_in_driving_direction));
+    cJSON_AddItemToObject(data, "NumberOfLaneOpposite", 
+                        cJSON_CreateNumber(segment_message.number_of_lanes_in_opposite_direction));
+    cJSON_AddItemToObject(data, "Tunnel", cJSON_CreateNumber(segment_message.tunnel));
+    cJSON_AddItemToObject(data, "Bridge", cJSON_CreateNumber(segment_message.bridge));
+    cJSON_AddItemToObject(data, "DividedRoad", cJSON_CreateNumber(segment_message.divided_road));
+    cJSON_AddItemToObject(data, "BuiltupArea", cJSON_CreateNumber(segment_message.built_up_area));
+    cJSON_AddItemToObject(data, "ComplexIntersection", cJSON_CreateNumber(segment_message.complex_intersection));
+    cJSON_AddItemToObject(data, "RelativeProbability", cJSON_CreateNumber(segment_message.relative_probability));
+    cJSON_AddItemToObject(data, "PartOfCalculatedRoute", cJSON_CreateNumber(segment_message.part_of_calculated_route));
+    cJSON_AddItemToObject(data, "Reserved", cJSON_CreateNumber(segment_message.complex_intersection));
+    cJSON_AddItemToObject(data, "LinkId", cJSON_CreateNumber(segment_message.link_id));
+    cJSON_AddItemToObject(root, "Data", data);
+
+    char *jsonString = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    std::string res(jsonString);
+    free(jsonString);
+    return res;
+}
+
+std::string position_message_to_json(const PositionMessage& position_message) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2Position"));
+
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(position_message.type));
+    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(position_message.cyclic_counter));
+    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(position_message.path_index));
+    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(position_message.offset));
+    cJSON_AddItemToObject(data, "PositionIndex", cJSON_CreateNumber(position_message.position_index));
+    cJSON_AddItemToObject(data, "PositionAge", cJSON_CreateNumber(position_message.position_age));
+    cJSON_AddItemToObject(data, "Speed", cJSON_CreateNumber(position_message.speed));
+    cJSON_AddItemToObject(data, "RelativeHeading", cJSON_CreateNumber(position_message.relative_heading));
+    cJSON_AddItemToObject(data, "PositionProbability", cJSON_CreateNumber(position_message.position_probability));
+    cJSON_AddItemToObject(data, "PositionConfidence", cJSON_CreateNumber(position_message.position_confidence));
+    cJSON_AddItemToObject(data, "CurrentLane", cJSON_CreateNumber(position_message.current_lane));
+    cJSON_AddItemToObject(data, "Reserved", cJSON_CreateNumber(position_message.reserved));
+    cJSON_AddItemToObject(root, "Data", data);
+
+    char *jsonString = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    std::string res(jsonString);
+    free(jsonString);
+    return res;
+}
+
+std::string profilelong_message_to_json(const ProfileLongMessage& profilelong_message) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2ProfileLong"));
+
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(profilelong_message.type));
+    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(profilelong_message.cyclic_counter));
+    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(profilelong_message.retrans));
+    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(profilelong_message.path_index));
+    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(profilelong_message.offset));
+    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(profilelong_message.update));
+    cJSON_AddItemToObject(data, "ProfileType", cJSON_CreateNumber(profilelong_message.profile_type));
+    cJSON_AddItemToObject(data, "ControlPoint", cJSON_CreateBool(profilelong_message.control_point));
+    if (8 == profilelong_message.profile_type) {
+        uint32_t value = 0;
+        struct TrafficSign {
+            uint32_t reversed = 0; // 1
+            uint32_t signLocation = 0; // 3
+            uint32_t condition = 0; // 4
+            uint32_t timeSpecific = 0; // 2
+            uint32_t vehicleSpecific = 0; // 2
+            uint32_t lane = 0; // 4
+            uint32_t signValue = 0; // 8
+            uint32_t signType = 0; // 8
+        };
+
+        TrafficSign tmp_sign;
+        tmp_sign.signType = profilelong_message.traffic_sign.sign_type;
+        value |= tmp_sign.reversed & 0x1;  
+        value |= (tmp_sign.signLocation & 0x7) << 1;  
+        value |= (tmp_sign.condition & 0xf) << 4;  
+        value |= (tmp_sign.timeSpecific & 0x3) << 8;  
+        value |= (tmp_sign.vehicleSpecific & 0x3) << 10;  
+        value |= (tmp_sign.lane & 0xF) << 12;  
+        value |= (tmp_sign.signValue & 0xFF) << 16;  
+        value |= (tmp_sign.signType & 0xFF) << 24;  
+
+        cJSON_AddItemToObject(data, "Value", cJSON_CreateNumber(value));
+    } else {
+        cJSON_AddItemToObject(data, "Value", cJSON_CreateNumber(profilelong_message.value));
+    }
+
+    cJSON_AddItemToObject(root, "Data", data);
+
+    char *jsonString = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    std::string res(jsonString);
+    free(jsonString);
+    return res;
+}
+
+std::string profileshort_message_to_json(const ProfileShortMessage& profileshort_message) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2ProfileShort"));
+
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(profileshort_message.type));
+    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(profileshort_message.cyclic_counter));
+    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(profileshort_message.retrans));
+    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(profileshort_message.path_index));
+    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(profileshort_message.offset));
+    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(profileshort_message.update));
+    cJSON_AddItemToObject(data, "ProfileType", cJSON_CreateNumber(profileshort_message.profile_type));
+    cJSON_AddItemToObject(data, "ControlPoint", cJSON_CreateBool(profileshort_message.control_point));
+    cJSON_AddItemToObject(data, "Value0", cJSON_CreateNumber(profileshort_message.value0));
+    cJSON_AddItemToObject(data, "Distance1", cJSON_CreateNumber(profileshort_message.distance1));
+    cJSON_AddItemToObject(data, "Value1", cJSON_CreateNumber(profileshort_message.value1));
+    cJSON_AddItemToObject(data, "Accuracy", cJSON_CreateNumber(profileshort_message.accuracy));
+
+    cJSON_AddItemToObject(root, "Data", data);
+
+    char *jsonString = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    std::string res(jsonString);
+    free(jsonString);
+    return res;
+}
+
+std::string stub_message_to_json(const StubMessage& stub_message) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2Stub"));
+
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(stub_message.type));
+    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(stub_message.cyclic_counter));
+    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(stub_message.retrans));
+    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(stub_message.path_index));
+    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(stub_message.offset));
+    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(stub_message.update));
+    cJSON_AddItemToObject(data, "SubPathIndex", cJSON_CreateNumber(stub_message.sub_path_index));
+    cJSON_AddItemToObject(data, "TurnAngle", cJSON_CreateNumber(stub_message.turn_angle));
+    cJSON_AddItemToObject(data, "RelativeProbability", cJSON_CreateNumber(stub_message.relative_probability));
+    cJSON_AddItemToObject(data, "FunctionalRoadClass", cJSON_CreateNumber(stub_message.functional_road_class));
+    cJSON_AddItemToObject(data, "FormOfWay", cJSON_CreateNumber(stub_message.form_of_way));
+    cJSON_AddItemToObject(data, "NumberOfLane", cJSON_CreateNumber(stub_message.number_of_lanes_in_driving_direction));
+    cJSON_AddItemToObject(data, "NumberOfLaneOpposite", cJSON_CreateNumber(stub_message.number_of_lanes_in_opposite_direction));
+    cJSON_AddItemToObject(data, "ComplexIntersection", cJSON_CreateNumber(stub_message.complex_intersection));
+    cJSON_AddItemToObject(data, "RightOfWay", cJSON_CreateNumber(stub_message.right_of_way));
+    cJSON_AddItemToObject(data, "PartOfCalculatedRoute", cJSON_CreateNumber(stub_message.part_of_calculated_route));
+    cJSON_AddItemToObject(data, "LastStubAtOffset", cJSON_CreateBool(stub_message.last_stub_at_offset));
+
+    std::string coord_str = "";
+    for (size_t i = 0; i < stub_message.coords.size(); i++) {
+        coord_str += std::to_string(stub_message.coords[i].x) + "," + std::to_string(stub_message.coords[i].y);
+        if (i + 1 < stub_message.coords.size()) {
+            coord_str += ";";
+        }
+    }
+    cJSON_AddItemToObject(data, "Coords", cJSON_CreateString(coord_str.c_str()));
+
+    cJSON_AddItemToObject(root, "Data", data);
+
+    char *jsonString = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    std::string res(jsonString);
+    free(jsonString);
+    return res;
+}
+
+} // namespace protocol_v2
+} // namespace adas
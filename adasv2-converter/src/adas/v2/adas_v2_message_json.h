@@ -0,0 +1,20 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <string>
+
+#include "adas_v2_type.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+// ehpv2消息转成回调给使用方的json，{"Type":"Av2Segment","Data":{...}}。
+// 不依赖AdasV2Protocol的状态，cyclic_counter等字段由调用方填好
+std::string segment_message_to_json(const SegmentMessage& segment_message);
+std::string position_message_to_json(const PositionMessage& position_message);
+std::string profilelong_message_to_json(const ProfileLongMessage& profilelong_message);
+std::string profileshort_message_to_json(const ProfileShortMessage& profileshort_message);
+std::string stub_message_to_json(const StubMessage& stub_message);
+
+} // namespace protocol_v2
+} // namespace adas
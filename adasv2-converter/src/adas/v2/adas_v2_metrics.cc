@@ -0,0 +1,130 @@
+#include <math.h>
+#include <algorithm>
+
+#include "adas_v2_metrics.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+const char* metric_stage_name(MetricStage stage) {
+    switch (stage) {
+        case METRIC_PARSE:
+            return "parse";
+        case METRIC_HORIZON_BUILD:
+            return "horizon_build";
+        case METRIC_SERIALIZE:
+            return "serialize";
+        case METRIC_QUEUE_WAIT:
+            return "queue_wait";
+        case METRIC_ADAS_CALLBACK:
+            return "adas_callback";
+        case METRIC_POSITION_CALLBACK:
+            return "position_callback";
+        default:
+            return "unknown";
+    }
+}
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+// 第0组是[0, SUB_BUCKET_COUNT)，桶宽为1；第g组是最高位为SUB_BUCKET_BITS + g - 1的值，桶宽为2^(g - 1)
+size_t LatencyHistogram::bucket_index(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    if (msb >= MAX_VALUE_BITS) {
+        return BUCKET_COUNT - 1;
+    }
+    int shift = msb - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + ((value >> shift) - SUB_BUCKET_COUNT);
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t index) {
+    size_t group = index / SUB_BUCKET_COUNT;
+    uint64_t sub = index % SUB_BUCKET_COUNT;
+    if (0 == group) {
+        return sub;
+    }
+    int shift = group - 1;
+    return ((SUB_BUCKET_COUNT + sub) << shift) + ((1ULL << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    _buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t current = _min.load(std::memory_order_relaxed);
+    while (value < current && !_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = _max.load(std::memory_order_relaxed);
+    while (value > current && !_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+    // 记录和统计可能同时进行，以各个桶实际读到的总数为准
+    std::vector<uint64_t> counts(BUCKET_COUNT);
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = _buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (0 == total) {
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, ceil(std::min(std::max(percentile, 0.0), 100.0) / 100.0 * total));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(bucket_upper(i), _max.load(std::memory_order_relaxed));
+        }
+    }
+    return _max.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::summarize(LatencySummary& summary) const {
+    summary.count = count();
+    if (0 == summary.count) {
+        summary.min_ns = summary.mean_ns = summary.p50_ns = summary.p90_ns = 0;
+        summary.p99_ns = summary.p999_ns = summary.max_ns = 0;
+        return;
+    }
+    summary.min_ns = _min.load(std::memory_order_relaxed);
+    summary.max_ns = _max.load(std::memory_order_relaxed);
+    summary.mean_ns = _sum.load(std::memory_order_relaxed) / summary.count;
+    summary.p50_ns = percentile(50.0);
+    summary.p90_ns = percentile(90.0);
+    summary.p99_ns = percentile(99.0);
+    summary.p999_ns = percentile(99.9);
+}
+
+void LatencyHistogram::reset() {
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        _buckets[i].store(0, std::memory_order_relaxed);
+    }
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _min.store(UINT64_MAX, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+void LatencyMetrics::summarize(std::vector<LatencySummary>& summaries) const {
+    summaries.resize(METRIC_STAGE_COUNT);
+    for (int i = 0; i < METRIC_STAGE_COUNT; i++) {
+        summaries[i].stage = metric_stage_name(MetricStage(i));
+        _histograms[i].summarize(summaries[i]);
+    }
+}
+
+void LatencyMetrics::reset() {
+    for (int i = 0; i < METRIC_STAGE_COUNT; i++) {
+        _histograms[i].reset();
+    }
+}
+
+} // namespace protocol_v2
+} // namespace adas
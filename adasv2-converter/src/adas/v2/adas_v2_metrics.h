@@ -0,0 +1,113 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace adas {
+namespace protocol_v2 {
+
+// 转换流程各阶段的耗时，ns
+enum MetricStage {
+    METRIC_PARSE = 0, // input_ehp_info里cJSON_Parse
+    METRIC_HORIZON_BUILD = 1, // input_ehp_info解析之后到消息全部入队，包括序列化
+    METRIC_SERIALIZE = 2, // 单条消息转json
+    METRIC_QUEUE_WAIT = 3, // 消息在Adasv2Channel里的等待，包括发送节流
+    METRIC_ADAS_CALLBACK = 4, // ehp_v2_callback/ehp_v2_batch_callback
+    METRIC_POSITION_CALLBACK = 5, // position消息的回调
+    METRIC_STAGE_COUNT = 6,
+};
+
+const char* metric_stage_name(MetricStage stage);
+
+inline uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+struct LatencySummary {
+    std::string stage;
+    uint64_t count = 0;
+    uint64_t min_ns = 0;
+    uint64_t mean_ns = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p90_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+// HDR风格的直方图: 值按2的幂分组，每组再线性分成SUB_BUCKET_COUNT个桶，
+// 分位数的相对误差不超过1/SUB_BUCKET_COUNT。记录只做几次relaxed原子操作，可以多线程同时记录
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 6;
+    static const uint64_t SUB_BUCKET_COUNT = 1ULL << SUB_BUCKET_BITS;
+    static const int MAX_VALUE_BITS = 40; // 约18分钟，更大的值记在最后一个桶
+    static const size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    LatencyHistogram();
+
+    void record(uint64_t value);
+
+    /**
+     * @brief 统计分位数，percentile为0~100，返回所在桶的上界(不超过最大值)，没有记录时返回0
+    */
+    uint64_t percentile(double percentile) const;
+
+    void summarize(LatencySummary& summary) const;
+
+    void reset();
+
+    uint64_t count() const {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    static size_t bucket_index(uint64_t value);
+    // 桶内的最大值
+    static uint64_t bucket_upper(size_t index);
+
+private:
+    std::atomic<uint64_t> _buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _min;
+    std::atomic<uint64_t> _max;
+}; // class LatencyHistogram
+
+class LatencyMetrics {
+public:
+    void record(MetricStage stage, uint64_t value_ns) {
+        _histograms[stage].record(value_ns);
+    }
+
+    void summarize(std::vector<LatencySummary>& summaries) const;
+
+    void reset();
+
+private:
+    LatencyHistogram _histograms[METRIC_STAGE_COUNT];
+}; // class LatencyMetrics
+
+// 作用域结束时记录耗时
+class ScopedLatency {
+public:
+    ScopedLatency(LatencyMetrics& metrics, MetricStage stage)
+            : _metrics(metrics), _stage(stage), _start(monotonic_ns()) {}
+    ~ScopedLatency() {
+        _metrics.record(_stage, monotonic_ns() - _start);
+    }
+
+private:
+    LatencyMetrics& _metrics;
+    MetricStage _stage;
+    uint64_t _start;
+}; // class ScopedLatency
+
+} // namespace protocol_v2
+} // namespace adas
@@ -5,15 +5,79 @@
 #include <thread>
 
 #include "adas_v2_protocol.h"
+#include "adas_v2_protocol_t.h"
+#include "adas_v2_message_json.h"
+#include "adas_v2_trace.h"
 
 namespace adas {
 namespace protocol_v2 {
 
-#define LOG(msg) _log(log_tag + msg)
+#define LOG_DEBUG(...) ADASV2_LOG(_logger, LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) ADASV2_LOG(_logger, LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) ADASV2_LOG(_logger, LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) ADASV2_LOG(_logger, LOG_LEVEL_ERROR, __VA_ARGS__)
 
 const int PATH_MAX_DISTANCE = 8191;
 const int POSITION_MAX_INTERVAL = 100;
 
+// link对象中用到的字段，通过cJSON_GetObjectItemsCaseSensitive一次遍历全部取出
+enum LinkField {
+    LINK_PATH_ID = 0,
+    LINK_LINK_ID,
+    LINK_OFFSET,
+    LINK_LENGTH,
+    LINK_PATHCLASS,
+    LINK_SPEED_LIMIT,
+    LINK_LINK_INDEX,
+    LINK_DISTANCE_TO_POS,
+    LINK_FORM_OF_WAY,
+    LINK_SPEED_LIMIT_TYPE,
+    LINK_LANENUM,
+    LINK_LANENUME2S,
+    LINK_IS_COMPLEX_INTERSECTION,
+    LINK_RELATIVE_PROBABILITY,
+    LINK_IS_PART_OF_ROUTE,
+    LINK_KIND,
+    LINK_SHAPE,
+    LINK_UFLAG,
+    LINK_ROAD_GRADE,
+    LINK_FIELD_SIZE
+};
+
+const char* const LINK_FIELD_NAMES[LINK_FIELD_SIZE] = {
+    "path_id", "link_id", "offset", "length", "pathclass", "speed_limit", "link_index",
+    "distance_to_pos", "form_of_way", "speed_limit_type", "lanenum", "lanenume2s",
+    "is_complex_intersection", "relative_probability", "is_part_of_route", "kind", "shape",
+    "uflag", "road_grade"
+};
+
+// path对象中用到的字段
+enum PathField {
+    PATH_ID = 0,
+    PATH_PID,
+    PATH_OFFSET,
+    PATH_IS_COMPLEX_INTERSECTION,
+    PATH_RELATIVE_PROBABILITY,
+    PATH_IS_PART_OF_ROUTE,
+    PATH_IS_LAST_STUB_AT_OFFSET,
+    PATH_TURN_ANGLE,
+    PATH_PATHCLASS,
+    PATH_LANENUMS2E,
+    PATH_LANENUME2S,
+    PATH_RIGHT_OF_WAY,
+    PATH_FORM_OF_WAY,
+    PATH_FIELD_SIZE
+};
+
+const char* const PATH_FIELD_NAMES[PATH_FIELD_SIZE] = {
+    "id", "pid", "offset", "is_complex_intersection", "relative_probability", "is_part_of_route",
+    "is_last_stub_at_offset", "turn_angle", "pathclass", "lanenums2e", "lanenume2s",
+    "right_of_way", "form_of_way"
+};
+
+const double LOC_MATCH_RADIUS = 30.0; // meter, link_id为0的坐标在主路径上匹配的搜索半径
+const double LOCAL_FRAME_RADIUS = 20000.0; // meter, 主路径起点离局部坐标系原点超过该距离时重新选原点
+
 std::atomic<int> position_cyclic(0);
 std::atomic<int> profilelong_cyclic(0);
 std::atomic<int> profileshort_cyclic(0);
@@ -23,74 +87,200 @@ std::atomic<int> segment_cyclic(0);
 void AdasV2Protocol::input_loc(const LocInfo& loc) {
     std::lock_guard<std::mutex> guard(public_func_mutex);
 
-    LOG("input loc");
+    LOG_DEBUG("input loc");
 
     if (loc.navi_route_id != _navi_route_id) {
-        LOG("input loc navi_route_id:" + loc.navi_route_id + 
-            " _navi_route_id:" + _navi_route_id);
+        LOG_DEBUG("input loc navi_route_id:%s _navi_route_id:%s", loc.navi_route_id.c_str(),
+            _navi_route_id.c_str());
         return;
     }
 
-    const std::vector<LinkInfo> main_path_linkinfos = _link_infos[8];
-    LOG("input loc main_path_linkinfos size:" + std::to_string(main_path_linkinfos.size()));
-    for (size_t i = 0; i < main_path_linkinfos.size(); i++) {
-        LOG("input loc linkid:" + std::to_string(loc.link_id)
-            + " linkindex:" + std::to_string(loc.link_index)
-            + " i:" + std::to_string(i) + " main_path_linkindex:" + std::to_string(main_path_linkinfos[i].link_index)
-            + " main_path_linkid:" + std::to_string(main_path_linkinfos[i].linkid));
-
-        if (loc.link_index == main_path_linkinfos[i].link_index &&
-                loc.link_id == main_path_linkinfos[i].linkid) {
-            PositionMessage position_message;
-            position_message.path_index = 8;
-            position_message.offset = main_path_linkinfos[i].offset + loc.link_offset;
-
-            if (0 == loc.link_index) {
-                double linklength_diff =  main_path_linkinfos[i].length - _navi_link_id_2_length[0][loc.link_id];
-                if (0 < linklength_diff && (fabs(_navi_link_id_2_length[0][loc.link_id] - 0) > 1e-6)) {
-                    position_message.offset += linklength_diff;
-                }
-            }
+    if (0 == loc.link_id) {
+        LocInfo matched_loc = loc;
+        if (0 != _match_loc_on_main_path(matched_loc)) {
+            LOG_WARN("input loc match on main path failed. x:%f y:%f", loc.coord.x, loc.coord.y);
+            return;
+        }
+        _input_loc(matched_loc);
+        return;
+    }
 
-            uint64_t gps_loc_time = loc.timestamp;
-            position_message.position_age = get_cur_time_ms() - gps_loc_time;
-            if (position_message.position_age < 0) {
-                position_message.position_age = 511;
-            } else if (position_message.position_age > 2545) {
-                position_message.position_age = 510;
-            } else {
-                position_message.position_age /= 5;
+    _input_loc(loc);
+}
+
+void AdasV2Protocol::_input_loc(const LocInfo& loc) {
+    auto ref = _link_refs.find(_link_ref_id(8, loc.link_index));
+    LOG_DEBUG("input loc main_path_linkinfos size:%zu", _link_infos[8].size());
+    if (_link_refs.end() != ref && loc.link_id == ref->second.linkid) {
+        const LinkInfo& link_info = _link_infos[8][ref->second.index];
+        LOG_DEBUG("input loc linkid:%ld linkindex:%ld i:%zu main_path_linkindex:%ld main_path_linkid:%lu",
+            loc.link_id, loc.link_index, ref->second.index, link_info.link_index, link_info.linkid);
+
+        PositionMessage position_message;
+        position_message.path_index = 8;
+        position_message.offset = link_info.offset + loc.link_offset;
+
+        if (0 == loc.link_index) {
+            double linklength_diff =  link_info.length - _navi_link_id_2_length[0][loc.link_id];
+            if (0 < linklength_diff && (fabs(_navi_link_id_2_length[0][loc.link_id] - 0) > 1e-6)) {
+                position_message.offset += linklength_diff;
             }
+        }
+
+        uint64_t gps_loc_time = loc.timestamp;
+        position_message.position_age = _now_ms() - gps_loc_time;
+        if (position_message.position_age < 0) {
+            position_message.position_age = 511;
+        } else if (position_message.position_age > 2545) {
+            position_message.position_age = 510;
+        } else {
+            position_message.position_age /= 5;
+        }
 
-            double speed = loc.speed;
-            position_message.speed = 64 + (speed / 0.2);
+        double speed = loc.speed;
+        position_message.speed = 64 + (speed / 0.2);
 
-            position_message.position_probability = 30;
-            position_message.relative_heading = normalize_direction(loc.direction - loc.link_direction);
+        position_message.position_probability = 30;
+        position_message.relative_heading = normalize_direction(loc.direction - loc.link_direction);
 
-            int64_t start = get_cur_time_ms();
-            _update_position_cache(position_message, "local_position");
-            int64_t end = get_cur_time_ms();
+        int64_t start = _now_ms();
+        _update_position_cache(position_message, "local_position");
+        int64_t end = _now_ms();
 
-            LOG("input loc update, linkid:" + std::to_string(loc.link_id) + 
-                        " linkoffset:" + std::to_string(loc.link_offset) + 
-                        " pathoffset:" + std::to_string(position_message.offset) +
-                        " cost_ms:" + std::to_string(end - start));
+        LOG_DEBUG("input loc update, linkid:%ld linkoffset:%f pathoffset:%d cost_ms:%ld", loc.link_id,
+            loc.link_offset, position_message.offset, end - start);
 
-            return;
+        return;
+    }
+
+    LOG_WARN("input loc update failed linkid:%ld linkindex:%ld", loc.link_id, loc.link_index);
+}
+
+int AdasV2Protocol::_match_loc_on_main_path(LocInfo& loc) {
+    std::vector<geo::SegmentHit> hits;
+    _link_grid.query(loc.coord.x, loc.coord.y, LOC_MATCH_RADIUS, hits);
+
+    double east = 0.0;
+    double north = 0.0;
+    _local_frame.to_local(loc.coord.x, loc.coord.y, east, north);
+
+    // hits按距离排好序，取最近的主路径link，在局部坐标系下投影
+    for (size_t i = 0; i < hits.size(); i++) {
+        auto ref = _link_refs.find(hits[i].id);
+        if (_link_refs.end() == ref || 8 != ref->second.path_id) {
+            continue;
+        }
+
+        const LinkRef& link_ref = ref->second;
+        geo::LocalProjection projection;
+        if (0 != geo::project_local(east, north, link_ref.local_east.data(), link_ref.local_north.data(),
+                    link_ref.local_east.size(), projection)) {
+            continue;
+        }
+
+        const LinkInfo& link_info = _link_infos[8][link_ref.index];
+        const std::vector<double>& distances =
+                link_shape_distances(link_info, link_shapes(link_info, _shape_buffer), _distance_buffer);
+        size_t k = projection.segment_index;
+        loc.link_id = link_info.linkid;
+        loc.link_index = link_info.link_index;
+        loc.link_offset = distances[k] + projection.ratio * (distances[k + 1] - distances[k]);
+        loc.link_direction = projection.heading;
+
+        LOG_DEBUG("input loc matched on main path. linkid:%ld linkindex:%ld linkoffset:%f distance:%f",
+            loc.link_id, loc.link_index, loc.link_offset, projection.distance);
+        return 0;
+    }
+    return -1;
+}
+
+bool AdasV2Protocol::_update_local_frame() {
+    const LinkInfo* anchor = nullptr;
+    auto main_path = _link_infos.find(8);
+    if (_link_infos.end() != main_path && !main_path->second.empty()) {
+        anchor = &main_path->second.front();
+    } else if (!_link_infos.empty() && !_link_infos.begin()->second.empty()) {
+        anchor = &_link_infos.begin()->second.front();
+    }
+    if (nullptr == anchor || 0 == link_shape_count(*anchor)) {
+        return false;
+    }
+
+    const Coord origin = anchor->compact_shapes.empty() ? anchor->shapes.front() : *anchor->compact_shapes.begin();
+    if (_local_frame.valid() && geo::equirectangular_distance(_local_frame.origin_lon(), _local_frame.origin_lat(),
+                origin.x, origin.y) < LOCAL_FRAME_RADIUS) {
+        return false;
+    }
+    _local_frame.reset(origin.x, origin.y);
+    LOG_INFO("reset local frame. lon:%f lat:%f", origin.x, origin.y);
+    return true;
+}
+
+void AdasV2Protocol::_update_link_index() {
+    // 局部坐标系换了原点时所有link的局部坐标都要重算，网格不受影响
+    bool reframe = _update_local_frame();
+
+    std::unordered_map<uint64_t, LinkRef> link_refs;
+    size_t reinserted = 0;
+    for (auto it = _link_infos.begin(); it != _link_infos.end(); it++) {
+        for (size_t j = 0; j < it->second.size(); j++) {
+            const LinkInfo& link_info = it->second[j];
+            uint64_t id = _link_ref_id(it->first, link_info.link_index);
+            LinkRef ref = {it->first, j, link_info.linkid, link_shape_count(link_info)};
+            auto inserted = link_refs.emplace(id, ref);
+            if (!inserted.second) {
+                continue;
+            }
+            LinkRef& new_ref = inserted.first->second;
+
+            // 前后两次下发的horizon大部分link相同，没有变化的link保留在网格里，局部坐标直接沿用
+            auto old = _link_refs.find(id);
+            bool unchanged = _link_refs.end() != old && old->second.linkid == ref.linkid &&
+                    old->second.shape_size == ref.shape_size;
+            if (unchanged && !reframe) {
+                new_ref.local_east.swap(old->second.local_east);
+                new_ref.local_north.swap(old->second.local_north);
+                continue;
+            }
+
+            const std::vector<Coord>& shapes = link_shapes(link_info, _shape_buffer);
+            const double* lonlat = reinterpret_cast<const double*>(shapes.data());
+            new_ref.local_east.resize(shapes.size());
+            new_ref.local_north.resize(shapes.size());
+            _local_frame.to_local(lonlat, shapes.size(), new_ref.local_east.data(), new_ref.local_north.data());
+            if (!unchanged) {
+                _link_grid.remove(id);
+                if (0 != _link_grid.insert(id, lonlat, shapes.size())) {
+                    LOG_WARN("insert link into grid failed. linkid:%lu shape size:%zu", link_info.linkid,
+                        shapes.size());
+                }
+                reinserted++;
+            }
         }
     }
 
-    LOG("input loc update failed linkid:" + std::to_string(loc.link_id)
-        + " linkindex:" + std::to_string(loc.link_index));
+    for (auto it = _link_refs.begin(); it != _link_refs.end(); it++) {
+        if (link_refs.end() == link_refs.find(it->first)) {
+            _link_grid.remove(it->first);
+        }
+    }
+    _link_refs.swap(link_refs);
+
+    LOG_INFO("update link index. links:%zu reinserted:%zu segments:%zu", _link_refs.size(), reinserted,
+        _link_grid.segment_count());
 }
 
 void AdasV2Protocol::input_ehp_info(const std::string& ehp_info) {
     std::lock_guard<std::mutex> guard(public_func_mutex);
 
+    ADASV2_TRACE(ehp_input, ehp_info.size());
+    uint64_t parse_start = monotonic_ns();
     cJSON* monitor_json = cJSON_Parse(ehp_info.c_str());
+    uint64_t build_start = monotonic_ns();
+    _metrics.record(METRIC_PARSE, build_start - parse_start);
+    ADASV2_TRACE(ehp_parsed, ehp_info.size(), build_start - parse_start, nullptr != monitor_json);
     if (nullptr == monitor_json) {
-        LOG("parse ehp_info json failed. " + ehp_info);
+        LOG_ERROR("parse ehp_info json failed. %s", ehp_info.c_str());
         return;
     }
 
@@ -107,8 +297,7 @@ void AdasV2Protocol::input_ehp_info(const std::string& ehp_info) {
     cJSON *cjson_version_ptr = cJSON_GetObjectItem(monitor_json, "version");
     if (cJSON_IsNumber(cjson_version_ptr)) {
         int64_t version = cjson_version_ptr->valuedouble;
-        LOG("ehp version. cur_version:" + std::to_string(_ehp_version) + 
-                            " update_version:" + std::to_string(version));
+        LOG_INFO("ehp version. cur_version:%ld update_version:%ld", _ehp_version, version);
         if (_ehp_version != version) {
             _ehp_version = version;
             _buffer_channel.clear();
@@ -120,6 +309,8 @@ void AdasV2Protocol::input_ehp_info(const std::string& ehp_info) {
 
             _path_infos.clear();
             _link_infos.clear();
+            _link_refs.clear();
+            _link_grid.clear();
 
             _sended_max_segment_link_index.clear();
             _sended_max_lonlat_link_index.clear();
@@ -160,11 +351,14 @@ void AdasV2Protocol::input_ehp_info(const std::string& ehp_info) {
 
     cJSON *cjson_warning_info_ptr = cJSON_GetObjectItem(monitor_json, "warning_info");
     _send_warning_info(cjson_warning_info_ptr);
+
+    _flush_batch();
+    _metrics.record(METRIC_HORIZON_BUILD, monotonic_ns() - build_start);
 }
 
 void AdasV2Protocol::_send_warning_info(cJSON* cjson_warning_info_ptr) {
     if (!cJSON_IsArray(cjson_warning_info_ptr)) {
-        LOG("send warning info failed. cjson warning info ptr isnot array");
+        LOG_ERROR("send warning info failed. cjson warning info ptr isnot array");
         return;
     }
 
@@ -219,14 +413,13 @@ void AdasV2Protocol::_send_warning_info(cJSON* cjson_warning_info_ptr) {
     
         profilelongs[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_profilelong_to_json(profilelongs[i]);
-        _buffer_channel.push_list1(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
+        _push_message(MESSAGE_CLASS_PROFILE_LONG, ehp_json);
     }
 }
 
 void AdasV2Protocol::_send_traffic_light(cJSON* cjson_traffic_light_ptr) {
     if (!cJSON_IsArray(cjson_traffic_light_ptr)) {
-        LOG("send traffic light failed. cjson traffic light ptr isnot array");
+        LOG_ERROR("send traffic light failed. cjson traffic light ptr isnot array");
         return;
     }
 
@@ -274,14 +467,13 @@ void AdasV2Protocol::_send_traffic_light(cJSON* cjson_traffic_light_ptr) {
 
         profilelongs[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_profilelong_to_json(profilelongs[i]);
-        _buffer_channel.push_list1(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
+        _push_message(MESSAGE_CLASS_PROFILE_LONG, ehp_json);
     }
 }
 
 void AdasV2Protocol::_parse_path_info(cJSON* cjson_paths_ptr) {
     if (!cJSON_IsArray(cjson_paths_ptr)) {
-        LOG("parse path topo failed. cjson_paths_ptr isnot a array");
+        LOG_ERROR("parse path topo failed. cjson_paths_ptr isnot a array");
         return;
     }
 
@@ -293,13 +485,16 @@ void AdasV2Protocol::_parse_path_info(cJSON* cjson_paths_ptr) {
         cJSON *path_item_ptr = cJSON_GetArrayItem(cjson_paths_ptr, i);
         PathInfo path_info;
 
-        cJSON *id_item_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "id");
+        cJSON *fields[PATH_FIELD_SIZE];
+        cJSON_GetObjectItemsCaseSensitive(path_item_ptr, PATH_FIELD_NAMES, fields, PATH_FIELD_SIZE);
+
+        cJSON *id_item_ptr = fields[PATH_ID];
         if (!cJSON_IsNumber(id_item_ptr)) {
             continue;
         }
         path_info.sub_path_id = id_item_ptr->valueint;
 
-        cJSON *pid_item_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "pid");
+        cJSON *pid_item_ptr = fields[PATH_PID];
         if (!cJSON_IsNumber(pid_item_ptr)) {
             continue;
         }
@@ -308,52 +503,52 @@ void AdasV2Protocol::_parse_path_info(cJSON* cjson_paths_ptr) {
             continue;
         }
 
-        cJSON *offset_item_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "offset");
+        cJSON *offset_item_ptr = fields[PATH_OFFSET];
         if (!cJSON_IsNumber(offset_item_ptr)) {
             continue;
         }
         path_info.offset = offset_item_ptr->valuedouble;
 
-        cJSON *complex_intersection_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "is_complex_intersection");
+        cJSON *complex_intersection_ptr = fields[PATH_IS_COMPLEX_INTERSECTION];
         if (cJSON_IsTrue(complex_intersection_ptr)) {
             path_info.is_complex_intersection = true;
         } else {
             path_info.is_complex_intersection = false;
         }
 
-        cJSON *relative_probability_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "relative_probability");
+        cJSON *relative_probability_ptr = fields[PATH_RELATIVE_PROBABILITY];
         if (!cJSON_IsNumber(relative_probability_ptr)) {
             continue;
         }
         path_info.relative_probability = relative_probability_ptr->valueint;
 
-        cJSON *is_part_of_route_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "is_part_of_route");
+        cJSON *is_part_of_route_ptr = fields[PATH_IS_PART_OF_ROUTE];
         if (cJSON_IsTrue(is_part_of_route_ptr)) {
             path_info.part_of_calculated_route = true;
         } else {
             path_info.part_of_calculated_route = false;
         }
 
-        cJSON *last_stub_at_offset_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "is_last_stub_at_offset");
+        cJSON *last_stub_at_offset_ptr = fields[PATH_IS_LAST_STUB_AT_OFFSET];
         if (cJSON_IsTrue(last_stub_at_offset_ptr)) {
             path_info.is_last_stub_at_offset = true;
         } else {
             path_info.is_last_stub_at_offset = false;
         }
 
-        cJSON *turn_angle_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "turn_angle");
+        cJSON *turn_angle_ptr = fields[PATH_TURN_ANGLE];
         if (!cJSON_IsNumber(turn_angle_ptr)) {
             continue;
         }
         path_info.turn_angle = turn_angle_ptr->valuedouble;
 
-        cJSON *functional_road_class_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "pathclass");
+        cJSON *functional_road_class_ptr = fields[PATH_PATHCLASS];
         if (!cJSON_IsNumber(functional_road_class_ptr)) {
             continue;
         }
         path_info.pathclass = functional_road_class_ptr->valueint;
 
-        cJSON *lanenums2e_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "lanenums2e");
+        cJSON *lanenums2e_ptr = fields[PATH_LANENUMS2E];
         if (!cJSON_IsNumber(lanenums2e_ptr)) {
             continue;
         }
@@ -362,7 +557,7 @@ void AdasV2Protocol::_parse_path_info(cJSON* cjson_paths_ptr) {
             path_info.lanenums2e = 6;
         }
 
-        cJSON *lanenume2s_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "lanenume2s");
+        cJSON *lanenume2s_ptr = fields[PATH_LANENUME2S];
         if (!cJSON_IsNumber(lanenume2s_ptr)) {
             continue;
         }
@@ -371,20 +566,20 @@ void AdasV2Protocol::_parse_path_info(cJSON* cjson_paths_ptr) {
             path_info.lanenume2s = 2;
         }
 
-        cJSON *right_of_way_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "right_of_way");
+        cJSON *right_of_way_ptr = fields[PATH_RIGHT_OF_WAY];
         if (!cJSON_IsNumber(right_of_way_ptr)) {
             continue;
         }
         path_info.right_of_way = right_of_way_ptr->valueint;
 
-        cJSON *form_of_way_ptr = cJSON_GetObjectItemCaseSensitive(path_item_ptr, "form_of_way");
+        cJSON *form_of_way_ptr = fields[PATH_FORM_OF_WAY];
         if (!cJSON_IsNumber(form_of_way_ptr)) {
             continue;
         }
         path_info.form_of_way = form_of_way_ptr->valueint;
         _path_infos.push_back(path_info);
     }
-    LOG("parse path info succ. path size:" + std::to_string(_path_infos.size()));
+    LOG_INFO("parse path info succ. path size:%zu", _path_infos.size());
 }
 
 void AdasV2Protocol::_send_stub() {
@@ -407,26 +602,33 @@ void AdasV2Protocol::_send_stub() {
             if (int64_t(path_info.offset * 100) > tmp_sended_max_mainpath_offset) {
                 tmp_sended_max_mainpath_offset = path_info.offset * 100;
             }
-            // continue stub 用 offset 找link的形点
-            const std::vector<LinkInfo> main_path_linkinfos = _link_infos[8];
+            // continue stub 用 offset 找link的形点，按形点累计距离二分取出覆盖50米的形点
+            const std::vector<LinkInfo>& main_path_linkinfos = _link_infos[8];
             double coord_length = 0.0;
             int matched_link = 0;
             for (size_t j = 0; j < main_path_linkinfos.size() && coord_length < 50.0; j++) {
-                if (int64_t(main_path_linkinfos[j].offset * 100) >= int64_t(path_info.offset * 100)) {
-                    matched_link++;
-                    for (size_t k = 0; k < main_path_linkinfos[j].shapes.size() && coord_length < 50.0; k++) {
-                        // 不是第一条匹配上的link，第一个点会和前面的点重合，不发
-                        if (0 == k && 1 != matched_link) {
-                            continue;
-                        }
-                        stub_item.coords.emplace_back(main_path_linkinfos[j].shapes[k]);
-                        if (0 != k) {
-                            coord_length += calculate_distance(main_path_linkinfos[j].shapes[k - 1].x,
-                                                            main_path_linkinfos[j].shapes[k - 1].y,
-                                                            main_path_linkinfos[j].shapes[k].x,
-                                                            main_path_linkinfos[j].shapes[k].y);
-                        }
-                    }
+                const LinkInfo& link_info = main_path_linkinfos[j];
+                if (int64_t(link_info.offset * 100) < int64_t(path_info.offset * 100)) {
+                    continue;
+                }
+                matched_link++;
+                const std::vector<Coord>& shapes = link_shapes(link_info, _shape_buffer);
+                const std::vector<double>& distances = link_shape_distances(link_info, shapes, _distance_buffer);
+                size_t first = 0;
+                size_t last = 0;
+                shape_points_within(distances, 0.0, 50.0 - coord_length, first, last);
+                // 超出50米的第一个点也要发，保证形状覆盖满50米
+                last = std::min(last + 1, distances.size());
+                // 不是第一条匹配上的link，第一个点会和前面的点重合，不发
+                if (1 != matched_link) {
+                    first = 1;
+                }
+                if (first < last) {
+                    stub_item.coords.insert(stub_item.coords.end(),
+                                            shapes.begin() + first, shapes.begin() + last);
+                }
+                if (0 != last) {
+                    coord_length += distances[last - 1];
                 }
             }
         }
@@ -444,20 +646,14 @@ void AdasV2Protocol::_send_stub() {
             // sub stub用pathid 直接匹配link的形点
             if (_link_infos.end() != _link_infos.find(path_info.sub_path_id) && 
                     0 != _link_infos[path_info.sub_path_id].size()) {
-                double coord_length = 0.0;
-                for (size_t k = 0; k < _link_infos[path_info.sub_path_id][0].shapes.size(); k++) {
-                    stub_item.coords.emplace_back(_link_infos[path_info.sub_path_id][0].shapes[k]);
-                    if (0 != k) {
-                        coord_length += calculate_distance(_link_infos[path_info.sub_path_id][0].shapes[k - 1].x,
-                                                        _link_infos[path_info.sub_path_id][0].shapes[k - 1].y,
-                                                        _link_infos[path_info.sub_path_id][0].shapes[k].x,
-                                                        _link_infos[path_info.sub_path_id][0].shapes[k].y);
-                    }
-                    if (coord_length > 50.0) {
-                        break;
-                    }
-                }
-
+                const LinkInfo& link_info = _link_infos[path_info.sub_path_id][0];
+                const std::vector<Coord>& shapes = link_shapes(link_info, _shape_buffer);
+                const std::vector<double>& distances = link_shape_distances(link_info, shapes, _distance_buffer);
+                size_t first = 0;
+                size_t last = 0;
+                shape_points_within(distances, 0.0, 50.0, first, last);
+                last = std::min(last + 1, distances.size());
+                stub_item.coords.insert(stub_item.coords.end(), shapes.begin() + first, shapes.begin() + last);
             }
         }
         stub_item.offset = path_info.offset;
@@ -485,8 +681,7 @@ void AdasV2Protocol::_send_stub() {
     std::sort(continue_stub_messages.begin(), continue_stub_messages.end(), sort_help_by_offset<StubMessage>());
     std::sort(sub_stub_messages.begin(), sub_stub_messages.end(), sort_help_by_offset<StubMessage>());
 
-    LOG("send continue stub size:" + std::to_string(continue_stub_messages.size()) + 
-        " sub stub size:" + std::to_string(sub_stub_messages.size()));
+    LOG_INFO("send continue stub size:%zu sub stub size:%zu", continue_stub_messages.size(), sub_stub_messages.size());
 
     for (size_t i = 0; i < continue_stub_messages.size(); i++) {
         continue_stub_messages[i].cyclic_counter = stub_cyclic;
@@ -495,8 +690,7 @@ void AdasV2Protocol::_send_stub() {
 
         continue_stub_messages[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_stub_to_json(continue_stub_messages[i]);
-        _buffer_channel.push_list0(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
+        _push_message(MESSAGE_CLASS_STUB, ehp_json);
     }
 
     for (size_t i = 0; i < sub_stub_messages.size(); i++) {
@@ -506,14 +700,13 @@ void AdasV2Protocol::_send_stub() {
 
         sub_stub_messages[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_stub_to_json(sub_stub_messages[i]);
-        _buffer_channel.push_list0(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
+        _push_message(MESSAGE_CLASS_STUB, ehp_json);
     }
 }
 
 void AdasV2Protocol::_send_curvature(cJSON* cjson_curvature_ptr) {
     if (!cJSON_IsArray(cjson_curvature_ptr)) {
-        LOG("send slope failed. cjson curvature ptr isnot array");
+        LOG_ERROR("send slope failed. cjson curvature ptr isnot array");
         return;
     }
 
@@ -563,7 +756,7 @@ void AdasV2Protocol::_send_curvature(cJSON* cjson_curvature_ptr) {
                 profileshort_item.value1 = value1;
                 if (1023 == value1) {
                     profileshort_item.distance1 = 1023;
-                    LOG("curvature profile short item. distance1 is 1023");
+                    LOG_DEBUG("curvature profile short item. distance1 is 1023");
                 } else {
                     profileshort_item.distance1 = cJSON_GetArrayItem(offset_array_ptr, k)->valueint - 
                                                                             profileshort_item.offset;
@@ -589,14 +782,13 @@ void AdasV2Protocol::_send_curvature(cJSON* cjson_curvature_ptr) {
 
         profileshorts[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_profileshort_to_json(profileshorts[i]);
-        _buffer_channel.push_list1(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
+        _push_message(MESSAGE_CLASS_PROFILE_SHORT, ehp_json);
     }
 }
 
 void AdasV2Protocol::_send_slope(cJSON* cjson_slope_ptr) {
     if (!cJSON_IsArray(cjson_slope_ptr)) {
-        LOG("send slope failed. cjson slope ptr isnot array");
+        LOG_ERROR("send slope failed. cjson slope ptr isnot array");
         return;
     }
 
@@ -646,7 +838,7 @@ void AdasV2Protocol::_send_slope(cJSON* cjson_slope_ptr) {
                 profileshort_item.value1 = value1;
                 if (1023 == value1) {
                     profileshort_item.distance1 = 1023;
-                    LOG("slope profile short item. distance1 is 1023");
+                    LOG_DEBUG("slope profile short item. distance1 is 1023");
                 } else {
                     profileshort_item.distance1 = cJSON_GetArrayItem(offset_array_ptr, k)->valueint - 
                                                                             profileshort_item.offset;
@@ -672,86 +864,91 @@ void AdasV2Protocol::_send_slope(cJSON* cjson_slope_ptr) {
 
         profileshorts[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_profileshort_to_json(profileshorts[i]);
-        _buffer_channel.push_list1(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
+        _push_message(MESSAGE_CLASS_PROFILE_SHORT, ehp_json);
     }
 }
 
 void AdasV2Protocol::_parse_link_info(cJSON* cjson_links_ptr) {
     if (!cJSON_IsArray(cjson_links_ptr)) {
-        LOG("parse links failed. cjson_links_ptr isnot a array");
+        LOG_ERROR("parse links failed. cjson_links_ptr isnot a array");
         return;
     }
 
     _link_infos.clear();
 
     size_t link_array_size = cJSON_GetArraySize(cjson_links_ptr);
+    size_t raw_shape_points = 0;
+    size_t invalid_shape_points = 0;
+    size_t kept_shape_points = 0;
 
     for (size_t i = 0; i < link_array_size; i++) {
         cJSON *link_item_ptr = cJSON_GetArrayItem(cjson_links_ptr, i);
 
+        cJSON *fields[LINK_FIELD_SIZE];
+        cJSON_GetObjectItemsCaseSensitive(link_item_ptr, LINK_FIELD_NAMES, fields, LINK_FIELD_SIZE);
+
         LinkInfo link_info;
-        cJSON *path_id_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "path_id");
+        cJSON *path_id_ptr = fields[LINK_PATH_ID];
         if (!cJSON_IsNumber(path_id_ptr)) {
             continue;
         }
         link_info.path_id = path_id_ptr->valueint;
 
-        cJSON *link_id_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "link_id");
+        cJSON *link_id_ptr = fields[LINK_LINK_ID];
         if (!cJSON_IsNumber(link_id_ptr)) {
             continue;
         }
         link_info.linkid = link_id_ptr->valuedouble;
 
-        cJSON *offset_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "offset");
+        cJSON *offset_ptr = fields[LINK_OFFSET];
         if (!cJSON_IsNumber(offset_ptr)) {
             continue;
         }
         link_info.offset = offset_ptr->valuedouble;
 
-        cJSON *length_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "length");
+        cJSON *length_ptr = fields[LINK_LENGTH];
         if (!cJSON_IsNumber(length_ptr)) {
             continue;
         }
         link_info.length = length_ptr->valuedouble;
 
-        cJSON *pathclass_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "pathclass");
+        cJSON *pathclass_ptr = fields[LINK_PATHCLASS];
         if (!cJSON_IsNumber(pathclass_ptr)) {
             continue;
         }
         link_info.pathclass = pathclass_ptr->valueint;
 
-        cJSON *speed_limit_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "speed_limit");
+        cJSON *speed_limit_ptr = fields[LINK_SPEED_LIMIT];
         if (!cJSON_IsNumber(speed_limit_ptr)) {
             continue;
         }
         link_info.speed_limit = speed_limit_ptr->valueint;
 
-        cJSON *link_index_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "link_index");
+        cJSON *link_index_ptr = fields[LINK_LINK_INDEX];
         if (!cJSON_IsNumber(link_index_ptr)) {
             continue;
         }
         link_info.link_index = link_index_ptr->valuedouble;
 
-        cJSON *distance_to_pos_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "distance_to_pos");
+        cJSON *distance_to_pos_ptr = fields[LINK_DISTANCE_TO_POS];
         if (!cJSON_IsNumber(distance_to_pos_ptr)) {
             continue;
         }
         link_info.distance_to_pos = distance_to_pos_ptr->valuedouble;
 
-        cJSON *form_of_way_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "form_of_way");
+        cJSON *form_of_way_ptr = fields[LINK_FORM_OF_WAY];
         if (!cJSON_IsNumber(form_of_way_ptr)) {
             continue;
         }
         link_info.form_of_way = form_of_way_ptr->valueint;
 
-        cJSON *speed_limit_type_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "speed_limit_type");
+        cJSON *speed_limit_type_ptr = fields[LINK_SPEED_LIMIT_TYPE];
         if (!cJSON_IsNumber(speed_limit_type_ptr)) {
             continue;
         }
         link_info.speed_limit_type = speed_limit_type_ptr->valueint;
 
-        cJSON *lanenums2e_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "lanenum");
+        cJSON *lanenums2e_ptr = fields[LINK_LANENUM];
         if (!cJSON_IsNumber(lanenums2e_ptr)) {
             continue;
         }
@@ -760,7 +957,7 @@ void AdasV2Protocol::_parse_link_info(cJSON* cjson_links_ptr) {
             link_info.lanenums2e = 6;
         }
 
-        cJSON *lanenume2s_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "lanenume2s");
+        cJSON *lanenume2s_ptr = fields[LINK_LANENUME2S];
         if (!cJSON_IsNumber(lanenume2s_ptr)) {
             continue;
         }
@@ -769,27 +966,27 @@ void AdasV2Protocol::_parse_link_info(cJSON* cjson_links_ptr) {
             link_info.lanenume2s = 2;
         }
 
-        cJSON *complex_intersection_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "is_complex_intersection");
+        cJSON *complex_intersection_ptr = fields[LINK_IS_COMPLEX_INTERSECTION];
         if (cJSON_IsTrue(complex_intersection_ptr)) {
             link_info.complex_intersection = true;
         } else {
             link_info.complex_intersection = false;
         }
 
-        cJSON *relative_probability_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "relative_probability");
+        cJSON *relative_probability_ptr = fields[LINK_RELATIVE_PROBABILITY];
         if (!cJSON_IsNumber(relative_probability_ptr)) {
             continue;
         }
         link_info.relative_probability = relative_probability_ptr->valueint;
 
-        cJSON *part_of_calculated_route_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "is_part_of_route");
+        cJSON *part_of_calculated_route_ptr = fields[LINK_IS_PART_OF_ROUTE];
         if (cJSON_IsTrue(part_of_calculated_route_ptr)) {
             link_info.part_of_calculated_route = true;
         } else {
             link_info.part_of_calculated_route = false;
         }
 
-        cJSON *kinds_array_ptr = cJSON_GetObjectItem(link_item_ptr, "kind");
+        cJSON *kinds_array_ptr = fields[LINK_KIND];
         if (cJSON_IsArray(kinds_array_ptr)) {
             size_t kind_array_size = cJSON_GetArraySize(kinds_array_ptr);
             for (size_t j = 0; j < kind_array_size; j++) {
@@ -800,29 +997,53 @@ void AdasV2Protocol::_parse_link_info(cJSON* cjson_links_ptr) {
             }
         }
 
-        cJSON *shape_array_ptr = cJSON_GetObjectItem(link_item_ptr, "shape");
+        cJSON *shape_array_ptr = fields[LINK_SHAPE];
         if (cJSON_IsArray(shape_array_ptr)) {
             size_t shape_array_size = cJSON_GetArraySize(shape_array_ptr);
             for (size_t j = 0; j < shape_array_size; j++) {
                 cJSON *shape_item_ptr = cJSON_GetArrayItem(shape_array_ptr, j);
                 if (cJSON_IsArray(shape_item_ptr)) {
                     if (2 == cJSON_GetArraySize(shape_item_ptr)) {
+                        // null或者非数字的形点会被cJSON当成0，成为(0,0)处的假形点，不是合法经纬度的形点直接丢掉
+                        cJSON *x_ptr = cJSON_GetArrayItem(shape_item_ptr, 0);
+                        cJSON *y_ptr = cJSON_GetArrayItem(shape_item_ptr, 1);
+                        if (!cJSON_IsNumber(x_ptr) || !cJSON_IsNumber(y_ptr) ||
+                                !(fabs(x_ptr->valuedouble) <= 180.0) || !(fabs(y_ptr->valuedouble) <= 90.0)) {
+                            invalid_shape_points++;
+                            continue;
+                        }
                         Coord coord;
-                        coord.x = cJSON_GetArrayItem(shape_item_ptr, 0)->valuedouble;
-                        coord.y = cJSON_GetArrayItem(shape_item_ptr, 1)->valuedouble;
+                        coord.x = x_ptr->valuedouble;
+                        coord.y = y_ptr->valuedouble;
                         link_info.shapes.push_back(coord);
                     }
                 }
             }
         }
+        raw_shape_points += link_info.shapes.size();
+        if (_shape_tolerance > 0.0 && link_info.shapes.size() > 2) {
+            _simplify_buffer.resize(link_info.shapes.size());
+            size_t count = geo::simplify_polyline(reinterpret_cast<double*>(link_info.shapes.data()),
+                    link_info.shapes.size(), _shape_tolerance, _simplify_buffer.data());
+            link_info.shapes.resize(count);
+        }
+        kept_shape_points += link_info.shapes.size();
+        // 紧凑存储时累计距离不保存，用到时由形点现算
+        if (_compact_shapes_enabled) {
+            link_info.compact_shapes.assign(link_info.shapes.data(), link_info.shapes.size());
+            std::vector<Coord>().swap(link_info.shapes);
+            std::vector<double>().swap(link_info.shape_distances);
+        } else {
+            calculate_shape_distances(link_info.shapes, link_info.shape_distances);
+        }
 
-        cJSON *uflag_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "uflag");
+        cJSON *uflag_ptr = fields[LINK_UFLAG];
         if (!cJSON_IsNumber(uflag_ptr)) {
             continue;
         }
         link_info.uflag = uflag_ptr->valueint;
 
-        cJSON *road_grade_ptr = cJSON_GetObjectItemCaseSensitive(link_item_ptr, "road_grade");
+        cJSON *road_grade_ptr = fields[LINK_ROAD_GRADE];
         if (!cJSON_IsNumber(road_grade_ptr)) {
             continue;
         }
@@ -834,8 +1055,16 @@ void AdasV2Protocol::_parse_link_info(cJSON* cjson_links_ptr) {
     for (auto it = _link_infos.begin(); it != _link_infos.end(); it++) {
         std::sort(it->second.begin(), it->second.end(), sort_help_by_offset<LinkInfo>());
     }
+    _update_link_index();
 
-    LOG("parse link info succ. link size:" + std::to_string(_link_infos.size()));
+    if (_shape_tolerance > 0.0) {
+        LOG_INFO("simplify link shapes. tolerance:%f points:%zu -> %zu", _shape_tolerance, raw_shape_points,
+            kept_shape_points);
+    }
+    if (invalid_shape_points > 0) {
+        LOG_WARN("drop invalid link shape points:%zu", invalid_shape_points);
+    }
+    LOG_INFO("parse link info succ. link size:%zu", _link_infos.size());
 }
 
 void AdasV2Protocol::_send_segment() {
@@ -901,7 +1130,7 @@ void AdasV2Protocol::_send_segment() {
         }
     }
 
-    LOG("send segment size:" + std::to_string(segment_messages.size()));
+    LOG_INFO("send segment size:%zu", segment_messages.size());
 
     std::sort(segment_messages.begin(), segment_messages.end(), sort_help_by_pathid_offset<SegmentMessage>());
     for (size_t i = 0; i < segment_messages.size(); i++) {
@@ -911,8 +1140,7 @@ void AdasV2Protocol::_send_segment() {
 
         segment_messages[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_segment_to_json(segment_messages[i]);
-        _buffer_channel.push_list0(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
+        _push_message(MESSAGE_CLASS_SEGMENT, ehp_json);
     }
 }
 
@@ -942,9 +1170,10 @@ void AdasV2Protocol::_send_lonlat() {
                 max_sended_link_index = link_info.link_index;
             }
 
-            float point_to_link_start = 0;
-            for (size_t j = 0; j < link_info.shapes.size(); j++) {
-                const Coord& loc = link_info.shapes[j];
+            const std::vector<Coord>& shapes = link_shapes(link_info, _shape_buffer);
+            const std::vector<double>& distances = link_shape_distances(link_info, shapes, _distance_buffer);
+            for (size_t j = 0; j < shapes.size(); j++) {
+                const Coord& loc = shapes[j];
 
                 ProfileLongMessage profilelong_item;
                 profilelong_item.retrans = 0;
@@ -958,10 +1187,7 @@ void AdasV2Protocol::_send_lonlat() {
                     continue;
                 }
                 if (0 != j) {
-                    point_to_link_start += calculate_distance(
-                        link_info.shapes[j - 1].x, link_info.shapes[j - 1].y,
-                        loc.x, loc.y);
-                    offset += point_to_link_start;
+                    offset += distances[j];
                 }
 
                 profilelong_item.offset = offset;
@@ -980,7 +1206,7 @@ void AdasV2Protocol::_send_lonlat() {
         }
     }
 
-    LOG("send lonlat size:" + std::to_string(profilelongs.size()));
+    LOG_INFO("send lonlat size:%zu", profilelongs.size());
 
     std::sort(profilelongs.begin(), profilelongs.end(), sort_help_by_pathid_offset<ProfileLongMessage>());
     for (size_t i = 0; i < profilelongs.size(); i++) {
@@ -990,26 +1216,91 @@ void AdasV2Protocol::_send_lonlat() {
 
         profilelongs[i].offset %= PATH_MAX_DISTANCE;
         std::string ehp_json = _convert_profilelong_to_json(profilelongs[i]);
+        _push_message(MESSAGE_CLASS_PROFILE_LONG, ehp_json);
+    }
+}
+
+void AdasV2Protocol::set_batch_callback(bool enable) {
+    std::lock_guard<std::mutex> guard(public_func_mutex);
+    _batch_callback_enabled = enable;
+}
+
+void AdasV2Protocol::set_compact_shapes(bool enable) {
+    std::lock_guard<std::mutex> guard(public_func_mutex);
+    _compact_shapes_enabled = enable;
+}
+
+void AdasV2Protocol::set_shape_tolerance(double tolerance) {
+    std::lock_guard<std::mutex> guard(public_func_mutex);
+    _shape_tolerance = tolerance;
+}
+
+void AdasV2Protocol::_push_message(MessageClass message_class, const std::string& ehp_json) {
+    bool list0 = (MESSAGE_CLASS_STUB == message_class || MESSAGE_CLASS_SEGMENT == message_class);
+    if (_batch_callback_enabled) {
+        // 和逐条发送的顺序保持一致: list0的消息整体在list1之前
+        EhpV2Batch& pending = list0 ? _pending_batch_list0 : _pending_batch_list1;
+        if (pending.ranges.empty() || pending.ranges.back().message_class != message_class) {
+            MessageClassRange range;
+            range.message_class = message_class;
+            range.begin = pending.messages.size();
+            range.end = range.begin;
+            pending.ranges.push_back(range);
+        }
+        pending.messages.push_back(ehp_json);
+        pending.ranges.back().end = pending.messages.size();
+        return;
+    }
+
+    if (list0) {
+        _buffer_channel.push_list0(ehp_json);
+    } else {
         _buffer_channel.push_list1(ehp_json);
-        pthread_cond_signal(&_adas_message_cond);
     }
+    pthread_cond_signal(&_adas_message_cond);
+}
+
+void AdasV2Protocol::_flush_batch() {
+    if (_pending_batch_list0.messages.empty() && _pending_batch_list1.messages.empty()) {
+        return;
+    }
+
+    EhpV2Batch batch;
+    batch.messages.swap(_pending_batch_list0.messages);
+    batch.ranges.swap(_pending_batch_list0.ranges);
+
+    size_t base = batch.messages.size();
+    batch.messages.reserve(base + _pending_batch_list1.messages.size());
+    for (size_t i = 0; i < _pending_batch_list1.messages.size(); i++) {
+        batch.messages.push_back(std::move(_pending_batch_list1.messages[i]));
+    }
+    for (size_t i = 0; i < _pending_batch_list1.ranges.size(); i++) {
+        MessageClassRange range = _pending_batch_list1.ranges[i];
+        range.begin += base;
+        range.end += base;
+        batch.ranges.push_back(range);
+    }
+    _pending_batch_list1 = EhpV2Batch();
+
+    _buffer_channel.push_batch(std::move(batch));
+    pthread_cond_signal(&_adas_message_cond);
 }
 
 void AdasV2Protocol::set_navi_route(const std::string& route) {
     std::lock_guard<std::mutex> guard(public_func_mutex);
 
-    LOG("set_navi_route:" + route);
+    LOG_INFO("set_navi_route:%s", route.c_str());
 
     cJSON* monitor_json = cJSON_Parse(route.c_str());
     if (nullptr == monitor_json) {
-        LOG("parse route json failed. " + route);
+        LOG_ERROR("parse route json failed. %s", route.c_str());
         return;
     }
     CJsonSafeDelete safe_delete(monitor_json);
 
     cJSON *cjson_route_ptr = cJSON_GetObjectItem(monitor_json, "route");
     if (!cJSON_IsObject(cjson_route_ptr)) {
-        LOG("parse route json failed. " + route);
+        LOG_ERROR("parse route json failed. %s", route.c_str());
         return;
     }
 
@@ -1028,7 +1319,7 @@ void AdasV2Protocol::set_navi_route(const std::string& route) {
     }
 
     if (navi_route_id != _navi_route_id) {
-        LOG(navi_route_id + " is not equal to _navi_route_id:" + _navi_route_id);
+        LOG_WARN("%s is not equal to _navi_route_id:%s", navi_route_id.c_str(), _navi_route_id.c_str());
         _navi_route_id = navi_route_id;
         _buffer_channel.clear();
         _seted_position_message = false;
@@ -1057,67 +1348,102 @@ void AdasV2Protocol::set_navi_route(const std::string& route) {
 }
 
 void AdasV2Protocol::set_log_file(const std::string& file) {
-    std::lock_guard<std::mutex> guard(public_func_mutex);
-    if (_run_log_thread) {
-        return;
-    }
+    set_log_file(file, LogRotation());
+}
 
-    _log_file = file;
-    _run_log_thread = true;
-    if (0 != pthread_create(&_async_log_tid, nullptr, (void* (*)(void*))_async_log_pthread, this)) {
-        _run_log_thread = false;
-    }
-    pthread_setname_np(_async_log_tid, "_async_tid");
+void AdasV2Protocol::set_log_file(const std::string& file, const LogRotation& rotation) {
+    std::lock_guard<std::mutex> guard(public_func_mutex);
+    _logger.open(file, rotation);
 }
 
 void AdasV2Protocol::close_log() {
     std::lock_guard<std::mutex> guard(public_func_mutex);
-    if (_run_log_thread) {
-        _run_log_thread = false;
-        pthread_cond_signal(&_async_log_cond);
-        pthread_join(_async_log_tid, nullptr);
+    _logger.close();
+}
+
+void AdasV2Protocol::set_log_level(LogLevel level) {
+    _logger.set_level(level);
+}
+
+void AdasV2Protocol::set_clock(Clock* clock) {
+    _clock.store(nullptr == clock ? &SteadyClock::instance() : clock, std::memory_order_release);
+}
+
+void AdasV2Protocol::get_metrics(std::vector<LatencySummary>& metrics) const {
+    _metrics.summarize(metrics);
+}
+
+void AdasV2Protocol::reset_metrics() {
+    _metrics.reset();
+}
+
+void AdasV2Protocol::set_metrics_dump_interval(int interval_seconds) {
+    std::lock_guard<std::mutex> guard(public_func_mutex);
+    _stop_metrics_dump();
+    if (interval_seconds <= 0) {
+        return;
     }
+    _metrics_dump_interval = interval_seconds;
+    _metrics_dump_stop = false;
+    _metrics_dump_thread = std::thread(&AdasV2Protocol::_metrics_dump_loop, this);
+    pthread_setname_np(_metrics_dump_thread.native_handle(), "_metrics_tid");
 }
 
-void AdasV2Protocol::_log(const std::string& msg) {
-    if (_run_log_thread) {
-        pthread_mutex_lock(&_async_log_mutex);
-        _async_log_buffer.push_back(msg + "\n");
-        pthread_cond_signal(&_async_log_cond);
-        pthread_mutex_unlock(&_async_log_mutex);
-    } else {
-        std::cout << msg << std::endl;
+void AdasV2Protocol::_stop_metrics_dump() {
+    if (!_metrics_dump_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_metrics_dump_mutex);
+        _metrics_dump_stop = true;
+    }
+    _metrics_dump_cond.notify_all();
+    _metrics_dump_thread.join();
+}
+
+void AdasV2Protocol::_metrics_dump_loop() {
+    std::unique_lock<std::mutex> lock(_metrics_dump_mutex);
+    std::vector<LatencySummary> metrics;
+    while (!_metrics_dump_cond.wait_for(lock, std::chrono::seconds(_metrics_dump_interval),
+                                         [this]() { return _metrics_dump_stop; })) {
+        _metrics.summarize(metrics);
+        for (size_t i = 0; i < metrics.size(); i++) {
+            const LatencySummary& m = metrics[i];
+            LOG_INFO("metrics %s count:%lu min_ns:%lu mean_ns:%lu p50_ns:%lu p90_ns:%lu p99_ns:%lu p999_ns:%lu"
+                " max_ns:%lu", m.stage.c_str(), m.count, m.min_ns, m.mean_ns, m.p50_ns, m.p90_ns, m.p99_ns,
+                m.p999_ns, m.max_ns);
+        }
     }
 }
 
 void AdasV2Protocol::_process_position(cJSON* cjson_position_ptr) {
     PositionMessage position_message;
     if (!cJSON_IsObject(cjson_position_ptr)) {
-        LOG("update position cached failed. cjson_position_ptr isnot a object");
+        LOG_WARN("update position cached failed. cjson_position_ptr isnot a object");
         return;
     }
 
     cJSON *path_id_item_ptr = cJSON_GetObjectItemCaseSensitive(cjson_position_ptr, "path_id");
     if (!cJSON_IsNumber(path_id_item_ptr)) {
-        LOG("update position cached failed. path_id isnot a number");
+        LOG_WARN("update position cached failed. path_id isnot a number");
         return;
     }
     position_message.path_index = path_id_item_ptr->valueint;
 
     cJSON *offset_item_ptr = cJSON_GetObjectItemCaseSensitive(cjson_position_ptr, "offset");
     if (!cJSON_IsNumber(offset_item_ptr)) {
-        LOG("update position cached failed. offset isnot a number");
+        LOG_WARN("update position cached failed. offset isnot a number");
         return;
     }
     position_message.offset = offset_item_ptr->valueint;
 
     cJSON *gps_loc_time_item_ptr = cJSON_GetObjectItemCaseSensitive(cjson_position_ptr, "gps_loc_time");
     if (!cJSON_IsNumber(gps_loc_time_item_ptr)) {
-        LOG("update position cached failed. gps_loc_time isnot a number");
+        LOG_WARN("update position cached failed. gps_loc_time isnot a number");
         return;
     }
     uint64_t gps_loc_time = gps_loc_time_item_ptr->valuedouble;
-    position_message.position_age = get_cur_time_ms() - gps_loc_time;
+    position_message.position_age = _now_ms() - gps_loc_time;
     if (position_message.position_age < 0) {
         position_message.position_age = 511;
     } else if (position_message.position_age > 2545) {
@@ -1128,7 +1454,7 @@ void AdasV2Protocol::_process_position(cJSON* cjson_position_ptr) {
 
     cJSON *speed_item_ptr = cJSON_GetObjectItemCaseSensitive(cjson_position_ptr, "speed");
     if (!cJSON_IsNumber(speed_item_ptr)) {
-        LOG("update position cached failed. speed isnot a number");
+        LOG_WARN("update position cached failed. speed isnot a number");
         return;
     }
     double speed = speed_item_ptr->valuedouble;
@@ -1136,7 +1462,7 @@ void AdasV2Protocol::_process_position(cJSON* cjson_position_ptr) {
 
     cJSON *probability_item_ptr = cJSON_GetObjectItemCaseSensitive(cjson_position_ptr, "probability");
     if (!cJSON_IsNumber(probability_item_ptr)) {
-        LOG("update position cached failed. probability isnot a number");
+        LOG_WARN("update position cached failed. probability isnot a number");
         return;
     }
     position_message.position_probability = probability_item_ptr->valueint;
@@ -1144,241 +1470,72 @@ void AdasV2Protocol::_process_position(cJSON* cjson_position_ptr) {
     cJSON *dir_item_ptr = cJSON_GetObjectItemCaseSensitive(cjson_position_ptr, "dir");
     cJSON *link_dir_item_ptr = cJSON_GetObjectItemCaseSensitive(cjson_position_ptr, "link_dir");
     if (!cJSON_IsNumber(dir_item_ptr) || !cJSON_IsNumber(link_dir_item_ptr)) {
-        LOG("update position cached failed. dir、link_Dir isnot a number");
+        LOG_WARN("update position cached failed. dir、link_Dir isnot a number");
         return;
     }
     position_message.relative_heading = normalize_direction(dir_item_ptr->valueint - link_dir_item_ptr->valueint);
 
-    int64_t start = get_cur_time_ms();
+    int64_t start = _now_ms();
     _update_position_cache(position_message, "server_position");
-    int64_t end = get_cur_time_ms();
+    int64_t end = _now_ms();
     
-    LOG("input loc from server update," +
-                        " path_index:" + std::to_string(position_message.path_index) + 
-                        " path_offset:" + std::to_string(position_message.offset) +
-                        " cost_ms:" + std::to_string(end - start));
+    LOG_DEBUG("input loc from server update, path_index:%d path_offset:%d cost_ms:%ld", position_message.path_index,
+        position_message.offset, end - start);
 }
 
 void AdasV2Protocol::_update_position_cache(const PositionMessage& position_message, const std::string& from) {
-    int64_t t0 = get_cur_time_ms();
+    int64_t t0 = _now_ms();
     pthread_mutex_lock(&_position_message_mutex);
-    int64_t t1 = get_cur_time_ms();
+    int64_t t1 = _now_ms();
 
     // 检查position offset是否发生回退
     if (_position_message_cache.offset > position_message.offset) {
-        LOG("update position cache failed. offset back. cache from " + from +
-            " last offset:" + std::to_string(_position_message_cache.offset) + 
-            " current offset:" + std::to_string(position_message.offset) + 
-            " get_lock_time:" + std::to_string(t1 - t0) +
-            "func exec time:" + std::to_string(get_cur_time_ms() - t0));
+        LOG_WARN("update position cache failed. offset back. cache from %s last offset:%d current offset:%d"
+            " get_lock_time:%ldfunc exec time:%lu", from.c_str(), _position_message_cache.offset,
+            position_message.offset, t1 - t0, _now_ms() - t0);
         pthread_mutex_unlock(&_position_message_mutex);
         return;
     }
-    int64_t t2 = get_cur_time_ms();
+    int64_t t2 = _now_ms();
     _position_message_cache = position_message;
 
-    int64_t t3 = get_cur_time_ms();
+    int64_t t3 = _now_ms();
     _seted_position_message = true;
-
-    int64_t t4 = get_cur_time_ms();
-    LOG("update position cache succ. from" + from + 
-            " last offset:" + std::to_string(_position_message_cache.offset) + 
-            " current offset:" + std::to_string(position_message.offset) + 
-            " get_lock_time:" + std::to_string(t1 - t0) +
-            " if_condition:" + std::to_string(t2 - t1) + 
-            " update_position_cached:" + std::to_string(t3 - t2) + 
-            " update_seted_flag:" + std::to_string(t4 - t3) +
-            " func exec time:" + std::to_string(t4 - t0));
+    _position_sequence++;
+    ADASV2_TRACE(position_update, position_message.path_index, position_message.offset, _position_sequence);
+
+    int64_t t4 = _now_ms();
+    LOG_DEBUG("update position cache succ. from%s last offset:%d current offset:%d get_lock_time:%ld"
+        " if_condition:%ld update_position_cached:%ld update_seted_flag:%ld func exec time:%ld",
+        from.c_str(), _position_message_cache.offset, position_message.offset, t1 - t0, t2 - t1, t3 - t2,
+        t4 - t3, t4 - t0);
     pthread_cond_signal(&_position_message_cond);
     pthread_mutex_unlock(&_position_message_mutex);
 }
 
 std::string AdasV2Protocol::_convert_segment_to_json(const SegmentMessage& segment_message) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2Segment"));
-
-    cJSON *data = cJSON_CreateObject();
-    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(segment_message.type));
-    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(segment_message.cyclic_counter));
-    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(segment_message.retrans));
-    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(segment_message.path_index));
-    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(segment_message.offset));
-    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(segment_message.update));
-    cJSON_AddItemToObject(data, "FunctionalRoadClass", cJSON_CreateNumber(segment_message.functional_road_class));
-    cJSON_AddItemToObject(data, "FormOfWay", cJSON_CreateNumber(segment_message.form_of_way));
-    cJSON_AddItemToObject(data, "EffectiveSpeedLimit", cJSON_CreateNumber(segment_message.effective_speed_limit));
-    cJSON_AddItemToObject(data, "EffectiveSpeedLimitType", 
-                        cJSON_CreateNumber(segment_message.effective_speed_limit_type));
-    cJSON_AddItemToObject(data, "NumberOfLane", 
-                        cJSON_CreateNumber(segment_message.number_of_lanes_in_driving_direction));
-    cJSON_AddItemToObject(data, "NumberOfLaneOpposite", 
-                        cJSON_CreateNumber(segment_message.number_of_lanes_in_opposite_direction));
-    cJSON_AddItemToObject(data, "Tunnel", cJSON_CreateNumber(segment_message.tunnel));
-    cJSON_AddItemToObject(data, "Bridge", cJSON_CreateNumber(segment_message.bridge));
-    cJSON_AddItemToObject(data, "DividedRoad", cJSON_CreateNumber(segment_message.divided_road));
-    cJSON_AddItemToObject(data, "BuiltupArea", cJSON_CreateNumber(segment_message.built_up_area));
-    cJSON_AddItemToObject(data, "ComplexIntersection", cJSON_CreateNumber(segment_message.complex_intersection));
-    cJSON_AddItemToObject(data, "RelativeProbability", cJSON_CreateNumber(segment_message.relative_probability));
-    cJSON_AddItemToObject(data, "PartOfCalculatedRoute", cJSON_CreateNumber(segment_message.part_of_calculated_route));
-    cJSON_AddItemToObject(data, "Reserved", cJSON_CreateNumber(segment_message.complex_intersection));
-    cJSON_AddItemToObject(data, "LinkId", cJSON_CreateNumber(segment_message.link_id));
-    cJSON_AddItemToObject(root, "Data", data);
-
-    char *jsonString = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    std::string res(jsonString);
-    free(jsonString);
-    return res;
+    ScopedLatency serialize_latency(_metrics, METRIC_SERIALIZE);
+    return segment_message_to_json(segment_message);
 }
 
 std::string AdasV2Protocol::_convert_position_to_json(const PositionMessage& position_message) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2Position"));
-
-    cJSON *data = cJSON_CreateObject();
-    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(position_message.type));
-    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(position_message.cyclic_counter));
-    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(position_message.path_index));
-    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(position_message.offset));
-    cJSON_AddItemToObject(data, "PositionIndex", cJSON_CreateNumber(position_message.position_index));
-    cJSON_AddItemToObject(data, "PositionAge", cJSON_CreateNumber(position_message.position_age));
-    cJSON_AddItemToObject(data, "Speed", cJSON_CreateNumber(position_message.speed));
-    cJSON_AddItemToObject(data, "RelativeHeading", cJSON_CreateNumber(position_message.relative_heading));
-    cJSON_AddItemToObject(data, "PositionProbability", cJSON_CreateNumber(position_message.position_probability));
-    cJSON_AddItemToObject(data, "PositionConfidence", cJSON_CreateNumber(position_message.position_confidence));
-    cJSON_AddItemToObject(data, "CurrentLane", cJSON_CreateNumber(position_message.current_lane));
-    cJSON_AddItemToObject(data, "Reserved", cJSON_CreateNumber(position_message.reserved));
-    cJSON_AddItemToObject(root, "Data", data);
-
-    char *jsonString = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    std::string res(jsonString);
-    free(jsonString);
-    return res;
+    ScopedLatency serialize_latency(_metrics, METRIC_SERIALIZE);
+    return position_message_to_json(position_message);
 }
 
 std::string AdasV2Protocol::_convert_profilelong_to_json(const ProfileLongMessage& profilelong_message) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2ProfileLong"));
-
-    cJSON *data = cJSON_CreateObject();
-    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(profilelong_message.type));
-    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(profilelong_message.cyclic_counter));
-    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(profilelong_message.retrans));
-    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(profilelong_message.path_index));
-    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(profilelong_message.offset));
-    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(profilelong_message.update));
-    cJSON_AddItemToObject(data, "ProfileType", cJSON_CreateNumber(profilelong_message.profile_type));
-    cJSON_AddItemToObject(data, "ControlPoint", cJSON_CreateBool(profilelong_message.control_point));
-    if (8 == profilelong_message.profile_type) {
-        uint32_t value = 0;
-        struct TrafficSign {
-            uint32_t reversed = 0; // 1
-            uint32_t signLocation = 0; // 3
-            uint32_t condition = 0; // 4
-            uint32_t timeSpecific = 0; // 2
-            uint32_t vehicleSpecific = 0; // 2
-            uint32_t lane = 0; // 4
-            uint32_t signValue = 0; // 8
-            uint32_t signType = 0; // 8
-        };
-
-        TrafficSign tmp_sign;
-        tmp_sign.signType = profilelong_message.traffic_sign.sign_type;
-        value |= tmp_sign.reversed & 0x1;  
-        value |= (tmp_sign.signLocation & 0x7) << 1;  
-        value |= (tmp_sign.condition & 0xf) << 4;  
-        value |= (tmp_sign.timeSpecific & 0x3) << 8;  
-        value |= (tmp_sign.vehicleSpecific & 0x3) << 10;  
-        value |= (tmp_sign.lane & 0xF) << 12;  
-        value |= (tmp_sign.signValue & 0xFF) << 16;  
-        value |= (tmp_sign.signType & 0xFF) << 24;  
-
-        cJSON_AddItemToObject(data, "Value", cJSON_CreateNumber(value));
-    } else {
-        cJSON_AddItemToObject(data, "Value", cJSON_CreateNumber(profilelong_message.value));
-    }
-
-    cJSON_AddItemToObject(root, "Data", data);
-
-    char *jsonString = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    std::string res(jsonString);
-    free(jsonString);
-    return res;
+    ScopedLatency serialize_latency(_metrics, METRIC_SERIALIZE);
+    return profilelong_message_to_json(profilelong_message);
 }
 
 std::string AdasV2Protocol::_convert_profileshort_to_json(const ProfileShortMessage& profileshort_message) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2ProfileShort"));
-
-    cJSON *data = cJSON_CreateObject();
-    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(profileshort_message.type));
-    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(profileshort_message.cyclic_counter));
-    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(profileshort_message.retrans));
-    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(profileshort_message.path_index));
-    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(profileshort_message.offset));
-    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(profileshort_message.update));
-    cJSON_AddItemToObject(data, "ProfileType", cJSON_CreateNumber(profileshort_message.profile_type));
-    cJSON_AddItemToObject(data, "ControlPoint", cJSON_CreateBool(profileshort_message.control_point));
-    cJSON_AddItemToObject(data, "Value0", cJSON_CreateNumber(profileshort_message.value0));
-    cJSON_AddItemToObject(data, "Distance1", cJSON_CreateNumber(profileshort_message.distance1));
-    cJSON_AddItemToObject(data, "Value1", cJSON_CreateNumber(profileshort_message.value1));
-    cJSON_AddItemToObject(data, "Accuracy", cJSON_CreateNumber(profileshort_message.accuracy));
-
-    cJSON_AddItemToObject(root, "Data", data);
-
-    char *jsonString = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    std::string res(jsonString);
-    free(jsonString);
-    return res;
+    ScopedLatency serialize_latency(_metrics, METRIC_SERIALIZE);
+    return profileshort_message_to_json(profileshort_message);
 }
 
 std::string AdasV2Protocol::_convert_stub_to_json(const StubMessage& stub_message) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "Type", cJSON_CreateString("Av2Stub"));
-
-    cJSON *data = cJSON_CreateObject();
-    cJSON_AddItemToObject(data, "MessageType", cJSON_CreateNumber(stub_message.type));
-    cJSON_AddItemToObject(data, "CyclicCounter", cJSON_CreateNumber(stub_message.cyclic_counter));
-    cJSON_AddItemToObject(data, "Retransmission", cJSON_CreateBool(stub_message.retrans));
-    cJSON_AddItemToObject(data, "PathIndex", cJSON_CreateNumber(stub_message.path_index));
-    cJSON_AddItemToObject(data, "Offset", cJSON_CreateNumber(stub_message.offset));
-    cJSON_AddItemToObject(data, "Update", cJSON_CreateBool(stub_message.update));
-    cJSON_AddItemToObject(data, "SubPathIndex", cJSON_CreateNumber(stub_message.sub_path_index));
-    cJSON_AddItemToObject(data, "TurnAngle", cJSON_CreateNumber(stub_message.turn_angle));
-    cJSON_AddItemToObject(data, "RelativeProbability", cJSON_CreateNumber(stub_message.relative_probability));
-    cJSON_AddItemToObject(data, "FunctionalRoadClass", cJSON_CreateNumber(stub_message.functional_road_class));
-    cJSON_AddItemToObject(data, "FormOfWay", cJSON_CreateNumber(stub_message.form_of_way));
-    cJSON_AddItemToObject(data, "NumberOfLane", cJSON_CreateNumber(stub_message.number_of_lanes_in_driving_direction));
-    cJSON_AddItemToObject(data, "NumberOfLaneOpposite", cJSON_CreateNumber(stub_message.number_of_lanes_in_opposite_direction));
-    cJSON_AddItemToObject(data, "ComplexIntersection", cJSON_CreateNumber(stub_message.complex_intersection));
-    cJSON_AddItemToObject(data, "RightOfWay", cJSON_CreateNumber(stub_message.right_of_way));
-    cJSON_AddItemToObject(data, "PartOfCalculatedRoute", cJSON_CreateNumber(stub_message.part_of_calculated_route));
-    cJSON_AddItemToObject(data, "LastStubAtOffset", cJSON_CreateBool(stub_message.last_stub_at_offset));
-
-    std::string coord_str = "";
-    for (size_t i = 0; i < stub_message.coords.size(); i++) {
-        coord_str += std::to_string(stub_message.coords[i].x) + "," + std::to_string(stub_message.coords[i].y);
-        if (i + 1 < stub_message.coords.size()) {
-            coord_str += ";";
-        }
-    }
-    cJSON_AddItemToObject(data, "Coords", cJSON_CreateString(coord_str.c_str()));
-
-    cJSON_AddItemToObject(root, "Data", data);
-
-    char *jsonString = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    std::string res(jsonString);
-    free(jsonString);
-    return res;
+    ScopedLatency serialize_latency(_metrics, METRIC_SERIALIZE);
+    return stub_message_to_json(stub_message);
 }
 
 void AdasV2Protocol::_send_invalid_stub_message() {
@@ -1402,8 +1559,13 @@ void AdasV2Protocol::_send_invalid_stub_message() {
     stub_cyclic = stub_cyclic % 4;
 
     std::string ehp_json = _convert_stub_to_json(invalid_stub);
-    _buffer_channel.push_list0(ehp_json);
-    pthread_cond_signal(&_adas_message_cond);
+    _push_message(MESSAGE_CLASS_STUB, ehp_json);
+}
+
+void AdasV2Protocol::ehp_v2_batch_callback(const EhpV2Batch& batch) {
+    for (size_t i = 0; i < batch.messages.size(); i++) {
+        ehp_v2_callback(batch.messages[i]);
+    }
 }
 
 void AdasV2Protocol::_send_invalid_position_message() {
@@ -1420,90 +1582,134 @@ void AdasV2Protocol::_send_invalid_position_message() {
     position_cyclic = position_cyclic % 4;
 
     std::string ehp_json = _convert_position_to_json(invalid_position);
+    ADASV2_TRACE(callback_begin, 1, ehp_json.size(), 1);
+    uint64_t callback_start = monotonic_ns();
     ehp_v2_callback(ehp_json);
+    uint64_t callback_cost = monotonic_ns() - callback_start;
+    _metrics.record(METRIC_POSITION_CALLBACK, callback_cost);
+    ADASV2_TRACE(callback_end, 1, 1, callback_cost);
 }
 
-void* AdasV2Protocol::_adas_pthread(AdasV2Protocol* protocol) {
-    while (!protocol->_exit) {
-        pthread_mutex_lock(&(protocol->_adas_message_mutex));
+namespace {
 
-        std::string ehp_json = "";
+// AdasV2Protocol自身的sink，转发到虚函数
+struct VirtualSink {
+    AdasV2Protocol* protocol;
 
-        int pop_status = protocol->_buffer_channel.pop(ehp_json);
-        if (-1 != pop_status) {
-            pthread_mutex_unlock(&(protocol->_adas_message_mutex));
-            protocol->ehp_v2_callback(ehp_json);
-            if (0 == pop_status) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            } else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            }
-            continue;
-        }
+    void on_message(const std::string& ehp_v2_json) {
+        protocol->ehp_v2_callback(ehp_v2_json);
+    }
 
-        pthread_cond_wait(&(protocol->_adas_message_cond), &(protocol->_adas_message_mutex));
-        pthread_mutex_unlock(&(protocol->_adas_message_mutex));
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    void on_batch(const EhpV2Batch& batch) {
+        protocol->ehp_v2_batch_callback(batch);
     }
-    return nullptr;
-}
+};
 
-void* AdasV2Protocol::_position_pthread(AdasV2Protocol* protocol) {
-    while (!protocol->_exit) {
-        int64_t t1 = get_cur_time_ms();
-        pthread_mutex_lock(&(protocol->_position_message_mutex));
-
-        // 有新的position生成后立即发送
-        pthread_cond_wait(&(protocol->_position_message_cond), &(protocol->_position_message_mutex));
-        if (!protocol->_seted_position_message || protocol->_exit) {
-            pthread_mutex_unlock(&(protocol->_position_message_mutex));
-            continue;
-        }
-        int64_t t2 = get_cur_time_ms();
+} // namespace
 
-        PositionMessage position_message = protocol->_position_message_cache;
-        pthread_mutex_unlock(&(protocol->_position_message_mutex));
+int AdasV2Protocol::_pop_adas_message(std::string& ehp_json, EhpV2Batch& batch) {
+    uint64_t enqueue_ns = 0;
+    int pop_status = _buffer_channel.pop(ehp_json, enqueue_ns);
+    if (-1 == pop_status && 0 == _buffer_channel.pop_batch(batch, enqueue_ns)) {
+        pop_status = ADAS_POP_BATCH;
+    }
+    if (-1 != pop_status) {
+        _metrics.record(METRIC_QUEUE_WAIT, monotonic_ns() - enqueue_ns);
+    }
+    return pop_status;
+}
+
+int AdasV2Protocol::_next_adas_message(std::string& ehp_json, EhpV2Batch& batch) {
+    pthread_mutex_lock(&_adas_message_mutex);
 
-        position_message.cyclic_counter = position_cyclic;
-        position_cyclic++;
-        position_cyclic = position_cyclic % 4;
+    int pop_status = _pop_adas_message(ehp_json, batch);
+    if (-1 != pop_status) {
+        pthread_mutex_unlock(&_adas_message_mutex);
+        return pop_status;
+    }
 
-        position_message.offset %= PATH_MAX_DISTANCE;
+    pthread_cond_wait(&_adas_message_cond, &_adas_message_mutex);
+    pthread_mutex_unlock(&_adas_message_mutex);
+    _sleep_ms(1);
+    return -1;
+}
 
-        std::string position_json = protocol->_convert_position_to_json(position_message);
-        int64_t t3 = get_cur_time_ms();
-        protocol->ehp_v2_callback(position_json);
-        int64_t t4 = get_cur_time_ms();
-        protocol->LOG("_position_pthread mutex_lock_time_ms:" + std::to_string(t2 - t1) 
-            + " process_time_ms:" + std::to_string(t3 - t2) 
-            + " callback_time_ms:" + std::to_string(t4 - t3));
+void AdasV2Protocol::_pace_adas_message(int pop_status) {
+    if (0 == pop_status) {
+        _sleep_ms(10);
+    } else {
+        _sleep_ms(1);
     }
+}
+
+void* AdasV2Protocol::_adas_pthread(AdasV2Protocol* protocol) {
+    VirtualSink sink{protocol};
+    protocol->_dispatch_adas_messages(sink);
     return nullptr;
 }
 
-void* AdasV2Protocol::_async_log_pthread(AdasV2Protocol* protocol) {
-    std::ofstream log_stream;
-    log_stream.open(protocol->_log_file);
+bool AdasV2Protocol::_next_position_message(std::string& position_json, int64_t& wait_start, int64_t& wait_end) {
+    wait_start = _now_ms();
+    pthread_mutex_lock(&_position_message_mutex);
+
+    // 有新的position生成后立即发送
+    pthread_cond_wait(&_position_message_cond, &_position_message_mutex);
+    if (!_seted_position_message || _exit) {
+        pthread_mutex_unlock(&_position_message_mutex);
+        return false;
+    }
+    wait_end = _now_ms();
 
-    while (protocol->_run_log_thread) {
-        pthread_mutex_lock(&(protocol->_async_log_mutex));
+    PositionMessage position_message = _position_message_cache;
+    _drained_position_sequence = _position_sequence;
+    ADASV2_TRACE(position_dequeue, position_message.path_index, position_message.offset, _position_sequence);
+    pthread_mutex_unlock(&_position_message_mutex);
 
-        if (0 != protocol->_async_log_buffer.size()) {
-            std::string log = protocol->_async_log_buffer.front();
-            protocol->_async_log_buffer.pop_front();
-            pthread_mutex_unlock(&(protocol->_async_log_mutex));
-            log_stream << log;
-            log_stream.flush();
-            continue;
-        }
+    position_json = _convert_dispatched_position(position_message);
+    return true;
+}
 
-        pthread_cond_wait(&(protocol->_async_log_cond), &(protocol->_async_log_mutex));
-        pthread_mutex_unlock(&(protocol->_async_log_mutex));
-    }
+int AdasV2Protocol::_try_adas_message(std::string& ehp_json, EhpV2Batch& batch) {
+    pthread_mutex_lock(&_adas_message_mutex);
+    int pop_status = _pop_adas_message(ehp_json, batch);
+    pthread_mutex_unlock(&_adas_message_mutex);
+    return pop_status;
+}
 
-    if (log_stream.is_open()) {
-        log_stream.close();
+bool AdasV2Protocol::_try_position_message(std::string& position_json) {
+    pthread_mutex_lock(&_position_message_mutex);
+    if (_position_sequence == _drained_position_sequence) {
+        pthread_mutex_unlock(&_position_message_mutex);
+        return false;
     }
+    PositionMessage position_message = _position_message_cache;
+    _drained_position_sequence = _position_sequence;
+    ADASV2_TRACE(position_dequeue, position_message.path_index, position_message.offset, _position_sequence);
+    pthread_mutex_unlock(&_position_message_mutex);
+
+    position_json = _convert_dispatched_position(position_message);
+    return true;
+}
+
+std::string AdasV2Protocol::_convert_dispatched_position(PositionMessage& position_message) {
+    position_message.cyclic_counter = position_cyclic;
+    position_cyclic++;
+    position_cyclic = position_cyclic % 4;
+
+    position_message.offset %= PATH_MAX_DISTANCE;
+
+    return _convert_position_to_json(position_message);
+}
+
+void AdasV2Protocol::_log_position_dispatch(int64_t wait_start, int64_t wait_end,
+                                            int64_t callback_start, int64_t callback_end) {
+    LOG_DEBUG("_position_pthread mutex_lock_time_ms:%ld process_time_ms:%ld callback_time_ms:%ld",
+        wait_end - wait_start, callback_start - wait_end, callback_end - callback_start);
+}
+
+void* AdasV2Protocol::_position_pthread(AdasV2Protocol* protocol) {
+    VirtualSink sink{protocol};
+    protocol->_dispatch_position_messages(sink);
     return nullptr;
 }
 
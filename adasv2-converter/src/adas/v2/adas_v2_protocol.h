@@ -5,9 +5,18 @@
 #include <fstream>
 #include <atomic>
 #include <map>
+#include <unordered_map>
 #include <assert.h>
 #include <pthread.h>
+#include <condition_variable>
+#include <thread>
 
+#include "geo_enu.h"
+#include "geo_grid_index.h"
+#include "geo_simplify.h"
+#include "adas_v2_clock.h"
+#include "adas_v2_log.h"
+#include "adas_v2_metrics.h"
 #include "adas_v2_utility.h"
 #include "adas_v2_type.h"
 #include "adas_v2_channel.h"
@@ -17,14 +26,29 @@ namespace protocol_v2 {
 
 class AdasV2Protocol {
 public:
-    AdasV2Protocol() : _exit(false), _run_log_thread(false), _seted_position_message(false) {
+    AdasV2Protocol() : AdasV2Protocol(true) {}
+    virtual ~AdasV2Protocol() {
+        _stop_metrics_dump();
+        close_log();
+        _stop_dispatch_threads();
+    }
+
+protected:
+    // start_dispatch_threads为false时由派生类自己调用_start_dispatch_threads，
+    // 用于AdasV2ProtocolT在sink构造完成之后再启动发送线程
+    explicit AdasV2Protocol(bool start_dispatch_threads)
+            : _exit(false), _seted_position_message(false) {
         _adas_message_cond = PTHREAD_COND_INITIALIZER;
         _position_message_cond = PTHREAD_COND_INITIALIZER;
-        _async_log_cond = PTHREAD_COND_INITIALIZER;
         _adas_message_mutex = PTHREAD_MUTEX_INITIALIZER;
         _position_message_mutex = PTHREAD_MUTEX_INITIALIZER;
-        _async_log_mutex = PTHREAD_MUTEX_INITIALIZER;
-        if (0 != pthread_create(&_adas_message_tid, nullptr, (void* (*)(void*))_adas_pthread, this)) {
+        if (start_dispatch_threads) {
+            _start_dispatch_threads((void* (*)(void*))_adas_pthread, (void* (*)(void*))_position_pthread, this);
+        }
+    }
+
+    void _start_dispatch_threads(void* (*adas_entry)(void*), void* (*position_entry)(void*), void* arg) {
+        if (0 != pthread_create(&_adas_message_tid, nullptr, adas_entry, arg)) {
             assert(false);
         }
 
@@ -32,25 +56,42 @@ public:
             assert(false);
         }
 
-        if (0 != pthread_create(&_position_message_tid, nullptr, (void* (*)(void*))_position_pthread, this)) {
+        if (0 != pthread_create(&_position_message_tid, nullptr, position_entry, arg)) {
             assert(false);
         }
-        
+
         if (0 != pthread_setname_np(_position_message_tid, "_pos_tid")) {
             assert(false);
         }
+        _dispatch_threads_started = true;
     }
-    ~AdasV2Protocol() {
-        close_log();
+
+    void _stop_dispatch_threads() {
         if (!_exit) {
             _exit = true;
-            pthread_cond_signal(&_adas_message_cond);
-            pthread_cond_signal(&_position_message_cond);
-            pthread_join(_adas_message_tid, nullptr);
-            pthread_join(_position_message_tid, nullptr);
+            if (_dispatch_threads_started) {
+                pthread_cond_signal(&_adas_message_cond);
+                pthread_cond_signal(&_position_message_cond);
+                pthread_join(_adas_message_tid, nullptr);
+                pthread_join(_position_message_tid, nullptr);
+            }
         }
     }
 
+    // 发送线程的主循环，Sink需要提供on_message(const std::string&)和on_batch(const EhpV2Batch&)。
+    // AdasV2Protocol自身用VirtualSink实例化，转发到虚函数ehp_v2_callback/ehp_v2_batch_callback，
+    // 定义在adas_v2_protocol_t.h
+    template<typename Sink>
+    void _dispatch_adas_messages(Sink& sink);
+
+    template<typename Sink>
+    void _dispatch_position_messages(Sink& sink);
+
+    // 不启动发送线程时(比如回放)由派生类在每次输入之后调用: 在当前线程把队列里的消息全部交给sink，
+    // 上次之后有新的position再交一条，不节流不等待。返回交出的消息条数，定义在adas_v2_protocol_t.h
+    template<typename Sink>
+    size_t _drain_messages(Sink& sink);
+
 public:
     /**
      * @brief 用于接收ehpv2消息的回调,派生类必须重写该函数用于回调数据
@@ -59,18 +100,76 @@ public:
         return;
     }
 
+    /**
+     * @brief 批量回调,set_batch_callback(true)之后生效。一次input_ehp_info产生的segment、stub、
+     *        profile消息按发送顺序一次性回调,ranges标明每一段消息的类别,使用方可以一次写入传输层。
+     *        position消息不走批量回调。默认实现逐条调用ehp_v2_callback
+    */
+    virtual void ehp_v2_batch_callback(const EhpV2Batch& batch);
+
+    /**
+     * @brief 开启/关闭批量回调,默认关闭
+    */
+    void set_batch_callback(bool enable);
+
+    /**
+     * @brief 开启/关闭link形点的紧凑存储,默认关闭。开启后缓存的horizon形点按1e-7度定点、差分、
+     *        varint压缩,不保存形点累计距离,用到时逐条link解码并现算距离。算上投影用的局部坐标,
+     *        每个形点的内存从32字节降到约13字节。从下一次input_ehp_info开始生效
+    */
+    void set_compact_shapes(bool enable);
+
+    /**
+     * @brief 设置link形点入库时Douglas-Peucker抽稀的容差,unit m,抽掉的形点到保留折线的距离不超过该值。
+     *        减少stub的坐标数和lonlat profile消息数。小于等于0时不抽稀,默认0。从下一次input_ehp_info开始生效
+    */
+    void set_shape_tolerance(double tolerance);
+
     /**
      * @brief 设置目录路径,需要有目录的写权限,并且文件所在的路径是存在的。
      *        比如ccc/aaa/xxx/ddd.log 那么需要ccc/aaa/xxx存在,ddd.log可以不存在
      *        如果不设置该目录,则通过std::cout、std::cerr等标准输出日志
+     *        日志文件为二进制格式,用adasv2_log_decode转成文本
+     *        默认按32MB切分,最多8个文件,切出去的文件为file.N.gz,见LogRotation
     */
     void set_log_file(const std::string& file);
 
+    /**
+     * @brief 同set_log_file,指定日志文件的切分大小、时间和保留个数
+    */
+    void set_log_file(const std::string& file, const LogRotation& rotation);
+
     /**
      * close log stream
      */
     void close_log();
 
+    /**
+     * @brief 设置最低日志级别(LogLevel),低于该级别的日志不输出、参数不求值,默认LOG_LEVEL_DEBUG。
+     *        编译时定义ADASV2_LOG_MIN_LEVEL可以把更低级别的日志整个去掉
+    */
+    void set_log_level(LogLevel level);
+
+    /**
+     * @brief 替换时间来源,PositionAge、耗时日志和发送节流都从clock取时间,nullptr恢复默认的SteadyClock。
+     *        回放时传入ManualClock,由回放程序按记录的时间推进。clock的生命周期由调用方管理,需要长于protocol
+    */
+    void set_clock(Clock* clock);
+
+    /**
+     * @brief 获取各阶段耗时的统计,unit ns,从创建或者上次reset_metrics开始累计。
+     *        阶段见MetricStage: 解析、horizon构建、单条消息序列化、消息排队、回调
+    */
+    void get_metrics(std::vector<LatencySummary>& metrics) const;
+
+    void reset_metrics();
+
+    /**
+     * @brief 每隔interval_seconds把get_metrics的结果以LOG_LEVEL_INFO写日志,每个阶段一行。
+     *        小于等于0时停止,默认不输出
+    */
+    void set_metrics_dump_interval(int interval_seconds);
+
     /**
      * @brief 设置导航route，每次route ID一旦发生变更，所有的缓存和队列的数据全部清空，等待相对应的数据从ehp服务端下发之后在处理
      *         
@@ -83,7 +182,8 @@ public:
     void input_ehp_info(const std::string& ehp_info);
 
     /**
-     * @brief 断网情况下，输入坐标，用于离线计算position
+     * @brief 断网情况下，输入坐标，用于离线计算position。
+     *        link_id为0时按坐标在主路径的形点上匹配出link和link_offset
     */
     void input_loc(const LocInfo& loc);
 private:
@@ -94,19 +194,41 @@ std::mutex public_func_mutex;
 private:
     std::atomic<bool> _exit;
 
+    bool _dispatch_threads_started = false;
+
     pthread_t _adas_message_tid;
     pthread_cond_t _adas_message_cond;
     pthread_mutex_t _adas_message_mutex;
     Adasv2Channel _buffer_channel;
     static void* _adas_pthread(AdasV2Protocol* protocol);
 
+    // 取下一条待发送的消息，队列为空时等待。返回值同Adasv2Channel::pop，批量返回ADAS_POP_BATCH
+    static const int ADAS_POP_BATCH = 2;
+    int _next_adas_message(std::string& ehp_json, EhpV2Batch& batch);
+    // 同_next_adas_message，队列为空时直接返回-1
+    int _try_adas_message(std::string& ehp_json, EhpV2Batch& batch);
+    // 调用方持有_adas_message_mutex
+    int _pop_adas_message(std::string& ehp_json, EhpV2Batch& batch);
+    // 按消息所在的队列节流
+    void _pace_adas_message(int pop_status);
+
     pthread_t _position_message_tid;
     pthread_cond_t _position_message_cond;
     pthread_mutex_t _position_message_mutex;
     PositionMessage _position_message_cache;
     std::atomic<bool> _seted_position_message;
+    uint64_t _position_sequence = 0; // position cache每更新一次加1
+    uint64_t _drained_position_sequence = 0; // 最近一次取出的position对应的_position_sequence
     static void* _position_pthread(AdasV2Protocol* protocol);
 
+    // 等待新的position并转成json，没有需要发送的position时返回false
+    bool _next_position_message(std::string& position_json, int64_t& wait_start, int64_t& wait_end);
+    // 不等待，上次取出之后position cache没有更新时返回false
+    bool _try_position_message(std::string& position_json);
+    // 填写cyclic_counter后转成json
+    std::string _convert_dispatched_position(PositionMessage& position_message);
+    void _log_position_dispatch(int64_t wait_start, int64_t wait_end, int64_t callback_start, int64_t callback_end);
+
 private:
     void _process_position(cJSON* cjson_position_ptr);
 
@@ -123,6 +245,19 @@ private:
     void _send_traffic_light(cJSON* cjson_traffic_light_ptr);
     void _send_warning_info(cJSON* cjson_warning_info_ptr);
 
+    // @brief _link_infos重建之后增量更新_link_refs和_link_grid，只有新增或者变化的link重新插入网格、
+    //        重新换算局部坐标
+    void _update_link_index();
+    // @brief 主路径起点离_local_frame原点太远时重新选原点，返回原点是否变化
+    bool _update_local_frame();
+    // @brief link_id为0的坐标在主路径上按形点匹配，补齐link_id, link_index, link_offset, link_direction
+    int _match_loc_on_main_path(LocInfo& loc);
+    void _input_loc(const LocInfo& loc);
+
+    // 消息进入发送队列，批量模式下先缓存，在本次更新结束时由_flush_batch整体入队
+    void _push_message(MessageClass message_class, const std::string& ehp_json);
+    void _flush_batch();
+
     void _send_invalid_stub_message();
     void _send_invalid_position_message();
 
@@ -135,6 +270,21 @@ private:
     std::vector<PathInfo> _path_infos; // 用于position更新的时候，动态更新stub使用
     std::map<int64_t, std::vector<LinkInfo> > _link_infos; // 用于离线绑路更新positon用
 
+    struct LinkRef {
+        int64_t path_id = 0;
+        size_t index = 0; // _link_infos[path_id]中的下标
+        uint64_t linkid = 0;
+        size_t shape_size = 0;
+        std::vector<float> local_east = {}; // 形点在_local_frame下的坐标，unit m
+        std::vector<float> local_north = {};
+    };
+    static uint64_t _link_ref_id(int64_t path_id, int64_t link_index) {
+        return (uint64_t(path_id) << 32) | (uint64_t(link_index) & 0xffffffffULL);
+    }
+    std::unordered_map<uint64_t, LinkRef> _link_refs; // (path_id, link_index) -> link
+    geo::SegmentGridIndex _link_grid; // 所有link形点的网格索引，id同_link_refs
+    geo::LocalFrame _local_frame; // 以主路径起点附近为原点的局部坐标系，投影计算在这个坐标系下做
+
     std::map<int64_t, int64_t> _sended_max_segment_link_index; // pathid -> link_index_on_path
     std::map<int64_t, int64_t> _sended_max_lonlat_link_index; // pathid -> link_index_on_path
     std::map<int64_t, int64_t> _sended_max_slope_offset; // pathid -> offset * 100;
@@ -149,17 +299,33 @@ private:
     std::map<int64_t, std::map<int64_t, int64_t> > _navi_link_id_2_length; // linkindex -> linkid -> linklength
     int64_t _ehp_version = 0;
 
-public:
-    pthread_t _async_log_tid;
-    pthread_cond_t _async_log_cond;
-    pthread_mutex_t _async_log_mutex;
-    static void* _async_log_pthread(AdasV2Protocol* protocol);
+    bool _batch_callback_enabled = false;
+    bool _compact_shapes_enabled = false;
+    std::vector<Coord> _shape_buffer; // 紧凑存储时解码一条link的形点用
+    std::vector<double> _distance_buffer; // 紧凑存储时现算一条link的形点累计距离用
+    double _shape_tolerance = 0.0;
+    std::vector<uint8_t> _simplify_buffer; // 抽稀时的保留标记，重复使用避免每条link分配
+    EhpV2Batch _pending_batch_list0; // stub, segment
+    EhpV2Batch _pending_batch_list1; // profileshort, profilelong
 
-    std::atomic<bool> _run_log_thread;
-    std::string _log_file;
+    BinaryLogger _logger;
+
+    std::atomic<Clock*> _clock{&SteadyClock::instance()};
+    int64_t _now_ms() const {
+        return _clock.load(std::memory_order_acquire)->now_ms();
+    }
+    void _sleep_ms(int64_t ms) const {
+        _clock.load(std::memory_order_acquire)->sleep_ms(ms);
+    }
 
-    void _log(const std::string& msg);
-    std::list<std::string>  _async_log_buffer;
+    LatencyMetrics _metrics;
+    std::thread _metrics_dump_thread;
+    std::mutex _metrics_dump_mutex;
+    std::condition_variable _metrics_dump_cond;
+    int _metrics_dump_interval = 0;
+    bool _metrics_dump_stop = false;
+    void _stop_metrics_dump();
+    void _metrics_dump_loop();
 }; // class AdasV2Protocol
 
 } // namesapce protocol_v2
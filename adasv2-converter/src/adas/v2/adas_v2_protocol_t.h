@@ -0,0 +1,187 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <string>
+#include <utility>
+#include <type_traits>
+
+#include "adas_v2_protocol.h"
+#include "adas_v2_trace.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+namespace detail {
+
+// Sink没有提供on_batch时逐条调用on_message
+template<typename Sink>
+class has_on_batch {
+    template<typename U>
+    static auto test(int) -> decltype(std::declval<U&>().on_batch(std::declval<const EhpV2Batch&>()),
+                                      std::true_type());
+    template<typename U>
+    static std::false_type test(...);
+
+public:
+    static const bool value = decltype(test<Sink>(0))::value;
+};
+
+template<typename Sink>
+inline typename std::enable_if<has_on_batch<Sink>::value>::type
+sink_batch(Sink& sink, const EhpV2Batch& batch) {
+    sink.on_batch(batch);
+}
+
+template<typename Sink>
+inline typename std::enable_if<!has_on_batch<Sink>::value>::type
+sink_batch(Sink& sink, const EhpV2Batch& batch) {
+    for (size_t i = 0; i < batch.messages.size(); i++) {
+        sink.on_message(batch.messages[i]);
+    }
+}
+
+} // namespace detail
+
+template<typename Sink>
+void AdasV2Protocol::_dispatch_adas_messages(Sink& sink) {
+    std::string ehp_json = "";
+    EhpV2Batch batch;
+    while (!_exit) {
+        int pop_status = _next_adas_message(ehp_json, batch);
+        if (ADAS_POP_BATCH == pop_status) {
+            // 整个更新一次交给使用方，由使用方自己做批量发送，这里不再按条节流
+            ADASV2_TRACE(callback_begin, 2, 0, batch.messages.size());
+            uint64_t callback_start = monotonic_ns();
+            detail::sink_batch(sink, batch);
+            uint64_t callback_cost = monotonic_ns() - callback_start;
+            _metrics.record(METRIC_ADAS_CALLBACK, callback_cost);
+            ADASV2_TRACE(callback_end, 2, batch.messages.size(), callback_cost);
+            continue;
+        }
+
+        if (-1 == pop_status) {
+            continue;
+        }
+
+        ADASV2_TRACE(callback_begin, 0, ehp_json.size(), 1);
+        uint64_t callback_start = monotonic_ns();
+        sink.on_message(ehp_json);
+        uint64_t callback_cost = monotonic_ns() - callback_start;
+        _metrics.record(METRIC_ADAS_CALLBACK, callback_cost);
+        ADASV2_TRACE(callback_end, 0, 1, callback_cost);
+        _pace_adas_message(pop_status);
+    }
+}
+
+template<typename Sink>
+void AdasV2Protocol::_dispatch_position_messages(Sink& sink) {
+    std::string position_json = "";
+    int64_t wait_start = 0;
+    int64_t wait_end = 0;
+    while (!_exit) {
+        if (!_next_position_message(position_json, wait_start, wait_end)) {
+            continue;
+        }
+
+        int64_t callback_start = _now_ms();
+        ADASV2_TRACE(callback_begin, 1, position_json.size(), 1);
+        uint64_t callback_start_ns = monotonic_ns();
+        sink.on_message(position_json);
+        uint64_t callback_cost = monotonic_ns() - callback_start_ns;
+        _metrics.record(METRIC_POSITION_CALLBACK, callback_cost);
+        ADASV2_TRACE(callback_end, 1, 1, callback_cost);
+        int64_t callback_end = _now_ms();
+        _log_position_dispatch(wait_start, wait_end, callback_start, callback_end);
+    }
+}
+
+template<typename Sink>
+size_t AdasV2Protocol::_drain_messages(Sink& sink) {
+    size_t count = 0;
+    std::string ehp_json = "";
+    EhpV2Batch batch;
+    while (true) {
+        int pop_status = _try_adas_message(ehp_json, batch);
+        if (-1 == pop_status) {
+            break;
+        }
+        bool is_batch = ADAS_POP_BATCH == pop_status;
+        size_t messages = is_batch ? batch.messages.size() : 1;
+        ADASV2_TRACE(callback_begin, is_batch ? 2 : 0, is_batch ? 0 : ehp_json.size(), messages);
+        uint64_t callback_start = monotonic_ns();
+        if (is_batch) {
+            detail::sink_batch(sink, batch);
+        } else {
+            sink.on_message(ehp_json);
+        }
+        uint64_t callback_cost = monotonic_ns() - callback_start;
+        _metrics.record(METRIC_ADAS_CALLBACK, callback_cost);
+        ADASV2_TRACE(callback_end, is_batch ? 2 : 0, messages, callback_cost);
+        count += messages;
+    }
+
+    std::string position_json = "";
+    if (_try_position_message(position_json)) {
+        ADASV2_TRACE(callback_begin, 1, position_json.size(), 1);
+        uint64_t callback_start = monotonic_ns();
+        sink.on_message(position_json);
+        uint64_t callback_cost = monotonic_ns() - callback_start;
+        _metrics.record(METRIC_POSITION_CALLBACK, callback_cost);
+        ADASV2_TRACE(callback_end, 1, 1, callback_cost);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief 编译期确定回调的AdasV2Protocol。Sink作为策略类，发送线程直接调用Sink::on_message，
+ *        不经过虚函数，可以被内联进发送循环。可选提供on_batch(const EhpV2Batch&)接收批量回调。
+ *        例如:
+ *          struct CanSink { void on_message(const std::string& ehp_v2_json) { ... } };
+ *          AdasV2ProtocolT<CanSink> protocol(can_sink构造参数);
+ *        构造参数原样转发给Sink。派生AdasV2Protocol并重写ehp_v2_callback的用法不变。
+ */
+template<typename Sink>
+class AdasV2ProtocolT final : public AdasV2Protocol {
+public:
+    template<typename... Args>
+    explicit AdasV2ProtocolT(Args&&... args) : AdasV2Protocol(false), _sink(std::forward<Args>(args)...) {
+        _start_dispatch_threads(_adas_entry, _position_entry, this);
+    }
+
+    ~AdasV2ProtocolT() {
+        // 先停掉发送线程，_sink析构之后不能再被调用
+        _stop_dispatch_threads();
+    }
+
+    Sink& sink() {
+        return _sink;
+    }
+
+    // 少数消息(比如版本切换时的无效position)在调用线程上直接回调，同样交给_sink
+    void ehp_v2_callback(const std::string& ehp_v2_json) override final {
+        _sink.on_message(ehp_v2_json);
+    }
+
+    void ehp_v2_batch_callback(const EhpV2Batch& batch) override final {
+        detail::sink_batch(_sink, batch);
+    }
+
+private:
+    static void* _adas_entry(void* arg) {
+        AdasV2ProtocolT* protocol = static_cast<AdasV2ProtocolT*>(arg);
+        protocol->_dispatch_adas_messages(protocol->_sink);
+        return nullptr;
+    }
+
+    static void* _position_entry(void* arg) {
+        AdasV2ProtocolT* protocol = static_cast<AdasV2ProtocolT*>(arg);
+        protocol->_dispatch_position_messages(protocol->_sink);
+        return nullptr;
+    }
+
+    Sink _sink;
+}; // class AdasV2ProtocolT
+
+} // namespace protocol_v2
+} // namespace adas
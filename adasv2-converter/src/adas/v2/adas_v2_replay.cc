@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "adas_v2_protocol_t.h"
+#include "adas_v2_replay.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+namespace {
+
+bool get_number(cJSON* object, const char* name, double& value) {
+    cJSON* item = cJSON_GetObjectItem(object, name);
+    if (!cJSON_IsNumber(item)) {
+        return false;
+    }
+    value = item->valuedouble;
+    return true;
+}
+
+// 字符串原样取出，对象按紧凑格式重新输出
+bool get_payload(cJSON* item, std::string& payload) {
+    if (cJSON_IsString(item)) {
+        payload = item->valuestring;
+        return true;
+    }
+    if (!cJSON_IsObject(item)) {
+        return false;
+    }
+    char* text = cJSON_PrintUnformatted(item);
+    if (nullptr == text) {
+        return false;
+    }
+    payload = text;
+    free(text);
+    return true;
+}
+
+int parse_loc(cJSON* data, LocInfo& loc) {
+    if (!cJSON_IsObject(data)) {
+        return -1;
+    }
+    double timestamp = 0.0;
+    double link_id = 0.0;
+    double link_index = 0.0;
+    if (!get_number(data, "timestamp", timestamp)) {
+        return -1;
+    }
+    loc = LocInfo();
+    loc.timestamp = timestamp;
+    get_number(data, "speed", loc.speed);
+    get_number(data, "direction", loc.direction);
+    get_number(data, "probability", loc.probability);
+    get_number(data, "lon", loc.coord.x);
+    get_number(data, "lat", loc.coord.y);
+    if (get_number(data, "link_id", link_id)) {
+        loc.link_id = link_id;
+    }
+    if (get_number(data, "link_index", link_index)) {
+        loc.link_index = link_index;
+    }
+    get_number(data, "link_offset", loc.link_offset);
+    get_number(data, "link_direction", loc.link_direction);
+    cJSON* route_id = cJSON_GetObjectItem(data, "navi_route_id");
+    if (cJSON_IsString(route_id)) {
+        loc.navi_route_id = route_id->valuestring;
+    }
+    return 0;
+}
+
+} // namespace
+
+const char* replay_event_type_name(ReplayEventType type) {
+    switch (type) {
+        case REPLAY_SET_NAVI_ROUTE:
+            return "set_navi_route";
+        case REPLAY_INPUT_EHP_INFO:
+            return "input_ehp_info";
+        case REPLAY_INPUT_LOC:
+            return "input_loc";
+        default:
+            return "unknown";
+    }
+}
+
+int parse_replay_event(const std::string& line, ReplayEvent& event) {
+    cJSON* root = cJSON_Parse(line.c_str());
+    if (nullptr == root) {
+        return -1;
+    }
+
+    int ret = -1;
+    double time_ms = 0.0;
+    cJSON* type = cJSON_GetObjectItem(root, "type");
+    cJSON* data = cJSON_GetObjectItem(root, "data");
+    if (get_number(root, "time_ms", time_ms) && cJSON_IsString(type)) {
+        event.time_ms = time_ms;
+        event.payload.clear();
+        for (int i = 0; i < REPLAY_EVENT_TYPE_COUNT; i++) {
+            if (0 == strcmp(type->valuestring, replay_event_type_name(ReplayEventType(i)))) {
+                event.type = ReplayEventType(i);
+                if (REPLAY_INPUT_LOC == event.type) {
+                    ret = parse_loc(data, event.loc);
+                } else {
+                    ret = get_payload(data, event.payload) ? 0 : -1;
+                }
+                break;
+            }
+        }
+    }
+    cJSON_Delete(root);
+    return ret;
+}
+
+uint64_t message_hash(const char* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= uint8_t(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+ReplayProtocol::ReplayProtocol() : AdasV2Protocol(false) {
+    set_clock(&_replay_clock);
+}
+
+ReplayProtocol::~ReplayProtocol() {
+    // _replay_clock先于基类析构，之后日志线程取时间用默认时钟
+    set_clock(nullptr);
+}
+
+size_t ReplayProtocol::replay(const ReplayEvent& event, std::vector<std::string>& messages) {
+    size_t begin = messages.size();
+    _messages = &messages;
+    _replay_clock.set_ms(event.time_ms);
+    switch (event.type) {
+        case REPLAY_SET_NAVI_ROUTE:
+            set_navi_route(event.payload);
+            break;
+        case REPLAY_INPUT_EHP_INFO:
+            input_ehp_info(event.payload);
+            break;
+        case REPLAY_INPUT_LOC:
+            input_loc(event.loc);
+            break;
+        default:
+            break;
+    }
+    Sink sink{this};
+    _drain_messages(sink);
+    _messages = nullptr;
+    return messages.size() - begin;
+}
+
+void ReplayProtocol::ehp_v2_callback(const std::string& ehp_v2_json) {
+    if (nullptr != _messages) {
+        _messages->push_back(ehp_v2_json);
+    }
+}
+
+} // namespace protocol_v2
+} // namespace adas
@@ -0,0 +1,80 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "adas_v2_clock.h"
+#include "adas_v2_protocol.h"
+#include "adas_v2_type.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+// 录制的会话为JSONL，每行一个输入事件，time_ms为事件发生时的epoch毫秒时间戳:
+//   {"time_ms":1716960728000,"type":"set_navi_route","data":{"route":{...}}}
+//   {"time_ms":1716960728020,"type":"input_ehp_info","data":{"link":[...],...}}
+//   {"time_ms":1716960733700,"type":"input_loc","data":{"speed":21.4,"direction":206.7,"timestamp":1716960733671,
+//       "link_id":16294306630,"link_index":0,"link_offset":20.0,"link_direction":206.6,"navi_route_id":"..."}}
+// set_navi_route和input_ehp_info的data也可以是原样的字符串。input_loc的lon/lat可选
+enum ReplayEventType {
+    REPLAY_SET_NAVI_ROUTE = 0,
+    REPLAY_INPUT_EHP_INFO = 1,
+    REPLAY_INPUT_LOC = 2,
+    REPLAY_EVENT_TYPE_COUNT = 3,
+};
+
+const char* replay_event_type_name(ReplayEventType type);
+
+struct ReplayEvent {
+    int64_t time_ms = 0;
+    ReplayEventType type = REPLAY_SET_NAVI_ROUTE;
+    std::string payload; // set_navi_route和input_ehp_info的参数
+    LocInfo loc; // input_loc的参数
+};
+
+/**
+ * @brief 解析会话里的一行
+ * @return 0 for ok, -1 for 不是json、type未知或者缺少字段
+*/
+int parse_replay_event(const std::string& line, ReplayEvent& event);
+
+// FNV-1a 64，用于比较不同版本回放输出的消息内容
+uint64_t message_hash(const char* data, size_t size, uint64_t hash = 14695981039346656037ULL);
+
+inline uint64_t message_hash(const std::string& message) {
+    return message_hash(message.data(), message.size());
+}
+
+// 回放用的protocol: 不启动发送线程，时间取自内部的ManualClock。每个事件先把时间设为time_ms，
+// 调用对应的输入接口，再在当前线程把产生的消息全部取出，不做发送节流，回放速度只受CPU限制。
+// 同样的会话每次回放的输出相同
+class ReplayProtocol : public AdasV2Protocol {
+public:
+    ReplayProtocol();
+    ~ReplayProtocol();
+
+    /**
+     * @brief 回放一个事件，本次产生的消息按发送顺序追加到messages
+     * @return 追加的消息条数
+    */
+    size_t replay(const ReplayEvent& event, std::vector<std::string>& messages);
+
+    // 少数消息(比如版本切换时的无效position)在调用线程上直接回调
+    void ehp_v2_callback(const std::string& ehp_v2_json) override;
+
+private:
+    struct Sink {
+        ReplayProtocol* protocol;
+        void on_message(const std::string& ehp_v2_json) {
+            protocol->ehp_v2_callback(ehp_v2_json);
+        }
+    };
+
+    ManualClock _replay_clock;
+    std::vector<std::string>* _messages = nullptr; // replay期间有效
+}; // class ReplayProtocol
+
+} // namespace protocol_v2
+} // namespace adas
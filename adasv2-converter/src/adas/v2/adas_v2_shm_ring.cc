@@ -0,0 +1,342 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "adas_v2_metrics.h"
+#include "adas_v2_shm_ring.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+static_assert(sizeof(Adasv2ShmReaderCursor) == 64, "reader cursor should take one cache line");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory atomics must be lock free");
+
+namespace {
+
+size_t slot_stride(uint32_t slot_size) {
+    return (sizeof(Adasv2ShmSlot) + slot_size + 63) & ~size_t(63);
+}
+
+size_t ring_size(uint32_t slot_count, uint32_t slot_size) {
+    return sizeof(Adasv2ShmHeader) + slot_count * slot_stride(slot_size);
+}
+
+Adasv2ShmSlot* ring_slot(Adasv2ShmHeader* header, uint64_t sequence) {
+    char* slots = reinterpret_cast<char*>(header) + sizeof(Adasv2ShmHeader);
+    size_t index = sequence & (header->slot_count - 1);
+    return reinterpret_cast<Adasv2ShmSlot*>(slots + index * slot_stride(header->slot_size));
+}
+
+uint64_t monotonic_ms() {
+    return monotonic_ns() / 1000000;
+}
+
+bool reader_alive(uint64_t heartbeat_ms, uint64_t now_ms) {
+    return now_ms < heartbeat_ms + ADASV2_SHM_READER_TIMEOUT_MS;
+}
+
+bool token_active(uint32_t token) {
+    return 0 != (token & 1);
+}
+
+// 下一代的占用token，和之前任何一代都不相同，卡住的原占用者不会把新token误认为自己的
+uint32_t next_token(uint32_t token) {
+    return ((token >> 1) + 1) << 1 | 1;
+}
+
+// 读端每读这么多条消息刷新一次heartbeat，避免每次read都取时间
+const uint32_t HEARTBEAT_READS = 64;
+
+} // namespace
+
+int Adasv2ShmPublisher::open(const std::string& name, uint32_t slot_count, uint32_t slot_size, mode_t mode) {
+    close();
+    if (0 == slot_count || 0 == slot_size) {
+        return -1;
+    }
+
+    uint32_t count = 1;
+    while (count < slot_count) {
+        count <<= 1;
+    }
+
+    // 只有新建的对象才设置大小和初始化，已存在的对象可能正被读端映射着，不能改大小也不能清空
+    size_t size = ring_size(count, slot_size);
+    bool created = true;
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode);
+    if (-1 == fd && EEXIST == errno) {
+        created = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0);
+    }
+    if (-1 == fd) {
+        return -1;
+    }
+
+    if (created) {
+        if (0 != ftruncate(fd, size)) {
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return -1;
+        }
+    } else {
+        // 另一个写端还没初始化完时大小也对不上，调用方稍后重试
+        struct stat st;
+        if (0 != fstat(fd, &st) || size_t(st.st_size) != size) {
+            ::close(fd);
+            return -1;
+        }
+    }
+
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (MAP_FAILED == base) {
+        if (created) {
+            shm_unlink(name.c_str());
+        }
+        return -1;
+    }
+
+    Adasv2ShmHeader* header = static_cast<Adasv2ShmHeader*>(base);
+    if (created) {
+        // ftruncate出来的对象全为0，只需要填写头部
+        header->version = ADASV2_SHM_VERSION;
+        header->slot_count = count;
+        header->slot_size = slot_size;
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = ADASV2_SHM_MAGIC;
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ADASV2_SHM_MAGIC != header->magic || ADASV2_SHM_VERSION != header->version ||
+                count != header->slot_count || slot_size != header->slot_size) {
+            munmap(base, size);
+            return -1;
+        }
+    }
+
+    _name = name;
+    _base = base;
+    _mapped_size = size;
+    _header = header;
+    _dropped = 0;
+    return 0;
+}
+
+void Adasv2ShmPublisher::close(bool unlink) {
+    if (nullptr != _base) {
+        munmap(_base, _mapped_size);
+        _base = nullptr;
+        _header = nullptr;
+        _mapped_size = 0;
+    }
+    if (unlink && !_name.empty()) {
+        shm_unlink(_name.c_str());
+        _name.clear();
+    }
+}
+
+int Adasv2ShmPublisher::publish(const char* data, size_t length) {
+    if (nullptr == _header || length > _header->slot_size) {
+        _dropped++;
+        return -1;
+    }
+
+    uint64_t sequence = _header->write_seq.load(std::memory_order_relaxed);
+    Adasv2ShmSlot* slot = ring_slot(_header, sequence);
+
+    slot->state.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(reinterpret_cast<char*>(slot) + sizeof(Adasv2ShmSlot), data, length);
+    slot->length = length;
+
+    slot->state.store(2 * sequence + 2, std::memory_order_release);
+    _header->write_seq.store(sequence + 1, std::memory_order_release);
+    return 0;
+}
+
+uint64_t Adasv2ShmPublisher::published() const {
+    if (nullptr == _header) {
+        return 0;
+    }
+    return _header->write_seq.load(std::memory_order_acquire);
+}
+
+int64_t Adasv2ShmPublisher::reader_lag(uint32_t reader_index) const {
+    if (nullptr == _header || reader_index >= ADASV2_SHM_MAX_READERS) {
+        return -1;
+    }
+
+    const Adasv2ShmReaderCursor& reader = _header->readers[reader_index];
+    if (!token_active(reader.active.load(std::memory_order_acquire))) {
+        return -1;
+    }
+    return _header->write_seq.load(std::memory_order_acquire) - reader.cursor.load(std::memory_order_relaxed);
+}
+
+int Adasv2ShmReader::open(const std::string& name) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (-1 == fd) {
+        return -1;
+    }
+
+    struct stat st;
+    if (0 != fstat(fd, &st) || size_t(st.st_size) < sizeof(Adasv2ShmHeader)) {
+        ::close(fd);
+        return -1;
+    }
+
+    void* base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (MAP_FAILED == base) {
+        return -1;
+    }
+
+    Adasv2ShmHeader* header = static_cast<Adasv2ShmHeader*>(base);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (ADASV2_SHM_MAGIC != header->magic || ADASV2_SHM_VERSION != header->version ||
+            size_t(st.st_size) < ring_size(header->slot_count, header->slot_size)) {
+        munmap(base, st.st_size);
+        return -1;
+    }
+
+    // 登记读游标，空闲的或者超时没有心跳的游标(占用者已退出或者卡死)可以回收。
+    // 先CAS heartbeat_ms再CAS active: 同时抢一个游标的读端只有一个能把heartbeat_ms从旧值改掉，
+    // 改成当前时间之后游标又是存活状态，后来的读端也不会再抢
+    uint64_t now_ms = monotonic_ms();
+    Adasv2ShmReaderCursor* cursor = nullptr;
+    uint32_t token = 0;
+    for (uint32_t i = 0; i < ADASV2_SHM_MAX_READERS && nullptr == cursor; i++) {
+        Adasv2ShmReaderCursor& reader = header->readers[i];
+        uint64_t heartbeat_ms = reader.heartbeat_ms.load(std::memory_order_acquire);
+        uint32_t active = reader.active.load(std::memory_order_acquire);
+        if (token_active(active) && reader_alive(heartbeat_ms, now_ms)) {
+            continue;
+        }
+        if (!reader.heartbeat_ms.compare_exchange_strong(heartbeat_ms, now_ms, std::memory_order_acq_rel)) {
+            continue;
+        }
+        if (reader.active.compare_exchange_strong(active, next_token(active), std::memory_order_acq_rel)) {
+            cursor = &reader;
+            token = next_token(active);
+        }
+    }
+    if (nullptr == cursor) {
+        munmap(base, st.st_size);
+        return -1;
+    }
+
+    _base = base;
+    _mapped_size = st.st_size;
+    _header = header;
+    _cursor = cursor;
+    _token = token;
+    _next = header->write_seq.load(std::memory_order_acquire);
+    _reads = 0;
+    _cursor->pid.store(getpid(), std::memory_order_relaxed);
+    _cursor->lapped.store(0, std::memory_order_relaxed);
+    _cursor->cursor.store(_next, std::memory_order_release);
+    return 0;
+}
+
+void Adasv2ShmReader::close() {
+    if (nullptr != _cursor) {
+        // 游标已经被回收时不能动新占用者的token
+        uint32_t token = _token;
+        _cursor->active.compare_exchange_strong(token, _token & ~1u, std::memory_order_acq_rel);
+        _cursor = nullptr;
+        _token = 0;
+    }
+    if (nullptr != _base) {
+        munmap(_base, _mapped_size);
+        _base = nullptr;
+        _header = nullptr;
+        _mapped_size = 0;
+    }
+}
+
+bool Adasv2ShmReader::_owned() {
+    if (_cursor->active.load(std::memory_order_acquire) == _token) {
+        return true;
+    }
+    close();
+    return false;
+}
+
+int Adasv2ShmReader::heartbeat() {
+    if (nullptr == _cursor) {
+        return -1;
+    }
+    if (!_owned()) {
+        return -3;
+    }
+    _cursor->heartbeat_ms.store(monotonic_ms(), std::memory_order_release);
+    return 0;
+}
+
+const Adasv2ShmSlot* Adasv2ShmReader::_slot(uint64_t sequence) const {
+    return ring_slot(_header, sequence);
+}
+
+int Adasv2ShmReader::read(Adasv2ShmMessage& message) {
+    if (nullptr == _header) {
+        return -1;
+    }
+
+    // 卡住超过超时时间的读端醒来时游标可能已经归别人了
+    if (!_owned()) {
+        return -3;
+    }
+
+    uint64_t write_seq = _header->write_seq.load(std::memory_order_acquire);
+    if (_next == write_seq) {
+        // 空闲轮询时刷新心跳，读得快的时候每HEARTBEAT_READS条刷新一次
+        _cursor->heartbeat_ms.store(monotonic_ms(), std::memory_order_release);
+        return 1;
+    }
+    if (0 == ++_reads % HEARTBEAT_READS) {
+        _cursor->heartbeat_ms.store(monotonic_ms(), std::memory_order_release);
+    }
+
+    uint64_t slot_count = _header->slot_count;
+    const Adasv2ShmSlot* slot = _slot(_next);
+    uint64_t state = slot->state.load(std::memory_order_acquire);
+    uint32_t length = slot->length;
+    if (write_seq - _next > slot_count || state != 2 * _next + 2 || length > _header->slot_size) {
+        // 被套圈: 跳到当前最老的完整消息，写端正在写的那个槽位也跳过
+        _next = write_seq >= slot_count ? write_seq - slot_count + 1 : 0;
+        _cursor->lapped.fetch_add(1, std::memory_order_relaxed);
+        _cursor->cursor.store(_next, std::memory_order_relaxed);
+        return -2;
+    }
+
+    message.sequence = _next;
+    message.data = reinterpret_cast<const char*>(slot) + sizeof(Adasv2ShmSlot);
+    message.length = length;
+
+    _next++;
+    _cursor->cursor.store(_next, std::memory_order_relaxed);
+    return 0;
+}
+
+bool Adasv2ShmReader::validate(const Adasv2ShmMessage& message) const {
+    if (nullptr == _header) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _slot(message.sequence)->state.load(std::memory_order_relaxed) == 2 * message.sequence + 2;
+}
+
+uint64_t Adasv2ShmReader::lapped() const {
+    if (nullptr == _cursor) {
+        return 0;
+    }
+    return _cursor->lapped.load(std::memory_order_relaxed);
+}
+
+} // namespace protocol_v2
+} // namespace adas
@@ -0,0 +1,185 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <atomic>
+#include <string>
+
+#include "adas_v2_type.h"
+
+namespace adas {
+namespace protocol_v2 {
+
+// 共享内存环形队列，单写多读。写端从不等待读端，读端落后超过一圈时被判定为lapped，
+// 跳到最老的可读消息继续读。每个槽位带序号做seqlock，读端零拷贝直接访问共享内存。
+// 共享内存对象的大小和槽位布局创建之后不再变化: 写端重启时挂接已有的对象，从原来的write_seq继续写，
+// 已映射的读端不受影响；槽位参数不一致时拒绝打开，需要先删除旧对象(close(true)或者shm_unlink)。
+//
+// 写端(转换器进程):
+//   AdasV2ProtocolT<Adasv2ShmPublisher> protocol;
+//   protocol.sink().open("/adasv2_ring", 1024, 2048);
+// 读端(CAN网关、HMI、记录仪等进程):
+//   Adasv2ShmReader reader;
+//   reader.open("/adasv2_ring");
+//   Adasv2ShmMessage message;
+//   if (0 == reader.read(message)) {
+//       ... 使用message.data/message.length ...
+//       if (!reader.validate(message)) { 使用过程中被覆盖，丢弃 }
+//   }
+
+const uint64_t ADASV2_SHM_MAGIC = 0x474E495232564441ULL; // "ADV2RING"
+const uint32_t ADASV2_SHM_VERSION = 3;
+const uint32_t ADASV2_SHM_MAX_READERS = 16;
+// 读端超过这个时间没有read/heartbeat时，它的游标可以被新读端回收，unit ms
+const uint64_t ADASV2_SHM_READER_TIMEOUT_MS = 10000;
+
+// 读端是否存活看heartbeat_ms(CLOCK_MONOTONIC，全系统共用)，不用pid: 容器里各自的PID namespace
+// 看到的pid对不上。pid只用于排查。
+// 回收超时游标时先把heartbeat_ms从看到的旧值CAS成当前时间，同时抢同一个游标的读端只有一个能成功；
+// 抢到的读端再把active换成新的owner token。原占用者卡住之后醒来，read/heartbeat发现token变了就不再使用该游标
+struct Adasv2ShmReaderCursor {
+    std::atomic<uint32_t> active; // owner token: 最低位为1表示占用，其余位为代数，每次登记加1
+
+    std::atomic<uint32_t> pid;
+    std::atomic<uint64_t> cursor; // 下一条要读的消息序号
+    std::atomic<uint64_t> lapped; // 被套圈的次数
+    std::atomic<uint64_t> heartbeat_ms;
+    char padding[32];
+};
+
+struct Adasv2ShmHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slot_count; // 2的幂
+    uint32_t slot_size; // 每个槽位的payload字节数
+    uint32_t reserved;
+    char padding0[40];
+
+    std::atomic<uint64_t> write_seq; // 已发布的消息数，下一条消息的序号
+    char padding1[56];
+
+    Adasv2ShmReaderCursor readers[ADASV2_SHM_MAX_READERS];
+};
+
+struct Adasv2ShmSlot {
+    // 2 * seq + 1: 正在写入消息seq，2 * seq + 2: 消息seq写入完成
+    std::atomic<uint64_t> state;
+    uint32_t length;
+    uint32_t reserved;
+    // 后面紧跟slot_size字节的payload
+};
+
+// 读端拿到的消息，data指向共享内存
+struct Adasv2ShmMessage {
+    uint64_t sequence = 0;
+    const char* data = nullptr;
+    uint32_t length = 0;
+};
+
+class Adasv2ShmPublisher {
+public:
+    Adasv2ShmPublisher() {}
+    ~Adasv2ShmPublisher() {
+        close();
+    }
+
+    /**
+     * @brief 创建共享内存环形队列，slot_count会向上取整到2的幂，mode为新建对象的权限。
+     *        对象已存在时挂接上去继续发布，不清空已有的消息和读端登记
+     * @return 0 for ok, -1 for error(包括已有对象的版本或者槽位参数不一致)
+    */
+    int open(const std::string& name, uint32_t slot_count, uint32_t slot_size, mode_t mode = 0600);
+
+    /**
+     * @brief 解除映射，unlink为true时同时删除共享内存对象
+    */
+    void close(bool unlink = false);
+
+    /**
+     * @brief 发布一条消息，从不阻塞
+     * @return 0 for ok, -1 for error(未打开或消息超过slot_size)
+    */
+    int publish(const char* data, size_t length);
+
+    // 作为AdasV2ProtocolT的Sink使用
+    void on_message(const std::string& ehp_v2_json) {
+        publish(ehp_v2_json.data(), ehp_v2_json.size());
+    }
+
+    void on_batch(const EhpV2Batch& batch) {
+        for (size_t i = 0; i < batch.messages.size(); i++) {
+            publish(batch.messages[i].data(), batch.messages[i].size());
+        }
+    }
+
+    uint64_t published() const;
+    uint64_t dropped() const {
+        return _dropped;
+    }
+
+    /**
+     * @brief 读端落后写端的消息数，读端不存在时返回-1
+    */
+    int64_t reader_lag(uint32_t reader_index) const;
+
+private:
+    std::string _name;
+    void* _base = nullptr;
+    size_t _mapped_size = 0;
+    Adasv2ShmHeader* _header = nullptr;
+    uint64_t _dropped = 0;
+}; // class Adasv2ShmPublisher
+
+class Adasv2ShmReader {
+public:
+    Adasv2ShmReader() {}
+    ~Adasv2ShmReader() {
+        close();
+    }
+
+    /**
+     * @brief 打开已存在的环形队列并登记一个读游标，从最新的消息开始读
+     * @return 0 for ok, -1 for error
+    */
+    int open(const std::string& name);
+
+    void close();
+
+    /**
+     * @brief 刷新存活时间，长时间不调用read的读端需要定期调用，否则游标可能被回收
+     * @return 0 for ok, -1 for 未打开, -3 for 游标已被其他读端回收(已自动close)
+    */
+    int heartbeat();
+
+    /**
+     * @brief 读取下一条消息，成功后游标前移
+     * @return 0 for ok, 1 for 暂无新消息, -1 for 未打开, -2 for 被写端套圈(游标已跳到最老的可读消息),
+     *         -3 for 游标超时后被其他读端回收(已自动close，需要重新open)
+    */
+    int read(Adasv2ShmMessage& message);
+
+    /**
+     * @brief 消费完message之后调用，返回false表示消费过程中槽位被写端覆盖，数据不可信
+    */
+    bool validate(const Adasv2ShmMessage& message) const;
+
+    uint64_t lapped() const;
+
+private:
+    const Adasv2ShmSlot* _slot(uint64_t sequence) const;
+    // 游标还归自己所有时返回true，被回收时close并返回false
+    bool _owned();
+
+    void* _base = nullptr;
+    size_t _mapped_size = 0;
+    Adasv2ShmHeader* _header = nullptr;
+    Adasv2ShmReaderCursor* _cursor = nullptr;
+    uint32_t _token = 0; // 登记时写入_cursor->active的owner token
+    uint64_t _next = 0;
+    uint32_t _reads = 0;
+}; // class Adasv2ShmReader
+
+} // namespace protocol_v2
+} // namespace adas
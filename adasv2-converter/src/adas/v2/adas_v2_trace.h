@@ -0,0 +1,36 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+// USDT静态探针，provider为adasv2，车上不能挂调试器时用bpftrace/perf跟踪转换延迟:
+//   bpftrace -e 'usdt:./test_bin:adasv2:message_dequeue { @queue_us = hist((nsecs - arg3) / 1000); }'
+// 有sys/sdt.h时编译进来，探针未开启时只是一条nop，参数都是现成的整数，不额外计算；
+// 没有sys/sdt.h或者定义了ADASV2_NO_USDT时ADASV2_TRACE展开为空，参数不求值。
+//
+// 探针及参数:
+//   ehp_input(bytes)                          input_ehp_info入口，ehp_info的长度
+//   ehp_parsed(bytes, parse_ns, ok)           cJSON_Parse完成，ok为0时解析失败
+//   message_enqueue(list, bytes, seq, depth)  Adasv2Channel入队，list 0:stub/segment 1:profile 2:批量，
+//                                             批量时bytes为消息条数；seq为入队序号，depth为入队后的队列长度
+//   message_dequeue(list, bytes, seq, enqueue_ns) Adasv2Channel出队，enqueue_ns为入队时的monotonic_ns()，
+//                                             和bpftrace的nsecs同一时钟，相减即排队时间
+//   position_update(path_index, offset, seq)  position缓存更新成功，seq为更新序号
+//   position_dequeue(path_index, offset, seq) 发送线程取出position缓存
+//   callback_begin(kind, bytes, count)        ehp_v2_callback/ehp_v2_batch_callback之前，
+//                                             kind 0:adas消息 1:position 2:批量，批量时bytes为0
+//   callback_end(kind, count, cost_ns)        回调返回
+// 同一条消息的message_dequeue和callback_begin在同一个线程上相继触发，用tid关联
+
+#ifndef ADASV2_NO_USDT
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define ADASV2_USDT 1
+#endif
+#endif
+#endif
+
+#ifdef ADASV2_USDT
+#define ADASV2_TRACE(name, ...) STAP_PROBEV(adasv2, name, __VA_ARGS__)
+#else
+#define ADASV2_TRACE(name, ...) do {} while (0)
+#endif
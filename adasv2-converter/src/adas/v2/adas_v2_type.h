@@ -2,6 +2,10 @@
 // Copyright 2024 Baidu Inc. All Rights Reserved.
 // Author: CHEN ShuaiShuai (chenshuaishuai01@baidu.com)
 
+#include <stdint.h>
+#include <stddef.h>
+#include <iterator>
+#include <string>
 #include <vector>
 
 namespace adas {
@@ -12,6 +16,129 @@ struct Coord {
     double y = 0.0;
 };
 
+// 紧凑存储的形点序列: 坐标按1e-7度取整成int32，相邻形点做差分，差分zig-zag之后用varint存储。
+// 形点间隔几十米时每个点3~4字节，Coord为16字节。
+// 解码用除法，最多7位小数的坐标(ehp下发的坐标就是这样)解码结果和原始double逐位一致。
+// 只能顺序访问，const_iterator在++时解码下一个点:
+//   for (auto it = shape.begin(); it != shape.end(); ++it) { it->x, it->y }
+class CompactShape {
+public:
+    static constexpr double SCALE = 1e7; // 1e-7度，经度180度对应1.8e9，在int32范围内
+
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Coord value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const Coord* pointer;
+        typedef const Coord& reference;
+
+        const_iterator() {}
+
+        const Coord& operator*() const {
+            return _coord;
+        }
+
+        const Coord* operator->() const {
+            return &_coord;
+        }
+
+        const_iterator& operator++() {
+            _index++;
+            _decode();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++(*this);
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return _index == other._index;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return _index != other._index;
+        }
+
+    private:
+        friend class CompactShape;
+        const_iterator(const uint8_t* data, size_t index, size_t size) : _data(data), _index(index), _size(size) {
+            _decode();
+        }
+
+        static int64_t _read_delta(const uint8_t*& data) {
+            uint64_t value = 0;
+            int shift = 0;
+            uint8_t byte = 0;
+            do {
+                byte = *data++;
+                value |= uint64_t(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            return int64_t(value >> 1) ^ -int64_t(value & 1);
+        }
+
+        void _decode() {
+            if (_index < _size) {
+                _x += _read_delta(_data);
+                _y += _read_delta(_data);
+                _coord.x = _x / SCALE;
+                _coord.y = _y / SCALE;
+            }
+        }
+
+        const uint8_t* _data = nullptr;
+        size_t _index = 0;
+        size_t _size = 0;
+        int64_t _x = 0;
+        int64_t _y = 0;
+        Coord _coord;
+    };
+
+    /**
+     * @brief 压缩count个形点，覆盖原有内容
+    */
+    void assign(const Coord* coords, size_t count);
+
+    /**
+     * @brief 全部解码到coords，覆盖原有内容
+    */
+    void decode(std::vector<Coord>& coords) const;
+
+    void clear() {
+        std::vector<uint8_t>().swap(_bytes);
+        _size = 0;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return 0 == _size;
+    }
+
+    // 压缩后的字节数
+    size_t byte_size() const {
+        return _bytes.size();
+    }
+
+    const_iterator begin() const {
+        return const_iterator(_bytes.data(), 0, _size);
+    }
+
+    const_iterator end() const {
+        return const_iterator(nullptr, _size, _size);
+    }
+
+private:
+    std::vector<uint8_t> _bytes;
+    size_t _size = 0;
+};
+
 struct LocInfo {
     Coord coord;
 
@@ -63,6 +190,9 @@ struct LinkInfo {
     int form_of_way = 0;
 
     std::vector<Coord> shapes;
+    CompactShape compact_shapes; // 开启紧凑存储时形点压缩存在这里，shapes为空，用link_shapes()读取
+    std::vector<double> shape_distances; // 每个形点沿形状到第一个形点的累计距离，解析时算好，unit m。
+                                         // 紧凑存储时为空，用link_shape_distances()读取
 
     bool complex_intersection = false;
     uint8_t relative_probability = 0;
@@ -168,5 +298,25 @@ struct ProfileShortMessage {
     int accuracy = 0; // 
 };
 
+enum MessageClass {
+    MESSAGE_CLASS_STUB = 0,
+    MESSAGE_CLASS_SEGMENT,
+    MESSAGE_CLASS_PROFILE_SHORT,
+    MESSAGE_CLASS_PROFILE_LONG,
+};
+
+// batch中[begin, end)范围内的消息都属于message_class
+struct MessageClassRange {
+    MessageClass message_class = MESSAGE_CLASS_STUB;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// 一次ehp更新产生的全部消息，顺序和逐条回调时一致
+struct EhpV2Batch {
+    std::vector<std::string> messages;
+    std::vector<MessageClassRange> ranges;
+};
+
 } // namespace protocol_v2
 } // namespace adas
\ No newline at end of file
@@ -1,26 +1,16 @@
 #include <time.h>
 #include <sys/time.h>
-#include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
 
+#include "adas_v2_log.h"
 #include "adas_v2_utility.h"
 
 namespace adas {
 namespace protocol_v2 {
 
 std::string log_time() {
-    auto now = std::chrono::system_clock::now();
-    auto now_time_t = std::chrono::system_clock::to_time_t(now);
-    struct tm buf;
-    localtime_r(&now_time_t, &buf);
-    
-    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-    std::stringstream ss;
-    ss << std::put_time(&buf, "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << milliseconds.count();
-    
-    return ss.str();
+    char text[LOG_TIME_LENGTH + 1];
+    return std::string(text, format_log_time(get_coarse_time_ms(), text));
 }
 
 uint64_t get_cur_time_ms() {
@@ -39,19 +29,99 @@ uint64_t get_cur_time_us() {
     return cur_time;
 }
 
-double rad(double d) {
-    return d * PI / 180.0;
+uint64_t get_coarse_time_ms() {
+    struct timespec ts;
+#ifdef CLOCK_REALTIME_COARSE
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+    return uint64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
 }
 
 double calculate_distance(double lon1, double lat1, double lon2, double lat2) {
-    double rad_lat1 = rad(lat1);
-    double rad_lat2 = rad(lat2);
-    double a = rad_lat1 - rad_lat2;
-    double b = rad(lon1) - rad(lon2);
-    double s = 2 * asin(sqrt(pow(sin(a / 2), 2) + 
-                cos(rad_lat1) * cos(rad_lat2) * pow(sin(b / 2), 2)));
-    s = s * EARTH_RADIUS;
-    return s;
+    return geo::haversine_distance(lon1, lat1, lon2, lat2);
+}
+
+void calculate_shape_distances(const std::vector<Coord>& shapes, std::vector<double>& distances) {
+    static_assert(sizeof(Coord) == 2 * sizeof(double), "Coord must be laid out as lon, lat");
+    distances.resize(shapes.size());
+    if (shapes.empty()) {
+        return;
+    }
+    // 先批量算出相邻形点的距离放在distances[1..]，再原地做前缀和
+    distances[0] = 0.0;
+    geo::polyline_distances(reinterpret_cast<const double*>(shapes.data()), shapes.size(),
+                            distances.data() + 1, geo::DISTANCE_HAVERSINE);
+    for (size_t i = 1; i < distances.size(); i++) {
+        distances[i] += distances[i - 1];
+    }
+}
+
+namespace {
+
+void write_delta(int64_t delta, std::vector<uint8_t>& bytes) {
+    uint64_t value = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+    while (value >= 0x80) {
+        bytes.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    bytes.push_back(uint8_t(value));
+}
+
+} // namespace
+
+void CompactShape::assign(const Coord* coords, size_t count) {
+    _bytes.clear();
+    // 间隔几十米的形点差分在1e4以内，每个分量2字节
+    _bytes.reserve(4 * count + 8);
+    int64_t x = 0;
+    int64_t y = 0;
+    for (size_t i = 0; i < count; i++) {
+        int64_t next_x = llround(coords[i].x * SCALE);
+        int64_t next_y = llround(coords[i].y * SCALE);
+        write_delta(next_x - x, _bytes);
+        write_delta(next_y - y, _bytes);
+        x = next_x;
+        y = next_y;
+    }
+    _bytes.shrink_to_fit();
+    _size = count;
+}
+
+void CompactShape::decode(std::vector<Coord>& coords) const {
+    coords.resize(_size);
+    size_t i = 0;
+    for (const_iterator it = begin(); it != end(); ++it) {
+        coords[i++] = *it;
+    }
+}
+
+const std::vector<Coord>& link_shapes(const LinkInfo& link_info, std::vector<Coord>& buffer) {
+    if (link_info.compact_shapes.empty()) {
+        return link_info.shapes;
+    }
+    link_info.compact_shapes.decode(buffer);
+    return buffer;
+}
+
+size_t link_shape_count(const LinkInfo& link_info) {
+    return link_info.compact_shapes.empty() ? link_info.shapes.size() : link_info.compact_shapes.size();
+}
+
+const std::vector<double>& link_shape_distances(const LinkInfo& link_info, const std::vector<Coord>& shapes,
+                                                std::vector<double>& buffer) {
+    if (link_info.compact_shapes.empty()) {
+        return link_info.shape_distances;
+    }
+    calculate_shape_distances(shapes, buffer);
+    return buffer;
+}
+
+void shape_points_within(const std::vector<double>& distances, double start, double end,
+                         size_t& first, size_t& last) {
+    first = std::lower_bound(distances.begin(), distances.end(), start) - distances.begin();
+    last = std::upper_bound(distances.begin() + first, distances.end(), end) - distances.begin();
 }
 
 int normalize_direction(double delta) {
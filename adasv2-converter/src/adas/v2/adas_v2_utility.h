@@ -7,17 +7,17 @@
 #include <map>
 
 #include "cJSON.h"
+#include "geo_kernel.h"
 #include "adas_v2_type.h"
 
 namespace adas {
 namespace protocol_v2 {
 
+// 当前本地时间"2024-05-01 12:00:00.123"，用CLOCK_REALTIME_COARSE取时间，精度为内核tick(1~4ms)
 std::string log_time();
 
-#define log_tag (log_time() + "[" + std::string(std::string(__FILE__) + ":" + std::to_string(__LINE__)) + "]")
-
-const int EARTH_RADIUS = 6371393; // meter
-const double PI = 3.141592653589793238462;
+using geo::EARTH_RADIUS; // meter
+using geo::PI;
 
 class CJsonSafeDelete {
 public:
@@ -33,6 +33,8 @@ private:
 
 uint64_t get_cur_time_ms();
 uint64_t get_cur_time_us();
+// 不需要亚毫秒精度时用，走vDSO，只读内核上一次tick更新的时间
+uint64_t get_coarse_time_ms();
 
 int normalize_direction(double delta);
 int normalize_speed(int speed);
@@ -40,6 +42,34 @@ int normalize_form_of_way(const LinkInfo& link_info);
 
 double calculate_distance(double lon1, double lat1, double lon2, double lat2);
 
+/**
+ * @brief 计算形点的累计距离，distances[i]为第i个形点沿形状到第一个形点的距离，unit m
+*/
+void calculate_shape_distances(const std::vector<Coord>& shapes, std::vector<double>& distances);
+
+/**
+ * @brief link的形点。紧凑存储时解码到buffer并返回buffer，否则直接返回link_info.shapes
+*/
+const std::vector<Coord>& link_shapes(const LinkInfo& link_info, std::vector<Coord>& buffer);
+
+/**
+ * @brief link的形点个数，不解码
+*/
+size_t link_shape_count(const LinkInfo& link_info);
+
+/**
+ * @brief 形点的累计距离。紧凑存储时不保存距离，由link_shapes()取出的shapes现算到buffer并返回buffer，
+ *        和解析时算出的结果逐位一致；否则直接返回link_info.shape_distances
+*/
+const std::vector<double>& link_shape_distances(const LinkInfo& link_info, const std::vector<Coord>& shapes,
+                                                std::vector<double>& buffer);
+
+/**
+ * @brief 二分查找累计距离落在[start, end]内的形点，结果为下标区间[first, last)
+*/
+void shape_points_within(const std::vector<double>& distances, double start, double end,
+                         size_t& first, size_t& last);
+
 template<typename T>
 struct sort_help_by_offset {
     bool operator() (const T& a, const T& b) {
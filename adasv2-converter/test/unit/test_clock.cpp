@@ -0,0 +1,65 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// SteadyClock: 系统时间小幅调整时按单调时间推进，系统时间跳变超过阈值时在下一次检查重新取锚点
+
+#include "test_util.h"
+#include "adas_v2_clock.h"
+
+namespace {
+
+using adas::protocol_v2::ManualClock;
+using adas::protocol_v2::SteadyClock;
+
+const int64_t EPOCH_MS = 1716960728000;
+
+} // namespace
+
+ADAS_TEST(clock_steady_reanchor_on_step) {
+    ManualClock realtime(EPOCH_MS);
+    ManualClock monotonic(5000);
+    SteadyClock clock(&realtime, &monotonic);
+    ADAS_CHECK_EQ(EPOCH_MS, clock.now_ms());
+
+    // NTP微调: 系统时间比单调时间多走了150ms，不超过阈值，继续按单调时间推进
+    monotonic.advance_ms(2000);
+    realtime.advance_ms(2150);
+    ADAS_CHECK_EQ(EPOCH_MS + 2000, clock.now_ms());
+
+    // 系统时间向前跳10s，上次检查不到1s，还用原来的锚点
+    realtime.advance_ms(10000);
+    monotonic.advance_ms(500);
+    realtime.advance_ms(500);
+    ADAS_CHECK_EQ(EPOCH_MS + 2500, clock.now_ms());
+
+    // 到了检查时间，跟上系统时间
+    monotonic.advance_ms(500);
+    realtime.advance_ms(500);
+    ADAS_CHECK_EQ(realtime.now_ms(), clock.now_ms());
+    int64_t anchored = clock.now_ms();
+    monotonic.advance_ms(100);
+    ADAS_CHECK_EQ(anchored + 100, clock.now_ms());
+
+    // 向后跳同样重新取锚点
+    realtime.advance_ms(100 - 60000);
+    monotonic.advance_ms(SteadyClock::CHECK_INTERVAL_MS);
+    realtime.advance_ms(SteadyClock::CHECK_INTERVAL_MS);
+    ADAS_CHECK_EQ(realtime.now_ms(), clock.now_ms());
+
+    // 累计微调到超过阈值时也重新取锚点
+    int64_t before = clock.now_ms();
+    monotonic.advance_ms(SteadyClock::CHECK_INTERVAL_MS);
+    realtime.advance_ms(SteadyClock::CHECK_INTERVAL_MS + SteadyClock::STEP_THRESHOLD_MS / 2);
+    ADAS_CHECK_EQ(before + SteadyClock::CHECK_INTERVAL_MS, clock.now_ms());
+    monotonic.advance_ms(SteadyClock::CHECK_INTERVAL_MS);
+    realtime.advance_ms(SteadyClock::CHECK_INTERVAL_MS + SteadyClock::STEP_THRESHOLD_MS);
+    ADAS_CHECK_EQ(realtime.now_ms(), clock.now_ms());
+}
+
+ADAS_TEST(clock_steady_system_time) {
+    // 真实时钟下和系统时间相差不超过阈值
+    SteadyClock& clock = SteadyClock::instance();
+    SteadyClock system(nullptr, nullptr);
+    int64_t now = clock.now_ms();
+    ADAS_CHECK(now - system.now_ms() <= SteadyClock::STEP_THRESHOLD_MS);
+    ADAS_CHECK(system.now_ms() - now <= SteadyClock::STEP_THRESHOLD_MS);
+}
@@ -0,0 +1,55 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// geo内核和局部坐标投影的边界输入
+
+#include <math.h>
+
+#include "test_util.h"
+#include "geo_kernel.h"
+#include "geo_enu.h"
+
+namespace {
+
+// 沿纬线的三个形点，约200m
+const double POLYLINE[] = {121.4, 31.2, 121.401, 31.2, 121.402, 31.2};
+
+} // namespace
+
+ADAS_TEST(geo_nearest_segment_nan) {
+    double ratio = -7.0;
+    ADAS_CHECK_EQ(1, adas::geo::nearest_segment(121.4015, 31.2001, POLYLINE, 3, &ratio));
+    ADAS_CHECK_NEAR(0.5, ratio, 1e-6);
+
+    ratio = -7.0;
+    ADAS_CHECK_EQ(-1, adas::geo::nearest_segment(NAN, 31.2, POLYLINE, 3, &ratio));
+    ADAS_CHECK_EQ(-1, adas::geo::nearest_segment(121.4, NAN, POLYLINE, 3, &ratio));
+    ADAS_CHECK_EQ(-7.0, ratio);
+
+    // 超过一组SIMD宽度的折线，NaN形点本身不会被选中
+    double lonlat[20];
+    for (int i = 0; i < 10; i++) {
+        lonlat[2 * i] = 121.4 + 0.001 * i;
+        lonlat[2 * i + 1] = 31.2;
+    }
+    lonlat[6] = NAN;
+    int index = adas::geo::nearest_segment(121.4001, 31.2001, lonlat, 10, &ratio);
+    ADAS_CHECK_EQ(0, index);
+    ADAS_CHECK_EQ(-1, adas::geo::nearest_segment(121.4, 31.2, lonlat, 1, &ratio));
+}
+
+ADAS_TEST(geo_project_local_nan) {
+    const float east[] = {0.0f, 100.0f, 200.0f};
+    const float north[] = {0.0f, 0.0f, 0.0f};
+    adas::geo::LocalProjection projection;
+    ADAS_CHECK_EQ(0, adas::geo::project_local(150.0f, 10.0f, east, north, 3, projection));
+    ADAS_CHECK_EQ(1, projection.segment_index);
+    ADAS_CHECK_NEAR(0.5, projection.ratio, 1e-6);
+    ADAS_CHECK_NEAR(10.0, projection.distance, 1e-4);
+    ADAS_CHECK_NEAR(90.0, projection.heading, 1e-4);
+
+    adas::geo::LocalProjection untouched;
+    ADAS_CHECK_EQ(-1, adas::geo::project_local(NAN, 10.0f, east, north, 3, untouched));
+    ADAS_CHECK_EQ(-1, adas::geo::project_local(150.0f, NAN, east, north, 3, untouched));
+    ADAS_CHECK_EQ(-1, untouched.segment_index);
+    ADAS_CHECK_EQ(-1, adas::geo::project_local(150.0f, 10.0f, east, north, 1, untouched));
+}
@@ -0,0 +1,141 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 坐标转换: 公开参考点、境外不偏移、GCJ-02求逆的精度，以及批量和单点结果的差别，
+// 误差上限和geo_coord.h里写明的一致
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include "test_util.h"
+#include "geo_coord.h"
+
+namespace {
+
+using namespace adas::geo;
+
+struct ReferencePoint {
+    CoordType from;
+    CoordType to;
+    double lon;
+    double lat;
+    double expected_lon;
+    double expected_lat;
+};
+
+// 常见公开实现对(116.404, 39.915)的转换结果，境外的点不偏移
+const ReferencePoint REFERENCE_POINTS[] = {
+    {COORD_WGS84, COORD_GCJ02, 116.404, 39.915, 116.41024449916938, 39.91640428150164},
+    {COORD_GCJ02, COORD_BD09, 116.404, 39.915, 116.41036949371029, 39.92133699351021},
+    {COORD_BD09, COORD_GCJ02, 116.404, 39.915, 116.39762729119315, 39.90865673957631},
+    {COORD_WGS84, COORD_GCJ02, 139.6917, 35.6895, 139.6917, 35.6895},
+    {COORD_GCJ02, COORD_WGS84, -122.4194, 37.7749, -122.4194, 37.7749},
+};
+
+const double REFERENCE_TOLERANCE = 1e-9; // 公开值只给到这个精度
+const double INVERSE_TOLERANCE = 5e-11; // gcj02_to_wgs84
+const double BATCH_TOLERANCE = 1e-13; // 批量和单点的差别
+
+void convert_one(CoordType from, CoordType to, double lon, double lat, double& out_lon, double& out_lat) {
+    if (from == to) {
+        out_lon = lon;
+        out_lat = lat;
+        return;
+    }
+    if (COORD_WGS84 == from) {
+        wgs84_to_gcj02(lon, lat, lon, lat);
+    } else if (COORD_BD09 == from) {
+        bd09_to_gcj02(lon, lat, lon, lat);
+    }
+    if (COORD_WGS84 == to) {
+        gcj02_to_wgs84(lon, lat, lon, lat);
+    } else if (COORD_BD09 == to) {
+        gcj02_to_bd09(lon, lat, lon, lat);
+    }
+    out_lon = lon;
+    out_lat = lat;
+}
+
+// 覆盖整个境内矩形的随机点，个数不是4的倍数，用到批量函数的尾部
+std::vector<double> china_points() {
+    std::vector<double> points;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 4099; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        points.push_back(72.1 + double(seed >> 11) / double(1ULL << 53) * 65.6);
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        points.push_back(0.9 + double(seed >> 11) / double(1ULL << 53) * 54.8);
+    }
+    return points;
+}
+
+} // namespace
+
+ADAS_TEST(geo_coord_reference_points) {
+    for (const ReferencePoint& p : REFERENCE_POINTS) {
+        double scalar[2];
+        convert_one(p.from, p.to, p.lon, p.lat, scalar[0], scalar[1]);
+        ADAS_CHECK_NEAR(p.expected_lon, scalar[0], REFERENCE_TOLERANCE);
+        ADAS_CHECK_NEAR(p.expected_lat, scalar[1], REFERENCE_TOLERANCE);
+
+        double batch[2] = {p.lon, p.lat};
+        ADAS_CHECK_EQ(0, convert_coords(batch, batch, 1, p.from, p.to));
+        ADAS_CHECK_NEAR(p.expected_lon, batch[0], REFERENCE_TOLERANCE);
+        ADAS_CHECK_NEAR(p.expected_lat, batch[1], REFERENCE_TOLERANCE);
+    }
+
+    ADAS_CHECK(out_of_china(139.6917, 35.6895));
+    ADAS_CHECK(!out_of_china(121.4, 31.2));
+    double out[2];
+    ADAS_CHECK_EQ(-1, convert_coords(out, out, 1, CoordType(3), COORD_WGS84));
+}
+
+ADAS_TEST(geo_coord_gcj02_inverse) {
+    std::vector<double> points = china_points();
+    size_t count = points.size() / 2;
+    std::vector<double> wgs(points.size());
+    std::vector<double> gcj(points.size());
+    ADAS_CHECK_EQ(0, convert_coords(points.data(), wgs.data(), count, COORD_GCJ02, COORD_WGS84));
+    ADAS_CHECK_EQ(0, convert_coords(wgs.data(), gcj.data(), count, COORD_WGS84, COORD_GCJ02));
+
+    double scalar_error = 0.0;
+    double batch_error = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        double w[2];
+        double g[2];
+        gcj02_to_wgs84(points[2 * i], points[2 * i + 1], w[0], w[1]);
+        wgs84_to_gcj02(w[0], w[1], g[0], g[1]);
+        for (int k = 0; k < 2; k++) {
+            scalar_error = std::max(scalar_error, fabs(g[k] - points[2 * i + k]));
+            batch_error = std::max(batch_error, fabs(gcj[2 * i + k] - points[2 * i + k]));
+        }
+    }
+    ADAS_CHECK(scalar_error < INVERSE_TOLERANCE);
+    ADAS_CHECK(batch_error < INVERSE_TOLERANCE);
+}
+
+ADAS_TEST(geo_coord_batch_matches_scalar) {
+    std::vector<double> points = china_points();
+    size_t count = points.size() / 2;
+    std::vector<double> out(points.size());
+    for (int from = COORD_WGS84; from <= COORD_BD09; from++) {
+        for (int to = COORD_WGS84; to <= COORD_BD09; to++) {
+            ADAS_CHECK_EQ(0, convert_coords(points.data(), out.data(), count, CoordType(from), CoordType(to)));
+            double error = 0.0;
+            for (size_t i = 0; i < count; i++) {
+                double expected[2];
+                convert_one(CoordType(from), CoordType(to), points[2 * i], points[2 * i + 1],
+                            expected[0], expected[1]);
+                error = std::max(error, std::max(fabs(out[2 * i] - expected[0]),
+                                                 fabs(out[2 * i + 1] - expected[1])));
+            }
+            ADAS_CHECK(error < BATCH_TOLERANCE);
+        }
+    }
+
+    // 原地转换和输出到另一个数组结果相同
+    std::vector<double> in_place = points;
+    convert_coords(points.data(), out.data(), count, COORD_WGS84, COORD_BD09);
+    convert_coords(in_place.data(), in_place.data(), count, COORD_WGS84, COORD_BD09);
+    ADAS_CHECK(in_place == out);
+}
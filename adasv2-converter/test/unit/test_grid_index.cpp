@@ -0,0 +1,60 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 线段网格索引: 非法形点和过长线段整条拒绝，长线段只登记经过的格子
+
+#include <math.h>
+#include <vector>
+
+#include "test_util.h"
+#include "geo_grid_index.h"
+
+namespace {
+
+using adas::geo::SegmentGridIndex;
+using adas::geo::SegmentHit;
+
+} // namespace
+
+ADAS_TEST(grid_index_reject_invalid_segment) {
+    SegmentGridIndex index(100.0);
+    // (0,0)是null形点被读成0时的样子，线段跨几千公里
+    const double far[] = {121.4, 31.2, 0.0, 0.0};
+    ADAS_CHECK_EQ(-1, index.insert(1, far, 2));
+    const double nan_point[] = {121.4, 31.2, NAN, 31.2};
+    ADAS_CHECK_EQ(-1, index.insert(2, nan_point, 2));
+    const double out_of_range[] = {121.4, 31.2, 121.4, 91.0};
+    ADAS_CHECK_EQ(-1, index.insert(3, out_of_range, 2));
+    ADAS_CHECK_EQ(0u, index.size());
+    ADAS_CHECK_EQ(0u, index.segment_count());
+
+    // 前面一段合法、后面一段过长，整条都不插入
+    const double partial[] = {121.4, 31.2, 121.401, 31.2, 0.0, 0.0};
+    ADAS_CHECK_EQ(-1, index.insert(4, partial, 3));
+    ADAS_CHECK(!index.contains(4));
+
+    const double valid[] = {121.4, 31.2, 121.401, 31.2};
+    ADAS_CHECK_EQ(0, index.insert(5, valid, 2));
+    ADAS_CHECK_EQ(1u, index.segment_count());
+}
+
+ADAS_TEST(grid_index_long_diagonal_segment) {
+    // 约50km的斜线段，外包框有几十万个格子，只登记经过的格子，查询结果和逐段算距离一致
+    SegmentGridIndex index(100.0);
+    const double line[] = {121.0, 31.0, 121.4, 31.3};
+    ADAS_CHECK_EQ(0, index.insert(1, line, 2));
+
+    std::vector<SegmentHit> hits;
+    for (int i = 0; i <= 100; i++) {
+        double t = i / 100.0;
+        double lon = line[0] + t * (line[2] - line[0]);
+        double lat = line[1] + t * (line[3] - line[1]);
+        // 线段上的点一定命中
+        index.query(lon, lat, 50.0, hits);
+        ADAS_CHECK_EQ(1u, hits.size());
+        // 偏离线段约1km的点不命中
+        index.query(lon + 0.01, lat - 0.01, 50.0, hits);
+        ADAS_CHECK(hits.empty());
+    }
+    ADAS_CHECK_EQ(0, index.remove(1));
+    ADAS_CHECK_EQ(0u, index.size());
+}
@@ -0,0 +1,129 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 二进制日志: 参数超过线程缓冲一半的记录截断字符串后照常写入，解码出的文本标出原长度；
+// 切文件失败之后丢弃的日志计入dropped，之后重新打开文件继续写
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "test_util.h"
+#include "adas_v2_log.h"
+
+namespace {
+
+using adas::protocol_v2::BinaryLogger;
+using adas::protocol_v2::LOG_LEVEL_INFO;
+using adas::protocol_v2::LOG_MAX_ARGS_SIZE;
+using adas::protocol_v2::LogRotation;
+
+std::string decode(const std::string& file) {
+    std::ostringstream out;
+    ADAS_CHECK_EQ(0, adas::protocol_v2::decode_log_file(file, out));
+    return out.str();
+}
+
+bool file_exists(const std::string& file) {
+    struct stat st;
+    return 0 == stat(file.c_str(), &st);
+}
+
+// 等后台线程处理完已经写入的日志
+void wait_drain() {
+    usleep(100 * 1000);
+}
+
+} // namespace
+
+ADAS_TEST(log_truncate_oversized_record) {
+    std::string file = "/tmp/adasv2_test_log_" + std::to_string(getpid()) + ".log";
+    BinaryLogger logger;
+    ADAS_CHECK_EQ(0, logger.open(file));
+
+    // 每条记录都接近半个缓冲，各用一个线程同时写(缓冲按线程分)，不会因为缓冲满被丢弃
+    std::string large(300000, 'a');
+    std::string medium(100000, 'b');
+    // 正好放得下的记录不截断
+    std::string fit(LOG_MAX_ARGS_SIZE - 5, 'c');
+    std::thread writers[] = {
+        std::thread([&] { ADASV2_LOG(logger, LOG_LEVEL_INFO, "large:%s id:%d", large.c_str(), 7); }),
+        std::thread([&] {
+            ADASV2_LOG(logger, LOG_LEVEL_INFO, "pair:%s|%s|%s", large.c_str(), "short", medium.c_str());
+        }),
+        std::thread([&] { ADASV2_LOG(logger, LOG_LEVEL_INFO, "fit:%s", fit.c_str()); }),
+    };
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    logger.close();
+
+    ADAS_CHECK_EQ(0u, logger.dropped());
+    ADAS_CHECK_EQ(2u, logger.truncated());
+
+    std::string text = decode(file);
+    std::istringstream lines(text);
+    std::string line;
+    int count = 0;
+    while (std::getline(lines, line)) {
+        count++;
+        ADAS_CHECK(line.size() < LOG_MAX_ARGS_SIZE + 128);
+        if (std::string::npos != line.find("large:")) {
+            ADAS_CHECK(std::string::npos != line.find("aaa...(truncated 300000 bytes) id:7"));
+        } else if (std::string::npos != line.find("pair:")) {
+            // 短字符串原样保留，两个长字符串平分剩下的空间
+            ADAS_CHECK(std::string::npos != line.find("a...(truncated 300000 bytes)|short|b"));
+            ADAS_CHECK(std::string::npos != line.find("b...(truncated 100000 bytes)"));
+            size_t kept = line.find("...(truncated 300000") - line.find("aaaa");
+            ADAS_CHECK(kept > LOG_MAX_ARGS_SIZE / 2 - 64 && kept < LOG_MAX_ARGS_SIZE / 2);
+        } else {
+            ADAS_CHECK(std::string::npos != line.find("fit:" + fit));
+            ADAS_CHECK(std::string::npos == line.find("truncated"));
+        }
+    }
+    ADAS_CHECK_EQ(3, count);
+    remove(file.c_str());
+}
+
+ADAS_TEST(log_reopen_after_rotate_failure) {
+    std::string dir = "/tmp/adasv2_test_log_dir_" + std::to_string(getpid());
+    std::string file = dir + "/adasv2.log";
+    ADAS_CHECK_EQ(0, mkdir(dir.c_str(), 0755));
+    LogRotation rotation;
+    rotation.segment_seconds = 1;
+    rotation.compress = false;
+    BinaryLogger logger;
+    ADAS_CHECK_EQ(0, logger.open(file, rotation));
+    ADASV2_LOG(logger, LOG_LEVEL_INFO, "before");
+    wait_drain();
+
+    // 删掉目录，按时间切文件时新文件打不开，之后的日志都没有地方写
+    remove(file.c_str());
+    ADAS_CHECK_EQ(0, rmdir(dir.c_str()));
+    usleep(1200 * 1000);
+    ADAS_CHECK(!file_exists(file));
+    for (int i = 0; i < 10; i++) {
+        ADASV2_LOG(logger, LOG_LEVEL_INFO, "lost:%d", i);
+    }
+    wait_drain();
+    ADAS_CHECK_EQ(10u, logger.dropped());
+
+    // 目录恢复之后按退避间隔重新打开，丢弃的条数写进新文件
+    ADAS_CHECK_EQ(0, mkdir(dir.c_str(), 0755));
+    for (int i = 0; i < 100 && !file_exists(file); i++) {
+        usleep(50 * 1000);
+    }
+    ADAS_CHECK(file_exists(file));
+    ADASV2_LOG(logger, LOG_LEVEL_INFO, "after:%d", 1);
+    logger.close();
+    ADAS_CHECK_EQ(10u, logger.dropped());
+
+    std::string text = decode(file);
+    ADAS_CHECK(std::string::npos != text.find("dropped 10 records"));
+    ADAS_CHECK(std::string::npos != text.find("after:1"));
+    ADAS_CHECK(std::string::npos == text.find("lost:"));
+    remove(file.c_str());
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,67 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 用法: unit_test [过滤子串...]
+// 不带参数时运行所有注册的case，有失败时返回1
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+#include "test_util.h"
+
+namespace adas {
+namespace test {
+
+std::vector<TestCase>& test_registry() {
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+int& check_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+std::string read_data_file(const std::string& name) {
+    std::string path = std::string(ADASV2_DATA_DIR) + "/" + name;
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        fprintf(stderr, "open data file failed. %s\n", path.c_str());
+        return "";
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+} // namespace test
+} // namespace adas
+
+int main(int argc, char** argv) {
+    using adas::test::TestCase;
+
+    std::vector<TestCase>& registry = adas::test::test_registry();
+    int run = 0;
+    int failed = 0;
+    for (size_t i = 0; i < registry.size(); i++) {
+        bool selected = argc <= 1;
+        for (int j = 1; j < argc && !selected; j++) {
+            selected = std::string::npos != registry[i].name.find(argv[j]);
+        }
+        if (!selected) {
+            continue;
+        }
+
+        adas::test::check_failures() = 0;
+        registry[i].func();
+        run++;
+        if (0 != adas::test::check_failures()) {
+            failed++;
+            printf("[FAIL] %s\n", registry[i].name.c_str());
+        } else {
+            printf("[ OK ] %s\n", registry[i].name.c_str());
+        }
+    }
+    printf("%d cases, %d failed\n", run, failed);
+    return 0 == failed ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 离线批量匹配: work-stealing调度下每个任务正好分出去一次、按大小交错分配、
+// 数字字段解析和strtod逐位一致(超过15位的字段交给strtod)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+#include "mm_batch.h"
+
+namespace {
+
+// 固定种子的伪随机数
+uint64_t next_random(uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 33;
+}
+
+// 和strtod比较，要求逐位相同，并且停在字段末尾
+void check_number(const std::string& field) {
+    std::string line = field + ",next";
+    const char* p = line.data();
+    double value = 0.0;
+    bool ok = parse_number(p, line.data() + line.size(), value);
+    ADAS_CHECK(ok);
+    double expected = strtod(field.c_str(), nullptr);
+    if (ok && 0 != memcmp(&value, &expected, sizeof(value))) {
+        ::adas::test::check_failed(__FILE__, __LINE__, field + " parsed differently from strtod");
+    }
+    ADAS_CHECK_EQ(size_t(field.size()), size_t(p - line.data()));
+}
+
+} // namespace
+
+ADAS_TEST(mm_batch_scheduler_each_task_once) {
+    // 线程数多于、等于、少于任务数，区间不能均分的情况都覆盖
+    const int workers = 16;
+    const size_t task_counts[] = {0, 1, 15, 16, 17, 1000, 100003};
+    for (size_t n = 0; n < sizeof(task_counts) / sizeof(task_counts[0]); n++) {
+        size_t task_count = task_counts[n];
+        WorkStealingScheduler scheduler(task_count, workers);
+        std::unique_ptr<std::atomic<int>[]> handed(new std::atomic<int>[task_count + 1]);
+        for (size_t i = 0; i < task_count; i++) {
+            handed[i].store(0);
+        }
+        std::atomic<int> ready(0);
+        std::atomic<int> out_of_range(0);
+        std::vector<std::thread> threads;
+        for (int w = 0; w < workers; w++) {
+            threads.emplace_back([&, w]() {
+                ready++;
+                while (ready.load() < workers) {
+                }
+                // 0号worker先睡一会儿，它的区间只能被别人偷走
+                if (0 == w) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+                for (int64_t task = scheduler.next(w); task >= 0; task = scheduler.next(w)) {
+                    if (task >= int64_t(task_count)) {
+                        out_of_range++;
+                        continue;
+                    }
+                    handed[task]++;
+                }
+                // 分完之后一直返回-1
+                if (scheduler.next(w) >= 0) {
+                    out_of_range++;
+                }
+            });
+        }
+        for (size_t w = 0; w < threads.size(); w++) {
+            threads[w].join();
+        }
+
+        ADAS_CHECK_EQ(0, out_of_range.load());
+        size_t wrong = 0;
+        for (size_t i = 0; i < task_count; i++) {
+            wrong += (1 != handed[i].load());
+        }
+        ADAS_CHECK_EQ(0u, wrong);
+        if (task_count >= 1000) {
+            uint64_t steals = 0;
+            for (int w = 0; w < workers; w++) {
+                steals += scheduler.steals(w);
+            }
+            ADAS_CHECK(steals > 0);
+        }
+    }
+}
+
+ADAS_TEST(mm_batch_order_by_size) {
+    const int workers = 4;
+    uint64_t state = 11;
+    std::vector<uint64_t> sizes(23);
+    for (size_t i = 0; i < sizes.size(); i++) {
+        sizes[i] = next_random(state) % 1000;
+    }
+    sizes[5] = sizes[17] = 5000; // 大小相同的任务保持原来的先后
+
+    std::vector<size_t> order = WorkStealingScheduler::order_by_size(sizes, workers);
+    ADAS_CHECK_EQ(sizes.size(), order.size());
+    std::vector<int> seen(sizes.size(), 0);
+    for (size_t i = 0; i < order.size(); i++) {
+        if (order[i] < seen.size()) {
+            seen[order[i]]++;
+        }
+    }
+    for (size_t i = 0; i < seen.size(); i++) {
+        ADAS_CHECK_EQ(1, seen[i]);
+    }
+
+    // 区间划分和WorkStealingScheduler一致: 每个区间内从大到小，各区间的第一个是最大的workers个任务
+    size_t task_count = sizes.size();
+    std::vector<uint64_t> heads;
+    for (int w = 0; w < workers; w++) {
+        size_t begin = task_count * w / workers;
+        size_t end = task_count * (w + 1) / workers;
+        for (size_t i = begin + 1; i < end; i++) {
+            ADAS_CHECK(sizes[order[i - 1]] >= sizes[order[i]]);
+        }
+        heads.push_back(sizes[order[begin]]);
+    }
+    std::vector<uint64_t> sorted = sizes;
+    std::sort(sorted.begin(), sorted.end(), [](uint64_t a, uint64_t b) {
+        return a > b;
+    });
+    std::sort(heads.begin(), heads.end(), [](uint64_t a, uint64_t b) {
+        return a > b;
+    });
+    for (int w = 0; w < workers; w++) {
+        ADAS_CHECK_EQ(sorted[w], heads[w]);
+    }
+    ADAS_CHECK_EQ(5u, order[0]);
+    ADAS_CHECK_EQ(17u, order[task_count / workers]);
+
+    // 没有任务、worker比任务多
+    ADAS_CHECK(WorkStealingScheduler::order_by_size(std::vector<uint64_t>(), workers).empty());
+    std::vector<size_t> few = WorkStealingScheduler::order_by_size(std::vector<uint64_t>{1, 3, 2}, 8);
+    ADAS_CHECK_EQ(3u, few.size());
+    if (3 == few.size()) {
+        ADAS_CHECK_EQ(1u, few[0]);
+        ADAS_CHECK_EQ(2u, few[1]);
+        ADAS_CHECK_EQ(0u, few[2]);
+    }
+}
+
+ADAS_TEST(mm_batch_parse_number_matches_strtod) {
+    const char* fields[] = {"0", "-0", "+1", "121.4737", "31.23041", "-0.5", "1.", ".25", "007.500",
+            "123456789012345", "12345678.9012345", "0.00000000000001",
+            // 超过15位交给strtod
+            "0.000000000000001", "1234567890123456", "121.47370000000001", "-31.230410000000000001", "0.1000000000000000055511"};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        check_number(fields[i]);
+    }
+
+    // 随机经纬度和速度，最多15位有效数字
+    uint64_t state = 3;
+    char field[64];
+    for (int i = 0; i < 100000; i++) {
+        int decimals = next_random(state) % 12;
+        double value = (next_random(state) % 3600000000ULL) / 1e7 - 180.0;
+        snprintf(field, sizeof(field), "%.*f", decimals, value);
+        check_number(field);
+    }
+
+    // 空字段和其他字符
+    const char* invalid[] = {"", "-", "1.2.3", "12a", "1e5", " 1"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        const char* p = invalid[i];
+        double value = 0.0;
+        ADAS_CHECK(!parse_number(p, invalid[i] + strlen(invalid[i]), value));
+    }
+
+    // 遇到'\r'停止，不越过end
+    const char* line = "121.5\r\n";
+    const char* p = line;
+    double value = 0.0;
+    ADAS_CHECK(parse_number(p, line + strlen(line), value));
+    ADAS_CHECK_EQ(121.5, value);
+    ADAS_CHECK_EQ('\r', *p);
+    p = line;
+    ADAS_CHECK(parse_number(p, line + 3, value));
+    ADAS_CHECK_EQ(121.0, value);
+}
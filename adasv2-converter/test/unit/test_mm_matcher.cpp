@@ -0,0 +1,216 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// HMM地图匹配: 在生成的小方格路网上检查带噪声的直线轨迹、方向区分同一条路的两个方向、
+// 找不到候选时断链、flush按顺序输出所有定位点
+
+#include <math.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "test_util.h"
+#include "mm_matcher.h"
+
+namespace {
+
+// 4x4个路口，经度间隔约190m，纬度间隔约220m，相邻路口之间两个方向各一条link
+const int GRID = 4;
+const double LON0 = 121.4;
+const double LAT0 = 31.2;
+const double STEP = 0.002;
+const double METERS_PER_DEGREE_LAT = 111195.0;
+
+struct GridNetwork {
+    std::vector<MatchLink> links;
+    // 路口from到路口to的link下标，路口编号为row * GRID + col
+    int link(int from, int to) const {
+        for (size_t i = 0; i < ends.size(); i++) {
+            if (ends[i].first == from && ends[i].second == to) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    std::vector<std::pair<int, int> > ends;
+};
+
+void add_link(GridNetwork& network, int from, int to) {
+    double x0 = LON0 + STEP * (from % GRID);
+    double y0 = LAT0 + STEP * (from / GRID);
+    double x1 = LON0 + STEP * (to % GRID);
+    double y1 = LAT0 + STEP * (to / GRID);
+    MatchLink link;
+    link.link_id = 1000 * (from + 1) + to;
+    // 中间加一个形点，投影要跨线段
+    link.lonlat = {x0, y0, (x0 + x1) / 2, (y0 + y1) / 2, x1, y1};
+    network.links.push_back(link);
+    network.ends.push_back(std::make_pair(from, to));
+}
+
+GridNetwork make_grid() {
+    GridNetwork network;
+    for (int row = 0; row < GRID; row++) {
+        for (int col = 0; col < GRID; col++) {
+            int node = row * GRID + col;
+            if (col + 1 < GRID) {
+                add_link(network, node, node + 1);
+                add_link(network, node + 1, node);
+            }
+            if (row + 1 < GRID) {
+                add_link(network, node, node + GRID);
+                add_link(network, node + GRID, node);
+            }
+        }
+    }
+    // 末路口和首路口相同即相连
+    for (size_t i = 0; i < network.ends.size(); i++) {
+        for (size_t j = 0; j < network.ends.size(); j++) {
+            if (network.ends[i].second == network.ends[j].first) {
+                network.links[i].successors.push_back(j);
+            }
+        }
+    }
+    return network;
+}
+
+// 固定种子的均匀噪声，[-1, 1)
+double noise(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / double(1 << 23) - 1.0;
+}
+
+MatchFix make_fix(double x, double y, double heading, int64_t second) {
+    MatchFix fix;
+    fix.x = x;
+    fix.y = y;
+    fix.heading = heading;
+    fix.timestamp = second * 1000;
+    return fix;
+}
+
+} // namespace
+
+ADAS_TEST(mm_matcher_noisy_straight_trace) {
+    GridNetwork network = make_grid();
+    HmmMatcher matcher(&network.links);
+
+    // 沿第1行自西向东，15m/s，定位误差最大约8m，方向误差最大10度
+    const int row = 1;
+    double lat = LAT0 + STEP * row;
+    double meters_per_degree_lon = METERS_PER_DEGREE_LAT * cos(lat * M_PI / 180.0);
+    double speed = 15.0 / meters_per_degree_lon;
+    uint32_t state = 7;
+    std::vector<double> truth;
+    std::vector<MatchResult> results;
+    for (int i = 0; LON0 + i * speed < LON0 + STEP * (GRID - 1); i++) {
+        double x = LON0 + i * speed;
+        truth.push_back(x);
+        MatchFix fix = make_fix(x + 8.0 * noise(state) / meters_per_degree_lon,
+                lat + 8.0 * noise(state) / METERS_PER_DEGREE_LAT, 90.0 + 10.0 * noise(state), i);
+        matcher.input(fix, results);
+    }
+    matcher.flush(results);
+
+    ADAS_CHECK_EQ(truth.size(), results.size());
+    int checked = 0;
+    for (size_t i = 0; i < results.size() && i < truth.size(); i++) {
+        ADAS_CHECK_EQ(int64_t(i) * 1000, results[i].timestamp);
+        ADAS_CHECK(results[i].link_index >= 0);
+        // 离路口20m以内的点两条link都说得通，只检查路段中间的点
+        double along = (truth[i] - LON0) / STEP;
+        int col = int(floor(along));
+        if (fabs(along - floor(along + 0.5)) * STEP * meters_per_degree_lon < 20.0) {
+            continue;
+        }
+        int expected = network.link(row * GRID + col, row * GRID + col + 1);
+        ADAS_CHECK_EQ(expected, results[i].link_index);
+        ADAS_CHECK_NEAR((along - col) * STEP * meters_per_degree_lon, results[i].offset, 10.0);
+        checked++;
+    }
+    ADAS_CHECK(checked > int(truth.size()) / 2);
+}
+
+ADAS_TEST(mm_matcher_heading_breaks_tie) {
+    GridNetwork network = make_grid();
+    HmmMatcher matcher(&network.links);
+    int east = network.link(GRID + 1, GRID + 2);
+    int west = network.link(GRID + 2, GRID + 1);
+    double x = LON0 + STEP * 1.4;
+    double y = LAT0 + STEP * 1 + 3.0 / METERS_PER_DEGREE_LAT;
+
+    // 两个方向的link形点完全相同，只靠定位方向区分
+    std::vector<MatchResult> results;
+    matcher.input(make_fix(x, y, 85.0, 0), results);
+    matcher.flush(results);
+    matcher.input(make_fix(x, y, 265.0, 1), results);
+    matcher.flush(results);
+    ADAS_CHECK_EQ(2u, results.size());
+    if (2 == results.size()) {
+        ADAS_CHECK_EQ(east, results[0].link_index);
+        ADAS_CHECK_EQ(west, results[1].link_index);
+        ADAS_CHECK_NEAR(3.0, results[0].dist_to_line, 0.5);
+    }
+}
+
+ADAS_TEST(mm_matcher_chain_break) {
+    GridNetwork network = make_grid();
+    HmmMatcher matcher(&network.links);
+    double lat = LAT0 + STEP;
+    double speed = 15.0 / (METERS_PER_DEGREE_LAT * cos(lat * M_PI / 180.0));
+
+    // 路上3个点，中间1个点离路网约1km，之后回到路上
+    std::vector<MatchResult> results;
+    for (int i = 0; i < 3; i++) {
+        ADAS_CHECK_EQ(0, matcher.input(make_fix(LON0 + STEP * 0.2 + i * speed, lat, 90.0, i), results));
+    }
+    // 找不到候选时窗口里的3个点先输出，再输出这个没匹配上的点
+    ADAS_CHECK_EQ(4, matcher.input(make_fix(LON0 + STEP * 0.2, lat - 0.01, 90.0, 3), results));
+    ADAS_CHECK_EQ(4u, results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        ADAS_CHECK_EQ(int64_t(i) * 1000, results[i].timestamp);
+    }
+    if (4 == results.size()) {
+        ADAS_CHECK(results[2].link_index >= 0);
+        ADAS_CHECK_EQ(-1, results[3].link_index);
+        ADAS_CHECK_EQ(0u, results[3].link_id);
+    }
+
+    // 断链之后从新的点重新开始匹配
+    results.clear();
+    matcher.input(make_fix(LON0 + STEP * 1.5, lat, 90.0, 4), results);
+    ADAS_CHECK_EQ(1, matcher.flush(results));
+    ADAS_CHECK_EQ(1u, results.size());
+    if (1 == results.size()) {
+        ADAS_CHECK_EQ(network.link(GRID + 1, GRID + 2), results[0].link_index);
+    }
+}
+
+ADAS_TEST(mm_matcher_flush_in_order) {
+    GridNetwork network = make_grid();
+    HmmMatcherConfig config;
+    HmmMatcher matcher(&network.links, config);
+    double lat = LAT0 + STEP * 2;
+    double speed = 12.0 / (METERS_PER_DEGREE_LAT * cos(lat * M_PI / 180.0));
+
+    // 窗口没满时input不输出，flush一次输出全部
+    std::vector<MatchResult> results;
+    for (int i = 0; i < config.lag; i++) {
+        ADAS_CHECK_EQ(0, matcher.input(make_fix(LON0 + STEP * 0.1 + i * speed, lat, 90.0, i), results));
+    }
+    ADAS_CHECK_EQ(config.lag, matcher.flush(results));
+    ADAS_CHECK_EQ(0, matcher.flush(results));
+
+    // 超过窗口之后每个点输出一个结果，加上flush正好每个点一个，按输入顺序
+    int emitted = 0;
+    int count = 3 * config.lag;
+    for (int i = 0; i < count; i++) {
+        emitted += matcher.input(make_fix(LON0 + STEP * 0.1 + i * speed, lat, 90.0, config.lag + i), results);
+    }
+    ADAS_CHECK_EQ(count - config.lag, emitted);
+    ADAS_CHECK_EQ(config.lag, matcher.flush(results));
+    ADAS_CHECK_EQ(size_t(config.lag + count), results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        ADAS_CHECK_EQ(int64_t(i) * 1000, results[i].timestamp);
+        ADAS_CHECK(results[i].link_index >= 0);
+    }
+}
@@ -0,0 +1,215 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 共享内存环形队列: 读端登记和退出、超时游标的回收、写端重启后挂接已有对象、槽位参数不一致时拒绝打开
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "test_util.h"
+#include "adas_v2_shm_ring.h"
+
+namespace {
+
+using adas::protocol_v2::ADASV2_SHM_MAX_READERS;
+using adas::protocol_v2::Adasv2ShmHeader;
+using adas::protocol_v2::Adasv2ShmMessage;
+using adas::protocol_v2::Adasv2ShmPublisher;
+using adas::protocol_v2::Adasv2ShmReader;
+
+std::string ring_name(const char* test) {
+    return std::string("/adasv2_test_") + test + "_" + std::to_string(getpid());
+}
+
+void publish_string(Adasv2ShmPublisher& publisher, const std::string& message) {
+    ADAS_CHECK_EQ(0, publisher.publish(message.data(), message.size()));
+}
+
+std::string read_string(Adasv2ShmReader& reader) {
+    Adasv2ShmMessage message;
+    if (0 != reader.read(message)) {
+        return "";
+    }
+    std::string value(message.data, message.length);
+    ADAS_CHECK(reader.validate(message));
+    return value;
+}
+
+// 直接映射共享内存对象，用来模拟读端卡住(心跳停在很久以前)
+Adasv2ShmHeader* map_header(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (-1 == fd) {
+        return nullptr;
+    }
+    void* base = mmap(nullptr, sizeof(Adasv2ShmHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return MAP_FAILED == base ? nullptr : static_cast<Adasv2ShmHeader*>(base);
+}
+
+} // namespace
+
+ADAS_TEST(shm_ring_attach_detach) {
+    std::string name = ring_name("attach");
+    Adasv2ShmReader reader;
+    ADAS_CHECK_EQ(-1, reader.open(name));
+
+    Adasv2ShmPublisher publisher;
+    ADAS_CHECK_EQ(0, publisher.open(name, 5, 64));
+    ADAS_CHECK_EQ(-1, publisher.reader_lag(0));
+
+    struct stat st;
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    ADAS_CHECK(-1 != fd && 0 == fstat(fd, &st) && 0600 == (st.st_mode & 0777));
+    if (-1 != fd) {
+        close(fd);
+    }
+
+    // 读端从登记时最新的消息开始读
+    publish_string(publisher, "before");
+    ADAS_CHECK_EQ(0, reader.open(name));
+    Adasv2ShmMessage message;
+    ADAS_CHECK_EQ(1, reader.read(message));
+    publish_string(publisher, "a");
+    publish_string(publisher, "b");
+    ADAS_CHECK_EQ(2, publisher.reader_lag(0));
+    ADAS_CHECK(read_string(reader) == "a");
+    ADAS_CHECK(read_string(reader) == "b");
+    ADAS_CHECK_EQ(0, publisher.reader_lag(0));
+
+    // 超过slot_size的消息不发布
+    std::string large(65, 'x');
+    ADAS_CHECK_EQ(-1, publisher.publish(large.data(), large.size()));
+    ADAS_CHECK_EQ(1u, publisher.dropped());
+
+    // 8个槽位写满两圈，读端被套圈后跳到最老的完整消息
+    for (int i = 0; i < 16; i++) {
+        publish_string(publisher, std::to_string(i));
+    }
+    ADAS_CHECK_EQ(-2, reader.read(message));
+    ADAS_CHECK_EQ(1u, reader.lapped());
+    ADAS_CHECK(read_string(reader) == "9");
+
+    reader.close();
+    ADAS_CHECK_EQ(-1, publisher.reader_lag(0));
+
+    // 游标全部占满后不能再登记，退出一个之后空出的游标可以复用
+    Adasv2ShmReader readers[ADASV2_SHM_MAX_READERS];
+    for (uint32_t i = 0; i < ADASV2_SHM_MAX_READERS; i++) {
+        ADAS_CHECK_EQ(0, readers[i].open(name));
+    }
+    ADAS_CHECK_EQ(-1, reader.open(name));
+    readers[3].close();
+    ADAS_CHECK_EQ(0, reader.open(name));
+    ADAS_CHECK(publisher.reader_lag(3) >= 0);
+
+    publisher.close(true);
+}
+
+ADAS_TEST(shm_ring_publisher_restart) {
+    std::string name = ring_name("restart");
+    Adasv2ShmPublisher publisher;
+    ADAS_CHECK_EQ(0, publisher.open(name, 8, 64));
+    Adasv2ShmReader reader;
+    ADAS_CHECK_EQ(0, reader.open(name));
+    publish_string(publisher, "first");
+    publisher.close();
+
+    // 写端退出后读端仍然能读完已发布的消息
+    ADAS_CHECK(read_string(reader) == "first");
+
+    // 槽位参数不一致时拒绝打开，不改动已有对象
+    Adasv2ShmPublisher other;
+    ADAS_CHECK_EQ(-1, other.open(name, 16, 64));
+    ADAS_CHECK_EQ(-1, other.open(name, 8, 128));
+
+    // 同样的参数重启: 不清空已有内容，序号接着写，读端登记保留
+    Adasv2ShmPublisher restarted;
+    ADAS_CHECK_EQ(0, restarted.open(name, 8, 64));
+    ADAS_CHECK_EQ(1u, restarted.published());
+    ADAS_CHECK_EQ(0, restarted.reader_lag(0));
+    publish_string(restarted, "second");
+    ADAS_CHECK(read_string(reader) == "second");
+    Adasv2ShmMessage message;
+    ADAS_CHECK_EQ(1, reader.read(message));
+
+    // 删除之后可以用新的参数创建，原来的读端还映射着旧对象，不会越界
+    restarted.close(true);
+    ADAS_CHECK_EQ(0, other.open(name, 16, 128));
+    std::string large(100, 'y');
+    ADAS_CHECK_EQ(0, other.publish(large.data(), large.size()));
+    ADAS_CHECK_EQ(1, reader.read(message));
+
+    Adasv2ShmReader new_reader;
+    ADAS_CHECK_EQ(0, new_reader.open(name));
+    publish_string(other, "third");
+    ADAS_CHECK(read_string(new_reader) == "third");
+
+    reader.close();
+    new_reader.close();
+    other.close(true);
+}
+
+ADAS_TEST(shm_ring_reclaim_stale_cursor) {
+    std::string name = ring_name("reclaim");
+    Adasv2ShmPublisher publisher;
+    ADAS_CHECK_EQ(0, publisher.open(name, 8, 64));
+    Adasv2ShmHeader* header = map_header(name);
+    ADAS_CHECK(nullptr != header);
+    if (nullptr == header) {
+        publisher.close(true);
+        return;
+    }
+
+    // 游标全部占满，每一轮让其中一个游标超时，两个读端同时抢，只能有一个抢到
+    Adasv2ShmReader readers[ADASV2_SHM_MAX_READERS];
+    for (uint32_t i = 0; i < ADASV2_SHM_MAX_READERS; i++) {
+        ADAS_CHECK_EQ(0, readers[i].open(name));
+    }
+    const uint32_t stale = 5;
+    Adasv2ShmReader* owner = &readers[stale];
+    Adasv2ShmReader racers[2][100];
+    for (int round = 0; round < 100; round++) {
+        header->readers[stale].heartbeat_ms.store(0);
+        std::atomic<int> ready(0);
+        int results[2] = {0, 0};
+        std::thread threads[2];
+        for (int t = 0; t < 2; t++) {
+            threads[t] = std::thread([&, t] {
+                ready++;
+                while (ready.load() < 2) {
+                }
+                results[t] = racers[t][round].open(name);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        ADAS_CHECK_EQ(-1, results[0] + results[1]);
+        if (-1 != results[0] + results[1]) {
+            break;
+        }
+
+        // 卡住的原占用者醒来后不能再用这个游标
+        Adasv2ShmMessage message;
+        ADAS_CHECK_EQ(-3, owner->read(message));
+        ADAS_CHECK_EQ(-1, owner->read(message));
+        ADAS_CHECK_EQ(-1, owner->heartbeat());
+        owner = &racers[0 == results[0] ? 0 : 1][round];
+        ADAS_CHECK_EQ(1, owner->read(message));
+    }
+
+    // 新占用者正常读写，被回收的读端close不影响它
+    publish_string(publisher, "after");
+    ADAS_CHECK(read_string(*owner) == "after");
+    readers[stale].close();
+    ADAS_CHECK_EQ(0, owner->heartbeat());
+    ADAS_CHECK(publisher.reader_lag(stale) >= 0);
+
+    munmap(header, sizeof(Adasv2ShmHeader));
+    publisher.close(true);
+}
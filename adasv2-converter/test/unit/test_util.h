@@ -0,0 +1,70 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+namespace adas {
+namespace test {
+
+typedef void (*TestFunc)();
+
+struct TestCase {
+    std::string name;
+    TestFunc func;
+};
+
+std::vector<TestCase>& test_registry();
+
+struct TestRegistrar {
+    TestRegistrar(const std::string& name, TestFunc func) {
+        test_registry().push_back(TestCase{name, func});
+    }
+};
+
+// 当前case的检查失败次数，runner在每个case前清零
+int& check_failures();
+
+inline void check_failed(const char* file, int line, const std::string& message) {
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message.c_str());
+    check_failures()++;
+}
+
+// 读取测试数据，ADASV2_DATA_DIR下的相对路径
+std::string read_data_file(const std::string& name);
+
+} // namespace test
+} // namespace adas
+
+// 定义并注册一个case: ADAS_TEST(shm_ring_restart) { ... }
+#define ADAS_TEST(name) \
+    static void name(); \
+    static ::adas::test::TestRegistrar _test_registrar_##name(#name, name); \
+    static void name()
+
+#define ADAS_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            ::adas::test::check_failed(__FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+#define ADAS_CHECK_EQ(a, b) \
+    do { \
+        if (!((a) == (b))) { \
+            ::adas::test::check_failed(__FILE__, __LINE__, std::string(#a " == " #b " (") + \
+                std::to_string(a) + " vs " + std::to_string(b) + ")"); \
+        } \
+    } while (0)
+
+#define ADAS_CHECK_NEAR(a, b, eps) \
+    do { \
+        double _check_a = (a); \
+        double _check_b = (b); \
+        if (!(fabs(_check_a - _check_b) <= (eps))) { \
+            ::adas::test::check_failed(__FILE__, __LINE__, std::string("|" #a " - " #b "| <= " #eps " (") + \
+                std::to_string(_check_a) + " vs " + std::to_string(_check_b) + ")"); \
+        } \
+    } while (0)
@@ -0,0 +1,25 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 把AdasV2Protocol::set_log_file写出的二进制日志转成文本，输出到标准输出。
+// 切分出的多个文件按参数顺序解码，从旧到新:
+//   adasv2_log_decode ehp_out.log.3.gz ehp_out.log.4.gz ehp_out.log > ehp_out.txt
+
+#include <stdio.h>
+#include <iostream>
+
+#include "adas_v2_log.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <binary log>...\n", argv[0]);
+        return 1;
+    }
+    int ret = 0;
+    for (int i = 1; i < argc; i++) {
+        if (0 != adas::protocol_v2::decode_log_file(argv[i], std::cout)) {
+            fprintf(stderr, "decode %s failed\n", argv[i]);
+            ret = 1;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,159 @@
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 按虚拟时间快速回放录制的会话(格式见adas_v2_replay.h)，输出每条消息及其内容hash，
+// 结束时在标准错误输出吞吐、每类事件的耗时分位数和整个输出的digest:
+//   adasv2_replay -o out.txt session.jsonl
+// 不同版本回放同一个会话，digest相同即输出一致，不同时diff两份输出定位具体消息。
+// 输出每行为: 事件序号(从1开始) 消息hash json
+//
+// 选项:
+//   -o file   消息输出文件，-为标准输出，不指定时只统计
+//   -b        开启批量回调(set_batch_callback)
+//   -c        开启形点紧凑存储(set_compact_shapes)
+//   -t meter  形点抽稀容差(set_shape_tolerance)
+//   -l file   protocol日志文件，不指定时不写日志
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "adas_v2_metrics.h"
+#include "adas_v2_replay.h"
+
+namespace {
+
+void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-o output] [-b] [-c] [-t tolerance] [-l log_file] <session.jsonl>...\n", name);
+}
+
+void print_summary(const char* name, const adas::protocol_v2::LatencySummary& summary) {
+    fprintf(stderr, "%-18s count:%lu mean_us:%.1f p50_us:%.1f p99_us:%.1f p999_us:%.1f max_us:%.1f\n",
+        name, summary.count, summary.mean_ns / 1000.0, summary.p50_ns / 1000.0, summary.p99_ns / 1000.0,
+        summary.p999_ns / 1000.0, summary.max_ns / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    using namespace adas::protocol_v2;
+
+    const char* output = nullptr;
+    const char* log_file = nullptr;
+    bool batch = false;
+    bool compact = false;
+    double tolerance = 0.0;
+    int opt = 0;
+    while (-1 != (opt = getopt(argc, argv, "o:bct:l:"))) {
+        switch (opt) {
+            case 'o':
+                output = optarg;
+                break;
+            case 'b':
+                batch = true;
+                break;
+            case 'c':
+                compact = true;
+                break;
+            case 't':
+                tolerance = atof(optarg);
+                break;
+            case 'l':
+                log_file = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* out = nullptr;
+    if (nullptr != output) {
+        out = 0 == strcmp(output, "-") ? stdout : fopen(output, "w");
+        if (nullptr == out) {
+            fprintf(stderr, "open %s failed\n", output);
+            return 1;
+        }
+    }
+
+    ReplayProtocol protocol;
+    if (nullptr != log_file) {
+        protocol.set_log_file(log_file);
+    } else {
+        protocol.set_log_level(LOG_LEVEL_OFF);
+    }
+    protocol.set_batch_callback(batch);
+    protocol.set_compact_shapes(compact);
+    protocol.set_shape_tolerance(tolerance);
+
+    LatencyHistogram latency[REPLAY_EVENT_TYPE_COUNT];
+    uint64_t digest = message_hash("", 0);
+    size_t events = 0;
+    size_t messages = 0;
+    size_t bad_lines = 0;
+    uint64_t replay_ns = 0;
+    ReplayEvent event;
+    std::vector<std::string> emitted;
+    std::string line;
+    int ret = 0;
+    for (int i = optind; i < argc; i++) {
+        std::ifstream session(argv[i]);
+        if (!session) {
+            fprintf(stderr, "open %s failed\n", argv[i]);
+            ret = 1;
+            continue;
+        }
+        while (std::getline(session, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            if (0 != parse_replay_event(line, event)) {
+                bad_lines++;
+                continue;
+            }
+            events++;
+            emitted.clear();
+            uint64_t start = monotonic_ns();
+            protocol.replay(event, emitted);
+            uint64_t cost = monotonic_ns() - start;
+            latency[event.type].record(cost);
+            replay_ns += cost;
+
+            for (size_t j = 0; j < emitted.size(); j++) {
+                uint64_t hash = message_hash(emitted[j]);
+                digest = message_hash(reinterpret_cast<const char*>(&hash), sizeof(hash), digest);
+                if (nullptr != out) {
+                    fprintf(out, "%lu %016lx %s\n", events, hash, emitted[j].c_str());
+                }
+            }
+            messages += emitted.size();
+        }
+    }
+    if (nullptr != out && stdout != out) {
+        fclose(out);
+    }
+
+    double seconds = replay_ns / 1e9;
+    fprintf(stderr, "events:%lu messages:%lu bad_lines:%lu replay_ms:%.1f events/s:%.0f messages/s:%.0f\n",
+        events, messages, bad_lines, replay_ns / 1e6, seconds > 0 ? events / seconds : 0.0,
+        seconds > 0 ? messages / seconds : 0.0);
+    for (int i = 0; i < REPLAY_EVENT_TYPE_COUNT; i++) {
+        LatencySummary summary;
+        latency[i].summarize(summary);
+        print_summary(replay_event_type_name(ReplayEventType(i)), summary);
+    }
+    std::vector<LatencySummary> stages;
+    protocol.get_metrics(stages);
+    for (size_t i = 0; i < stages.size(); i++) {
+        print_summary(stages[i].stage.c_str(), stages[i]);
+    }
+    fprintf(stderr, "digest:%016lx\n", digest);
+    return ret;
+}
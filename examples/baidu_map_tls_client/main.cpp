@@ -12,6 +12,8 @@
 
 #include <nlohmann/json.hpp>
 
+#include "geo_coord.h"
+
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 
@@ -46,6 +48,10 @@ std::string CASE = "shanghai_gaosu";
 // 不传入路线，将进入巡航模式，将根据直行优先的策略进行探路
 int ROUTE_TYPE = 1; // 1 巡航，2 导航
 
+// 轨迹点文件的坐标系，上报给服务端的坐标为gcj02
+// GNSS直接录制的wgs84轨迹配置为adas::geo::COORD_WGS84，回放前整条轨迹批量转换
+adas::geo::CoordType CASE_COORD_TYPE = adas::geo::COORD_GCJ02;
+
 // 使用websocketpp实现一个Client
 class WebsocketClient {
 public:
@@ -454,6 +460,10 @@ void gps_worker(std::weak_ptr<WebsocketClient> client) {
     // 设置导航态、巡航态
     set_route(client, msgid);
     
+    // 先读入整条轨迹，坐标按CASE_COORD_TYPE批量转换成gcj02之后再逐点回放
+    std::vector<double> lonlat;
+    std::vector<double> speeds;
+    std::vector<double> dirs;
     while (getline(in_loc_stream, line)) {
         // 按","对字符串进行分割
         std::stringstream ss(line);
@@ -467,6 +477,14 @@ void gps_worker(std::weak_ptr<WebsocketClient> client) {
             continue;
         }
 
+        lonlat.push_back(std::atof(loc_infos[0].c_str()));
+        lonlat.push_back(std::atof(loc_infos[1].c_str()));
+        speeds.push_back(std::atof(loc_infos[2].c_str()));
+        dirs.push_back(std::atof(loc_infos[3].c_str()));
+    }
+    adas::geo::convert_coords(lonlat.data(), lonlat.data(), speeds.size(), CASE_COORD_TYPE, adas::geo::COORD_GCJ02);
+
+    for (size_t i = 0; i < speeds.size(); i++) {
         auto now = std::chrono::system_clock::now();
         auto duration = now.time_since_epoch();
         auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
@@ -481,11 +499,11 @@ void gps_worker(std::weak_ptr<WebsocketClient> client) {
         j["ts"] = milliseconds.count();
 
         json loc;
-        loc["x"] = std::atof(loc_infos[0].c_str());
-        loc["y"] = std::atof(loc_infos[1].c_str());
-        loc["speed"] = std::atof(loc_infos[2].c_str());
-        loc["dir"] = std::atof(loc_infos[3].c_str());
-        loc["coordtype"] = 1;
+        loc["x"] = lonlat[2 * i];
+        loc["y"] = lonlat[2 * i + 1];
+        loc["speed"] = speeds[i];
+        loc["dir"] = dirs[i];
+        loc["coordtype"] = 1; // gcj02
         loc["ts"] = milliseconds.count();
 
         json data;
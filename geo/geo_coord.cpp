@@ -0,0 +1,295 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "geo_kernel.h"
+#include "geo_coord.h"
+#include "geo_vec.h"
+
+namespace adas {
+namespace geo {
+
+namespace {
+
+// GCJ-02使用的克拉索夫斯基椭球
+const double KRASOVSKY_A = 6378245.0;
+const double KRASOVSKY_EE = 0.00669342162296594323;
+const double X_PI = PI * 3000.0 / 180.0;
+const double BD09_LON_SHIFT = 0.0065;
+const double BD09_LAT_SHIFT = 0.006;
+
+const double CHINA_MIN_LON = 72.004;
+const double CHINA_MAX_LON = 137.8347;
+const double CHINA_MIN_LAT = 0.8293;
+const double CHINA_MAX_LAT = 55.8271;
+
+// GCJ-02的偏移随位置变化很慢，不动点迭代每次误差缩小两个数量级以上，4次之后小于5e-11度
+const int GCJ02_INVERSE_ITERATIONS = 4;
+
+double transform_lat(double x, double y) {
+    double ret = -100.0 + 2.0 * x + 3.0 * y + 0.2 * y * y + 0.1 * x * y + 0.2 * sqrt(fabs(x));
+    ret += (20.0 * sin(6.0 * x * PI) + 20.0 * sin(2.0 * x * PI)) * 2.0 / 3.0;
+    ret += (20.0 * sin(y * PI) + 40.0 * sin(y / 3.0 * PI)) * 2.0 / 3.0;
+    ret += (160.0 * sin(y / 12.0 * PI) + 320.0 * sin(y * PI / 30.0)) * 2.0 / 3.0;
+    return ret;
+}
+
+double transform_lon(double x, double y) {
+    double ret = 300.0 + x + 2.0 * y + 0.1 * x * x + 0.1 * x * y + 0.1 * sqrt(fabs(x));
+    ret += (20.0 * sin(6.0 * x * PI) + 20.0 * sin(2.0 * x * PI)) * 2.0 / 3.0;
+    ret += (20.0 * sin(x * PI) + 40.0 * sin(x / 3.0 * PI)) * 2.0 / 3.0;
+    ret += (150.0 * sin(x / 12.0 * PI) + 300.0 * sin(x / 30.0 * PI)) * 2.0 / 3.0;
+    return ret;
+}
+
+using namespace detail;
+
+// 和transform_lat/transform_lon相同的运算顺序，两者共用的sin(6x PI)、sin(2x PI)只算一次
+inline __attribute__((always_inline)) void vec_wgs84_to_gcj02(const Vec& lon, const Vec& lat,
+                                                              Vec& out_lon, Vec& out_lat) {
+    Vec x = lon - 105.0;
+    Vec y = lat - 35.0;
+    Vec abs_x = (Vec)((VecMask)x & INT64_MAX);
+    Vec sqrt_x;
+    vec_sqrt(abs_x, sqrt_x);
+
+    Vec s6x, s2x, s1x, s3x, s12x, s30x, s1y, s3y, s12y, s30y;
+    vec_sin(6.0 * x * PI, s6x);
+    vec_sin(2.0 * x * PI, s2x);
+    vec_sin(x * PI, s1x);
+    vec_sin(x / 3.0 * PI, s3x);
+    vec_sin(x / 12.0 * PI, s12x);
+    vec_sin(x / 30.0 * PI, s30x);
+    vec_sin(y * PI, s1y);
+    vec_sin(y / 3.0 * PI, s3y);
+    vec_sin(y / 12.0 * PI, s12y);
+    vec_sin(y * PI / 30.0, s30y);
+    Vec common = (20.0 * s6x + 20.0 * s2x) * 2.0 / 3.0;
+
+    Vec d_lat = -100.0 + 2.0 * x + 3.0 * y + 0.2 * y * y + 0.1 * x * y + 0.2 * sqrt_x;
+    d_lat += common;
+    d_lat += (20.0 * s1y + 40.0 * s3y) * 2.0 / 3.0;
+    d_lat += (160.0 * s12y + 320.0 * s30y) * 2.0 / 3.0;
+
+    Vec d_lon = 300.0 + x + 2.0 * y + 0.1 * x * x + 0.1 * x * y + 0.1 * sqrt_x;
+    d_lon += common;
+    d_lon += (20.0 * s1x + 40.0 * s3x) * 2.0 / 3.0;
+    d_lon += (150.0 * s12x + 300.0 * s30x) * 2.0 / 3.0;
+
+    Vec rad_lat = lat / 180.0 * PI;
+    Vec sin_lat, cos_lat, sqrt_magic;
+    vec_sin(rad_lat, sin_lat);
+    vec_cos(rad_lat, cos_lat);
+    Vec magic = 1.0 - KRASOVSKY_EE * sin_lat * sin_lat;
+    vec_sqrt(magic, sqrt_magic);
+    d_lat = (d_lat * 180.0) / ((KRASOVSKY_A * (1.0 - KRASOVSKY_EE)) / (magic * sqrt_magic) * PI);
+    d_lon = (d_lon * 180.0) / (KRASOVSKY_A / sqrt_magic * cos_lat * PI);
+
+    VecMask inside = (lon >= CHINA_MIN_LON) & (lon <= CHINA_MAX_LON) &
+            (lat >= CHINA_MIN_LAT) & (lat <= CHINA_MAX_LAT);
+    vec_select(inside, lon + d_lon, lon, out_lon);
+    vec_select(inside, lat + d_lat, lat, out_lat);
+}
+
+// 不动点迭代w = w - (gcj(w) - g)，境外的点gcj(w) = w，迭代结果就是输入
+inline __attribute__((always_inline)) void vec_gcj02_to_wgs84(const Vec& lon, const Vec& lat,
+                                                              Vec& out_lon, Vec& out_lat) {
+    Vec w_lon = lon;
+    Vec w_lat = lat;
+    for (int i = 0; i < GCJ02_INVERSE_ITERATIONS; i++) {
+        Vec g_lon, g_lat;
+        vec_wgs84_to_gcj02(w_lon, w_lat, g_lon, g_lat);
+        w_lon -= g_lon - lon;
+        w_lat -= g_lat - lat;
+    }
+    out_lon = w_lon;
+    out_lat = w_lat;
+}
+
+// 原公式为z * cos(atan2(y, x) + delta)，展开成z / r * (x * cos(delta) - y * sin(delta))，
+// 省掉atan2。|delta| <= 3e-6，cos、sin取泰勒展开的前两项已经精确到舍入误差
+inline __attribute__((always_inline)) void vec_rotate_scale(const Vec& x, const Vec& y, const Vec& z, const Vec& r,
+                                                            const Vec& delta, Vec& out_x, Vec& out_y) {
+    Vec cos_delta = 1.0 - delta * delta * 0.5;
+    Vec sin_delta = delta - delta * delta * delta * (1.0 / 6.0);
+    Vec zero = {0.0, 0.0, 0.0, 0.0};
+    Vec scale;
+    vec_select(r > 0.0, z / r, zero, scale);
+    Vec rotated_x = scale * (x * cos_delta - y * sin_delta);
+    Vec rotated_y = scale * (y * cos_delta + x * sin_delta);
+    out_x = rotated_x;
+    out_y = rotated_y;
+}
+
+inline __attribute__((always_inline)) void vec_gcj02_to_bd09(const Vec& lon, const Vec& lat,
+                                                             Vec& out_lon, Vec& out_lat) {
+    Vec r, sin_y, cos_x;
+    vec_sqrt(lon * lon + lat * lat, r);
+    vec_sin(lat * X_PI, sin_y);
+    vec_cos(lon * X_PI, cos_x);
+    Vec z = r + 0.00002 * sin_y;
+    vec_rotate_scale(lon, lat, z, r, 0.000003 * cos_x, out_lon, out_lat);
+    out_lon += BD09_LON_SHIFT;
+    out_lat += BD09_LAT_SHIFT;
+}
+
+inline __attribute__((always_inline)) void vec_bd09_to_gcj02(const Vec& lon, const Vec& lat,
+                                                             Vec& out_lon, Vec& out_lat) {
+    Vec x = lon - BD09_LON_SHIFT;
+    Vec y = lat - BD09_LAT_SHIFT;
+    Vec r, sin_y, cos_x;
+    vec_sqrt(x * x + y * y, r);
+    vec_sin(y * X_PI, sin_y);
+    vec_cos(x * X_PI, cos_x);
+    Vec z = r - 0.00002 * sin_y;
+    vec_rotate_scale(x, y, z, r, -0.000003 * cos_x, out_lon, out_lat);
+}
+
+// 转换LANES个交错存放的点
+inline __attribute__((always_inline)) void convert_block(const double* lonlat, double* out,
+                                                         CoordType from, CoordType to) {
+    Vec lon = {lonlat[0], lonlat[2], lonlat[4], lonlat[6]};
+    Vec lat = {lonlat[1], lonlat[3], lonlat[5], lonlat[7]};
+    // 各个转换的输入输出不能是同一个变量
+    Vec gcj_lon = lon;
+    Vec gcj_lat = lat;
+    if (COORD_WGS84 == from) {
+        vec_wgs84_to_gcj02(lon, lat, gcj_lon, gcj_lat);
+    } else if (COORD_BD09 == from) {
+        vec_bd09_to_gcj02(lon, lat, gcj_lon, gcj_lat);
+    }
+    Vec out_lon = gcj_lon;
+    Vec out_lat = gcj_lat;
+    if (COORD_WGS84 == to) {
+        vec_gcj02_to_wgs84(gcj_lon, gcj_lat, out_lon, out_lat);
+    } else if (COORD_BD09 == to) {
+        vec_gcj02_to_bd09(gcj_lon, gcj_lat, out_lon, out_lat);
+    }
+    for (int i = 0; i < LANES; i++) {
+        out[2 * i] = out_lon[i];
+        out[2 * i + 1] = out_lat[i];
+    }
+}
+
+// 不足LANES个的尾部补齐之后按整块转换，保证每个点的结果和它在数组中的位置无关
+inline __attribute__((always_inline)) void convert_all(const double* lonlat, double* out, size_t point_count,
+                                                       CoordType from, CoordType to) {
+    size_t i = 0;
+    for (; i + LANES <= point_count; i += LANES) {
+        convert_block(lonlat + 2 * i, out + 2 * i, from, to);
+    }
+    if (i < point_count) {
+        double tail[2 * LANES] = {0.0};
+        memcpy(tail, lonlat + 2 * i, 2 * (point_count - i) * sizeof(double));
+        convert_block(tail, tail, from, to);
+        memcpy(out + 2 * i, tail, 2 * (point_count - i) * sizeof(double));
+    }
+}
+
+void convert_generic(const double* lonlat, double* out, size_t point_count, CoordType from, CoordType to) {
+    convert_all(lonlat, out, point_count, from, to);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("avx2")))
+void convert_avx2(const double* lonlat, double* out, size_t point_count, CoordType from, CoordType to) {
+    convert_all(lonlat, out, point_count, from, to);
+}
+#endif
+
+typedef void (*ConvertKernel)(const double*, double*, size_t, CoordType, CoordType);
+
+struct ConvertChoice {
+    ConvertKernel kernel;
+    const char* name;
+};
+
+ConvertChoice select_convert_kernel() {
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {convert_avx2, "avx2"};
+    }
+#endif
+    return {convert_generic, "generic"};
+}
+
+const ConvertChoice& convert_choice() {
+    static const ConvertChoice choice = select_convert_kernel();
+    return choice;
+}
+
+} // namespace
+
+bool out_of_china(double lon, double lat) {
+    return lon < CHINA_MIN_LON || lon > CHINA_MAX_LON || lat < CHINA_MIN_LAT || lat > CHINA_MAX_LAT;
+}
+
+void wgs84_to_gcj02(double lon, double lat, double& out_lon, double& out_lat) {
+    if (out_of_china(lon, lat)) {
+        out_lon = lon;
+        out_lat = lat;
+        return;
+    }
+    double d_lat = transform_lat(lon - 105.0, lat - 35.0);
+    double d_lon = transform_lon(lon - 105.0, lat - 35.0);
+    double rad_lat = lat / 180.0 * PI;
+    double magic = sin(rad_lat);
+    magic = 1 - KRASOVSKY_EE * magic * magic;
+    double sqrt_magic = sqrt(magic);
+    d_lat = (d_lat * 180.0) / ((KRASOVSKY_A * (1 - KRASOVSKY_EE)) / (magic * sqrt_magic) * PI);
+    d_lon = (d_lon * 180.0) / (KRASOVSKY_A / sqrt_magic * cos(rad_lat) * PI);
+    out_lon = lon + d_lon;
+    out_lat = lat + d_lat;
+}
+
+void gcj02_to_wgs84(double lon, double lat, double& out_lon, double& out_lat) {
+    double w_lon = lon;
+    double w_lat = lat;
+    for (int i = 0; i < GCJ02_INVERSE_ITERATIONS; i++) {
+        double g_lon = 0.0;
+        double g_lat = 0.0;
+        wgs84_to_gcj02(w_lon, w_lat, g_lon, g_lat);
+        w_lon -= g_lon - lon;
+        w_lat -= g_lat - lat;
+    }
+    out_lon = w_lon;
+    out_lat = w_lat;
+}
+
+void gcj02_to_bd09(double lon, double lat, double& out_lon, double& out_lat) {
+    double z = sqrt(lon * lon + lat * lat) + 0.00002 * sin(lat * X_PI);
+    double theta = atan2(lat, lon) + 0.000003 * cos(lon * X_PI);
+    out_lon = z * cos(theta) + BD09_LON_SHIFT;
+    out_lat = z * sin(theta) + BD09_LAT_SHIFT;
+}
+
+void bd09_to_gcj02(double lon, double lat, double& out_lon, double& out_lat) {
+    double x = lon - BD09_LON_SHIFT;
+    double y = lat - BD09_LAT_SHIFT;
+    double z = sqrt(x * x + y * y) - 0.00002 * sin(y * X_PI);
+    double theta = atan2(y, x) - 0.000003 * cos(x * X_PI);
+    out_lon = z * cos(theta);
+    out_lat = z * sin(theta);
+}
+
+int convert_coords(const double* lonlat, double* out, size_t point_count, CoordType from, CoordType to) {
+    if (from < COORD_WGS84 || from > COORD_BD09 || to < COORD_WGS84 || to > COORD_BD09) {
+        return -1;
+    }
+    if (from == to) {
+        if (out != lonlat) {
+            memmove(out, lonlat, 2 * point_count * sizeof(double));
+        }
+        return 0;
+    }
+    convert_choice().kernel(lonlat, out, point_count, from, to);
+    return 0;
+}
+
+const char* coord_kernel_name() {
+    return convert_choice().name;
+}
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,49 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// WGS-84、GCJ-02、BD-09经纬度坐标之间的转换。
+// 单点函数用libm实现，结果和常见的公开实现逐位一致；批量函数一次转换整个数组，
+// 三角函数换成多项式，AVX2可用时一次算4个点，和单点函数的差别小于1e-13度。
+// GCJ-02的偏移只在中国境内(粗略的经纬度矩形)生效，境外的点原样返回。
+
+#include <stddef.h>
+
+namespace adas {
+namespace geo {
+
+enum CoordType {
+    COORD_WGS84 = 0, // GNSS原始坐标
+    COORD_GCJ02 = 1, // 国测局坐标，ehp服务端、mm_tool使用的坐标
+    COORD_BD09 = 2,  // 百度经纬度坐标
+};
+
+/**
+ * @brief 粗略判断是否在中国境外，境外不做GCJ-02偏移
+*/
+bool out_of_china(double lon, double lat);
+
+void wgs84_to_gcj02(double lon, double lat, double& out_lon, double& out_lat);
+
+/**
+ * @brief 迭代求逆，结果再转回GCJ-02和输入相差小于5e-11度(约5um)
+*/
+void gcj02_to_wgs84(double lon, double lat, double& out_lon, double& out_lat);
+
+void gcj02_to_bd09(double lon, double lat, double& out_lon, double& out_lat);
+
+void bd09_to_gcj02(double lon, double lat, double& out_lon, double& out_lat);
+
+/**
+ * @brief 批量转换，lonlat为交错存放的lon0, lat0, lon1, lat1...，out可以和lonlat是同一个数组。
+ *        WGS-84和BD-09之间经过GCJ-02中转
+ * @return 0 for ok, -1 for from或者to不合法
+*/
+int convert_coords(const double* lonlat, double* out, size_t point_count, CoordType from, CoordType to);
+
+/**
+ * @brief 批量转换实际使用的内核: "avx2" 或 "generic"
+*/
+const char* coord_kernel_name();
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,197 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "geo_kernel.h"
+#include "geo_enu.h"
+
+namespace adas {
+namespace geo {
+
+namespace {
+
+// 和geo_coord一样用GCC的向量扩展写一份，AVX2可用时一次算8条线段，否则由编译器拆成128位指令
+typedef float Vec __attribute__((vector_size(32)));
+typedef int32_t VecInt __attribute__((vector_size(32)));
+const int LANES = 8;
+
+// 点在原点，到线段(a, b)最近点距离的平方，向量和标量两种实现运算顺序相同
+inline float segment_distance2(float ax, float ay, float bx, float by) {
+    float dx = bx - ax;
+    float dy = by - ay;
+    float len2 = dx * dx + dy * dy;
+    float t = 0.0f;
+    if (len2 > 0.0f) {
+        t = -(ax * dx + ay * dy) / len2;
+        t = t > 0.0f ? (t < 1.0f ? t : 1.0f) : 0.0f;
+    }
+    float cx = ax + t * dx;
+    float cy = ay + t * dy;
+    return cx * cx + cy * cy;
+}
+
+inline __attribute__((always_inline)) void vec_select(const VecInt& mask, const Vec& a, const Vec& b, Vec& out) {
+    out = (Vec)(((VecInt)a & mask) | ((VecInt)b & ~mask));
+}
+
+inline __attribute__((always_inline)) int nearest_local_segment(float east, float north, const float* xs,
+                                                                const float* ys, size_t segments) {
+    Vec zero = {};
+    Vec best = zero + HUGE_VALF;
+    VecInt best_index = (VecInt)zero - 1;
+    VecInt index = {0, 1, 2, 3, 4, 5, 6, 7};
+
+    size_t i = 0;
+    for (; i + LANES <= segments; i += LANES) {
+        Vec ax, ay, bx, by;
+        memcpy(&ax, xs + i, sizeof(Vec));
+        memcpy(&ay, ys + i, sizeof(Vec));
+        memcpy(&bx, xs + i + 1, sizeof(Vec));
+        memcpy(&by, ys + i + 1, sizeof(Vec));
+        ax -= east;
+        ay -= north;
+        bx -= east;
+        by -= north;
+
+        Vec dx = bx - ax;
+        Vec dy = by - ay;
+        Vec len2 = dx * dx + dy * dy;
+        Vec t = -(ax * dx + ay * dy) / len2;
+        vec_select(t > 0.0f, t, zero, t);
+        vec_select(t < 1.0f, t, zero + 1.0f, t);
+        vec_select(len2 > 0.0f, t, zero, t);
+        Vec cx = ax + t * dx;
+        Vec cy = ay + t * dy;
+        Vec d = cx * cx + cy * cy;
+
+        VecInt closer = d < best;
+        vec_select(closer, d, best, best);
+        best_index = (index & closer) | (best_index & ~closer);
+        index += LANES;
+    }
+
+    int result = -1;
+    float result_distance2 = HUGE_VALF;
+    for (int k = 0; k < LANES; k++) {
+        if (best_index[k] >= 0 && (best[k] < result_distance2 ||
+                (best[k] == result_distance2 && best_index[k] < result))) {
+            result_distance2 = best[k];
+            result = best_index[k];
+        }
+    }
+    for (; i < segments; i++) {
+        float d = segment_distance2(xs[i] - east, ys[i] - north, xs[i + 1] - east, ys[i + 1] - north);
+        if (d < result_distance2) {
+            result_distance2 = d;
+            result = i;
+        }
+    }
+    return result;
+}
+
+int nearest_local_generic(float east, float north, const float* xs, const float* ys, size_t segments) {
+    return nearest_local_segment(east, north, xs, ys, segments);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("avx2")))
+int nearest_local_avx2(float east, float north, const float* xs, const float* ys, size_t segments) {
+    return nearest_local_segment(east, north, xs, ys, segments);
+}
+#endif
+
+typedef int (*NearestLocalKernel)(float, float, const float*, const float*, size_t);
+
+NearestLocalKernel select_nearest_local() {
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return nearest_local_avx2;
+    }
+#endif
+    return nearest_local_generic;
+}
+
+} // namespace
+
+void LocalFrame::reset(double origin_lon, double origin_lat) {
+    _valid = true;
+    _origin_lon = origin_lon;
+    _origin_lat = origin_lat;
+    _sin_lat = sin(rad(origin_lat));
+    _cos_lat = cos(rad(origin_lat));
+}
+
+// north = R * (sin(lat)cos(lat0) - cos(lat)sin(lat0)cos(dlon))，
+// 改写成sin(lat - lat0) + 2cos(lat)sin(lat0)sin^2(dlon / 2)，避免原点附近两项相减损失精度
+void LocalFrame::to_local(double lon, double lat, double& east, double& north) const {
+    double phi = rad(lat);
+    double dlambda = rad(lon - _origin_lon);
+    double cos_phi = cos(phi);
+    double half = sin(dlambda / 2);
+    east = EARTH_RADIUS * cos_phi * sin(dlambda);
+    north = EARTH_RADIUS * (sin(phi - rad(_origin_lat)) + 2 * cos_phi * _sin_lat * half * half);
+}
+
+void LocalFrame::to_local(const double* lonlat, size_t point_count, float* east, float* north) const {
+    for (size_t i = 0; i < point_count; i++) {
+        double e = 0.0;
+        double n = 0.0;
+        to_local(lonlat[2 * i], lonlat[2 * i + 1], e, n);
+        east[i] = e;
+        north[i] = n;
+    }
+}
+
+void LocalFrame::to_lonlat(double east, double north, double& lon, double& lat) const {
+    double rho = sqrt(east * east + north * north);
+    if (0.0 == rho) {
+        lon = _origin_lon;
+        lat = _origin_lat;
+        return;
+    }
+    double c = asin(std::min(rho / EARTH_RADIUS, 1.0));
+    double sin_c = sin(c);
+    double cos_c = cos(c);
+    lat = asin(cos_c * _sin_lat + north * sin_c * _cos_lat / rho) * 180.0 / PI;
+    lon = _origin_lon + atan2(east * sin_c, rho * cos_c * _cos_lat - north * sin_c * _sin_lat) * 180.0 / PI;
+}
+
+int project_local(float east, float north, const float* shape_east, const float* shape_north,
+                  size_t point_count, LocalProjection& projection) {
+    if (point_count < 2) {
+        return -1;
+    }
+    static const NearestLocalKernel kernel = select_nearest_local();
+    int index = kernel(east, north, shape_east, shape_north, point_count - 1);
+    if (index < 0) {
+        return -1;
+    }
+
+    float ax = shape_east[index] - east;
+    float ay = shape_north[index] - north;
+    float dx = shape_east[index + 1] - shape_east[index];
+    float dy = shape_north[index + 1] - shape_north[index];
+    float len2 = dx * dx + dy * dy;
+    float t = 0.0f;
+    if (len2 > 0.0f) {
+        t = -(ax * dx + ay * dy) / len2;
+        t = t > 0.0f ? (t < 1.0f ? t : 1.0f) : 0.0f;
+    }
+    float cx = ax + t * dx;
+    float cy = ay + t * dy;
+
+    float heading = atan2f(dx, dy) * float(180.0 / PI);
+    if (heading < 0.0f) {
+        heading += 360.0f;
+    }
+    projection.segment_index = index;
+    projection.ratio = t;
+    projection.distance = sqrtf(cx * cx + cy * cy);
+    projection.heading = heading >= 360.0f ? 0.0f : heading;
+    return 0;
+}
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,75 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 局部切平面(ENU去掉高程)坐标系。horizon或者一个瓦片范围内的形点在入库时换算成以米为单位的
+// 局部坐标，之后的投影、方向、弧长计算都是平面上的float四则运算，可以向量化，
+// 只有输出时才换算回经纬度。
+// 换算为球面到切平面的正射投影，离原点d米处的长度误差约为(d / EARTH_RADIUS)^2 / 2，
+// 20km以内小于1e-5；float在20km处的分辨率约2mm。
+
+#include <stddef.h>
+
+namespace adas {
+namespace geo {
+
+class LocalFrame {
+public:
+    LocalFrame() {}
+    LocalFrame(double origin_lon, double origin_lat) {
+        reset(origin_lon, origin_lat);
+    }
+
+    void reset(double origin_lon, double origin_lat);
+
+    bool valid() const {
+        return _valid;
+    }
+
+    double origin_lon() const {
+        return _origin_lon;
+    }
+
+    double origin_lat() const {
+        return _origin_lat;
+    }
+
+    /**
+     * @brief 经纬度换算成局部坐标，east向东、north向北，unit m
+    */
+    void to_local(double lon, double lat, double& east, double& north) const;
+
+    /**
+     * @brief 批量换算，lonlat为交错存放的lon0, lat0, lon1, lat1...，east、north各point_count个
+    */
+    void to_local(const double* lonlat, size_t point_count, float* east, float* north) const;
+
+    /**
+     * @brief 局部坐标换算回经纬度，只在输出时使用
+    */
+    void to_lonlat(double east, double north, double& lon, double& lat) const;
+
+private:
+    bool _valid = false;
+    double _origin_lon = 0.0;
+    double _origin_lat = 0.0;
+    double _sin_lat = 0.0;
+    double _cos_lat = 1.0;
+};
+
+struct LocalProjection {
+    int segment_index = -1; // 最近线段的索引，线段i为形点i到形点i+1
+    float ratio = 0.0f;     // 投影点在线段上的位置，截断到[0, 1]
+    float distance = 0.0f;  // 点到投影点的距离，unit m
+    float heading = 0.0f;   // 最近线段的方向，和正北方向的顺时针夹角，unit 度，[0, 360)
+};
+
+/**
+ * @brief 局部坐标系下点到折线的投影，east、north为形点的局部坐标。
+ *        AVX2可用时一次比较8条线段，距离相同时取索引小的
+ * @return 0 for ok, -1 for 形点少于2个或者坐标有NaN找不到最近线段，此时不输出projection
+*/
+int project_local(float east, float north, const float* shape_east, const float* shape_north,
+                  size_t point_count, LocalProjection& projection);
+
+} // namespace geo
+} // namespace adas
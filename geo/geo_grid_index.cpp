@@ -0,0 +1,190 @@
+#include <math.h>
+#include <algorithm>
+
+#include "geo_kernel.h"
+#include "geo_grid_index.h"
+
+namespace adas {
+namespace geo {
+
+namespace {
+
+const double METERS_PER_DEGREE = EARTH_RADIUS * PI / 180.0;
+
+} // namespace
+
+SegmentGridIndex::SegmentGridIndex(double cell_size) : _cell_size(cell_size) {}
+
+int64_t SegmentGridIndex::_cell_x(double lon) const {
+    return int64_t(floor(lon / _cell_lon));
+}
+
+int64_t SegmentGridIndex::_cell_y(double lat) const {
+    return int64_t(floor(lat / _cell_lat));
+}
+
+bool SegmentGridIndex::_valid_point(const double* p) {
+    return isfinite(p[0]) && isfinite(p[1]) && fabs(p[0]) <= 180.0 && fabs(p[1]) <= 90.0;
+}
+
+int SegmentGridIndex::insert(uint64_t id, const double* lonlat, size_t point_count) {
+    if (point_count < 2 || contains(id)) {
+        return -1;
+    }
+
+    double cell_lat = _cell_lat;
+    double cell_lon = _cell_lon;
+    if (0.0 == cell_lat) {
+        cell_lat = _cell_size / METERS_PER_DEGREE;
+        cell_lon = cell_lat / std::max(cos(rad(lonlat[1])), 0.01);
+    }
+
+    // 先检查所有线段，有一段不合法就整条不插入，网格保持原样
+    for (size_t i = 0; i < point_count; i++) {
+        if (!_valid_point(lonlat + 2 * i)) {
+            return -1;
+        }
+    }
+    for (size_t i = 0; i + 1 < point_count; i++) {
+        const double* p = lonlat + 2 * i;
+        double columns = fabs(floor(p[2] / cell_lon) - floor(p[0] / cell_lon)) + 1.0;
+        double rows = fabs(floor(p[3] / cell_lat) - floor(p[1] / cell_lat)) + 1.0;
+        if (columns + rows > double(MAX_SEGMENT_CELLS)) {
+            return -1;
+        }
+    }
+    _cell_lat = cell_lat;
+    _cell_lon = cell_lon;
+
+    Polyline& polyline = _polylines[id];
+    polyline.lonlat.assign(lonlat, lonlat + 2 * point_count);
+    for (size_t i = 0; i + 1 < point_count; i++) {
+        const double* p = polyline.lonlat.data() + 2 * i;
+        Entry entry = {id, uint32_t(i), p};
+        int64_t x_begin = _cell_x(std::min(p[0], p[2]));
+        int64_t x_end = _cell_x(std::max(p[0], p[2]));
+        int64_t y_begin = _cell_y(std::min(p[1], p[3]));
+        int64_t y_end = _cell_y(std::max(p[1], p[3]));
+        if ((x_end - x_begin + 1) * (y_end - y_begin + 1) <= SMALL_SEGMENT_CELLS) {
+            for (int64_t x = x_begin; x <= x_end; x++) {
+                for (int64_t y = y_begin; y <= y_end; y++) {
+                    _add_entry(_cell_key(x, y), entry, polyline);
+                }
+            }
+            continue;
+        }
+
+        // 长线段按列扫描，每一列只放线段在该列经度范围内经过的格子，而不是整个外包框
+        double lon_min = std::min(p[0], p[2]);
+        double lon_max = std::max(p[0], p[2]);
+        double dlon = p[2] - p[0];
+        for (int64_t x = x_begin; x <= x_end; x++) {
+            double y0 = p[1];
+            double y1 = p[3];
+            if (0.0 != dlon) {
+                double lon0 = std::max(lon_min, x * _cell_lon);
+                double lon1 = std::min(lon_max, (x + 1) * _cell_lon);
+                y0 = p[1] + (p[3] - p[1]) * ((lon0 - p[0]) / dlon);
+                y1 = p[1] + (p[3] - p[1]) * ((lon1 - p[0]) / dlon);
+            }
+            // 插值的舍入误差可能让线段刚好落到相邻格子，行范围不超出线段本身的外包框
+            int64_t row_begin = std::max(y_begin, _cell_y(std::min(y0, y1)));
+            int64_t row_end = std::min(y_end, _cell_y(std::max(y0, y1)));
+            for (int64_t y = row_begin; y <= row_end; y++) {
+                _add_entry(_cell_key(x, y), entry, polyline);
+            }
+        }
+    }
+    std::sort(polyline.cells.begin(), polyline.cells.end());
+    polyline.cells.erase(std::unique(polyline.cells.begin(), polyline.cells.end()), polyline.cells.end());
+    _segment_count += point_count - 1;
+    return 0;
+}
+
+void SegmentGridIndex::_add_entry(int64_t key, const Entry& entry, Polyline& polyline) {
+    _cells[key].push_back(entry);
+    polyline.cells.push_back(key);
+}
+
+int SegmentGridIndex::remove(uint64_t id) {
+    auto it = _polylines.find(id);
+    if (_polylines.end() == it) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < it->second.cells.size(); i++) {
+        auto cell = _cells.find(it->second.cells[i]);
+        if (_cells.end() == cell) {
+            continue;
+        }
+        std::vector<Entry>& entries = cell->second;
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [id](const Entry& entry) {
+            return entry.id == id;
+        }), entries.end());
+        if (entries.empty()) {
+            _cells.erase(cell);
+        }
+    }
+    _segment_count -= it->second.lonlat.size() / 2 - 1;
+    _polylines.erase(it);
+    return 0;
+}
+
+void SegmentGridIndex::clear() {
+    _cells.clear();
+    _polylines.clear();
+    _segment_count = 0;
+    _cell_lon = 0.0;
+    _cell_lat = 0.0;
+}
+
+void SegmentGridIndex::query(double lon, double lat, double radius, std::vector<SegmentHit>& hits) const {
+    hits.clear();
+    if (_polylines.empty()) {
+        return;
+    }
+
+    double cos_lat = cos(rad(lat));
+    double radius_lat = radius / METERS_PER_DEGREE;
+    double radius_lon = radius_lat / std::max(cos_lat, 0.01);
+    int64_t x_begin = _cell_x(lon - radius_lon);
+    int64_t x_end = _cell_x(lon + radius_lon);
+    int64_t y_begin = _cell_y(lat - radius_lat);
+    int64_t y_end = _cell_y(lat + radius_lat);
+
+    for (int64_t x = x_begin; x <= x_end; x++) {
+        for (int64_t y = y_begin; y <= y_end; y++) {
+            auto cell = _cells.find(_cell_key(x, y));
+            if (_cells.end() == cell) {
+                continue;
+            }
+            for (size_t i = 0; i < cell->second.size(); i++) {
+                const Entry& entry = cell->second[i];
+                const double* p = entry.points;
+                double distance = local_segment_distance(lon, lat, cos_lat, p[0], p[1], p[2], p[3]);
+                if (distance <= radius) {
+                    SegmentHit hit;
+                    hit.id = entry.id;
+                    hit.segment_index = entry.segment_index;
+                    hit.distance = distance;
+                    hits.push_back(hit);
+                }
+            }
+        }
+    }
+
+    // 跨格子的线段会被命中多次，去重后按距离排序
+    std::sort(hits.begin(), hits.end(), [](const SegmentHit& a, const SegmentHit& b) {
+        return a.id != b.id ? a.id < b.id : a.segment_index < b.segment_index;
+    });
+    hits.erase(std::unique(hits.begin(), hits.end(), [](const SegmentHit& a, const SegmentHit& b) {
+        return a.id == b.id && a.segment_index == b.segment_index;
+    }), hits.end());
+    std::sort(hits.begin(), hits.end(), [](const SegmentHit& a, const SegmentHit& b) {
+        return a.distance != b.distance ? a.distance < b.distance :
+                (a.id != b.id ? a.id < b.id : a.segment_index < b.segment_index);
+    });
+}
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,98 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 折线线段的均匀网格索引，用于按半径查找候选线段。
+// 网格按经纬度划分，格子的经度跨度在第一次插入时按当时的纬度换算，
+// 适用于几十公里范围内的horizon或者轨迹，不适合跨越很大纬度范围的数据。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <unordered_map>
+#include <vector>
+
+namespace adas {
+namespace geo {
+
+struct SegmentHit {
+    uint64_t id = 0; // insert时传入的折线id
+    uint32_t segment_index = 0; // 线段i为形点i到形点i+1
+    double distance = 0.0; // 查询点到线段的距离，unit m
+};
+
+class SegmentGridIndex {
+public:
+    // 单条线段最多登记的格子数，按100m的格子约为200km，足够覆盖正常的link
+    static const int64_t MAX_SEGMENT_CELLS = 4096;
+
+    /**
+     * @brief cell_size为格子边长，unit m。查询半径和格子边长相当时效率最好
+    */
+    explicit SegmentGridIndex(double cell_size = 100.0);
+
+    /**
+     * @brief 插入一条折线，lonlat为交错存放的lon0, lat0, lon1, lat1...，内部会拷贝一份。
+     *        线段只登记在它经过的格子里，一条线段最多经过MAX_SEGMENT_CELLS个格子
+     * @return 0 for ok, -1 for error(id已存在、形点少于2个、形点不是合法经纬度或者线段过长)，
+     *         出错时整条折线都不插入
+    */
+    int insert(uint64_t id, const double* lonlat, size_t point_count);
+
+    /**
+     * @return 0 for ok, -1 for id不存在
+    */
+    int remove(uint64_t id);
+
+    bool contains(uint64_t id) const {
+        return _polylines.end() != _polylines.find(id);
+    }
+
+    void clear();
+
+    size_t size() const {
+        return _polylines.size();
+    }
+
+    size_t segment_count() const {
+        return _segment_count;
+    }
+
+    /**
+     * @brief 查找和(lon, lat)距离不超过radius米的线段，按距离从近到远放进hits，
+     *        同一条折线的多条线段会分别返回
+    */
+    void query(double lon, double lat, double radius, std::vector<SegmentHit>& hits) const;
+
+private:
+    struct Entry {
+        uint64_t id;
+        uint32_t segment_index;
+        const double* points; // 指向_polylines里线段的起点，unordered_map的元素地址不会因为rehash变化
+    };
+
+    struct Polyline {
+        std::vector<double> lonlat;
+        std::vector<int64_t> cells;
+    };
+
+    // 外包框不超过这么多格子的线段直接登记整个外包框
+    static const int64_t SMALL_SEGMENT_CELLS = 16;
+
+    static bool _valid_point(const double* p);
+    void _add_entry(int64_t key, const Entry& entry, Polyline& polyline);
+    int64_t _cell_x(double lon) const;
+    int64_t _cell_y(double lat) const;
+
+    static int64_t _cell_key(int64_t x, int64_t y) {
+        return int64_t((uint64_t(x) << 32) ^ (uint64_t(y) & 0xffffffffULL));
+    }
+
+    double _cell_size;
+    double _cell_lon = 0.0; // 格子的经度跨度，第一次插入时确定
+    double _cell_lat = 0.0;
+    size_t _segment_count = 0;
+    std::unordered_map<int64_t, std::vector<Entry> > _cells;
+    std::unordered_map<uint64_t, Polyline> _polylines;
+}; // class SegmentGridIndex
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,545 @@
+#include <math.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define GEO_KERNEL_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define GEO_KERNEL_NEON 1
+#endif
+
+#include "geo_kernel.h"
+#include "geo_vec.h"
+
+namespace adas {
+namespace geo {
+
+namespace {
+
+using namespace detail;
+
+const double DEG_TO_RAD = PI / 180.0;
+
+// cos(x)的泰勒展开到x^16，|x| <= PI/2时截断误差小于1e-12，
+// 标量和SIMD内核使用同一组系数和同样的运算顺序
+const double COS_C0 = 1.0;
+const double COS_C1 = -1.0 / 2.0;
+const double COS_C2 = 1.0 / 24.0;
+const double COS_C3 = -1.0 / 720.0;
+const double COS_C4 = 1.0 / 40320.0;
+const double COS_C5 = -1.0 / 3628800.0;
+const double COS_C6 = 1.0 / 479001600.0;
+const double COS_C7 = -1.0 / 87178291200.0;
+const double COS_C8 = 1.0 / 20922789888000.0;
+
+inline double cos_poly(double x) {
+    double z = x * x;
+    double r = COS_C8;
+    r = r * z + COS_C7;
+    r = r * z + COS_C6;
+    r = r * z + COS_C5;
+    r = r * z + COS_C4;
+    r = r * z + COS_C3;
+    r = r * z + COS_C2;
+    r = r * z + COS_C1;
+    r = r * z + COS_C0;
+    return r;
+}
+
+void equirectangular_batch_scalar(const double* lon1, const double* lat1, const double* lon2, const double* lat2,
+                                  double* distances, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        distances[i] = equirectangular_distance(lon1[i], lat1[i], lon2[i], lat2[i]);
+    }
+}
+
+#if defined(GEO_KERNEL_X86)
+__attribute__((target("avx2")))
+void equirectangular_batch_avx2(const double* lon1, const double* lat1, const double* lon2, const double* lat2,
+                                double* distances, size_t size) {
+    const __m256d half_deg = _mm256_set1_pd(0.5 * DEG_TO_RAD);
+    const __m256d deg = _mm256_set1_pd(DEG_TO_RAD);
+    const __m256d radius = _mm256_set1_pd(EARTH_RADIUS);
+    const double coefs[] = {COS_C7, COS_C6, COS_C5, COS_C4, COS_C3, COS_C2, COS_C1, COS_C0};
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d a_lon = _mm256_loadu_pd(lon1 + i);
+        __m256d a_lat = _mm256_loadu_pd(lat1 + i);
+        __m256d b_lon = _mm256_loadu_pd(lon2 + i);
+        __m256d b_lat = _mm256_loadu_pd(lat2 + i);
+
+        __m256d phi = _mm256_mul_pd(_mm256_add_pd(a_lat, b_lat), half_deg);
+        __m256d z = _mm256_mul_pd(phi, phi);
+        __m256d c = _mm256_set1_pd(COS_C8);
+        for (int k = 0; k < 8; k++) {
+            c = _mm256_add_pd(_mm256_mul_pd(c, z), _mm256_set1_pd(coefs[k]));
+        }
+
+        __m256d x = _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(b_lon, a_lon), deg), c);
+        __m256d y = _mm256_mul_pd(_mm256_sub_pd(b_lat, a_lat), deg);
+        __m256d d = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)));
+        _mm256_storeu_pd(distances + i, _mm256_mul_pd(d, radius));
+    }
+    equirectangular_batch_scalar(lon1 + i, lat1 + i, lon2 + i, lat2 + i, distances + i, size - i);
+}
+#endif
+
+#if defined(GEO_KERNEL_NEON)
+void equirectangular_batch_neon(const double* lon1, const double* lat1, const double* lon2, const double* lat2,
+                                double* distances, size_t size) {
+    const float64x2_t half_deg = vdupq_n_f64(0.5 * DEG_TO_RAD);
+    const float64x2_t deg = vdupq_n_f64(DEG_TO_RAD);
+    const float64x2_t radius = vdupq_n_f64(EARTH_RADIUS);
+    const double coefs[] = {COS_C7, COS_C6, COS_C5, COS_C4, COS_C3, COS_C2, COS_C1, COS_C0};
+
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        float64x2_t a_lon = vld1q_f64(lon1 + i);
+        float64x2_t a_lat = vld1q_f64(lat1 + i);
+        float64x2_t b_lon = vld1q_f64(lon2 + i);
+        float64x2_t b_lat = vld1q_f64(lat2 + i);
+
+        float64x2_t phi = vmulq_f64(vaddq_f64(a_lat, b_lat), half_deg);
+        float64x2_t z = vmulq_f64(phi, phi);
+        float64x2_t c = vdupq_n_f64(COS_C8);
+        for (int k = 0; k < 8; k++) {
+            c = vaddq_f64(vmulq_f64(c, z), vdupq_n_f64(coefs[k]));
+        }
+
+        float64x2_t x = vmulq_f64(vmulq_f64(vsubq_f64(b_lon, a_lon), deg), c);
+        float64x2_t y = vmulq_f64(vsubq_f64(b_lat, a_lat), deg);
+        float64x2_t d = vsqrtq_f64(vaddq_f64(vmulq_f64(x, x), vmulq_f64(y, y)));
+        vst1q_f64(distances + i, vmulq_f64(d, radius));
+    }
+    equirectangular_batch_scalar(lon1 + i, lat1 + i, lon2 + i, lat2 + i, distances + i, size - i);
+}
+#endif
+
+// asin(u)的泰勒展开，u^(2n+1)的系数为C(2n, n) / (4^n * (2n + 1))，取到n = 12，
+// |u| <= sin(PI / 12)时截断误差小于1e-17
+const double ASIN_C1 = 1.0 / 6.0;
+const double ASIN_C2 = 3.0 / 40.0;
+const double ASIN_C3 = 5.0 / 112.0;
+const double ASIN_C4 = 35.0 / 1152.0;
+const double ASIN_C5 = 63.0 / 2816.0;
+const double ASIN_C6 = 231.0 / 13312.0;
+const double ASIN_C7 = 143.0 / 10240.0;
+const double ASIN_C8 = 6435.0 / 557056.0;
+const double ASIN_C9 = 12155.0 / 1245184.0;
+const double ASIN_C10 = 46189.0 / 5505024.0;
+const double ASIN_C11 = 88179.0 / 12058624.0;
+const double ASIN_C12 = 676039.0 / 104857600.0;
+
+// x取[0, 1]。x > 0.5时asin(x) = PI / 2 - 2 * asin(sqrt((1 - x) / 2))，把x缩到[0, 0.5]；
+// 再用半角公式asin(y) = 2 * asin(y / sqrt(2 * (1 + sqrt(1 - y * y))))缩到sin(PI / 12)以内，
+// 这一步没有相近数相减，小角度的相对精度不受影响
+template<typename Sqrt>
+inline __attribute__((always_inline)) void vec_asin_unit(const Vec& x, Vec& out) {
+    VecMask big = x > 0.5;
+    Vec folded;
+    Sqrt::apply((1.0 - x) * 0.5, folded);
+    Vec y;
+    vec_select(big, folded, x, y);
+
+    Vec c;
+    Sqrt::apply(1.0 - y * y, c);
+    Vec half;
+    Sqrt::apply(2.0 * (1.0 + c), half);
+    Vec u = y / half;
+
+    Vec z = u * u;
+    Vec p = z * ASIN_C12 + ASIN_C11;
+    p = p * z + ASIN_C10;
+    p = p * z + ASIN_C9;
+    p = p * z + ASIN_C8;
+    p = p * z + ASIN_C7;
+    p = p * z + ASIN_C6;
+    p = p * z + ASIN_C5;
+    p = p * z + ASIN_C4;
+    p = p * z + ASIN_C3;
+    p = p * z + ASIN_C2;
+    p = p * z + ASIN_C1;
+    Vec asin_y = 2.0 * (u + u * z * p);
+    vec_select(big, PI / 2.0 - 2.0 * asin_y, asin_y, out);
+}
+
+// 各指令集的sqrt结果都是正确舍入的，换实现不影响结果
+struct GenericSqrt {
+    static inline __attribute__((always_inline)) void apply(const Vec& x, Vec& out) {
+        vec_sqrt(x, out);
+    }
+};
+
+#if defined(GEO_KERNEL_X86)
+struct Avx2Sqrt {
+    __attribute__((target("avx2"))) static inline void apply(const Vec& x, Vec& out) {
+        out = (Vec)_mm256_sqrt_pd((__m256d)x);
+    }
+};
+#endif
+
+// 和haversine_distance同样的公式，sin、cos、asin换成多项式。
+// 经差、纬差先按度相减(相近的两个数相减没有舍入误差)再换算成弧度，短线段比精确模式更准
+template<typename Sqrt>
+inline __attribute__((always_inline)) void haversine_block(const double* lon1, const double* lat1,
+                                                           const double* lon2, const double* lat2, double* out) {
+    Vec a_lon = {lon1[0], lon1[1], lon1[2], lon1[3]};
+    Vec a_lat = {lat1[0], lat1[1], lat1[2], lat1[3]};
+    Vec b_lon = {lon2[0], lon2[1], lon2[2], lon2[3]};
+    Vec b_lat = {lat2[0], lat2[1], lat2[2], lat2[3]};
+
+    Vec sin_a, sin_b, cos_lat1, cos_lat2;
+    vec_sin((a_lat - b_lat) * (0.5 * DEG_TO_RAD), sin_a);
+    vec_sin((a_lon - b_lon) * (0.5 * DEG_TO_RAD), sin_b);
+    vec_cos(a_lat * DEG_TO_RAD, cos_lat1);
+    vec_cos(b_lat * DEG_TO_RAD, cos_lat2);
+
+    Vec h = sin_a * sin_a + cos_lat1 * cos_lat2 * (sin_b * sin_b);
+    // 舍入误差可能让h略微超出[0, 1]
+    Vec zero = {0.0, 0.0, 0.0, 0.0};
+    Vec one = {1.0, 1.0, 1.0, 1.0};
+    Vec non_negative, clamped;
+    vec_select(h < zero, zero, h, non_negative);
+    vec_select(non_negative > one, one, non_negative, clamped);
+    Vec root, s;
+    Sqrt::apply(clamped, root);
+    vec_asin_unit<Sqrt>(root, s);
+    Vec d = 2.0 * s * EARTH_RADIUS;
+    for (int i = 0; i < LANES; i++) {
+        out[i] = d[i];
+    }
+}
+
+// 不足LANES个的尾部补齐之后按整块计算，每条线段的结果和它在数组中的位置无关
+template<typename Sqrt>
+inline __attribute__((always_inline)) void haversine_all(const double* lon1, const double* lat1,
+                                                         const double* lon2, const double* lat2,
+                                                         double* distances, size_t size) {
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        haversine_block<Sqrt>(lon1 + i, lat1 + i, lon2 + i, lat2 + i, distances + i);
+    }
+    if (i < size) {
+        double tail[4][LANES] = {{0.0}};
+        for (size_t k = 0; k < size - i; k++) {
+            tail[0][k] = lon1[i + k];
+            tail[1][k] = lat1[i + k];
+            tail[2][k] = lon2[i + k];
+            tail[3][k] = lat2[i + k];
+        }
+        double out[LANES];
+        haversine_block<Sqrt>(tail[0], tail[1], tail[2], tail[3], out);
+        for (size_t k = 0; k < size - i; k++) {
+            distances[i + k] = out[k];
+        }
+    }
+}
+
+void haversine_batch_generic(const double* lon1, const double* lat1, const double* lon2, const double* lat2,
+                             double* distances, size_t size) {
+    haversine_all<GenericSqrt>(lon1, lat1, lon2, lat2, distances, size);
+}
+
+#if defined(GEO_KERNEL_X86)
+__attribute__((target("avx2")))
+void haversine_batch_avx2(const double* lon1, const double* lat1, const double* lon2, const double* lat2,
+                          double* distances, size_t size) {
+    haversine_all<Avx2Sqrt>(lon1, lat1, lon2, lat2, distances, size);
+}
+#endif
+
+// 点在原点，求到线段(a, b)最近点距离的平方，坐标已经换算到局部平面
+inline double segment_distance2(double ax, double ay, double bx, double by) {
+    double dx = bx - ax;
+    double dy = by - ay;
+    double len2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (len2 > 0.0) {
+        t = -(ax * dx + ay * dy) / len2;
+        t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    }
+    double cx = ax + t * dx;
+    double cy = ay + t * dy;
+    return cx * cx + cy * cy;
+}
+
+int nearest_segment_scalar(double lon, double lat, double kx, const double* lonlat, size_t first, size_t segments,
+                           int best, double& best_distance2) {
+    for (size_t i = first; i < segments; i++) {
+        double d = segment_distance2((lonlat[2 * i] - lon) * kx, lonlat[2 * i + 1] - lat,
+                                     (lonlat[2 * i + 2] - lon) * kx, lonlat[2 * i + 3] - lat);
+        if (d < best_distance2) {
+            best_distance2 = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+#if defined(GEO_KERNEL_X86)
+// 一次读4个交错存放的形点: unpacklo/hi得到[x0 x2 x1 x3]和[y0 y2 y1 y3]，
+// 从下一个形点开始再读一次就是4条线段的终点，各lane对应的线段为[i, i+2, i+1, i+3]
+__attribute__((target("avx2")))
+int nearest_segment_avx2(double lon, double lat, double kx, const double* lonlat, size_t segments,
+                         double& best_distance2) {
+    const __m256d origin_x = _mm256_set1_pd(lon);
+    const __m256d origin_y = _mm256_set1_pd(lat);
+    const __m256d scale_x = _mm256_set1_pd(kx);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d step = _mm256_set1_pd(4.0);
+
+    __m256d best_d = _mm256_set1_pd(best_distance2);
+    __m256d best_i = _mm256_set1_pd(-1.0);
+    __m256d index = _mm256_set_pd(3.0, 1.0, 2.0, 0.0);
+
+    size_t i = 0;
+    for (; i + 4 <= segments; i += 4) {
+        const double* p = lonlat + 2 * i;
+        __m256d a0 = _mm256_loadu_pd(p);
+        __m256d a1 = _mm256_loadu_pd(p + 4);
+        __m256d b0 = _mm256_loadu_pd(p + 2);
+        __m256d b1 = _mm256_loadu_pd(p + 6);
+        __m256d ax = _mm256_mul_pd(_mm256_sub_pd(_mm256_unpacklo_pd(a0, a1), origin_x), scale_x);
+        __m256d ay = _mm256_sub_pd(_mm256_unpackhi_pd(a0, a1), origin_y);
+        __m256d bx = _mm256_mul_pd(_mm256_sub_pd(_mm256_unpacklo_pd(b0, b1), origin_x), scale_x);
+        __m256d by = _mm256_sub_pd(_mm256_unpackhi_pd(b0, b1), origin_y);
+
+        __m256d dx = _mm256_sub_pd(bx, ax);
+        __m256d dy = _mm256_sub_pd(by, ay);
+        __m256d len2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        __m256d dot = _mm256_add_pd(_mm256_mul_pd(ax, dx), _mm256_mul_pd(ay, dy));
+        __m256d t = _mm256_div_pd(_mm256_xor_pd(dot, sign), len2);
+        t = _mm256_min_pd(_mm256_max_pd(t, zero), one);
+        t = _mm256_and_pd(t, _mm256_cmp_pd(len2, zero, _CMP_GT_OQ));
+
+        __m256d cx = _mm256_add_pd(ax, _mm256_mul_pd(t, dx));
+        __m256d cy = _mm256_add_pd(ay, _mm256_mul_pd(t, dy));
+        __m256d d = _mm256_add_pd(_mm256_mul_pd(cx, cx), _mm256_mul_pd(cy, cy));
+
+        __m256d closer = _mm256_cmp_pd(d, best_d, _CMP_LT_OQ);
+        best_d = _mm256_blendv_pd(best_d, d, closer);
+        best_i = _mm256_blendv_pd(best_i, index, closer);
+        index = _mm256_add_pd(index, step);
+    }
+
+    double lane_d[4];
+    double lane_i[4];
+    _mm256_storeu_pd(lane_d, best_d);
+    _mm256_storeu_pd(lane_i, best_i);
+    int best = -1;
+    for (int k = 0; k < 4; k++) {
+        if (lane_i[k] < 0) {
+            continue;
+        }
+        if (lane_d[k] < best_distance2 || (lane_d[k] == best_distance2 && lane_i[k] < best)) {
+            best_distance2 = lane_d[k];
+            best = lane_i[k];
+        }
+    }
+    return nearest_segment_scalar(lon, lat, kx, lonlat, i, segments, best, best_distance2);
+}
+#endif
+
+#if defined(GEO_KERNEL_NEON)
+int nearest_segment_neon(double lon, double lat, double kx, const double* lonlat, size_t segments,
+                         double& best_distance2) {
+    const float64x2_t origin_x = vdupq_n_f64(lon);
+    const float64x2_t origin_y = vdupq_n_f64(lat);
+    const float64x2_t scale_x = vdupq_n_f64(kx);
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    const float64x2_t one = vdupq_n_f64(1.0);
+    const float64x2_t step = vdupq_n_f64(2.0);
+
+    float64x2_t best_d = vdupq_n_f64(best_distance2);
+    float64x2_t best_i = vdupq_n_f64(-1.0);
+    const double start_index[] = {0.0, 1.0};
+    float64x2_t index = vld1q_f64(start_index);
+
+    size_t i = 0;
+    for (; i + 2 <= segments; i += 2) {
+        float64x2x2_t a = vld2q_f64(lonlat + 2 * i);
+        float64x2x2_t b = vld2q_f64(lonlat + 2 * i + 2);
+        float64x2_t ax = vmulq_f64(vsubq_f64(a.val[0], origin_x), scale_x);
+        float64x2_t ay = vsubq_f64(a.val[1], origin_y);
+        float64x2_t bx = vmulq_f64(vsubq_f64(b.val[0], origin_x), scale_x);
+        float64x2_t by = vsubq_f64(b.val[1], origin_y);
+
+        float64x2_t dx = vsubq_f64(bx, ax);
+        float64x2_t dy = vsubq_f64(by, ay);
+        float64x2_t len2 = vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy));
+        float64x2_t dot = vaddq_f64(vmulq_f64(ax, dx), vmulq_f64(ay, dy));
+        float64x2_t t = vdivq_f64(vnegq_f64(dot), len2);
+        t = vminq_f64(vmaxq_f64(t, zero), one);
+        t = vbslq_f64(vcgtq_f64(len2, zero), t, zero);
+
+        float64x2_t cx = vaddq_f64(ax, vmulq_f64(t, dx));
+        float64x2_t cy = vaddq_f64(ay, vmulq_f64(t, dy));
+        float64x2_t d = vaddq_f64(vmulq_f64(cx, cx), vmulq_f64(cy, cy));
+
+        uint64x2_t closer = vcltq_f64(d, best_d);
+        best_d = vbslq_f64(closer, d, best_d);
+        best_i = vbslq_f64(closer, index, best_i);
+        index = vaddq_f64(index, step);
+    }
+
+    double lane_d[2];
+    double lane_i[2];
+    vst1q_f64(lane_d, best_d);
+    vst1q_f64(lane_i, best_i);
+    int best = -1;
+    for (int k = 0; k < 2; k++) {
+        if (lane_i[k] < 0) {
+            continue;
+        }
+        if (lane_d[k] < best_distance2 || (lane_d[k] == best_distance2 && lane_i[k] < best)) {
+            best_distance2 = lane_d[k];
+            best = lane_i[k];
+        }
+    }
+    return nearest_segment_scalar(lon, lat, kx, lonlat, i, segments, best, best_distance2);
+}
+#endif
+
+typedef void (*BatchKernel)(const double*, const double*, const double*, const double*, double*, size_t);
+
+typedef int (*NearestSegmentKernel)(double, double, double, const double*, size_t, double&);
+
+int nearest_segment_all_scalar(double lon, double lat, double kx, const double* lonlat, size_t segments,
+                               double& best_distance2) {
+    return nearest_segment_scalar(lon, lat, kx, lonlat, 0, segments, -1, best_distance2);
+}
+
+struct KernelChoice {
+    BatchKernel kernel;
+    BatchKernel haversine;
+    NearestSegmentKernel nearest_segment;
+    const char* name;
+};
+
+KernelChoice select_kernel() {
+#if defined(GEO_KERNEL_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {equirectangular_batch_avx2, haversine_batch_avx2, nearest_segment_avx2, "avx2"};
+    }
+#elif defined(GEO_KERNEL_NEON)
+    return {equirectangular_batch_neon, haversine_batch_generic, nearest_segment_neon, "neon"};
+#endif
+    return {equirectangular_batch_scalar, haversine_batch_generic, nearest_segment_all_scalar, "scalar"};
+}
+
+const KernelChoice& kernel_choice() {
+    static const KernelChoice choice = select_kernel();
+    return choice;
+}
+
+} // namespace
+
+double haversine_distance(double lon1, double lat1, double lon2, double lat2) {
+    double rad_lat1 = rad(lat1);
+    double rad_lat2 = rad(lat2);
+    double a = rad_lat1 - rad_lat2;
+    double b = rad(lon1) - rad(lon2);
+    // 保留pow的写法: 不开优化编译时glibc的pow(x, 2)和x * x在极少数输入上差一位，精确模式要和原实现一致
+    double s = 2 * asin(sqrt(pow(sin(a / 2), 2) +
+                cos(rad_lat1) * cos(rad_lat2) * pow(sin(b / 2), 2)));
+    return s * EARTH_RADIUS;
+}
+
+double equirectangular_distance(double lon1, double lat1, double lon2, double lat2) {
+    double phi = (lat1 + lat2) * (0.5 * DEG_TO_RAD);
+    double x = (lon2 - lon1) * DEG_TO_RAD * cos_poly(phi);
+    double y = (lat2 - lat1) * DEG_TO_RAD;
+    return sqrt(x * x + y * y) * EARTH_RADIUS;
+}
+
+double bearing(double lon1, double lat1, double lon2, double lat2) {
+    double dx = rad(lon2 - lon1) * cos(rad((lat1 + lat2) / 2));
+    double dy = rad(lat2 - lat1);
+    double degree = atan2(dx, dy) * 180.0 / PI;
+    if (degree < 0) {
+        degree += 360.0;
+    }
+    return degree >= 360.0 ? 0.0 : degree;
+}
+
+void distance_batch(const double* lon1, const double* lat1, const double* lon2, const double* lat2,
+                    double* distances, size_t size, DistanceMode mode) {
+    if (DISTANCE_EQUIRECTANGULAR == mode) {
+        kernel_choice().kernel(lon1, lat1, lon2, lat2, distances, size);
+        return;
+    }
+    if (DISTANCE_HAVERSINE_POLY == mode) {
+        kernel_choice().haversine(lon1, lat1, lon2, lat2, distances, size);
+        return;
+    }
+    for (size_t i = 0; i < size; i++) {
+        distances[i] = haversine_distance(lon1[i], lat1[i], lon2[i], lat2[i]);
+    }
+}
+
+void polyline_distances(const double* lonlat, size_t point_count, double* distances, DistanceMode mode) {
+    if (point_count < 2) {
+        return;
+    }
+    if (DISTANCE_HAVERSINE == mode) {
+        for (size_t i = 0; i + 1 < point_count; i++) {
+            distances[i] = haversine_distance(lonlat[2 * i], lonlat[2 * i + 1],
+                                              lonlat[2 * i + 2], lonlat[2 * i + 3]);
+        }
+        return;
+    }
+
+    // 交错存放的形点分块拆成经度、纬度两个数组，相邻两点错开一位即为线段的两端
+    const size_t CHUNK = 256;
+    double lon[CHUNK + 1];
+    double lat[CHUNK + 1];
+    for (size_t start = 0; start + 1 < point_count; start += CHUNK) {
+        size_t points = point_count - start < CHUNK + 1 ? point_count - start : CHUNK + 1;
+        for (size_t i = 0; i < points; i++) {
+            lon[i] = lonlat[2 * (start + i)];
+            lat[i] = lonlat[2 * (start + i) + 1];
+        }
+        distance_batch(lon, lat, lon + 1, lat + 1, distances + start, points - 1, mode);
+    }
+}
+
+int nearest_segment(double lon, double lat, const double* lonlat, size_t point_count, double* ratio) {
+    if (point_count < 2) {
+        return -1;
+    }
+    // 经度方向按查询点所在纬度缩放，只用于比较远近，单位保持为度
+    double kx = cos(rad(lat));
+    double best_distance2 = HUGE_VAL;
+    int index = kernel_choice().nearest_segment(lon, lat, kx, lonlat, point_count - 1, best_distance2);
+    if (index < 0) {
+        // 查询点或者形点有NaN时所有比较都不成立，找不到最近线段
+        return -1;
+    }
+    if (nullptr != ratio) {
+        const double* p = lonlat + 2 * index;
+        double ax = (p[0] - lon) * kx;
+        double ay = p[1] - lat;
+        double dx = (p[2] - lon) * kx - ax;
+        double dy = p[3] - lat - ay;
+        double len2 = dx * dx + dy * dy;
+        *ratio = len2 > 0.0 ? -(ax * dx + ay * dy) / len2 : 0.0;
+    }
+    return index;
+}
+
+double local_segment_distance(double lon, double lat, double cos_lat,
+                              double lon1, double lat1, double lon2, double lat2) {
+    double d2 = segment_distance2((lon1 - lon) * cos_lat, lat1 - lat, (lon2 - lon) * cos_lat, lat2 - lat);
+    return sqrt(d2) * (EARTH_RADIUS * DEG_TO_RAD);
+}
+
+const char* simd_kernel_name() {
+    return kernel_choice().name;
+}
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,84 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 经纬度距离计算的公共实现，adasv2-converter和tool/mm_tool共用。
+// 输入均为度，输出为米。
+
+#include <stddef.h>
+
+namespace adas {
+namespace geo {
+
+const double EARTH_RADIUS = 6371393.0; // meter
+const double PI = 3.141592653589793238462;
+
+enum DistanceMode {
+    // 球面haversine公式，和原来adas_v2_utility.cc里的calculate_distance逐位一致
+    DISTANCE_HAVERSINE = 0,
+    // 等距圆柱近似: 经差乘以两点平均纬度的余弦后按平面勾股计算，不调用三角函数库，可以向量化。
+    // 相对haversine的误差随线段长度平方增长，线段长度1km以内、纬度不超过70度时
+    // 相对误差小于1e-7(即1km线段误差小于0.1mm)，纬度不超过85度时小于1e-6。
+    // 经差跨越180度经线时结果无意义。
+    DISTANCE_EQUIRECTANGULAR = 1,
+    // 公式同精确模式，sin、cos、asin换成多项式，批量接口可以向量化。不限线段长度和纬度，
+    // 离对跖点超过130km时和真值的相对误差小于1e-13；对跖点附近asin的条件数趋于无穷，误差随之增大。
+    // 短线段的经差、纬差先按度相减，没有精确模式里弧度相减的抵消误差(1m线段约1e-9)
+    DISTANCE_HAVERSINE_POLY = 2,
+};
+
+inline double rad(double d) {
+    return d * PI / 180.0;
+}
+
+/**
+ * @brief 精确模式，球面大圆距离
+*/
+double haversine_distance(double lon1, double lat1, double lon2, double lat2);
+
+/**
+ * @brief 快速模式，误差见DISTANCE_EQUIRECTANGULAR
+*/
+double equirectangular_distance(double lon1, double lat1, double lon2, double lat2);
+
+/**
+ * @brief 线段(1, 2)的方向，和正北方向的顺时针夹角，unit 度，[0, 360)
+*/
+double bearing(double lon1, double lat1, double lon2, double lat2);
+
+/**
+ * @brief 批量计算distances[i] = distance(lon1[i], lat1[i], lon2[i], lat2[i])。
+ *        快速模式在支持的平台上使用AVX2/NEON，否则退化为标量实现；
+ *        DISTANCE_HAVERSINE_POLY用AVX2或者编译器展开的128位指令
+*/
+void distance_batch(const double* lon1, const double* lat1, const double* lon2, const double* lat2,
+                    double* distances, size_t size, DistanceMode mode);
+
+/**
+ * @brief 折线相邻形点之间的距离。lonlat为交错存放的lon0, lat0, lon1, lat1...，
+ *        distances[i]为第i个形点到第i+1个形点的距离，共point_count - 1个
+*/
+void polyline_distances(const double* lonlat, size_t point_count, double* distances, DistanceMode mode);
+
+/**
+ * @brief 在以(lon, lat)为原点的局部平面(等距圆柱近似)上找折线中离该点最近的线段，
+ *        线段i为形点i到形点i+1，lonlat的存放方式同polyline_distances。
+ *        AVX2/NEON一次比较多条线段，距离相同时取索引小的
+ * @param ratio 不为空时输出点在最近线段上的投影参数，未截断到[0, 1]，小于0表示在线段起点之前
+ * @return 最近线段的索引，point_count < 2或者坐标有NaN找不到最近线段时返回-1，此时不输出ratio
+*/
+int nearest_segment(double lon, double lat, const double* lonlat, size_t point_count, double* ratio = nullptr);
+
+/**
+ * @brief 以(lon, lat)为原点、经度方向按cos_lat缩放的局部平面上，点到线段(1, 2)的距离，单位米。
+ *        cos_lat一般为cos(rad(lat))，同一个点查询多条线段时由调用方只算一次。误差同快速模式
+*/
+double local_segment_distance(double lon, double lat, double cos_lat,
+                              double lon1, double lat1, double lon2, double lat2);
+
+/**
+ * @brief 当前进程实际使用的快速模式内核: "avx2", "neon" 或 "scalar"
+*/
+const char* simd_kernel_name();
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,82 @@
+#include <math.h>
+
+#include "geo_kernel.h"
+#include "geo_simplify.h"
+
+namespace adas {
+namespace geo {
+
+namespace {
+
+// 以度为单位、经度按cos_lat缩放的平面上，点p到线段(a, b)距离的平方
+double segment_distance2(const double* p, const double* a, const double* b, double cos_lat) {
+    double ax = (a[0] - p[0]) * cos_lat;
+    double ay = a[1] - p[1];
+    double dx = (b[0] - a[0]) * cos_lat;
+    double dy = b[1] - a[1];
+    double len2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (len2 > 0.0) {
+        t = -(ax * dx + ay * dy) / len2;
+        t = t > 0.0 ? (t < 1.0 ? t : 1.0) : 0.0;
+    }
+    double cx = ax + t * dx;
+    double cy = ay + t * dy;
+    return cx * cx + cy * cy;
+}
+
+} // namespace
+
+// 递归版本的栈由keep标记代替: [anchor, floater]超出容差时在最远点处切开，floater移到最远点；
+// 否则这一段处理完，anchor移到floater，floater移到anchor之后的下一个保留点
+size_t simplify_polyline(double* lonlat, size_t point_count, double tolerance, uint8_t* keep) {
+    if (tolerance <= 0.0 || point_count < 3) {
+        return point_count;
+    }
+
+    double cos_lat = cos(rad(lonlat[1]));
+    double limit = tolerance / (EARTH_RADIUS * PI / 180.0);
+    double limit2 = limit * limit;
+    for (size_t i = 0; i < point_count; i++) {
+        keep[i] = 0;
+    }
+    keep[0] = 1;
+    keep[point_count - 1] = 1;
+
+    size_t anchor = 0;
+    size_t floater = point_count - 1;
+    while (anchor < point_count - 1) {
+        size_t farthest = anchor;
+        double farthest2 = limit2;
+        for (size_t i = anchor + 1; i < floater; i++) {
+            double d2 = segment_distance2(lonlat + 2 * i, lonlat + 2 * anchor, lonlat + 2 * floater, cos_lat);
+            if (d2 > farthest2) {
+                farthest2 = d2;
+                farthest = i;
+            }
+        }
+        if (farthest != anchor) {
+            keep[farthest] = 1;
+            floater = farthest;
+            continue;
+        }
+        anchor = floater;
+        floater++;
+        while (floater < point_count - 1 && 0 == keep[floater]) {
+            floater++;
+        }
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < point_count; i++) {
+        if (keep[i]) {
+            lonlat[2 * count] = lonlat[2 * i];
+            lonlat[2 * count + 1] = lonlat[2 * i + 1];
+            count++;
+        }
+    }
+    return count;
+}
+
+} // namespace geo
+} // namespace adas
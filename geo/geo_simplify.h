@@ -0,0 +1,22 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// 折线抽稀(Douglas-Peucker)。用在形点入库时，减少之后投影、stub坐标和lonlat profile的形点数。
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace adas {
+namespace geo {
+
+/**
+ * @brief Douglas-Peucker抽稀，保留首末点，抽掉的每个形点到包含它的保留线段的距离不超过tolerance米。
+ *        距离在首点处的局部平面(等距圆柱近似)上计算。迭代实现，不递归、不分配内存，
+ *        keep为调用方提供的point_count字节的缓冲。保留的形点按原顺序写回lonlat的前面
+ * @param lonlat 交错存放的lon0, lat0, lon1, lat1...
+ * @return 保留的形点数，tolerance <= 0或者形点少于3个时原样返回point_count
+*/
+size_t simplify_polyline(double* lonlat, size_t point_count, double tolerance, uint8_t* keep);
+
+} // namespace geo
+} // namespace adas
@@ -0,0 +1,73 @@
+#pragma once
+// Copyright 2024 Baidu Inc. All Rights Reserved.
+//
+// geo内部使用: 批量内核用GCC的向量扩展写一份，在AVX2的函数里展开成256位指令，
+// 其他平台由编译器拆成SSE2/NEON的128位指令。不开FMA，两种展开的结果逐位一致。
+// 向量只通过引用传递，避免不同指令集之间的ABI问题
+
+#include <math.h>
+#include <stdint.h>
+
+#include "geo_kernel.h"
+
+namespace adas {
+namespace geo {
+namespace detail {
+
+typedef double Vec __attribute__((vector_size(32)));
+typedef int64_t VecMask __attribute__((vector_size(32)));
+const int LANES = 4;
+
+// 加上1.5 * 2^52之后，小数部分按当前舍入方式(就近取偶)舍掉，尾数最低位即为整数的奇偶
+const double ROUND_MAGIC = 6755399441055744.0;
+const double INV_PI = 1.0 / PI;
+
+// sin(r)的泰勒展开到r^19，|r| <= PI/2时截断误差小于3e-16
+const double SIN_C3 = -1.0 / 6.0;
+const double SIN_C5 = 1.0 / 120.0;
+const double SIN_C7 = -1.0 / 5040.0;
+const double SIN_C9 = 1.0 / 362880.0;
+const double SIN_C11 = -1.0 / 39916800.0;
+const double SIN_C13 = 1.0 / 6227020800.0;
+const double SIN_C15 = -1.0 / 1307674368000.0;
+const double SIN_C17 = 1.0 / 355687428096000.0;
+const double SIN_C19 = -1.0 / 121645100408832000.0;
+
+// sin(x) = (-1)^k * sin(x - k * PI)，k为x / PI就近取整
+inline __attribute__((always_inline)) void vec_sin(const Vec& x, Vec& out) {
+    Vec t = x * INV_PI + ROUND_MAGIC;
+    Vec k = t - ROUND_MAGIC;
+    Vec r = x - k * PI;
+    Vec z = r * r;
+    Vec p = z * SIN_C19 + SIN_C17;
+    p = p * z + SIN_C15;
+    p = p * z + SIN_C13;
+    p = p * z + SIN_C11;
+    p = p * z + SIN_C9;
+    p = p * z + SIN_C7;
+    p = p * z + SIN_C5;
+    p = p * z + SIN_C3;
+    Vec s = r + r * z * p;
+    out = (Vec)((VecMask)s ^ ((VecMask)t << 63));
+}
+
+inline __attribute__((always_inline)) void vec_cos(const Vec& x, Vec& out) {
+    vec_sin(x + PI / 2.0, out);
+}
+
+// 逐个lane写入初始化过的临时变量，out可以是未初始化的变量
+inline __attribute__((always_inline)) void vec_sqrt(const Vec& x, Vec& out) {
+    Vec r = x;
+    for (int i = 0; i < LANES; i++) {
+        r[i] = sqrt(r[i]);
+    }
+    out = r;
+}
+
+inline __attribute__((always_inline)) void vec_select(const VecMask& mask, const Vec& a, const Vec& b, Vec& out) {
+    out = (Vec)(((VecMask)a & mask) | ((VecMask)b & ~mask));
+}
+
+} // namespace detail
+} // namespace geo
+} // namespace adas
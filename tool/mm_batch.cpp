@@ -0,0 +1,255 @@
+#include <fcntl.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "mm_batch.h"
+
+namespace {
+
+const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+const int MAX_EXACT_DIGITS = 15;
+
+int64_t point_key(double lon, double lat) {
+    int64_t x = llround(lon * 1e6);
+    int64_t y = llround(lat * 1e6);
+    return int64_t((uint64_t(x) << 32) ^ (uint64_t(y) & 0xffffffffULL));
+}
+
+} // namespace
+
+bool parse_number(const char*& p, const char* end, double& value) {
+    const char* begin = p;
+    bool negative = false;
+    if (p < end && ('-' == *p || '+' == *p)) {
+        negative = ('-' == *p);
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int scale = 0;
+    bool fraction = false;
+    for (; p < end && ',' != *p && '\r' != *p; p++) {
+        if ('.' == *p && !fraction) {
+            fraction = true;
+        } else if (*p >= '0' && *p <= '9') {
+            if (digits < MAX_EXACT_DIGITS) {
+                mantissa = mantissa * 10 + (*p - '0');
+                scale += fraction;
+            }
+            digits++;
+        } else {
+            return false;
+        }
+    }
+    if (0 == digits) {
+        return false;
+    }
+
+    if (digits > MAX_EXACT_DIGITS) {
+        char buffer[64];
+        size_t length = std::min(size_t(p - begin), sizeof(buffer) - 1);
+        memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+        value = strtod(buffer, nullptr);
+        return true;
+    }
+    value = double(mantissa) / POW10[scale];
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
+int MappedFile::open(const std::string& file) {
+    close();
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (0 != fstat(fd, &st)) {
+        ::close(fd);
+        return -1;
+    }
+    if (st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == data) {
+            ::close(fd);
+            return -1;
+        }
+        /// 轨迹文件只顺序读一遍
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        _data = (const char*)data;
+        _size = st.st_size;
+    }
+    ::close(fd);
+    return 0;
+}
+
+void MappedFile::close() {
+    if (nullptr != _data) {
+        munmap((void*)_data, _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
+
+bool TraceReader::next(MatchFix& fix) {
+    while (_p < _end) {
+        const char* line_end = (const char*)memchr(_p, '\n', _end - _p);
+        if (nullptr == line_end) {
+            line_end = _end;
+        }
+
+        double values[4];
+        bool valid = true;
+        for (int i = 0; valid && i < 4; i++) {
+            valid = parse_number(_p, line_end, values[i]);
+            if (_p < line_end && ',' == *_p) {
+                _p++;
+            }
+        }
+        int64_t line = _line++;
+        _p = line_end + 1;
+        if (valid) {
+            fix.x = values[0];
+            fix.y = values[1];
+            fix.heading = values[3];
+            fix.timestamp = line * 1000;
+            return true;
+        }
+    }
+    return false;
+}
+
+int load_match_links(const std::string& file, std::vector<MatchLink>& links) {
+    MappedFile mapped;
+    if (0 != mapped.open(file)) {
+        return -1;
+    }
+
+    links.clear();
+    const char* p = mapped.data();
+    const char* end = p + mapped.size();
+    while (p < end) {
+        const char* line_end = (const char*)memchr(p, '\n', end - p);
+        if (nullptr == line_end) {
+            line_end = end;
+        }
+
+        MatchLink link;
+        double value = 0.0;
+        bool valid = parse_number(p, line_end, value);
+        link.link_id = uint64_t(value);
+        while (valid && p < line_end && ',' == *p) {
+            p++;
+            valid = parse_number(p, line_end, value);
+            link.lonlat.push_back(value);
+        }
+        if (valid && link.lonlat.size() >= 4 && 0 == link.lonlat.size() % 2) {
+            links.push_back(std::move(link));
+        }
+        p = line_end + 1;
+    }
+
+    std::unordered_map<int64_t, std::vector<int> > starts;
+    for (size_t i = 0; i < links.size(); i++) {
+        starts[point_key(links[i].lonlat[0], links[i].lonlat[1])].push_back(i);
+    }
+    for (size_t i = 0; i < links.size(); i++) {
+        const std::vector<double>& lonlat = links[i].lonlat;
+        auto it = starts.find(point_key(lonlat[lonlat.size() - 2], lonlat.back()));
+        if (starts.end() != it) {
+            links[i].successors = it->second;
+        }
+    }
+    return 0;
+}
+
+WorkStealingScheduler::WorkStealingScheduler(size_t task_count, int worker_count) :
+        _worker_count(worker_count), _ranges(new Range[worker_count]) {
+    for (int w = 0; w < worker_count; w++) {
+        uint64_t begin = task_count * w / worker_count;
+        uint64_t end = task_count * (w + 1) / worker_count;
+        _ranges[w].bounds.store(_pack(begin, end), std::memory_order_relaxed);
+    }
+}
+
+std::vector<size_t> WorkStealingScheduler::order_by_size(const std::vector<uint64_t>& sizes, int worker_count) {
+    std::vector<size_t> by_size(sizes.size());
+    for (size_t i = 0; i < by_size.size(); i++) {
+        by_size[i] = i;
+    }
+    std::stable_sort(by_size.begin(), by_size.end(), [&sizes](size_t a, size_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    /// 区间的划分方式和构造函数一致，从大到小轮流放进每个worker的区间
+    size_t task_count = sizes.size();
+    std::vector<size_t> order(task_count);
+    std::vector<size_t> cursor(worker_count);
+    for (int w = 0; w < worker_count; w++) {
+        cursor[w] = task_count * w / worker_count;
+    }
+    int w = 0;
+    for (size_t i = 0; i < task_count; i++) {
+        while (cursor[w] == task_count * (w + 1) / worker_count) {
+            w = (w + 1) % worker_count;
+        }
+        order[cursor[w]++] = by_size[i];
+        w = (w + 1) % worker_count;
+    }
+    return order;
+}
+
+int64_t WorkStealingScheduler::next(int worker) {
+    std::atomic<uint64_t>& bounds = _ranges[worker].bounds;
+    while (true) {
+        uint64_t current = bounds.load(std::memory_order_acquire);
+        uint64_t begin = current & 0xffffffffULL;
+        uint64_t end = current >> 32;
+        if (begin < end) {
+            if (bounds.compare_exchange_weak(current, _pack(begin + 1, end), std::memory_order_acq_rel)) {
+                return begin;
+            }
+            continue;
+        }
+        if (0 != _steal(worker)) {
+            return -1;
+        }
+    }
+}
+
+int WorkStealingScheduler::_steal(int thief) {
+    for (int k = 1; k < _worker_count; k++) {
+        int victim = (thief + k) % _worker_count;
+        std::atomic<uint64_t>& bounds = _ranges[victim].bounds;
+        uint64_t current = bounds.load(std::memory_order_acquire);
+        while (true) {
+            uint64_t begin = current & 0xffffffffULL;
+            uint64_t end = current >> 32;
+            if (begin >= end) {
+                break;
+            }
+            /// 偷走尾部的一半，只剩一个任务时整个偷走
+            uint64_t middle = begin + (end - begin) / 2;
+            if (bounds.compare_exchange_weak(current, _pack(begin, middle), std::memory_order_acq_rel)) {
+                /// 自己的区间为空时其他worker不会修改它，直接写入
+                _ranges[thief].bounds.store(_pack(middle, end), std::memory_order_release);
+                _ranges[thief].steals++;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2024 Baidu.com, Inc. All Rights Reserved
+ *
+ **************************************************************************/
+
+/**
+ * @file mm_batch.h
+ * @brief 离线批量轨迹匹配: mmap读轨迹文件、加载路网文件、work-stealing任务调度
+ *
+ **/
+
+#ifndef  MAPMATCH_MM_BATCH_H
+#define  MAPMATCH_MM_BATCH_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mm_matcher.h"
+
+///
+/// \brief 只读mmap一个文件，析构时unmap
+///
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ///
+    /// \return 0 成功，-1 打开或者mmap失败。空文件也返回成功，size()为0
+    ///
+    int open(const std::string& file);
+
+    void close();
+
+    const char* data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+};
+
+///
+/// \brief 解析一个十进制小数字段，遇到','、'\r'或者end停止，p指向停止的位置。
+///        数字不超过15位时整数部分和小数部分拼成一个精确的整数再做一次除法，结果和strtod一致，
+///        更长的字段交给strtod
+/// \return false 空字段或者有其他字符
+///
+bool parse_number(const char*& p, const char* end, double& value);
+
+///
+/// \brief 逐行解析轨迹，每行 x,y,speed,dir，格式同examples/baidu_map_tls_client/shanghai_gaosu_case。
+///        直接在mmap的内容上解析，不拷贝也不要求以'\0'结尾。
+///        轨迹没有时间戳，timestamp按行号1Hz编号，单位ms。格式不对的行跳过，但仍占一个行号
+///
+class TraceReader {
+public:
+    TraceReader(const char* data, size_t size) : _p(data), _end(data + size) {}
+
+    ///
+    /// \return false 已经读完
+    ///
+    bool next(MatchFix& fix);
+
+private:
+    const char* _p;
+    const char* _end;
+    int64_t _line = 0;
+};
+
+///
+/// \brief 加载路网文件，每行 link_id,lon0,lat0,lon1,lat1,...，gcj02。
+///        后继关系按形点推出: link末点和另一条link首点坐标相同(1e-6度以内)即相连
+/// \return 0 成功，-1 文件打不开
+///
+int load_match_links(const std::string& file, std::vector<MatchLink>& links);
+
+///
+/// \brief 固定任务集合上的work-stealing调度。
+///        任务编号[0, task_count)按worker均分成连续区间，每个区间用一个64位原子量表示(begin, end)，
+///        worker从自己区间的头部取任务，取空之后从其他worker区间的尾部偷走一半，全程无锁。
+///        任务只会被分出去一次，所以所有区间都为空时即可退出
+///
+class WorkStealingScheduler {
+public:
+    WorkStealingScheduler(size_t task_count, int worker_count);
+
+    ///
+    /// \brief 按任务大小从大到小交错分到各个worker的区间，大任务先做，尾部剩下的小任务用来平衡负载
+    /// \return order，调度出的任务编号i对应原来的第order[i]个任务
+    ///
+    static std::vector<size_t> order_by_size(const std::vector<uint64_t>& sizes, int worker_count);
+
+    ///
+    /// \brief worker取下一个任务
+    /// \return 任务编号，所有任务都已经分出去时返回-1
+    ///
+    int64_t next(int worker);
+
+    uint64_t steals(int worker) const {
+        return _ranges[worker].steals;
+    }
+
+private:
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds;  ///< 低32位begin，高32位end
+        uint64_t steals = 0;           ///< 只有worker自己写
+    };
+
+    static uint64_t _pack(uint64_t begin, uint64_t end) {
+        return (end << 32) | begin;
+    }
+
+    int _steal(int thief);
+
+    int _worker_count;
+    std::unique_ptr<Range[]> _ranges;
+}; // class WorkStealingScheduler
+
+#endif
@@ -0,0 +1,336 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2024 Baidu.com, Inc. All Rights Reserved
+ *
+ **************************************************************************/
+
+/**
+ * @file mm_batch_main.cpp
+ * @brief 离线批量轨迹匹配命令行工具
+ *
+ * 用法: mm_batch -l links.csv -o out_dir [-t threads] [-r search_radius] [-c wgs84|gcj02|bd09]
+ *           trace_file_or_dir ...
+ *   路网为gcj02坐标，-c为轨迹的坐标系，默认gcj02，其他坐标系按块批量转换成gcj02之后再匹配。
+ *   每个轨迹文件输出到 out_dir/<文件名>.mm，每行 timestamp,link_id,offset,dist_to_line，
+ *   link_id为0表示没有匹配上。目录参数展开为目录下的所有普通文件，不递归。
+ *   不同目录下有同名轨迹文件时输出会互相覆盖，启动前检查到就报错退出，不做任何匹配。
+ *
+ * 每个线程有自己的HmmMatcher，共享只读的MatchNetwork；轨迹文件按大小交错分给各线程，
+ * 线程做完自己的文件后从其他线程偷。每个文件的统计写在按文件下标预分配的槽位里，
+ * 每个线程的统计写在自己独占cache line的槽位里，线程结束后由主线程汇总，不需要锁。
+ **/
+
+#include <dirent.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "geo_coord.h"
+#include "mm_batch.h"
+
+namespace {
+
+const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+const size_t CONVERT_CHUNK = 256;
+
+struct alignas(64) TraceStat {
+    uint64_t bytes = 0;
+    uint64_t fixes = 0;
+    uint64_t matched = 0;
+    int status = 0;     ///< 0 成功，-1 轨迹打不开，-2 输出文件写失败
+};
+
+struct alignas(64) WorkerStat {
+    uint64_t files = 0;
+    uint64_t fixes = 0;
+    double seconds = 0.0;
+};
+
+void usage(const char* program) {
+    fprintf(stderr, "usage: %s -l links.csv -o out_dir [-t threads] [-r search_radius] "
+            "[-c wgs84|gcj02|bd09] trace_file_or_dir ...\n", program);
+}
+
+void list_traces(const std::string& path, std::vector<std::string>& traces) {
+    struct stat st;
+    if (0 != stat(path.c_str(), &st)) {
+        fprintf(stderr, "skip %s: not found\n", path.c_str());
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        traces.push_back(path);
+        return;
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (nullptr == dir) {
+        fprintf(stderr, "skip %s: can not open\n", path.c_str());
+        return;
+    }
+    std::vector<std::string> names;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string file = path + "/" + entry->d_name;
+        if (0 == stat(file.c_str(), &st) && S_ISREG(st.st_mode)) {
+            names.push_back(file);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    traces.insert(traces.end(), names.begin(), names.end());
+}
+
+std::string output_path(const std::string& out_dir, const std::string& trace) {
+    size_t slash = trace.rfind('/');
+    return out_dir + "/" + (std::string::npos == slash ? trace : trace.substr(slash + 1)) + ".mm";
+}
+
+///
+/// \brief 检查输出文件名有没有重复，重复时两个worker会同时写同一个文件
+/// \return 重复的输出文件个数，每个重复都打印对应的轨迹文件
+///
+int check_output_conflicts(const std::vector<std::string>& traces, const std::vector<std::string>& outputs) {
+    std::vector<size_t> order(outputs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&outputs](size_t a, size_t b) {
+        return outputs[a] != outputs[b] ? outputs[a] < outputs[b] : a < b;
+    });
+
+    int conflicts = 0;
+    for (size_t i = 1; i < order.size(); i++) {
+        if (outputs[order[i]] == outputs[order[i - 1]]) {
+            fprintf(stderr, "%s and %s both write %s\n", traces[order[i - 1]].c_str(),
+                    traces[order[i]].c_str(), outputs[order[i]].c_str());
+            conflicts++;
+        }
+    }
+    return conflicts;
+}
+
+void append_results(const std::vector<MatchResult>& results, TraceStat& stat, std::string& buffer) {
+    char line[128];
+    for (size_t i = 0; i < results.size(); i++) {
+        const MatchResult& result = results[i];
+        int length = snprintf(line, sizeof(line), "%ld,%lu,%.2f,%.2f\n", (long)result.timestamp,
+                (unsigned long)result.link_id, result.offset, result.dist_to_line);
+        buffer.append(line, length);
+        stat.matched += (result.link_index >= 0);
+    }
+}
+
+int flush_output(FILE* output, std::string& buffer) {
+    int ret = 0;
+    if (!buffer.empty() && buffer.size() != fwrite(buffer.data(), 1, buffer.size(), output)) {
+        ret = -1;
+    }
+    buffer.clear();
+    return ret;
+}
+
+int parse_coord_type(const std::string& name, adas::geo::CoordType& coord_type) {
+    if ("wgs84" == name) {
+        coord_type = adas::geo::COORD_WGS84;
+    } else if ("gcj02" == name) {
+        coord_type = adas::geo::COORD_GCJ02;
+    } else if ("bd09" == name) {
+        coord_type = adas::geo::COORD_BD09;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+///
+/// \brief 匹配一个轨迹文件，定位点按CONVERT_CHUNK个一块转换坐标之后送进matcher，
+///        结果攒够OUTPUT_BUFFER_SIZE写一次，内存占用和文件大小无关
+///
+void match_trace(HmmMatcher& matcher, const std::string& trace, const std::string& output_file,
+        adas::geo::CoordType coord_type, std::vector<MatchResult>& results, std::string& buffer,
+        TraceStat& stat) {
+    MappedFile mapped;
+    if (0 != mapped.open(trace)) {
+        stat.status = -1;
+        return;
+    }
+    stat.bytes = mapped.size();
+
+    FILE* output = fopen(output_file.c_str(), "w");
+    if (nullptr == output) {
+        stat.status = -2;
+        return;
+    }
+
+    matcher.reset();
+    TraceReader reader(mapped.data(), mapped.size());
+    MatchFix fixes[CONVERT_CHUNK];
+    double lonlat[2 * CONVERT_CHUNK];
+    while (true) {
+        size_t count = 0;
+        while (count < CONVERT_CHUNK && reader.next(fixes[count])) {
+            count++;
+        }
+        if (0 == count) {
+            break;
+        }
+        if (adas::geo::COORD_GCJ02 != coord_type) {
+            for (size_t i = 0; i < count; i++) {
+                lonlat[2 * i] = fixes[i].x;
+                lonlat[2 * i + 1] = fixes[i].y;
+            }
+            adas::geo::convert_coords(lonlat, lonlat, count, coord_type, adas::geo::COORD_GCJ02);
+            for (size_t i = 0; i < count; i++) {
+                fixes[i].x = lonlat[2 * i];
+                fixes[i].y = lonlat[2 * i + 1];
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            stat.fixes++;
+            if (matcher.input(fixes[i], results) > 0) {
+                append_results(results, stat, buffer);
+                results.clear();
+                if (buffer.size() >= OUTPUT_BUFFER_SIZE && 0 != flush_output(output, buffer)) {
+                    stat.status = -2;
+                }
+            }
+        }
+    }
+    matcher.flush(results);
+    append_results(results, stat, buffer);
+    results.clear();
+    if (0 != flush_output(output, buffer) || 0 != fclose(output)) {
+        stat.status = -2;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string links_file;
+    std::string out_dir;
+    int threads = std::thread::hardware_concurrency();
+    HmmMatcherConfig config;
+    adas::geo::CoordType coord_type = adas::geo::COORD_GCJ02;
+
+    int opt = 0;
+    while (-1 != (opt = getopt(argc, argv, "l:o:t:r:c:h"))) {
+        switch (opt) {
+        case 'l':
+            links_file = optarg;
+            break;
+        case 'o':
+            out_dir = optarg;
+            break;
+        case 't':
+            threads = atoi(optarg);
+            break;
+        case 'r':
+            config.search_radius = atof(optarg);
+            break;
+        case 'c':
+            if (0 != parse_coord_type(optarg, coord_type)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (links_file.empty() || out_dir.empty() || optind >= argc || threads <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> traces;
+    for (int i = optind; i < argc; i++) {
+        list_traces(argv[i], traces);
+    }
+    std::vector<std::string> outputs(traces.size());
+    for (size_t i = 0; i < traces.size(); i++) {
+        outputs[i] = output_path(out_dir, traces[i]);
+    }
+    if (0 != check_output_conflicts(traces, outputs)) {
+        fprintf(stderr, "output file names conflict, rename the traces or run them separately\n");
+        return 1;
+    }
+    mkdir(out_dir.c_str(), 0755);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MatchLink> links;
+    if (0 != load_match_links(links_file, links)) {
+        fprintf(stderr, "can not open %s\n", links_file.c_str());
+        return 1;
+    }
+    MatchNetwork network(&links);
+    double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "loaded %zu links in %.2fs, %zu traces, %d threads\n",
+            links.size(), load_seconds, traces.size(), threads);
+
+    std::vector<uint64_t> sizes(traces.size());
+    for (size_t i = 0; i < traces.size(); i++) {
+        struct stat st;
+        sizes[i] = (0 == stat(traces[i].c_str(), &st)) ? st.st_size : 0;
+    }
+    std::vector<size_t> order = WorkStealingScheduler::order_by_size(sizes, threads);
+    WorkStealingScheduler scheduler(traces.size(), threads);
+
+    std::vector<TraceStat> trace_stats(traces.size());
+    std::vector<WorkerStat> worker_stats(threads);
+    std::vector<std::thread> workers;
+    start = std::chrono::steady_clock::now();
+    for (int w = 0; w < threads; w++) {
+        workers.emplace_back([&, w]() {
+            auto worker_start = std::chrono::steady_clock::now();
+            HmmMatcher matcher(&network, config);
+            std::vector<MatchResult> results;
+            std::string buffer;
+            buffer.reserve(OUTPUT_BUFFER_SIZE + 4096);
+            WorkerStat& worker_stat = worker_stats[w];
+            for (int64_t task = scheduler.next(w); task >= 0; task = scheduler.next(w)) {
+                size_t index = order[task];
+                match_trace(matcher, traces[index], outputs[index], coord_type, results, buffer, trace_stats[index]);
+                worker_stat.files++;
+                worker_stat.fixes += trace_stats[index].fixes;
+            }
+            worker_stat.seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - worker_start).count();
+        });
+    }
+    for (size_t w = 0; w < workers.size(); w++) {
+        workers[w].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TraceStat total;
+    int failed = 0;
+    for (size_t i = 0; i < traces.size(); i++) {
+        const TraceStat& stat = trace_stats[i];
+        if (0 != stat.status) {
+            fprintf(stderr, "%s: %s\n", traces[i].c_str(),
+                    -1 == stat.status ? "can not open" : "write output failed");
+            failed++;
+        }
+        total.bytes += stat.bytes;
+        total.fixes += stat.fixes;
+        total.matched += stat.matched;
+    }
+    for (int w = 0; w < threads; w++) {
+        fprintf(stderr, "worker %d: %lu files, %lu fixes, %lu steals, %.2fs\n", w,
+                (unsigned long)worker_stats[w].files, (unsigned long)worker_stats[w].fixes,
+                (unsigned long)scheduler.steals(w), worker_stats[w].seconds);
+    }
+    fprintf(stderr, "%zu files, %.1f MB, %lu fixes, %.2f%% matched, %.2fs, %.0f fixes/s\n",
+            traces.size(), total.bytes / 1e6, (unsigned long)total.fixes,
+            total.fixes > 0 ? 100.0 * total.matched / total.fixes : 0.0,
+            seconds, seconds > 0 ? total.fixes / seconds : 0.0);
+    return 0 == failed ? 0 : 2;
+}
@@ -0,0 +1,263 @@
+#include <math.h>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "geo_kernel.h"
+#include "mm_matcher.h"
+
+namespace {
+
+double link_length(const MatchLink& link) {
+    return link.prefix_lengths.empty() ? 0.0 : link.prefix_lengths.back();
+}
+
+} // namespace
+
+MatchNetwork::MatchNetwork(std::vector<MatchLink>* links) : _links(links) {
+    std::map<std::pair<int, int>, int> tiles;
+    for (size_t i = 0; i < _links->size(); i++) {
+        MatchLink& link = (*_links)[i];
+        int point_count = link.lonlat.size() / 2;
+        if (int(link.prefix_lengths.size()) != point_count) {
+            link.prefix_lengths.resize(point_count);
+            calculate_prefix_lengths(link.lonlat.data(), point_count, link.prefix_lengths.data());
+        }
+        if (point_count > 0) {
+            std::pair<int, int> tile(int(floor(link.lonlat[0] / FRAME_TILE)), int(floor(link.lonlat[1] / FRAME_TILE)));
+            auto it = tiles.find(tile);
+            if (tiles.end() == it) {
+                it = tiles.insert(std::make_pair(tile, int(_frames.size()))).first;
+                _frames.emplace_back((tile.first + 0.5) * FRAME_TILE, (tile.second + 0.5) * FRAME_TILE);
+            }
+            link.frame = it->second;
+            link.local_east.resize(point_count);
+            link.local_north.resize(point_count);
+            _frames[link.frame].to_local(link.lonlat.data(), point_count,
+                    link.local_east.data(), link.local_north.data());
+        }
+        _grid.insert(i, link.lonlat.data(), point_count);
+    }
+}
+
+HmmMatcher::HmmMatcher(std::vector<MatchLink>* links, const HmmMatcherConfig& config) :
+        _own_network(new MatchNetwork(links)), _network(_own_network.get()),
+        _links(&_network->links()), _config(config) {}
+
+HmmMatcher::HmmMatcher(const MatchNetwork* network, const HmmMatcherConfig& config) :
+        _network(network), _links(&_network->links()), _config(config) {}
+
+void HmmMatcher::reset() {
+    _window.clear();
+}
+
+void HmmMatcher::_find_candidates(const MatchFix& fix, std::vector<Candidate>& candidates) {
+    candidates.clear();
+    _fix_frames.clear();
+    _fix_local.clear();
+    _network->grid().query(fix.x, fix.y, _config.search_radius, _hits);
+
+    for (size_t n = 0; n < _hits.size(); n++) {
+        /// 同一条link的多条线段只取一次，投影在整条link上做
+        size_t i = _hits[n].id;
+        bool seen = false;
+        for (size_t k = 0; k < candidates.size() && !seen; k++) {
+            seen = (int(i) == candidates[k].link_index);
+        }
+        if (seen) {
+            continue;
+        }
+        const MatchLink& link = (*_links)[i];
+
+        /// 定位点在每个用到的坐标系下只换算一次，附近的link一般都在同一个坐标系
+        size_t f = 0;
+        while (f < _fix_frames.size() && _fix_frames[f] != link.frame) {
+            f++;
+        }
+        if (f == _fix_frames.size()) {
+            double east = 0.0;
+            double north = 0.0;
+            _network->frame(link.frame).to_local(fix.x, fix.y, east, north);
+            _fix_frames.push_back(link.frame);
+            _fix_local.push_back(east);
+            _fix_local.push_back(north);
+        }
+
+        adas::geo::LocalProjection local;
+        int point_count = link.local_east.size();
+        if (0 != adas::geo::project_local(_fix_local[2 * f], _fix_local[2 * f + 1], link.local_east.data(),
+                    link.local_north.data(), point_count, local)) {
+            continue;
+        }
+        if (local.distance > _config.search_radius) {
+            continue;
+        }
+
+        Candidate candidate;
+        int k = local.segment_index;
+        candidate.projection.segment_index = k;
+        candidate.projection.dist_to_line = local.distance;
+        candidate.projection.offset = link.prefix_lengths[k] +
+                local.ratio * (link.prefix_lengths[k + 1] - link.prefix_lengths[k]);
+        candidate.projection.bearing = local.heading;
+        if (0 == k && 0.0f == local.ratio) {
+            candidate.projection.project_type = 1;
+        } else if (point_count - 2 == k && 1.0f == local.ratio) {
+            candidate.projection.project_type = 2;
+        }
+
+        double d = candidate.projection.dist_to_line / _config.gps_sigma;
+        candidate.emission = -0.5 * d * d;
+        if (fix.heading >= 0) {
+            double delta = fabs(fix.heading - candidate.projection.bearing);
+            if (delta > 180.0) {
+                delta = 360.0 - delta;
+            }
+            double h = delta / _config.heading_sigma;
+            candidate.emission -= 0.5 * h * h;
+        }
+        candidate.link_index = i;
+        candidate.score = candidate.emission;
+        candidate.prev = -1;
+        candidates.push_back(candidate);
+    }
+
+    if (int(candidates.size()) > _config.max_candidates) {
+        std::partial_sort(candidates.begin(), candidates.begin() + _config.max_candidates, candidates.end(),
+                [](const Candidate& a, const Candidate& b) {
+                    return a.emission > b.emission;
+                });
+        candidates.resize(_config.max_candidates);
+    }
+}
+
+void HmmMatcher::_search_route(int link_index, double distance, int target, double target_offset,
+        int depth, double& best) const {
+    const std::vector<int>& successors = (*_links)[link_index].successors;
+    for (size_t i = 0; i < successors.size(); i++) {
+        int next = successors[i];
+        if (next == target) {
+            best = std::min(best, distance + target_offset);
+            continue;
+        }
+        double next_distance = distance + link_length((*_links)[next]);
+        if (depth > 1 && next_distance < best && next_distance < _config.max_route_distance) {
+            _search_route(next, next_distance, target, target_offset, depth - 1, best);
+        }
+    }
+}
+
+double HmmMatcher::_route_distance(const Candidate& from, const Candidate& to) const {
+    if (from.link_index == to.link_index &&
+            to.projection.offset + _config.backward_tolerance >= from.projection.offset) {
+        return std::max(0.0, to.projection.offset - from.projection.offset);
+    }
+
+    double best = HUGE_VAL;
+    double rest = link_length((*_links)[from.link_index]) - from.projection.offset;
+    _search_route(from.link_index, rest, to.link_index, to.projection.offset, _config.max_route_depth, best);
+    return best;
+}
+
+int HmmMatcher::_emit_front(std::vector<MatchResult>& results) {
+    // 从最新一列的最优候选回溯到窗口最老的一列
+    int index = _window.back().best;
+    for (size_t c = _window.size() - 1; c > 0; c--) {
+        index = _window[c].candidates[index].prev;
+    }
+
+    const Column& front = _window.front();
+    const Candidate& candidate = front.candidates[index];
+    MatchResult result;
+    result.timestamp = front.fix.timestamp;
+    result.link_index = candidate.link_index;
+    result.link_id = (*_links)[candidate.link_index].link_id;
+    result.offset = candidate.projection.offset;
+    result.dist_to_line = candidate.projection.dist_to_line;
+    results.push_back(result);
+
+    _window.pop_front();
+    return 1;
+}
+
+int HmmMatcher::flush(std::vector<MatchResult>& results) {
+    int emitted = 0;
+    while (!_window.empty()) {
+        emitted += _emit_front(results);
+    }
+    return emitted;
+}
+
+int HmmMatcher::input(const MatchFix& fix, std::vector<MatchResult>& results) {
+    int emitted = 0;
+    _find_candidates(fix, _scratch);
+    if (_scratch.empty()) {
+        /// 没有候选，链断开，窗口内的点先全部输出
+        emitted += flush(results);
+        MatchResult result;
+        result.timestamp = fix.timestamp;
+        results.push_back(result);
+        return emitted + 1;
+    }
+
+    if (!_window.empty()) {
+        const Column& last = _window.back();
+        double gps_distance = adas::geo::equirectangular_distance(last.fix.x, last.fix.y, fix.x, fix.y);
+        bool connected = false;
+        for (size_t j = 0; j < _scratch.size(); j++) {
+            Candidate& to = _scratch[j];
+            double best = -HUGE_VAL;
+            to.prev = -1;
+            for (size_t i = 0; i < last.candidates.size(); i++) {
+                const Candidate& from = last.candidates[i];
+                double route = _route_distance(from, to);
+                if (HUGE_VAL == route) {
+                    continue;
+                }
+                double score = from.score - fabs(route - gps_distance) / _config.transition_beta;
+                if (score > best) {
+                    best = score;
+                    to.prev = i;
+                }
+            }
+            if (to.prev >= 0) {
+                to.score = best + to.emission;
+                connected = true;
+            }
+        }
+
+        if (connected) {
+            _scratch.erase(std::remove_if(_scratch.begin(), _scratch.end(),
+                    [](const Candidate& candidate) {
+                        return candidate.prev < 0;
+                    }), _scratch.end());
+        } else {
+            /// 路网上走不通，链断开，从当前点重新开始
+            emitted += flush(results);
+            for (size_t j = 0; j < _scratch.size(); j++) {
+                _scratch[j].score = _scratch[j].emission;
+            }
+        }
+    }
+
+    Column column;
+    column.fix = fix;
+    column.best = 0;
+    for (size_t j = 1; j < _scratch.size(); j++) {
+        if (_scratch[j].score > _scratch[column.best].score) {
+            column.best = j;
+        }
+    }
+    /// 分数减去最大值，避免长轨迹上累加溢出
+    double max_score = _scratch[column.best].score;
+    for (size_t j = 0; j < _scratch.size(); j++) {
+        _scratch[j].score -= max_score;
+    }
+    column.candidates.swap(_scratch);
+    _window.push_back(std::move(column));
+
+    while (int(_window.size()) > _config.lag) {
+        emitted += _emit_front(results);
+    }
+    return emitted;
+}
@@ -0,0 +1,168 @@
+/***************************************************************************
+ *
+ * Copyright (c) 2024 Baidu.com, Inc. All Rights Reserved
+ *
+ **************************************************************************/
+
+/**
+ * @file mm_matcher.h
+ * @brief 基于HMM的在线地图匹配，固定延迟Viterbi解码
+ *
+ **/
+
+#ifndef  MAPMATCH_MM_MATCHER_H
+#define  MAPMATCH_MM_MATCHER_H
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "geo_enu.h"
+#include "geo_grid_index.h"
+#include "mm_tool.h"
+
+///
+/// \brief 路网中的一条link
+///
+struct MatchLink {
+    uint64_t link_id = 0;
+    std::vector<double> lonlat;         ///< 交错存放的形点 lon0, lat0, lon1, lat1 ...，gcj02
+    std::vector<double> prefix_lengths; ///< 形点累计长度，为空时由HmmMatcher构造时计算
+    std::vector<int> successors;        ///< 末点相连的后继link在links中的下标
+    int frame = -1;                     ///< 所在局部坐标系在MatchNetwork中的下标，构造时填写
+    std::vector<float> local_east;      ///< 形点的局部坐标，单位米，构造时填写
+    std::vector<float> local_north;
+};
+
+///
+/// \brief 一个GPS定位点
+///
+struct MatchFix {
+    double x = 0.0;
+    double y = 0.0;
+    double heading = -1.0;  ///< 和正北方向的顺时针夹角，单位度，小于0表示无效
+    int64_t timestamp = 0;  ///< 单位ms
+};
+
+///
+/// \brief 一个定位点的匹配结果，结果顺序和输入顺序一致
+///
+struct MatchResult {
+    int64_t timestamp = 0;
+    int link_index = -1;         ///< links中的下标，-1表示没有匹配上
+    uint64_t link_id = 0;
+    double offset = 0.0;         ///< 投影点到link首点的距离，单位米
+    double dist_to_line = 0.0;   ///< 定位点到投影点的距离，单位米
+};
+
+struct HmmMatcherConfig {
+    double search_radius = 50.0;        ///< 候选link的搜索半径，单位米
+    int max_candidates = 8;             ///< 每个定位点最多保留的候选数
+    double gps_sigma = 10.0;            ///< 定位误差的标准差，单位米
+    double heading_sigma = 45.0;        ///< 方向误差的标准差，单位度
+    double transition_beta = 5.0;       ///< 路网距离和直线距离之差的指数分布参数，单位米
+    double backward_tolerance = 5.0;    ///< 同一条link上允许的倒退距离，单位米
+    double max_route_distance = 2000.0; ///< 两个定位点之间路网距离的搜索上限，单位米
+    int max_route_depth = 3;            ///< 两个定位点之间最多经过的link数
+    int lag = 8;                        ///< 固定延迟，窗口内超过lag个定位点时输出最老的一个
+};
+
+///
+/// \brief 匹配用的路网: links和link线段的网格索引，id为links中的下标。
+///        路网按FRAME_TILE度的瓦片划分局部坐标系，link的形点换算到首点所在瓦片的坐标系，
+///        投影在平面上用float计算。构造之后只读，可以被多个线程里的HmmMatcher共享
+///
+class MatchNetwork {
+public:
+    static constexpr double FRAME_TILE = 0.2; ///< 单位度，瓦片中心到边缘不超过约15km
+
+    /// links的生命周期需要长于MatchNetwork，构造时补齐prefix_lengths和局部坐标
+    explicit MatchNetwork(std::vector<MatchLink>* links);
+
+    const adas::geo::LocalFrame& frame(int index) const {
+        return _frames[index];
+    }
+
+    int frame_count() const {
+        return _frames.size();
+    }
+
+    const std::vector<MatchLink>& links() const {
+        return *_links;
+    }
+
+    const adas::geo::SegmentGridIndex& grid() const {
+        return _grid;
+    }
+
+private:
+    std::vector<MatchLink>* _links;
+    std::vector<adas::geo::LocalFrame> _frames;
+    adas::geo::SegmentGridIndex _grid;
+}; // class MatchNetwork
+
+///
+/// \brief 在线HMM地图匹配。
+///        发射概率由投影距离和方向差决定，转移概率由路网距离和两点直线距离的差决定，
+///        Viterbi解码只保留最近lag个定位点的窗口，内存和每个点的计算量都有上界。
+///        例如:
+///          HmmMatcher matcher(&links);
+///          matcher.input(fix, results);   // 每个定位点调用，results追加已经确定的结果
+///          matcher.flush(results);        // 轨迹结束时输出窗口内剩余的结果
+///
+class HmmMatcher {
+public:
+    /// links的生命周期需要长于HmmMatcher，构造时补齐prefix_lengths
+    explicit HmmMatcher(std::vector<MatchLink>* links, const HmmMatcherConfig& config = HmmMatcherConfig());
+
+    /// 多个HmmMatcher共享同一个路网，network的生命周期需要长于HmmMatcher
+    explicit HmmMatcher(const MatchNetwork* network, const HmmMatcherConfig& config = HmmMatcherConfig());
+
+    ///
+    /// \brief 输入一个定位点，把已经离开窗口的定位点的匹配结果追加到results
+    /// \return 追加的结果数
+    ///
+    int input(const MatchFix& fix, std::vector<MatchResult>& results);
+
+    ///
+    /// \brief 输出窗口内所有剩余的结果，之后可以继续输入新的轨迹
+    /// \return 追加的结果数
+    ///
+    int flush(std::vector<MatchResult>& results);
+
+    void reset();
+
+private:
+    struct Candidate {
+        int link_index;
+        PolylineProjection projection;
+        double emission;
+        double score;
+        int prev;
+    };
+
+    struct Column {
+        MatchFix fix;
+        std::vector<Candidate> candidates;
+        int best;
+    };
+
+    void _find_candidates(const MatchFix& fix, std::vector<Candidate>& candidates);
+    double _route_distance(const Candidate& from, const Candidate& to) const;
+    void _search_route(int link_index, double distance, int target, double target_offset,
+            int depth, double& best) const;
+    int _emit_front(std::vector<MatchResult>& results);
+
+    std::unique_ptr<MatchNetwork> _own_network;  ///< 用links构造时自己持有的路网
+    const MatchNetwork* _network;
+    const std::vector<MatchLink>* _links;
+    HmmMatcherConfig _config;
+    std::vector<adas::geo::SegmentHit> _hits;
+    std::vector<int> _fix_frames;        ///< 当前定位点已经换算过的坐标系
+    std::vector<float> _fix_local;       ///< 当前定位点在_fix_frames中各坐标系下的east, north
+    std::deque<Column> _window;
+    std::vector<Candidate> _scratch;
+}; // class HmmMatcher
+
+#endif
@@ -2,25 +2,10 @@
 #include <math.h>
 
 
+#include "geo_kernel.h"
 #include "mm_tool.h"
 
-const double EARTH_RADIUS = 6378.137;
-static const double PI  = 3.141592653589793238462;
-static double rad(double d) {
-    return d * PI / 180.0;
-}
-
-
-double calculate_distance(double lon1, double lat1, double lon2, double lat2) {
-    double rad_lat1 = rad(lat1);
-    double rad_lat2 = rad(lat2);
-    double a = rad_lat1 - rad_lat2;
-    double b = rad(lon1) - rad(lon2);
-    double s = 2 * asin(sqrt(pow(sin(a / 2), 2) + 
-                cos(rad_lat1) * cos(rad_lat2) * pow(sin(b / 2), 2)));
-    s = s * EARTH_RADIUS;
-    return 1000.0 * s;
-}
+using adas::geo::haversine_distance;
 
 void calculate_projection(double p_x, double p_y,
         double l_x1, double l_y1,
@@ -47,7 +32,7 @@ void calculate_projection(double p_x, double p_y,
 
     if (cos_angle1 < 0) {
         /// 在首点之前
-        dist_to_line = calculate_distance(p_x, p_y, l_x1, l_y1);
+        dist_to_line = haversine_distance(p_x, p_y, l_x1, l_y1);
         dist_to_snode = 0;
         project_type = 1;
     } else {
@@ -60,14 +45,64 @@ void calculate_projection(double p_x, double p_y,
 
         if (cos_angle2 < 0) {
             /// 在末点之后
-            dist_to_line = calculate_distance(p_x, p_y, l_x2, l_y2);
-            dist_to_snode = calculate_distance(l_x1, l_y1, l_x2, l_y2);
+            dist_to_line = haversine_distance(p_x, p_y, l_x2, l_y2);
+            dist_to_snode = haversine_distance(l_x1, l_y1, l_x2, l_y2);
             project_type = 2;
         } else {
-            double dist = calculate_distance(p_x, p_y, l_x1, l_y1);
+            double dist = haversine_distance(p_x, p_y, l_x1, l_y1);
             dist_to_snode = dist * cos_angle1;
             dist_to_line = dist * sqrt(1 - cos_angle1 * cos_angle1);
             project_type = 0;
         }
     }
 }
+
+void calculate_prefix_lengths(const double* lonlat, int point_count, double* prefix_lengths) {
+    if (point_count <= 0) {
+        return;
+    }
+    prefix_lengths[0] = 0.0;
+    adas::geo::polyline_distances(lonlat, point_count, prefix_lengths + 1, adas::geo::DISTANCE_HAVERSINE);
+    for (int i = 1; i < point_count; i++) {
+        prefix_lengths[i] += prefix_lengths[i - 1];
+    }
+}
+
+double calculate_bearing(double l_x1, double l_y1, double l_x2, double l_y2) {
+    return adas::geo::bearing(l_x1, l_y1, l_x2, l_y2);
+}
+
+int calculate_polyline_projection(double p_x, double p_y,
+        const double* lonlat,
+        const double* prefix_lengths,
+        int point_count,
+        PolylineProjection& projection) {
+    double ratio = 0;
+    int index = adas::geo::nearest_segment(p_x, p_y, lonlat, point_count, &ratio);
+    if (index < 0) {
+        return -1;
+    }
+
+    projection.project_type = 0;
+    if (ratio < 0) {
+        /// 落在中间形点之前的算在折线上，只有首条线段之前才算在折线首点之前
+        projection.project_type = (0 == index ? 1 : 0);
+        ratio = 0;
+    } else if (ratio > 1) {
+        projection.project_type = (point_count - 2 == index ? 2 : 0);
+        ratio = 1;
+    }
+
+    double l_x1 = lonlat[2 * index];
+    double l_y1 = lonlat[2 * index + 1];
+    double l_x2 = lonlat[2 * index + 2];
+    double l_y2 = lonlat[2 * index + 3];
+    double foot_x = l_x1 + ratio * (l_x2 - l_x1);
+    double foot_y = l_y1 + ratio * (l_y2 - l_y1);
+
+    projection.segment_index = index;
+    projection.dist_to_line = haversine_distance(p_x, p_y, foot_x, foot_y);
+    projection.offset = prefix_lengths[index] + ratio * (prefix_lengths[index + 1] - prefix_lengths[index]);
+    projection.bearing = calculate_bearing(l_x1, l_y1, l_x2, l_y2);
+    return 0;
+}
@@ -32,5 +32,45 @@ void calculate_projection(double p_x, double p_y,
         double& dist_to_snode,
         int& project_type);
 
+///
+/// \brief 点到折线的投影结果
+///
+struct PolylineProjection {
+    int segment_index = -1;     ///< 最近线段的索引，线段i为形点i到形点i+1
+    double dist_to_line = 0.0;  ///< 点到投影点的距离，单位米
+    double offset = 0.0;        ///< 投影点沿折线到首点的距离，单位米
+    double bearing = 0.0;       ///< 最近线段的方向，和正北方向的顺时针夹角，单位度，[0, 360)
+    int project_type = 0;       ///< 0:投影点在折线上，1:投影点在折线首点之前，2:投影点在折线末点之后
+};
+
+///
+/// \brief 计算折线各形点到首点的累计长度，供calculate_polyline_projection使用
+/// \param lonlat 交错存放的形点坐标 lon0, lat0, lon1, lat1 ...，gcj02
+/// \param point_count 形点个数
+/// \param prefix_lengths 输出，point_count个，prefix_lengths[i]为形点i到首点的折线长度，单位米
+///
+void calculate_prefix_lengths(const double* lonlat, int point_count, double* prefix_lengths);
+
+///
+/// \brief 求一个点在折线上的投影。在以该点为原点的局部平面上用SIMD找出最近的线段，
+///        投影点按在该线段上的比例插值，offset为投影点沿折线的累计距离
+/// \param p_x, p_y 点的坐标
+/// \param lonlat 交错存放的形点坐标，同calculate_prefix_lengths
+/// \param prefix_lengths calculate_prefix_lengths的结果
+/// \param point_count 形点个数
+/// \param projection 投影结果
+/// \return 0 成功，-1 形点少于2个
+///
+int calculate_polyline_projection(double p_x, double p_y,
+        const double* lonlat,
+        const double* prefix_lengths,
+        int point_count,
+        PolylineProjection& projection);
+
+///
+/// \brief 线段方向，和正北方向的顺时针夹角，单位度，[0, 360)
+///
+double calculate_bearing(double l_x1, double l_y1, double l_x2, double l_y2);
+
 
 #endif 